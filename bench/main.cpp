@@ -0,0 +1,857 @@
+// Headless benchmark suite. See bench/README.md for usage and the output schema.
+#include <ecs/ecs.hpp>
+#include <ecs/modules/hierarchy_ops.hpp>
+#include <ecs/modules/spatial_grid.hpp>
+#include <ecs/modules/transform.hpp>
+#include <ecs/modules/transform_propagation.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ecs;
+
+// ---------------------------------------------------------------------------
+// Components (the scene shapes mirror examples/stress_harness)
+// ---------------------------------------------------------------------------
+
+struct Velocity {
+    float vx, vy, vz;
+};
+struct MeshTag {
+    int type;
+};
+struct Orbital {
+    float speed, orbit_radius, angle;
+};
+template <int I>
+struct Field {
+    float v[4];
+};
+struct Disabled {};
+template <int I>
+struct Flag {};
+struct NetId {
+    uint32_t value;
+};
+struct Stunned {};
+template <>
+struct ecs::is_sparse_component<Stunned> : std::true_type {};
+// One particle stored whole (AoS) and split into lanes (see ecs::split_fields)
+struct Particle {
+    float x, y, z, vx, vy, vz, age, drag;
+};
+struct SplitParticle {
+    float x, y, z, vx, vy, vz, age, drag;
+};
+template <>
+struct ecs::split_fields<SplitParticle>
+    : ecs::fields<&SplitParticle::x, &SplitParticle::y, &SplitParticle::z, &SplitParticle::vx,
+                  &SplitParticle::vy, &SplitParticle::vz, &SplitParticle::age,
+                  &SplitParticle::drag> {};
+
+using F0 = Field<0>;
+using F1 = Field<1>;
+using F2 = Field<2>;
+using F3 = Field<3>;
+using F4 = Field<4>;
+using F5 = Field<5>;
+using F6 = Field<6>;
+using F7 = Field<7>;
+
+// Keeps results observable so the optimizer cannot drop the measured work
+static volatile float g_sink;
+
+static float randf(float lo, float hi) {
+    return lo + static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX) * (hi - lo);
+}
+
+template <typename F>
+static double time_ms(F&& f) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0)
+        .count();
+}
+
+// ---------------------------------------------------------------------------
+// Cases: each returns the timed milliseconds of one repetition (setup is untimed)
+// ---------------------------------------------------------------------------
+
+struct Case {
+    const char* name;
+    size_t base_n; // entity count at --scale=1
+    std::function<double(size_t n)> run;
+};
+
+static void fill_wide(World& w, size_t n) {
+    for (size_t i = 0; i < n; ++i)
+        w.create_with(F0{{1, 0, 0, 0}}, F1{}, F2{}, F3{}, F4{}, F5{}, F6{}, F7{});
+}
+
+template <int... Is>
+static Entity create_wide(World& w, std::integer_sequence<int, Is...>) {
+    return w.create_with(Field<Is>{{float(Is)}}...);
+}
+
+static void spawn_flat(World& w, size_t n, bool wide) {
+    for (size_t i = 0; i < n; ++i) {
+        LocalTransform lt{{randf(-50, 50), randf(-50, 50), randf(-50, 50)}};
+        Velocity v{randf(-5, 5), randf(-5, 5), randf(-5, 5)};
+        if (wide)
+            w.create_with(std::move(lt), WorldTransform{}, std::move(v), MeshTag{int(i % 3)},
+                          F0{}, F1{}, F2{}, F3{});
+        else
+            w.create_with(std::move(lt), WorldTransform{}, std::move(v), MeshTag{int(i % 3)});
+    }
+}
+
+static void spawn_shallow_trees(World& w, size_t n) {
+    for (size_t t = 0; t < std::max<size_t>(1, n / 41); ++t) {
+        Entity root = w.create_with(LocalTransform{{randf(-30, 30), 0, randf(-30, 30)}},
+                                    WorldTransform{}, MeshTag{0});
+        for (int c = 0; c < 8; ++c) {
+            Entity child = w.create_with(LocalTransform{}, WorldTransform{},
+                                         Orbital{randf(0.5f, 3), randf(1, 3), 0}, MeshTag{1});
+            set_parent(w, child, root);
+            for (int g = 0; g < 4; ++g) {
+                Entity gc = w.create_with(LocalTransform{}, WorldTransform{},
+                                          Orbital{randf(1, 5), randf(0.3f, 1), 0}, MeshTag{2});
+                set_parent(w, gc, child);
+            }
+        }
+    }
+}
+
+static void spawn_deep_chain(World& w, size_t n) {
+    Entity prev = w.create_with(LocalTransform{}, WorldTransform{}, MeshTag{0});
+    for (size_t i = 1; i < n; ++i) {
+        Entity e = w.create_with(LocalTransform{{0, 0.5f, 0}}, WorldTransform{},
+                                 MeshTag{int(i % 3)});
+        set_parent(w, e, prev);
+        prev = e;
+    }
+}
+
+// Agents for the spatial cases: a 200 x 200 x 10 slab, about 7 neighbours within 4 units at 10k
+static void spawn_agents(World& w, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        WorldTransform wt{};
+        wt.matrix.m[0] = wt.matrix.m[5] = wt.matrix.m[10] = wt.matrix.m[15] = 1.0f;
+        wt.matrix.m[12] = randf(-100, 100);
+        wt.matrix.m[13] = randf(-100, 100);
+        wt.matrix.m[14] = randf(-5, 5);
+        w.create_with(std::move(wt));
+    }
+}
+
+// One stress-harness frame: motion system, full propagation, instance collection
+static void scene_frame(World& w, std::vector<Mat4>& instances) {
+    const float dt = 1.0f / 60.0f;
+    w.each<Velocity, LocalTransform>([&](Entity, Velocity& v, LocalTransform& lt) {
+        lt.position.x += v.vx * dt;
+        lt.position.y += v.vy * dt;
+        lt.position.z += v.vz * dt;
+    });
+    w.each<Orbital, LocalTransform>([&](Entity, Orbital& o, LocalTransform& lt) {
+        o.angle += o.speed * dt;
+        lt.position = {std::cos(o.angle) * o.orbit_radius, 0, std::sin(o.angle) * o.orbit_radius};
+    });
+    w.each<LocalTransform, Parent>(
+        [&](Entity, LocalTransform& lt, Parent&) { lt.position.x = 0.3f; });
+    propagate_transforms(w);
+    instances.clear();
+    w.each<WorldTransform, MeshTag>(
+        [&](Entity, WorldTransform& wt, MeshTag&) { instances.push_back(wt.matrix); });
+}
+
+template <typename Spawn>
+static Case scene_case(const char* name, size_t n, Spawn spawn) {
+    return {name, n, [spawn](size_t count) {
+                World w;
+                spawn(w, count);
+                std::vector<Mat4> instances;
+                scene_frame(w, instances); // warm caches and the query cache
+                double ms = time_ms([&] { scene_frame(w, instances); });
+                g_sink = instances.empty() ? 0.0f : instances.back().m[12];
+                return ms;
+            }};
+}
+
+static void register_bench_components() {
+    register_component<F0>("F0");
+    register_component<F1>("F1");
+    register_component<F2>("F2");
+    register_component<Velocity>("Velocity");
+    register_component<LocalTransform>("LocalTransform");
+    register_component<WorldTransform>("WorldTransform");
+}
+
+static std::vector<Case> make_cases() {
+    std::vector<Case> cases;
+
+    cases.push_back({"create/create_with_3", 100000, [](size_t n) {
+                         World w;
+                         return time_ms([&] {
+                             for (size_t i = 0; i < n; ++i)
+                                 w.create_with(F0{}, F1{}, F2{});
+                         });
+                     }});
+    cases.push_back({"create/create_n_3", 100000, [](size_t n) {
+                         World w;
+                         return time_ms([&] { w.create_n(n, F0{}, F1{}, F2{}); });
+                     }});
+    cases.push_back({"destroy/destroy_3", 100000, [](size_t n) {
+                         World w;
+                         std::vector<Entity> es;
+                         for (size_t i = 0; i < n; ++i)
+                             es.push_back(w.create_with(F0{}, F1{}, F2{}));
+                         return time_ms([&] {
+                             for (Entity e : es)
+                                 w.destroy(e);
+                         });
+                     }});
+    cases.push_back({"migrate/add", 100000, [](size_t n) {
+                         World w;
+                         std::vector<Entity> es;
+                         for (size_t i = 0; i < n; ++i)
+                             es.push_back(w.create_with(F0{}, F1{}));
+                         return time_ms([&] {
+                             for (Entity e : es)
+                                 w.add(e, F2{});
+                         });
+                     }});
+    cases.push_back({"migrate/remove", 100000, [](size_t n) {
+                         World w;
+                         std::vector<Entity> es;
+                         for (size_t i = 0; i < n; ++i)
+                             es.push_back(w.create_with(F0{}, F1{}, F2{}));
+                         return time_ms([&] {
+                             for (Entity e : es)
+                                 w.remove<F2>(e);
+                         });
+                     }});
+
+    cases.push_back({"migrate/toggle_tag", 100000, [](size_t n) {
+                         World w;
+                         std::vector<Entity> es;
+                         for (size_t i = 0; i < n; ++i)
+                             es.push_back(w.create_with(LocalTransform{}, WorldTransform{},
+                                                        Velocity{}, F0{}));
+                         return time_ms([&] {
+                             for (Entity e : es)
+                                 w.add(e, Disabled{});
+                             for (Entity e : es)
+                                 w.remove<Disabled>(e);
+                         });
+                     }});
+    cases.push_back({"migrate/toggle_sparse", 100000, [](size_t n) {
+                         World w;
+                         std::vector<Entity> es;
+                         for (size_t i = 0; i < n; ++i)
+                             es.push_back(w.create_with(LocalTransform{}, WorldTransform{},
+                                                        Velocity{}, F0{}));
+                         return time_ms([&] {
+                             for (Entity e : es)
+                                 w.add(e, Stunned{});
+                             for (Entity e : es)
+                                 w.remove<Stunned>(e);
+                         });
+                     }});
+
+    // create_n with an observer on one of the components: per-entity vs batched
+    cases.push_back({"observe/on_add", 100000, [](size_t n) {
+                         World w;
+                         float sum = 0;
+                         w.on_add<F0>([&](World&, Entity, F0& f) { sum += f.v[0]; });
+                         double ms = time_ms([&] { w.create_n(n, F0{}, F1{}, F2{}); });
+                         g_sink = sum;
+                         return ms;
+                     }});
+    cases.push_back({"observe/on_add_batch", 100000, [](size_t n) {
+                         World w;
+                         float sum = 0;
+                         w.on_add_batch<F0>([&](World&, Span<const Entity> es, F0* f) {
+                             for (size_t i = 0; i < es.size(); ++i)
+                                 sum += f[i].v[0];
+                         });
+                         double ms = time_ms([&] { w.create_n(n, F0{}, F1{}, F2{}); });
+                         g_sink = sum;
+                         return ms;
+                     }});
+
+    // 1000 lookups of random keys among n entities with unique NetIds (two archetypes)
+    auto lookup_world = [](World& w, size_t n, std::vector<uint32_t>& keys) {
+        for (size_t i = 0; i < n; ++i) {
+            NetId id{static_cast<uint32_t>(i * 2654435761u)};
+            if (i % 2)
+                w.create_with(id, F0{});
+            else
+                w.create_with(id, F0{}, F1{});
+        }
+        for (int i = 0; i < 1000; ++i)
+            keys.push_back(static_cast<uint32_t>((std::rand() % n) * 2654435761u));
+    };
+    cases.push_back({"lookup/scan", 100000, [lookup_world](size_t n) {
+                         World w;
+                         std::vector<uint32_t> keys;
+                         lookup_world(w, n, keys);
+                         uint32_t found = 0;
+                         double ms = time_ms([&] {
+                             for (uint32_t key : keys)
+                                 w.each<const NetId>([&](Entity e, const NetId& id) {
+                                     if (id.value == key)
+                                         found += e.index;
+                                 });
+                         });
+                         g_sink = static_cast<float>(found);
+                         return ms;
+                     }});
+    cases.push_back({"lookup/find_by", 100000, [lookup_world](size_t n) {
+                         World w;
+                         w.index_by<NetId>(&NetId::value);
+                         std::vector<uint32_t> keys;
+                         lookup_world(w, n, keys);
+                         uint32_t found = 0;
+                         double ms = time_ms([&] {
+                             for (uint32_t key : keys)
+                                 found += w.find_by<NetId>(key).index;
+                         });
+                         g_sink = static_cast<float>(found);
+                         return ms;
+                     }});
+    cases.push_back({"lookup/index_upkeep", 100000, [](size_t n) {
+                         World w;
+                         w.index_by<NetId>(&NetId::value);
+                         double ms = time_ms([&] {
+                             for (size_t i = 0; i < n; ++i)
+                                 w.create_with(NetId{static_cast<uint32_t>(i)}, F0{});
+                             w.destroy_all<NetId>();
+                         });
+                         return ms;
+                     }});
+
+    cases.push_back({"each/1", 500000, [](size_t n) {
+                         World w;
+                         fill_wide(w, n);
+                         float sum = 0;
+                         double ms = time_ms(
+                             [&] { w.each<F0>([&](Entity, F0& a) { sum += a.v[0]; }); });
+                         g_sink = sum;
+                         return ms;
+                     }});
+    cases.push_back({"each/4", 500000, [](size_t n) {
+                         World w;
+                         fill_wide(w, n);
+                         double ms = time_ms([&] {
+                             w.each<F0, F1, F2, F3>([](Entity, F0& a, F1& b, F2& c, F3& d) {
+                                 d.v[0] = a.v[0] + b.v[0] + c.v[0];
+                             });
+                         });
+                         return ms;
+                     }});
+    cases.push_back({"each/8", 500000, [](size_t n) {
+                         World w;
+                         fill_wide(w, n);
+                         double ms = time_ms([&] {
+                             w.each<F0, F1, F2, F3, F4, F5, F6, F7>(
+                                 [](Entity, F0& a, F1& b, F2& c, F3& d, F4& e, F5& f, F6& g,
+                                    F7& h) {
+                                     h.v[0] = a.v[0] + b.v[0] + c.v[0] + d.v[0] + e.v[0] +
+                                              f.v[0] + g.v[0];
+                                 });
+                         });
+                         return ms;
+                     }});
+    cases.push_back({"each/exclude", 500000, [](size_t n) {
+                         // Four archetypes of F0; half of them carry the excluded tag
+                         World w;
+                         for (size_t i = 0; i < n; ++i) {
+                             switch (i % 4) {
+                             case 0: w.create_with(F0{{1}}); break;
+                             case 1: w.create_with(F0{{1}}, F1{}); break;
+                             case 2: w.create_with(F0{{1}}, Disabled{}); break;
+                             default: w.create_with(F0{{1}}, F1{}, Disabled{}); break;
+                             }
+                         }
+                         float sum = 0;
+                         double ms = time_ms([&] {
+                             w.each<F0>(World::Exclude<Disabled>{},
+                                        [&](Entity, F0& a) { sum += a.v[0]; });
+                         });
+                         g_sink = sum;
+                         return ms;
+                     }});
+    // 64 archetypes of F0 (every combination of six flags), iterated 1000 times per rep
+    auto fill_flags = [](World& w, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            Entity e = w.create_with(F0{{1}});
+            if (i & 1) w.add(e, Flag<0>{});
+            if (i & 2) w.add(e, Flag<1>{});
+            if (i & 4) w.add(e, Flag<2>{});
+            if (i & 8) w.add(e, Flag<3>{});
+            if (i & 16) w.add(e, Flag<4>{});
+            if (i & 32) w.add(e, Flag<5>{});
+        }
+    };
+    cases.push_back({"query/each_world", 10000, [=](size_t n) {
+                         World w;
+                         fill_flags(w, n);
+                         float sum = 0;
+                         double ms = time_ms([&] {
+                             for (int pass = 0; pass < 1000; ++pass)
+                                 w.each<F0>(World::Exclude<Disabled>{},
+                                            [&](Entity, F0& a) { sum += a.v[0]; });
+                         });
+                         g_sink = sum;
+                         return ms;
+                     }});
+    cases.push_back({"query/each_handle", 10000, [=](size_t n) {
+                         World w;
+                         fill_flags(w, n);
+                         auto q = w.query<F0>(World::Exclude<Disabled>{});
+                         float sum = 0;
+                         double ms = time_ms([&] {
+                             for (int pass = 0; pass < 1000; ++pass)
+                                 q.each([&](Entity, F0& a) { sum += a.v[0]; });
+                         });
+                         g_sink = sum;
+                         return ms;
+                     }});
+    cases.push_back({"query/count", 10000, [=](size_t n) {
+                         World w;
+                         fill_flags(w, n);
+                         size_t total = 0;
+                         double ms = time_ms([&] {
+                             for (int pass = 0; pass < 1000; ++pass)
+                                 total += w.count<F0, Flag<0>>() + w.count();
+                         });
+                         g_sink = float(total);
+                         return ms;
+                     }});
+    // Per-entity lookups in a 24-component archetype, as scripting bindings issue them
+    cases.push_back({"lookup/get_wide", 100000, [](size_t n) {
+                         World w;
+                         std::vector<Entity> es;
+                         for (size_t i = 0; i < n; ++i)
+                             es.push_back(create_wide(w, std::make_integer_sequence<int, 24>{}));
+                         const World& reader = w;
+                         float sum = 0;
+                         double ms = time_ms([&] {
+                             for (Entity e : es)
+                                 sum += reader.get<Field<21>>(e).v[0] +
+                                        reader.get<Field<2>>(e).v[0] +
+                                        reader.get<Field<13>>(e).v[0];
+                         });
+                         g_sink = sum;
+                         return ms;
+                     }});
+    // 10 gravity steps, which touch only y and vy of a 32-byte particle: whole structs vs
+    // one aligned array per field
+    cases.push_back({"lanes/gravity_aos", 100000, [](size_t n) {
+                         World w;
+                         for (size_t i = 0; i < n; ++i)
+                             w.create_with(Particle{0, randf(0, 10), 0, 0, 0, 0, 0, 1});
+                         auto q = w.query<Particle>();
+                         double ms = time_ms([&] {
+                             for (int step = 0; step < 10; ++step)
+                                 q.each_chunk([](Span<const Entity> es, Particle* p) {
+                                     for (size_t i = 0; i < es.size(); ++i) {
+                                         p[i].vy -= 9.8f * 0.016f;
+                                         p[i].y += p[i].vy * 0.016f;
+                                     }
+                                 });
+                         });
+                         g_sink = float(q.count());
+                         return ms;
+                     }});
+    cases.push_back({"lanes/gravity_split", 100000, [](size_t n) {
+                         World w;
+                         for (size_t i = 0; i < n; ++i)
+                             w.add(w.create(), SplitParticle{0, randf(0, 10), 0, 0, 0, 0, 0, 1});
+                         double ms = time_ms([&] {
+                             for (int step = 0; step < 10; ++step)
+                                 w.each_lanes<SplitParticle>(
+                                     [](Span<const Entity> es, Lanes<SplitParticle> p) {
+                                         float* y = p.lane<1>();
+                                         float* vy = p.lane<4>();
+                                         for (size_t i = 0; i < es.size(); ++i) {
+                                             vy[i] -= 9.8f * 0.016f;
+                                             y[i] += vy[i] * 0.016f;
+                                         }
+                                     });
+                         });
+                         g_sink = float(w.count<Lane<SplitParticle, 0>>());
+                         return ms;
+                     }});
+    cases.push_back({"sort/shuffled", 100000, [](size_t n) {
+                         World w;
+                         for (size_t i = 0; i < n; ++i)
+                             w.create_with(F0{{randf(0, 1)}}, F1{});
+                         return time_ms([&] {
+                             w.sort<F0>([](const F0& a, const F0& b) { return a.v[0] < b.v[0]; });
+                         });
+                     }});
+    // A sorted world where 1% of the keys change per frame: full re-sort vs maintained order
+    auto perturbed = [](size_t n, bool maintained) {
+        World w;
+        std::vector<Entity> es;
+        for (size_t i = 0; i < n; ++i)
+            es.push_back(w.create_with(F0{{randf(0, 1)}}, F1{}));
+        auto by_key = [](const F0& a, const F0& b) { return a.v[0] < b.v[0]; };
+        if (maintained)
+            w.order_by<F0>([](const F0& f) { return f.v[0]; });
+        else
+            w.sort<F0>(by_key);
+        for (size_t i = 0; i < n; i += 100)
+            w.get<F0>(es[i]).v[0] = randf(0, 1);
+        return time_ms([&] {
+            if (maintained)
+                w.refresh_order();
+            else
+                w.sort<F0>(by_key);
+        });
+    };
+    cases.push_back({"sort/resort_1pct", 100000, [=](size_t n) { return perturbed(n, false); }});
+    cases.push_back({"sort/maintained_1pct", 100000, [=](size_t n) { return perturbed(n, true); }});
+    cases.push_back({"command_buffer/flush", 100000, [](size_t n) {
+                         World w;
+                         std::vector<Entity> es;
+                         for (size_t i = 0; i < n; ++i)
+                             es.push_back(w.create_with(F0{}));
+                         CommandBuffer cb;
+                         for (size_t i = 0; i < n; ++i) {
+                             cb.add(es[i], F1{});
+                             cb.create_with(F0{}, F2{});
+                             if (i % 4 == 0)
+                                 cb.destroy(es[i]);
+                         }
+                         return time_ms([&] { cb.flush(w); });
+                     }});
+    // Recording one add per entity during iteration; the parallel case includes the merge
+    cases.push_back({"command_buffer/record_each", 100000, [](size_t n) {
+                         World w;
+                         for (size_t i = 0; i < n; ++i)
+                             w.create_with(F0{});
+                         double ms = time_ms([&] {
+                             w.each<const F0>(
+                                 [&](Entity e, const F0&) { w.deferred().add(e, F1{}); });
+                         });
+                         w.flush_deferred();
+                         return ms;
+                     }});
+    cases.push_back({"command_buffer/record_par_each", 100000, [](size_t n) {
+                         World w;
+                         for (size_t i = 0; i < n; ++i)
+                             w.create_with(F0{});
+                         ThreadPool pool(4);
+                         double ms = time_ms([&] {
+                             w.par_each<const F0>(
+                                 pool, [&](Entity e, const F0&) { w.deferred().add(e, F1{}); });
+                         });
+                         w.flush_deferred();
+                         return ms;
+                     }});
+    cases.push_back({"prefab/instantiate", 100000, [](size_t n) {
+                         World w;
+                         Prefab p = Prefab::create(F0{{1}}, F1{}, Velocity{1, 2, 3});
+                         return time_ms([&] {
+                             for (size_t i = 0; i < n; ++i)
+                                 instantiate(w, p);
+                         });
+                     }});
+    cases.push_back({"prefab/instantiate_n", 100000, [](size_t n) {
+                         World w;
+                         Prefab p = Prefab::create(F0{{1}}, F1{}, Velocity{1, 2, 3});
+                         return time_ms([&] { instantiate_n(w, p, n); });
+                     }});
+    cases.push_back({"prefab/instantiate_n_generate", 100000, [](size_t n) {
+                         World w;
+                         Prefab p = Prefab::create(F0{{1}}, F1{}, Velocity{1, 2, 3});
+                         return time_ms([&] {
+                             instantiate_n<Velocity>(w, p, n, [](size_t i) {
+                                 return std::make_tuple(Velocity{float(i), 0, 0});
+                             });
+                         });
+                     }});
+
+    auto serialize_world = [](World& w, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            if (i & 1)
+                w.create_with(LocalTransform{}, WorldTransform{}, Velocity{1, 1, 1});
+            else
+                w.create_with(F0{}, F1{}, F2{});
+        }
+    };
+    cases.push_back({"serialize/v1", 200000, [serialize_world](size_t n) {
+                         World w;
+                         serialize_world(w, n);
+                         std::stringstream ss;
+                         return time_ms([&] { serialize(w, ss); });
+                     }});
+    cases.push_back({"deserialize/v1", 200000, [serialize_world](size_t n) {
+                         World w;
+                         serialize_world(w, n);
+                         std::stringstream ss;
+                         serialize(w, ss);
+                         World r;
+                         return time_ms([&] { deserialize(r, ss); });
+                     }});
+    cases.push_back({"serialize/snapshot_v2", 200000, [serialize_world](size_t n) {
+                         World w;
+                         serialize_world(w, n);
+                         std::stringstream ss;
+                         return time_ms([&] { serialize_snapshot(w, ss); });
+                     }});
+    cases.push_back({"deserialize/snapshot_v2", 200000, [serialize_world](size_t n) {
+                         World w;
+                         serialize_world(w, n);
+                         std::stringstream ss;
+                         serialize_snapshot(w, ss);
+                         std::string bytes = ss.str();
+                         World r;
+                         return time_ms(
+                             [&] { deserialize_snapshot(r, bytes.data(), bytes.size()); });
+                     }});
+    // Steady state of a rollback ring: the checkpoint's buffers are already sized
+    cases.push_back({"checkpoint/capture", 200000, [serialize_world](size_t n) {
+                         World w;
+                         serialize_world(w, n);
+                         Checkpoint cp;
+                         cp.capture(w);
+                         return time_ms([&] { cp.capture(w); });
+                     }});
+    cases.push_back({"checkpoint/restore", 200000, [serialize_world](size_t n) {
+                         World w;
+                         serialize_world(w, n);
+                         Checkpoint cp;
+                         cp.capture(w);
+                         w.each<F0>([](Entity, F0& a) { a.v[0] += 1; });
+                         w.destroy_all<Velocity>();
+                         return time_ms([&] { cp.restore(w); });
+                     }});
+
+    // Neighbour counting for every agent: the O(n^2) scan systems do today, then the grid
+    constexpr float SPATIAL_RADIUS = 4.0f;
+    cases.push_back({"spatial/neighbours_scan", 10000, [=](size_t n) {
+                         World w;
+                         spawn_agents(w, n);
+                         size_t found = 0;
+                         double ms = time_ms([&] {
+                             w.each<const WorldTransform>([&](Entity, const WorldTransform& a) {
+                                 w.each<const WorldTransform>(
+                                     [&](Entity, const WorldTransform& b) {
+                                         float dx = a.matrix.m[12] - b.matrix.m[12];
+                                         float dy = a.matrix.m[13] - b.matrix.m[13];
+                                         float dz = a.matrix.m[14] - b.matrix.m[14];
+                                         found += dx * dx + dy * dy + dz * dz <=
+                                                  SPATIAL_RADIUS * SPATIAL_RADIUS;
+                                     });
+                             });
+                         });
+                         g_sink = float(found);
+                         return ms;
+                     }});
+    cases.push_back({"spatial/neighbours_grid", 10000, [=](size_t n) {
+                         World w;
+                         spawn_agents(w, n);
+                         SpatialGrid grid(SPATIAL_RADIUS);
+                         grid.update(w);
+                         std::vector<Entity> out;
+                         size_t found = 0;
+                         double ms = time_ms([&] {
+                             w.each<const WorldTransform>([&](Entity, const WorldTransform& a) {
+                                 Vec3 p = SpatialGrid::position_of(a.matrix);
+                                 found += grid.query_radius(p, SPATIAL_RADIUS, out).size();
+                             });
+                         });
+                         g_sink = float(found);
+                         return ms;
+                     }});
+    cases.push_back({"spatial/nearest_8", 10000, [=](size_t n) {
+                         World w;
+                         spawn_agents(w, n);
+                         SpatialGrid grid(SPATIAL_RADIUS);
+                         grid.update(w);
+                         std::vector<Entity> out;
+                         size_t found = 0;
+                         double ms = time_ms([&] {
+                             w.each<const WorldTransform>([&](Entity, const WorldTransform& a) {
+                                 Vec3 p = SpatialGrid::position_of(a.matrix);
+                                 found += grid.query_nearest(p, 8, out).size();
+                             });
+                         });
+                         g_sink = float(found);
+                         return ms;
+                     }});
+    cases.push_back({"spatial/build", 100000, [=](size_t n) {
+                         World w;
+                         spawn_agents(w, n);
+                         SpatialGrid grid(SPATIAL_RADIUS);
+                         return time_ms([&] { grid.update(w); });
+                     }});
+    // 10% of the agents move half a cell: most stay in their cell, some cross a boundary
+    cases.push_back({"spatial/update_10pct", 100000, [=](size_t n) {
+                         World w;
+                         spawn_agents(w, n);
+                         SpatialGrid grid(SPATIAL_RADIUS);
+                         grid.update(w);
+                         w.advance_tick(); // frame boundary
+                         std::vector<Entity> movers;
+                         w.each<const WorldTransform>([&](Entity e, const WorldTransform&) {
+                             if (e.index % 10 == 0)
+                                 movers.push_back(e);
+                         });
+                         for (Entity e : movers)
+                             w.get<WorldTransform>(e).matrix.m[12] += 0.5f * SPATIAL_RADIUS;
+                         return time_ms([&] { grid.update(w); });
+                     }});
+
+    cases.push_back(scene_case("scene/flat_swarm", 100000,
+                               [](World& w, size_t n) { spawn_flat(w, n, false); }));
+    cases.push_back(scene_case("scene/wide_swarm", 100000,
+                               [](World& w, size_t n) { spawn_flat(w, n, true); }));
+    cases.push_back(scene_case("scene/shallow_tree", 100000, spawn_shallow_trees));
+    cases.push_back(scene_case("scene/deep_chain", 10000, spawn_deep_chain));
+    return cases;
+}
+
+// ---------------------------------------------------------------------------
+// Reporting
+// ---------------------------------------------------------------------------
+
+struct Result {
+    const char* name;
+    size_t n;
+    std::vector<double> samples; // sorted
+    double min() const { return samples.front(); }
+    double median() const { return samples[(samples.size() - 1) / 2]; }
+    double mean() const {
+        double total = 0;
+        for (double s : samples)
+            total += s;
+        return total / samples.size();
+    }
+    double ns_per_entity() const { return n ? median() * 1e6 / n : 0.0; }
+};
+
+static void report_text(std::FILE* out, const std::vector<Result>& results) {
+    std::fprintf(out, "%-26s %9s %11s %11s %11s %9s\n", "benchmark", "n", "min ms", "median ms",
+                 "mean ms", "ns/ent");
+    for (auto& r : results)
+        std::fprintf(out, "%-26s %9zu %11.3f %11.3f %11.3f %9.2f\n", r.name, r.n, r.min(),
+                     r.median(), r.mean(), r.ns_per_entity());
+}
+
+static void report_csv(std::FILE* out, const std::vector<Result>& results) {
+    std::fprintf(out, "benchmark,n,reps,min_ms,median_ms,mean_ms,ns_per_entity\n");
+    for (auto& r : results)
+        std::fprintf(out, "%s,%zu,%zu,%.6f,%.6f,%.6f,%.4f\n", r.name, r.n, r.samples.size(),
+                     r.min(), r.median(), r.mean(), r.ns_per_entity());
+}
+
+static void report_json(std::FILE* out, const std::vector<Result>& results, double scale) {
+    std::fprintf(out, "{\n  \"suite\": \"ecs_bench\",\n  \"schema\": 1,\n");
+#if defined(__VERSION__)
+    std::fprintf(out, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    std::fprintf(out, "  \"simd\": \"%s\",\n  \"scale\": %g,\n  \"results\": [\n",
+                 mat4_batch_backend(), scale);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(out,
+                     "    {\"name\": \"%s\", \"n\": %zu, \"reps\": %zu, \"min_ms\": %.6f, "
+                     "\"median_ms\": %.6f, \"mean_ms\": %.6f, \"ns_per_entity\": %.4f}%s\n",
+                     r.name, r.n, r.samples.size(), r.min(), r.median(), r.mean(),
+                     r.ns_per_entity(), i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+static void usage() {
+    std::fprintf(stderr,
+                 "usage: ecs_bench [--filter=SUBSTR] [--format=text|json|csv] [--out=PATH]\n"
+                 "                 [--reps=N] [--scale=F] [--list]\n");
+}
+
+int main(int argc, char** argv) {
+    std::string filter, format = "text", out_path;
+    int reps = 5;
+    double scale = 1.0;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        auto value = [&](const char* flag) -> const char* {
+            size_t len = std::strlen(flag);
+            return std::strncmp(a, flag, len) == 0 && a[len] == '=' ? a + len + 1 : nullptr;
+        };
+        if (const char* v = value("--filter"))
+            filter = v;
+        else if (const char* v = value("--format"))
+            format = v;
+        else if (const char* v = value("--out"))
+            out_path = v;
+        else if (const char* v = value("--reps"))
+            reps = std::max(1, std::atoi(v));
+        else if (const char* v = value("--scale"))
+            scale = std::atof(v);
+        else if (std::strcmp(a, "--list") == 0)
+            list = true;
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if ((format != "text" && format != "json" && format != "csv") || !(scale > 0)) {
+        usage();
+        return 2;
+    }
+
+    register_bench_components();
+    std::vector<Case> cases = make_cases();
+    if (list) {
+        for (auto& c : cases)
+            std::printf("%s\n", c.name);
+        return 0;
+    }
+
+    std::vector<Result> results;
+    for (auto& c : cases) {
+        if (!filter.empty() && std::strstr(c.name, filter.c_str()) == nullptr)
+            continue;
+        size_t n = std::max<size_t>(1, static_cast<size_t>(c.base_n * scale));
+        Result r{c.name, n, {}};
+        std::srand(12345);
+        for (int i = 0; i < reps; ++i)
+            r.samples.push_back(c.run(n));
+        std::sort(r.samples.begin(), r.samples.end());
+        results.push_back(std::move(r));
+        std::fprintf(stderr, "  %s: %.3f ms\n", c.name, results.back().median());
+    }
+
+    std::FILE* out = stdout;
+    if (!out_path.empty()) {
+        out = std::fopen(out_path.c_str(), "w");
+        if (!out) {
+            std::fprintf(stderr, "ecs_bench: cannot open %s\n", out_path.c_str());
+            return 1;
+        }
+    }
+    if (format == "json")
+        report_json(out, results, scale);
+    else if (format == "csv")
+        report_csv(out, results);
+    else
+        report_text(out, results);
+    if (out != stdout)
+        std::fclose(out);
+    return 0;
+}
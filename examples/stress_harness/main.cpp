@@ -119,6 +119,8 @@ static int current_count = 0;
 
 static bool paused = false;
 static bool show_help = true;
+static bool incremental_propagation = false;
+static ecs::TransformPropagator propagator;
 static bool auto_ramp = false;
 static int auto_ramp_cliff = 0;
 
@@ -504,9 +506,13 @@ static void handle_input() {
         if (auto_ramp) auto_ramp_cliff = 0;
     }
 
-    // P: pause, H: help
+    // P: pause, H: help, I: incremental propagation
     if (IsKeyPressed(KEY_P)) paused = !paused;
     if (IsKeyPressed(KEY_H)) show_help = !show_help;
+    if (IsKeyPressed(KEY_I)) {
+        incremental_propagation = !incremental_propagation;
+        propagator.invalidate();
+    }
 }
 
 // ---------------------------------------------------------------------------
@@ -575,6 +581,11 @@ static void draw_ui() {
         y += 24;
     }
 
+    snprintf(buf, sizeof(buf), "Propagation: %s",
+             incremental_propagation ? "incremental" : "full BFS");
+    DrawText(buf, 10, y, 20, WHITE);
+    y += 24;
+
     if (paused) {
         DrawText("PAUSED", 10, y, 20, ORANGE);
         y += 24;
@@ -606,6 +617,7 @@ static void draw_ui() {
         DrawText("  Left/Right Switch stress mode", 10, y, 16, LIGHTGRAY); y += 18;
         DrawText("  Home       Auto-ramp to 60fps cliff", 10, y, 16, LIGHTGRAY); y += 18;
         DrawText("  P          Pause motion", 10, y, 16, LIGHTGRAY); y += 18;
+        DrawText("  I          Toggle incremental propagation", 10, y, 16, LIGHTGRAY); y += 18;
         DrawText("  H          Toggle help", 10, y, 16, LIGHTGRAY); y += 18;
     }
 }
@@ -664,7 +676,11 @@ int main() {
         double t1 = GetTime();
 
         // --- Transform propagation ---
-        ecs::propagate_transforms(world);
+        if (incremental_propagation)
+            propagator.run(world);
+        else
+            ecs::propagate_transforms(world);
+        world.advance_tick(); // end the frame's change tick; the propagator sees later writes
         double t2 = GetTime();
 
         // --- Drawing ---
@@ -0,0 +1,249 @@
+#pragma once
+
+#include "component.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @file allocator.hpp
+ * @brief Pluggable allocation for archetype storage, command buffers and prefabs.
+ */
+
+namespace ecs {
+
+/**
+ * @brief Allocation interface used for archetype blocks/chunks, `CommandBuffer` storage and
+ * `Prefab` data.
+ * @details Function pointers plus a context pointer, so any pool or arena can be plugged in
+ * without virtual dispatch. `deallocate` receives the same `bytes` and `align` passed to the
+ * matching `allocate`. An allocator shared between Worlds may be called concurrently, so shared
+ * implementations must be thread-safe.
+ * Allocation failure is fatal (asserted by callers); there is no null-return path.
+ * `trim` is optional: it releases memory the allocator keeps cached, and is called by
+ * `World::compact`.
+ */
+struct Allocator {
+    void* user = nullptr;
+    void* (*allocate)(void* user, size_t bytes, size_t align) = nullptr;
+    void (*deallocate)(void* user, void* ptr, size_t bytes, size_t align) = nullptr;
+    void (*trim)(void* user) = nullptr;
+};
+
+/**
+ * @brief Thread-safe size-class pool for large, long-lived blocks.
+ * @details Requests are rounded up to one of four classes per power of two (at most 25%
+ * slack) between `MIN_CLASS` and `MAX_CLASS`; larger requests go straight to the system
+ * allocator. Freed blocks are kept on their class's free list (one mutex per class) until
+ * `retain_bytes` are cached, then returned to the system. Every block is `ALIGN`-aligned.
+ * Requests for a stricter alignment bypass the pool and go to aligned `operator new`.
+ * Blocks must be returned to the pool that allocated them, and the pool must outlive them.
+ */
+class BlockPool {
+public:
+    static constexpr size_t ALIGN = 64;
+    static constexpr size_t MIN_CLASS = 256;
+    static constexpr size_t MAX_CLASS = size_t(1) << 30;
+
+    /** @param retain_bytes Upper bound on the bytes kept cached for reuse. */
+    explicit BlockPool(size_t retain_bytes = size_t(256) << 20)
+        : retain_bytes_(retain_bytes), classes_(class_index(MAX_CLASS) + 1) {
+        allocator_.user = this;
+        allocator_.allocate = [](void* self, size_t bytes, size_t align) {
+            return static_cast<BlockPool*>(self)->allocate(bytes, align);
+        };
+        allocator_.deallocate = [](void* self, void* ptr, size_t bytes, size_t align) {
+            static_cast<BlockPool*>(self)->deallocate(ptr, bytes, align);
+        };
+        allocator_.trim = [](void* self) { static_cast<BlockPool*>(self)->trim(); };
+    }
+
+    ~BlockPool() { trim(); }
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    /** @brief Returns an `Allocator` bound to this pool, valid for the pool's lifetime. */
+    const Allocator& allocator() const { return allocator_; }
+
+    void* allocate(size_t bytes, size_t align) {
+        if (align > ALIGN)
+            return ::operator new(bytes, std::align_val_t(align));
+        if (bytes > MAX_CLASS)
+            return system_alloc(align_up(bytes));
+        size_t index = class_index(bytes);
+        SizeClass& sc = classes_[index];
+        {
+            std::lock_guard<std::mutex> lock(sc.mutex);
+            if (!sc.free.empty()) {
+                void* p = sc.free.back();
+                sc.free.pop_back();
+                cached_bytes_.fetch_sub(class_size(index), std::memory_order_relaxed);
+                reused_.fetch_add(1, std::memory_order_relaxed);
+                return p;
+            }
+        }
+        return system_alloc(class_size(index));
+    }
+
+    void deallocate(void* ptr, size_t bytes, size_t align) {
+        if (!ptr)
+            return;
+        if (align > ALIGN) {
+            ::operator delete(ptr, std::align_val_t(align));
+            return;
+        }
+        if (bytes > MAX_CLASS) {
+            std::free(ptr);
+            return;
+        }
+        size_t index = class_index(bytes);
+        size_t size = class_size(index);
+        if (cached_bytes_.fetch_add(size, std::memory_order_relaxed) + size > retain_bytes_) {
+            cached_bytes_.fetch_sub(size, std::memory_order_relaxed);
+            std::free(ptr);
+            return;
+        }
+        SizeClass& sc = classes_[index];
+        std::lock_guard<std::mutex> lock(sc.mutex);
+        sc.free.push_back(ptr);
+    }
+
+    /** @brief Returns every cached block to the system allocator. */
+    void trim() {
+        for (size_t i = 0; i < classes_.size(); ++i) {
+            std::lock_guard<std::mutex> lock(classes_[i].mutex);
+            for (void* p : classes_[i].free)
+                std::free(p);
+            cached_bytes_.fetch_sub(classes_[i].free.size() * class_size(i),
+                                    std::memory_order_relaxed);
+            classes_[i].free.clear();
+            classes_[i].free.shrink_to_fit();
+        }
+    }
+
+    /** @brief Bytes currently cached on the free lists. */
+    size_t cached_bytes() const { return cached_bytes_.load(std::memory_order_relaxed); }
+
+    /** @brief Number of allocations served from a free list instead of the system. */
+    uint64_t reused() const { return reused_.load(std::memory_order_relaxed); }
+
+    /** @brief The byte size a request of `bytes` occupies (its class size). */
+    static size_t rounded_size(size_t bytes) {
+        return bytes > MAX_CLASS ? align_up(bytes) : class_size(class_index(bytes));
+    }
+
+private:
+    struct SizeClass {
+        std::mutex mutex;
+        std::vector<void*> free;
+    };
+
+    size_t retain_bytes_;
+    std::vector<SizeClass> classes_;
+    std::atomic<size_t> cached_bytes_{0};
+    std::atomic<uint64_t> reused_{0};
+    Allocator allocator_;
+
+    // Sizes are in units of MIN_CLASS / 4. Class 0 is MIN_CLASS; class k >= 1 is
+    // (4 + s) << l units with l = (k - 1) / 4 and s = (k - 1) % 4 + 1.
+    static size_t class_index(size_t bytes) {
+        if (bytes <= MIN_CLASS)
+            return 0;
+        size_t units = (bytes + MIN_CLASS / 4 - 1) / (MIN_CLASS / 4); // >= 5
+        size_t log = 0;
+        while ((size_t(8) << log) < units)
+            ++log; // units in (4 << log, 8 << log]
+        size_t step = size_t(1) << log;
+        size_t sub = (units - (size_t(4) << log) + step - 1) / step; // 1..4
+        return log * 4 + sub;
+    }
+
+    static size_t class_size(size_t index) {
+        size_t log = index == 0 ? 0 : (index - 1) / 4;
+        size_t sub = index == 0 ? 0 : (index - 1) % 4 + 1;
+        return ((size_t(4) + sub) << log) * (MIN_CLASS / 4);
+    }
+
+    static size_t align_up(size_t bytes) { return (bytes + ALIGN - 1) & ~(ALIGN - 1); }
+
+    static void* system_alloc(size_t bytes) {
+        void* p = std::aligned_alloc(ALIGN, bytes);
+        ECS_ASSERT(p, "BlockPool: out of memory");
+        return p;
+    }
+};
+
+/** @brief Bytes the process-wide default pool keeps cached (see `default_block_pool`). */
+inline constexpr size_t DEFAULT_POOL_RETAIN = size_t(16) << 20;
+
+/**
+ * @brief The process-wide pool used when no allocator is configured.
+ * @details Shared by every World, so storage freed by one world is recycled by the
+ * next. It caches at most `DEFAULT_POOL_RETAIN` bytes, and `World::compact` empties the
+ * cache, so freed storage goes back to the system. Intentionally never destroyed, so Worlds
+ * with static storage duration can still release into it during exit.
+ */
+inline BlockPool& default_block_pool() {
+    static BlockPool* pool = new BlockPool(DEFAULT_POOL_RETAIN);
+    return *pool;
+}
+
+/** @brief `default_block_pool().allocator()`. */
+inline const Allocator& default_allocator() { return default_block_pool().allocator(); }
+
+/**
+ * @brief Standard-library allocator adapter over an `Allocator`, for byte buffers.
+ * @details Always requests at least `alignof(std::max_align_t)`, since buffers place aligned
+ * records at offsets from their start. Propagates on move, copy and swap, so buffers can be
+ * exchanged freely between owners using different allocators.
+ */
+template <typename T>
+struct StlAllocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    const Allocator* alloc;
+
+    StlAllocator() noexcept : alloc(&default_allocator()) {}
+    explicit StlAllocator(const Allocator* a) noexcept : alloc(a ? a : &default_allocator()) {}
+    template <typename U>
+    StlAllocator(const StlAllocator<U>& o) noexcept : alloc(o.alloc) {}
+
+    T* allocate(size_t n) {
+        void* p = alloc->allocate(alloc->user, n * sizeof(T), buffer_align());
+        ECS_ASSERT(p, "allocator returned null");
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        alloc->deallocate(alloc->user, p, n * sizeof(T), buffer_align());
+    }
+
+    template <typename U>
+    bool operator==(const StlAllocator<U>& o) const noexcept {
+        return alloc == o.alloc;
+    }
+    template <typename U>
+    bool operator!=(const StlAllocator<U>& o) const noexcept {
+        return alloc != o.alloc;
+    }
+
+private:
+    static constexpr size_t buffer_align() {
+        return std::max(alignof(T), alignof(std::max_align_t));
+    }
+};
+
+/** @brief Byte buffer backed by an `Allocator` (CommandBuffer and Prefab storage). */
+using ByteBuffer = std::vector<uint8_t, StlAllocator<uint8_t>>;
+
+} // namespace ecs
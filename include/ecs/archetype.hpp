@@ -1,9 +1,13 @@
 #pragma once
+#include "allocator.hpp"
 #include "component.hpp"
+#include "component_mask.hpp"
 #include "entity.hpp"
+#include "profile.hpp"
 
 #include <algorithm>
-#include <bitset>
+#include <cstdint>
+#include <cstring>
 #include <unordered_map>
 #include <vector>
 
@@ -53,16 +57,22 @@ struct ArchetypeEdge {
  * Structure-of-Arrays (SoA) layout (via `ComponentColumn`). This ensures high cache locality
  * when iterating over components of a specific type.
  *
- * Memory is managed in a single large block (`block_`) which is subdivided among the columns.
- * When the capacity is exceeded, the entire block is reallocated and data is migrated.
+ * Memory is managed in one of two layouts:
+ * - **Block** (default): a single large block subdivided among the columns. When the capacity is
+ *   exceeded, the entire block is reallocated at 2x and data is migrated.
+ * - **Chunked**: a list of fixed-size chunks, each holding an SoA slice of every column. Growth
+ *   allocates one more chunk and never moves existing rows, so component pointers stay stable.
  */
 struct Archetype {
+    /** @brief Minimum alignment of each column's storage (raised by `column_alignment<T>`). */
     static constexpr size_t CHUNK_ALIGN = 16;
+    /** @brief Target byte size of one row range (initial allocation, parallel work unit). */
+    static constexpr size_t CHUNK_BYTES = 16384;
 
     /** @brief The sorted list of component types this archetype stores. */
     TypeSet type_set;
-    /** @brief Bitset for fast component presence checks (optimization for small ID counts). */
-    std::bitset<256> component_bits;
+    /** @brief Signature mask for fast component presence checks and query matching. */
+    ComponentMask component_bits;
     /** @brief Sorted flat storage of component columns, keyed by component ID. */
     std::vector<std::pair<ComponentTypeID, ComponentColumn>> columns;
     /** @brief List of entities currently stored in this archetype. */
@@ -74,6 +84,27 @@ struct Archetype {
      */
     std::vector<std::pair<ComponentTypeID, ArchetypeEdge>> edges;
 
+    /** @brief Bookkeeping for a maintained row order (see `World::order_by`). */
+    struct OrderState {
+        bool rows_moved = true; // rows were appended or moved since the last refresh
+        size_t rows = 0;        // row count at the last refresh
+        uint32_t tick = 0;      // change tick of the last refresh
+    };
+    /** @brief Lets `World::refresh_order` skip archetypes whose rows kept their places. */
+    OrderState order;
+
+    /**
+     * @brief Whether any component here has add (resp. remove) observers in the owning World.
+     * @details Lets structural changes skip observer dispatch with one branch per entity.
+     */
+    bool observed_add = false;
+    bool observed_remove = false;
+
+#if defined(ECS_PROFILE)
+    /** @brief Owning World's counters for storage growth; null for standalone archetypes. */
+    ProfileCounters* profile = nullptr;
+#endif
+
     Archetype() = default;
 
     /**
@@ -83,7 +114,7 @@ struct Archetype {
     ~Archetype() {
         for (auto& [id, col] : columns)
             col.destroy_all();
-        std::free(block_);
+        release_blocks();
     }
 
     Archetype(Archetype&& o) noexcept
@@ -92,9 +123,21 @@ struct Archetype {
           columns(std::move(o.columns)),
           entities(std::move(o.entities)),
           edges(std::move(o.edges)),
-          block_(o.block_),
-          capacity_(o.capacity_) {
-        o.block_ = nullptr;
+          order(o.order),
+          observed_add(o.observed_add),
+          observed_remove(o.observed_remove),
+          column_slots_(std::move(o.column_slots_)),
+          blocks_(std::move(o.blocks_)),
+          allocator_(o.allocator_),
+          block_bytes_(o.block_bytes_),
+          capacity_(o.capacity_),
+          chunked_(o.chunked_),
+          chunk_bytes_(o.chunk_bytes_),
+          chunk_shift_(o.chunk_shift_) {
+#if defined(ECS_PROFILE)
+        profile = o.profile;
+#endif
+        o.blocks_.clear();
         o.capacity_ = 0;
     }
 
@@ -102,15 +145,27 @@ struct Archetype {
         if (this != &o) {
             for (auto& [id, col] : columns)
                 col.destroy_all();
-            std::free(block_);
+            release_blocks();
             type_set = std::move(o.type_set);
             component_bits = o.component_bits;
             columns = std::move(o.columns);
             entities = std::move(o.entities);
             edges = std::move(o.edges);
-            block_ = o.block_;
+            order = o.order;
+            observed_add = o.observed_add;
+            observed_remove = o.observed_remove;
+            column_slots_ = std::move(o.column_slots_);
+            blocks_ = std::move(o.blocks_);
+            allocator_ = o.allocator_;
+            block_bytes_ = o.block_bytes_;
             capacity_ = o.capacity_;
-            o.block_ = nullptr;
+            chunked_ = o.chunked_;
+            chunk_bytes_ = o.chunk_bytes_;
+            chunk_shift_ = o.chunk_shift_;
+#if defined(ECS_PROFILE)
+            profile = o.profile;
+#endif
+            o.blocks_.clear();
             o.capacity_ = 0;
         }
         return *this;
@@ -122,22 +177,113 @@ struct Archetype {
     /** @brief Returns the number of entities in this archetype. */
     size_t count() const { return entities.size(); }
 
+    /** @brief Allocated row capacity (all chunks). */
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Switches this archetype to chunked storage. Must be called before the first row.
+     * @param chunk_bytes Byte budget of one chunk (all columns of `chunk_rows()` rows).
+     */
+    void set_chunked_storage(size_t chunk_bytes) {
+        ECS_ASSERT(capacity_ == 0, "set_chunked_storage: archetype already allocated");
+        ECS_ASSERT(chunk_bytes > 0, "set_chunked_storage: chunk size must be non-zero");
+        chunked_ = true;
+        chunk_bytes_ = chunk_bytes;
+    }
+
+    /**
+     * @brief Selects the allocator for this archetype's blocks/chunks. Must be called before
+     * the first row; the allocator must outlive the archetype.
+     */
+    void set_allocator(const Allocator* allocator) {
+        ECS_ASSERT(capacity_ == 0, "set_allocator: archetype already allocated");
+        allocator_ = allocator ? allocator : &default_allocator();
+    }
+
+    /** @brief Checks whether this archetype uses chunked storage. */
+    bool chunked() const { return chunked_; }
+
+    /**
+     * @brief Number of rows whose components fit in one chunk.
+     * @details Block storage: `CHUNK_BYTES / row_size`, at least 16 (the initial capacity).
+     * Chunked storage: the same ratio for the configured chunk size, rounded down to a power of
+     * two (at least 1) so row lookup is a shift and mask. Also the unit of work for
+     * `World::par_each`.
+     */
+    size_t chunk_rows() const {
+        size_t row_size = 0;
+        for (auto& [cid, col] : columns)
+            row_size += col.elem_size;
+        if (!chunked_) {
+            size_t rows = (row_size > 0) ? CHUNK_BYTES / row_size : 64;
+            return rows < 16 ? 16 : rows;
+        }
+        size_t rows = (row_size > 0) ? chunk_bytes_ / row_size : 64;
+        size_t pow2 = 1;
+        while (pow2 * 2 <= rows)
+            pow2 *= 2;
+        return pow2;
+    }
+
+    /** @brief Number of allocated storage chunks (block storage has at most one). */
+    size_t chunk_count() const { return blocks_.size(); }
+
+    /**
+     * @brief Invokes `fn(first_row, length)` for each chunk-contiguous run of rows in
+     * `[begin, end)`.
+     * @details Within a run, every column's elements are contiguous, so callers can resolve
+     * column pointers once per run and index linearly. Block storage yields a single run.
+     */
+    template <typename Func>
+    void for_each_run(size_t begin, size_t end, Func&& fn) const {
+        while (begin < end) {
+            size_t chunk_end = ((begin >> chunk_shift_) + 1) << chunk_shift_;
+            size_t run_end = std::min(end, chunk_end);
+            fn(begin, run_end - begin);
+            begin = run_end;
+        }
+    }
+
     /** @brief Checks if this archetype contains the specified component type. */
-    bool has_component(ComponentTypeID id) const { return find_column(id) != nullptr; }
+    bool has_component(ComponentTypeID id) const { return component_bits.test(id); }
+
+    /** @brief `column_slot` result for a component this archetype does not have. */
+    static constexpr size_t NO_SLOT = SIZE_MAX;
+
+    /**
+     * @brief Builds the table behind `column_slot`. Call once `columns` is final (the World
+     * does so when it creates the archetype).
+     */
+    void index_columns() {
+        ECS_ASSERT(columns.size() < NO_COLUMN, "index_columns: too many columns");
+        column_slots_.assign(columns.empty() ? 0 : columns.back().first + 1, NO_COLUMN);
+        for (size_t i = 0; i < columns.size(); ++i)
+            column_slots_[columns[i].first] = static_cast<uint16_t>(i);
+    }
 
-    /** @brief Linear scan lookup of a column by component ID. */
+    /**
+     * @brief Index into `columns` of component `id`, or `NO_SLOT`.
+     * @details One load from a table indexed by component ID, sized to this archetype's largest
+     * ID (two bytes per ID). Constant time regardless of the number of columns.
+     * @warning Asserts if `columns` is non-empty but `index_columns()` has not been called.
+     */
+    size_t column_slot(ComponentTypeID id) const {
+        ECS_ASSERT(!column_slots_.empty() || columns.empty(),
+                   "column_slot: call index_columns() after filling columns");
+        if (id >= column_slots_.size() || column_slots_[id] == NO_COLUMN)
+            return NO_SLOT;
+        return column_slots_[id];
+    }
+
+    /** @brief Constant-time lookup of a column by component ID (see `column_slot`). */
     ComponentColumn* find_column(ComponentTypeID id) {
-        for (auto& [cid, col] : columns)
-            if (cid == id)
-                return &col;
-        return nullptr;
+        size_t slot = column_slot(id);
+        return slot == NO_SLOT ? nullptr : &columns[slot].second;
     }
 
     const ComponentColumn* find_column(ComponentTypeID id) const {
-        for (auto& [cid, col] : columns)
-            if (cid == id)
-                return &col;
-        return nullptr;
+        size_t slot = column_slot(id);
+        return slot == NO_SLOT ? nullptr : &columns[slot].second;
     }
 
     /** @brief Linear scan lookup of an edge by component ID. */
@@ -159,8 +305,12 @@ struct Archetype {
 
     /** @brief Debug assertion to verify all columns have the same count as the entity list. */
     void assert_parity() const {
-        for (auto& [id, col] : columns)
+        for (auto& [id, col] : columns) {
             ECS_ASSERT(col.count == entities.size(), "entity-column parity violated");
+            ECS_ASSERT(col.added_ticks.size() == col.count && col.changed_ticks.size() == col.count &&
+                           col.block_changed_ticks.size() == ComponentColumn::tick_blocks(col.count),
+                       "column tick parity violated");
+        }
     }
 
     /**
@@ -172,6 +322,7 @@ struct Archetype {
     void push_entity(Entity e) {
         ensure_capacity(count() + 1);
         entities.push_back(e);
+        order.rows_moved = true;
     }
 
     /**
@@ -182,22 +333,80 @@ struct Archetype {
      * @return The Entity that was moved into `row` (the one that was previously last), or
      * INVALID_ENTITY if the removed entity was the last one.
      */
-    Entity swap_remove(size_t row) {
+    Entity swap_remove(size_t row) { return swap_remove(row, ComponentMask{}); }
+
+    /**
+     * @brief `swap_remove` after the row's components in `relocated` were moved out (by
+     * `ComponentColumn::push_moved`); only the remaining columns destroy their element.
+     */
+    Entity swap_remove(size_t row, const ComponentMask& relocated) {
         Entity swapped = INVALID_ENTITY;
         if (row < entities.size() - 1) {
             swapped = entities.back();
             entities[row] = entities.back();
+            order.rows_moved = true;
         }
         entities.pop_back();
         for (auto& [id, col] : columns)
-            col.swap_remove(row);
+            col.swap_remove(row, relocated.test(id));
         assert_parity();
         return swapped;
     }
 
     /**
-     * @brief Resizes the underlying memory block to hold at least `needed` elements.
-     * @details If reallocation is required, all existing components are moved to the new block.
+     * @brief Removes several rows at once, filling the holes from the tail.
+     * @details Equivalent to one `swap_remove` per row, but each column is compacted in a single
+     * pass. Columns whose ID is set in `relocated` must already have had the removed rows moved
+     * out (their storage is dead and is not destroyed again); other columns are destroyed.
+     * @param rows Distinct row indices, sorted ascending.
+     * @param relocated Component IDs whose removed rows were already moved out.
+     * @param on_move Called as `on_move(entity, new_row)` for each entity moved into a hole.
+     */
+    template <typename OnMove>
+    void remove_rows(const std::vector<size_t>& rows, const ComponentMask& relocated,
+                     OnMove&& on_move) {
+        if (rows.empty())
+            return;
+        size_t n = count();
+        size_t new_n = n - rows.size();
+        // Holes are removed rows below new_n; sources are surviving rows at or above it.
+        size_t holes = std::lower_bound(rows.begin(), rows.end(), new_n) - rows.begin();
+        std::vector<std::pair<size_t, size_t>> moves; // (hole, source)
+        moves.reserve(holes);
+        size_t tail_removed = holes;
+        for (size_t src = new_n; src < n && moves.size() < holes; ++src) {
+            if (tail_removed < rows.size() && rows[tail_removed] == src) {
+                ++tail_removed;
+                continue;
+            }
+            moves.push_back({rows[moves.size()], src});
+        }
+
+        for (auto& [cid, col] : columns) {
+            if (!relocated.test(cid) && !col.trivially_destructible) {
+                for (size_t row : rows)
+                    col.destroy_fn(col.get(row));
+            }
+            for (auto& [hole, src] : moves) {
+                col.relocate_elem(col.get(hole), col.get(src));
+                col.move_ticks(hole, src);
+            }
+            col.count = new_n;
+            col.truncate_ticks(new_n);
+        }
+        for (auto& [hole, src] : moves) {
+            entities[hole] = entities[src];
+            on_move(entities[hole], hole);
+        }
+        entities.resize(new_n);
+        order.rows_moved = true;
+        assert_parity();
+    }
+
+    /**
+     * @brief Grows storage to hold at least `needed` elements.
+     * @details Block storage reallocates and moves all existing components to the new block.
+     * Chunked storage appends chunks; existing components are never moved.
      * @param needed Minimum capacity required.
      */
     void ensure_capacity(size_t needed) {
@@ -205,56 +414,197 @@ struct Archetype {
             return;
         if (columns.empty())
             return;
+        if (chunked_) {
+            grow_chunks(needed);
+            return;
+        }
 
         size_t new_cap;
         if (capacity_ == 0) {
-            static constexpr size_t CHUNK_BYTES = 16384;
-            size_t row_size = 0;
-            for (auto& [cid, col] : columns)
-                row_size += col.elem_size;
-            new_cap = (row_size > 0) ? CHUNK_BYTES / row_size : 64;
-            if (new_cap < 16)
-                new_cap = 16;
+            new_cap = chunk_rows();
         } else {
             new_cap = capacity_ * 2;
         }
         if (new_cap < needed)
             new_cap = needed;
+        relocate_block(new_cap);
+    }
+
+    /**
+     * @brief Releases storage beyond `count()` rows.
+     * @details Block storage reallocates to exactly `count()` rows, moving every component (as
+     * growth does). Chunked storage frees trailing empty chunks; rows never move. An empty
+     * archetype releases all of its storage. Tick and entity vectors are shrunk as well.
+     * @return Whether any row storage was released.
+     */
+    bool shrink_to_fit() {
+        size_t n = count();
+        entities.shrink_to_fit();
+        for (auto& [cid, col] : columns) {
+            col.added_ticks.shrink_to_fit();
+            col.changed_ticks.shrink_to_fit();
+            col.block_changed_ticks.shrink_to_fit();
+        }
+        if (capacity_ == n)
+            return false;
+        if (n == 0) {
+            release_blocks();
+            for (auto& [cid, col] : columns) {
+                col.chunks.clear();
+                col.capacity = 0;
+            }
+            capacity_ = 0;
+            return true;
+        }
+        if (!chunked_) {
+            relocate_block(n);
+            return true;
+        }
+        size_t rows = size_t(1) << chunk_shift_;
+        size_t keep = (n + rows - 1) / rows;
+        bool released = blocks_.size() > keep;
+        while (blocks_.size() > keep) {
+            free_block(blocks_.back());
+            blocks_.pop_back();
+            for (auto& [cid, col] : columns) {
+                col.chunks.pop_back();
+                col.capacity -= rows;
+            }
+            capacity_ -= rows;
+        }
+        return released;
+    }
+
+private:
+    static constexpr uint16_t NO_COLUMN = UINT16_MAX;
+    std::vector<uint16_t> column_slots_; // component ID -> index into columns, or NO_COLUMN
+    std::vector<uint8_t*> blocks_; // block storage: at most one; chunked: one per chunk
+    const Allocator* allocator_ = &default_allocator();
+    size_t block_bytes_ = 0; // byte size of every entry of blocks_ (returned on release)
+    size_t capacity_ = 0;
+    bool chunked_ = false;
+    size_t chunk_bytes_ = CHUNK_BYTES;
+    uint32_t chunk_shift_ = ComponentColumn::BLOCK_SHIFT;
 
+    // Block storage: moves every column into one new block of `new_cap` rows (>= count()).
+    void relocate_block(size_t new_cap) {
         size_t total = block_size_for(new_cap);
-        uint8_t* new_block = static_cast<uint8_t*>(std::malloc(total));
+        uint8_t* new_block = allocate_block(total);
 
         size_t offset = 0;
         for (auto& [cid, col] : columns) {
-            offset = align_up(offset, CHUNK_ALIGN);
+            if (col.tag) {
+                col.chunks.assign(1, ComponentColumn::tag_storage());
+                col.capacity = new_cap;
+                continue;
+            }
+            offset = align_up(offset, column_align(col));
             uint8_t* new_data = new_block + offset;
-            if (col.data) {
-                for (size_t i = 0; i < col.count; ++i)
-                    col.move_fn(new_data + i * col.elem_size, col.data + i * col.elem_size);
+            if (!col.chunks.empty()) {
+                if (col.trivially_relocatable) {
+                    if (col.count > 0)
+                        std::memcpy(new_data, col.chunks[0], col.count * col.elem_size);
+                } else {
+                    for (size_t i = 0; i < col.count; ++i)
+                        col.move_fn(new_data + i * col.elem_size, col.get(i));
+                }
             }
-            col.data = new_data;
+            col.chunks.assign(1, new_data);
             col.capacity = new_cap;
             offset += new_cap * col.elem_size;
         }
 
-        std::free(block_);
-        block_ = new_block;
+#if defined(ECS_PROFILE)
+        if (profile && new_block) {
+            ECS_PROFILE_ADD(*profile, storage_allocations, 1);
+            for (auto& [cid, col] : columns)
+                ECS_PROFILE_ADD(*profile, bytes_moved, col.count * col.elem_size);
+        }
+#endif
+        release_blocks();
+        blocks_.assign(1, new_block);
+        block_bytes_ = total;
         capacity_ = new_cap;
     }
 
-private:
-    uint8_t* block_ = nullptr;
-    size_t capacity_ = 0;
+    void grow_chunks(size_t needed) {
+        if (blocks_.empty()) {
+            size_t rows = chunk_rows();
+            chunk_shift_ = 0;
+            while ((size_t(1) << chunk_shift_) < rows)
+                ++chunk_shift_;
+            for (auto& [cid, col] : columns)
+                col.chunk_shift = chunk_shift_;
+        }
+        size_t rows = size_t(1) << chunk_shift_;
+        size_t bytes = block_size_for(rows);
+        block_bytes_ = bytes;
+        while (capacity_ < needed) {
+            uint8_t* chunk = allocate_block(bytes);
+            size_t offset = 0;
+            for (auto& [cid, col] : columns) {
+                col.capacity += rows;
+                if (col.tag) {
+                    col.chunks.push_back(ComponentColumn::tag_storage());
+                    continue;
+                }
+                offset = align_up(offset, column_align(col));
+                col.chunks.push_back(chunk + offset);
+                offset += rows * col.elem_size;
+            }
+            blocks_.push_back(chunk);
+            capacity_ += rows;
+#if defined(ECS_PROFILE)
+            if (profile && chunk)
+                ECS_PROFILE_ADD(*profile, storage_allocations, 1);
+#endif
+        }
+    }
+
+    // Tag-only archetypes need no storage: their blocks are null
+    uint8_t* allocate_block(size_t bytes) {
+        if (bytes == 0)
+            return nullptr;
+        void* p = allocator_->allocate(allocator_->user, bytes, storage_align());
+        ECS_ASSERT(p, "archetype storage allocation failed");
+        return static_cast<uint8_t*>(p);
+    }
+
+    void free_block(uint8_t* block) {
+        if (block)
+            allocator_->deallocate(allocator_->user, block, block_bytes_, storage_align());
+    }
+
+    void release_blocks() {
+        for (auto* block : blocks_)
+            free_block(block);
+        blocks_.clear();
+    }
 
     static size_t align_up(size_t offset, size_t align) {
         return (offset + align - 1) & ~(align - 1);
     }
 
+    static size_t column_align(const ComponentColumn& col) {
+        return std::max(CHUNK_ALIGN, col.alignment);
+    }
+
+    // Alignment of every block/chunk: the strictest column's, so each column offset keeps it
+    size_t storage_align() const {
+        size_t align = CHUNK_ALIGN;
+        for (auto& [cid, col] : columns)
+            if (!col.tag)
+                align = std::max(align, col.alignment);
+        return align;
+    }
+
     // Compute total block size for a given capacity
     size_t block_size_for(size_t cap) const {
         size_t offset = 0;
         for (auto& [cid, col] : columns) {
-            offset = align_up(offset, CHUNK_ALIGN);
+            if (col.tag)
+                continue;
+            offset = align_up(offset, column_align(col));
             offset += cap * col.elem_size;
         }
         return offset;
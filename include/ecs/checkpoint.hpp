@@ -0,0 +1,332 @@
+#pragma once
+#include "world.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace ecs {
+
+/**
+ * @brief In-memory copy of a World's entities and components, for rollback.
+ *
+ * @details `capture(world)` copies every non-empty archetype's rows, ticks and entity list,
+ * every sparse set, the entity tables (generations, records, free list) and the change tick.
+ * `restore(world)` puts them back in place: archetypes are refilled rather than recreated,
+ * so `Archetype*` pointers, query caches and `Query` handles stay valid, and archetypes
+ * created since the capture are left empty. Trivially copyable columns copy with one
+ * `memcpy` per storage run; other types use their copy constructor.
+ *
+ * A checkpoint keeps its buffers between captures, so a ring of them (one per rollback
+ * frame) allocates nothing in steady state. Column copies come from the world's allocator,
+ * which must outlive the checkpoint. Not captured: resources, observers, value index
+ * contents (rebuilt on restore) and pending deferred commands. Restore fires no observers,
+ * like the deserializers.
+ */
+class Checkpoint {
+public:
+    Checkpoint() = default;
+    Checkpoint(Checkpoint&&) = default;
+    Checkpoint& operator=(Checkpoint&&) = default;
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    /** @brief Whether nothing has been captured yet. */
+    bool empty() const { return world_ == nullptr; }
+
+    /** @brief The World's change tick when the checkpoint was captured. */
+    uint32_t change_tick() const { return change_tick_; }
+
+    /** @brief Number of live entities captured. */
+    size_t entity_count() const {
+        size_t total = 0;
+        for (size_t i = 0; i < archetype_count_; ++i)
+            total += archetypes_[i].entities.size();
+        return total;
+    }
+
+    /**
+     * @brief Copies `world`'s state into this checkpoint, replacing what it held.
+     * @warning Asserts if called during query iteration, or if a component type with rows in
+     * the world is not copy-constructible.
+     */
+    void capture(const World& world);
+
+    /**
+     * @brief Returns `world` to the captured state.
+     * @details Value indexes are rebuilt. Pending deferred commands are kept. The change tick
+     * is rewound to `change_tick()`, so `Changed<>` trackers that recorded a later tick
+     * (`TransformPropagator`, `SpatialGrid`) need `invalidate()`.
+     * @warning Asserts if `world` is not the World this was captured from, or if called
+     * during query iteration.
+     */
+    void restore(World& world) const;
+
+private:
+    // One column's rows and ticks, in a buffer reused across captures
+    class ColumnCopy {
+    public:
+        ColumnCopy() = default;
+        ~ColumnCopy() { release(); }
+        ColumnCopy(ColumnCopy&& o) noexcept { *this = std::move(o); }
+        ColumnCopy& operator=(ColumnCopy&& o) noexcept {
+            if (this != &o) {
+                release();
+                alloc_ = o.alloc_;
+                data_ = o.data_;
+                bytes_ = o.bytes_;
+                align_ = o.align_;
+                count_ = o.count_;
+                elem_size_ = o.elem_size_;
+                destroy_fn_ = o.destroy_fn_;
+                copy_fn_ = o.copy_fn_;
+                added_ = std::move(o.added_);
+                changed_ = std::move(o.changed_);
+                blocks_ = std::move(o.blocks_);
+                last_added_ = o.last_added_;
+                last_changed_ = o.last_changed_;
+                o.data_ = nullptr;
+                o.bytes_ = 0;
+                o.count_ = 0;
+            }
+            return *this;
+        }
+
+        void capture(const ComponentColumn& col, const Allocator& alloc) {
+            reset();
+            if (alloc_ != &alloc) {
+                release();
+                alloc_ = &alloc;
+            }
+            elem_size_ = col.elem_size;
+            copy_fn_ = col.trivially_copyable ? nullptr : col.copy_fn;
+            destroy_fn_ = col.trivially_destructible ? nullptr : col.destroy_fn;
+            if (elem_size_ > 0 && col.count > 0) {
+                ECS_ASSERT(col.trivially_copyable || col.copy_fn,
+                           "Checkpoint: component type is not copy-constructible");
+                reserve(col.count * elem_size_, std::max(col.alignment, alignof(std::max_align_t)));
+                if (!copy_fn_) {
+                    for_each_run(col, col.count, [&](size_t row, size_t len) {
+                        std::memcpy(data_ + row * elem_size_, col.get(row), len * elem_size_);
+                    });
+                } else {
+                    for (size_t row = 0; row < col.count; ++row)
+                        copy_fn_(data_ + row * elem_size_, col.get(row));
+                }
+            }
+            count_ = col.count;
+            added_.assign(col.added_ticks.begin(), col.added_ticks.end());
+            changed_.assign(col.changed_ticks.begin(), col.changed_ticks.end());
+            blocks_.assign(col.block_changed_ticks.begin(), col.block_changed_ticks.end());
+            last_added_ = col.last_added;
+            last_changed_ = col.last_changed;
+        }
+
+        // `col` must be empty with capacity for count() rows
+        void restore(ComponentColumn& col) const {
+            if (elem_size_ > 0) {
+                if (!copy_fn_) {
+                    for_each_run(col, count_, [&](size_t row, size_t len) {
+                        std::memcpy(col.get(row), data_ + row * elem_size_, len * elem_size_);
+                    });
+                } else {
+                    for (size_t row = 0; row < count_; ++row)
+                        copy_fn_(col.get(row), data_ + row * elem_size_);
+                }
+            }
+            col.count = count_;
+            col.added_ticks.assign(added_.begin(), added_.end());
+            col.changed_ticks.assign(changed_.begin(), changed_.end());
+            col.block_changed_ticks.assign(blocks_.begin(), blocks_.end());
+            col.last_added = last_added_;
+            col.last_changed = last_changed_;
+        }
+
+        size_t count() const { return count_; }
+
+    private:
+        const Allocator* alloc_ = nullptr; // owns data_
+        uint8_t* data_ = nullptr;
+        size_t bytes_ = 0;
+        size_t align_ = 0;
+        size_t count_ = 0;
+        size_t elem_size_ = 0;
+        ComponentColumn::DestroyFunc destroy_fn_ = nullptr; // null: trivially destructible
+        ComponentColumn::CopyFunc copy_fn_ = nullptr;       // null: trivially copyable
+        std::vector<uint32_t> added_;
+        std::vector<uint32_t> changed_;
+        std::vector<uint32_t> blocks_;
+        uint32_t last_added_ = 0;
+        uint32_t last_changed_ = 0;
+
+        // Destroys the held copies; keeps the buffer
+        void reset() {
+            if (destroy_fn_)
+                for (size_t row = 0; row < count_; ++row)
+                    destroy_fn_(data_ + row * elem_size_);
+            count_ = 0;
+        }
+
+        void release() {
+            reset();
+            if (data_)
+                alloc_->deallocate(alloc_->user, data_, bytes_, align_);
+            data_ = nullptr;
+            bytes_ = 0;
+            align_ = 0;
+        }
+
+        void reserve(size_t bytes, size_t align) {
+            if (bytes <= bytes_ && align <= align_)
+                return;
+            if (data_)
+                alloc_->deallocate(alloc_->user, data_, bytes_, align_);
+            bytes_ = std::max(bytes, bytes_ * 2);
+            align_ = std::max(align, align_);
+            data_ = static_cast<uint8_t*>(alloc_->allocate(alloc_->user, bytes_, align_));
+            ECS_ASSERT(data_, "Checkpoint: allocation failed");
+        }
+
+        // Calls `fn(first_row, length)` per run of rows of `col` contiguous in one chunk
+        template <typename Fn>
+        static void for_each_run(const ComponentColumn& col, size_t rows, Fn&& fn) {
+            size_t chunk_rows = size_t(1) << col.chunk_shift;
+            for (size_t row = 0; row < rows;) {
+                size_t len = std::min(rows - row, chunk_rows - (row & (chunk_rows - 1)));
+                fn(row, len);
+                row += len;
+            }
+        }
+    };
+
+    struct ArchetypeCopy {
+        Archetype* archetype = nullptr;
+        TypeSet types;
+        std::vector<Entity> entities;
+        std::vector<ColumnCopy> columns; // in the archetype's column order
+        Archetype::OrderState order;
+    };
+    struct SparseCopy {
+        ComponentTypeID id = 0;
+        std::vector<Entity> dense;
+        ColumnCopy column;
+    };
+
+    const World* world_ = nullptr;
+    uint64_t archetype_epoch_ = 0;
+    // Slots past the counts keep their buffers for the next capture
+    std::vector<ArchetypeCopy> archetypes_;
+    size_t archetype_count_ = 0;
+    std::vector<SparseCopy> sparse_;
+    size_t sparse_count_ = 0;
+    std::vector<uint32_t> generations_;
+    std::vector<uint32_t> structure_ticks_;
+    std::vector<EntityRecord> records_;
+    std::vector<uint32_t> free_list_;
+    uint32_t generation_floor_ = 0;
+    uint32_t change_tick_ = 0;
+};
+
+inline void Checkpoint::capture(const World& world) {
+    ECS_ASSERT(world.iterating_ == 0, "Checkpoint::capture during iteration");
+    world_ = &world;
+    archetype_epoch_ = world.archetype_epoch_;
+
+    archetype_count_ = 0;
+    for (auto& [ts, arch] : world.archetypes_) {
+        if (arch->count() == 0)
+            continue;
+        if (archetype_count_ == archetypes_.size())
+            archetypes_.emplace_back();
+        ArchetypeCopy& copy = archetypes_[archetype_count_++];
+        copy.archetype = arch.get();
+        copy.types = ts;
+        copy.entities.assign(arch->entities.begin(), arch->entities.end());
+        copy.order = arch->order;
+        if (copy.columns.size() < arch->columns.size())
+            copy.columns.resize(arch->columns.size());
+        for (size_t c = 0; c < arch->columns.size(); ++c)
+            copy.columns[c].capture(arch->columns[c].second, world.allocator());
+    }
+
+    sparse_count_ = 0;
+    for (ComponentTypeID cid : world.sparse_ids_) {
+        const SparseSet& set = *world.sparse_sets_[cid];
+        if (set.size() == 0)
+            continue;
+        if (sparse_count_ == sparse_.size())
+            sparse_.emplace_back();
+        SparseCopy& copy = sparse_[sparse_count_++];
+        copy.id = cid;
+        copy.dense.assign(set.entities().begin(), set.entities().end());
+        copy.column.capture(set.column(), world.allocator());
+    }
+
+    generations_.assign(world.generations_.begin(), world.generations_.end());
+    structure_ticks_.assign(world.structure_ticks_.begin(), world.structure_ticks_.end());
+    records_.assign(world.records_.begin(), world.records_.end());
+    free_list_.assign(world.free_list_.begin(), world.free_list_.end());
+    generation_floor_ = world.generation_floor_;
+    change_tick_ = world.change_tick_;
+}
+
+inline void Checkpoint::restore(World& world) const {
+    ECS_ASSERT(world_ == &world, "Checkpoint::restore: not captured from this World");
+    ECS_ASSERT(world.iterating_ == 0, "Checkpoint::restore during iteration");
+
+    for (auto& [ts, arch] : world.archetypes_) {
+        if (arch->count() == 0)
+            continue;
+        for (auto& [cid, col] : arch->columns)
+            col.destroy_all();
+        arch->entities.clear();
+        arch->order.rows_moved = true;
+    }
+    for (ComponentTypeID cid : world.sparse_ids_)
+        world.sparse_sets_[cid]->clear();
+
+    // Archetypes deleted since the capture are recreated, and records re-pointed at them
+    bool same_archetypes = archetype_epoch_ == world.archetype_epoch_;
+    std::unordered_map<const Archetype*, Archetype*> moved;
+    for (size_t i = 0; i < archetype_count_; ++i) {
+        const ArchetypeCopy& copy = archetypes_[i];
+        Archetype* arch = copy.archetype;
+        if (!same_archetypes) {
+            arch = world.get_or_create_archetype(copy.types);
+            if (arch != copy.archetype)
+                moved[copy.archetype] = arch;
+        }
+        arch->ensure_capacity(copy.entities.size());
+        arch->entities.assign(copy.entities.begin(), copy.entities.end());
+        for (size_t c = 0; c < arch->columns.size(); ++c)
+            copy.columns[c].restore(arch->columns[c].second);
+        arch->order = copy.order;
+        arch->assert_parity();
+    }
+    for (size_t i = 0; i < sparse_count_; ++i) {
+        const SparseCopy& copy = sparse_[i];
+        SparseSet& set = world.sparse_set(copy.id);
+        set.reserve(copy.dense.size());
+        copy.column.restore(set.column());
+        set.assign_entities(Span<const Entity>(copy.dense.data(), copy.dense.size()));
+    }
+
+    world.generations_.assign(generations_.begin(), generations_.end());
+    world.structure_ticks_.assign(structure_ticks_.begin(), structure_ticks_.end());
+    world.records_.assign(records_.begin(), records_.end());
+    if (!moved.empty()) {
+        for (EntityRecord& rec : world.records_) {
+            auto it = rec.archetype ? moved.find(rec.archetype) : moved.end();
+            if (it != moved.end())
+                rec.archetype = it->second;
+        }
+    }
+    world.free_list_.assign(free_list_.begin(), free_list_.end());
+    world.generation_floor_ = generation_floor_;
+    world.change_tick_ = change_tick_;
+    world.rebuild_indexes();
+}
+
+} // namespace ecs
@@ -1,12 +1,16 @@
 #pragma once
 
+#include "allocator.hpp"
 #include "component.hpp"
 #include "entity.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <new>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace ecs {
@@ -21,11 +25,22 @@ class World; // forward declaration — flush() defined after World in world.hpp
  * invalidating iterators or modifying the archetype graph during a query.
  *
  * Commands are stored in a linear byte buffer and executed in FIFO order when `flush()` is called.
+ * The buffer acts as a per-frame arena: a flush empties it but keeps its capacity (two buffers
+ * alternate, so commands recorded during a flush have somewhere to go), so a steady-state frame
+ * allocates nothing. When the buffer grows while holding components that are not trivially
+ * relocatable, it moves them to the new storage with their move constructors.
  */
 class CommandBuffer {
 public:
     CommandBuffer() = default;
 
+    /**
+     * @brief Constructs an empty buffer whose storage comes from `allocator`.
+     * @param allocator Must outlive the buffer; null selects `default_allocator()`.
+     */
+    explicit CommandBuffer(const Allocator* allocator)
+        : buf_(StlAllocator<uint8_t>(allocator)), spare_(StlAllocator<uint8_t>(allocator)) {}
+
     /**
      * @brief Destructor.
      * @details Destroys any unflushed components stored in the buffer to prevent memory leaks.
@@ -61,6 +76,7 @@ public:
                      nullptr);
         void* dst = alloc_inline(sizeof(U), alignof(std::max_align_t));
         new (dst) U(std::forward<T>(comp));
+        relocate_on_growth_ |= !is_trivially_relocatable_v<U>;
     }
 
     /**
@@ -96,12 +112,65 @@ public:
      */
     void flush(World& w); // defined after World class in world.hpp
 
+    /**
+     * @brief Executes all queued commands, batching runs of identical structural changes.
+     * @details Consecutive `add<T>` (or `remove<T>`) commands on distinct entities form a run.
+     * The run's entities are grouped by source archetype and each group migrates with one
+     * capacity reservation and one column pairing. Consecutive `create_with` commands with the
+     * same component list reserve target capacity once. Runs end at any other command or at
+     * the first repeated entity, so the final state matches `flush()`. Differences: row order
+     * within target archetypes may differ, and a run's `on_add` hooks fire after all of its
+     * rows have moved (`on_remove` hooks fire before any row moves).
+     * @param w The World to update.
+     */
+    void flush_batched(World& w); // defined after World class in world.hpp
+
     /**
      * @brief Checks if the buffer contains any pending commands.
      * @return true if empty, false otherwise.
      */
     bool empty() const { return buf_.empty(); }
 
+    /**
+     * @brief Moves every command of `other` to the end of this buffer, leaving `other` empty.
+     * @details Commands keep their order, so appending per-job buffers in job order gives the
+     * sequence one thread would have recorded. Payloads are moved with their move functions;
+     * when this buffer is empty the storage is swapped instead. Both buffers keep their
+     * capacity for reuse.
+     */
+    void append(CommandBuffer& other) {
+        if (other.buf_.empty())
+            return;
+        if (buf_.empty()) {
+            buf_.swap(other.buf_);
+            std::swap(relocate_on_growth_, other.relocate_on_growth_);
+            return;
+        }
+        // Commands start on CMD_ALIGN boundaries, so `other`'s bytes stay valid at any such
+        // offset and the gap before them is skipped like any other padding
+        size_t offset = align_up(buf_.size(), CMD_ALIGN);
+        size_t needed = offset + other.buf_.size();
+        if (needed > buf_.capacity() && relocate_on_growth_)
+            grow_relocating(needed);
+        buf_.resize(needed);
+        std::memcpy(buf_.data() + offset, other.buf_.data(), other.buf_.size());
+        if (other.relocate_on_growth_) {
+            for_each_payload(other.buf_, [&](size_t pos, ComponentColumn::MoveFunc move_fn,
+                                             ComponentColumn::DestroyFunc) {
+                move_fn(buf_.data() + offset + pos, other.buf_.data() + pos);
+            });
+            relocate_on_growth_ = true;
+        }
+        other.buf_.clear(); // payloads were moved out; only dead bytes remain
+        other.relocate_on_growth_ = false;
+    }
+
+    /** @brief Releases the capacity retained for future frames (pending commands are kept). */
+    void shrink_to_fit() {
+        spare_ = ByteBuffer(spare_.get_allocator());
+        buf_.shrink_to_fit();
+    }
+
 private:
     enum class CmdTag : uint8_t { Destroy, Add, Remove, CreateWith };
 
@@ -121,7 +190,13 @@ private:
         ComponentColumn::DestroyFunc destroy_fn;
     };
 
-    std::vector<uint8_t> buf_;
+    ByteBuffer buf_;
+    ByteBuffer spare_; // the previous frame's storage, emptied; swapped in by flush
+    bool relocate_on_growth_ = false; // buf_ holds a payload that must not be moved bytewise
+
+    // Every command starts at a multiple of this (payloads are aligned to it as well), so
+    // offsets are preserved when a buffer's bytes are appended to another's (see append)
+    static constexpr size_t CMD_ALIGN = alignof(std::max_align_t);
 
     static size_t align_up(size_t offset, size_t align) {
         return (offset + align - 1) & ~(align - 1);
@@ -129,14 +204,31 @@ private:
 
     void* alloc_raw(size_t size, size_t alignment) {
         size_t offset = align_up(buf_.size(), alignment);
+        if (offset + size > buf_.capacity() && relocate_on_growth_)
+            grow_relocating(offset + size);
         buf_.resize(offset + size);
         return buf_.data() + offset;
     }
 
+    // Grows buf_ to fit `needed` bytes by hand: the vector's own reallocation copies bytes,
+    // which breaks payloads that point into themselves. Headers are copied, payloads are
+    // moved with their move functions.
+    void grow_relocating(size_t needed) {
+        ByteBuffer grown(buf_.get_allocator());
+        grown.reserve(std::max(needed, buf_.capacity() * 2));
+        grown.resize(buf_.size());
+        std::memcpy(grown.data(), buf_.data(), buf_.size());
+        for_each_payload(buf_, [&](size_t pos, ComponentColumn::MoveFunc move_fn,
+                                   ComponentColumn::DestroyFunc) {
+            move_fn(grown.data() + pos, buf_.data() + pos);
+        });
+        buf_.swap(grown); // the old storage holds only dead bytes now
+    }
+
     CmdHeader* write_header(CmdTag tag, Entity e, ComponentTypeID cid, size_t payload,
                             ComponentColumn::MoveFunc move_fn,
                             ComponentColumn::DestroyFunc destroy_fn, void* /*unused*/) {
-        void* dst = alloc_raw(sizeof(CmdHeader), alignof(CmdHeader));
+        void* dst = alloc_raw(sizeof(CmdHeader), CMD_ALIGN);
         auto* hdr = new (dst) CmdHeader{tag, e, cid, payload, move_fn, destroy_fn};
         return hdr;
     }
@@ -151,15 +243,50 @@ private:
         new (dst) SubEntry{component_id<U>(), sizeof(U), col.move_fn, col.destroy_fn};
         void* data_dst = alloc_inline(sizeof(U), alignof(std::max_align_t));
         new (data_dst) U(std::forward<T>(comp));
+        relocate_on_growth_ |= !is_trivially_relocatable_v<U>;
     }
 
-    void destroy_unflushed() {
+    // Reads `count` create_with sub-entries starting at `pos`; returns the end offset.
+    static size_t read_sub_entries(ByteBuffer& buf, size_t pos, size_t count,
+                                   std::vector<ComponentTypeID>& ids, std::vector<void*>& data) {
+        ids.resize(count);
+        data.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            pos = align_up(pos, alignof(SubEntry));
+            auto* sub = reinterpret_cast<SubEntry*>(buf.data() + pos);
+            pos = align_up(pos + sizeof(SubEntry), alignof(std::max_align_t));
+            ids[i] = sub->cid;
+            data[i] = buf.data() + pos;
+            pos += sub->elem_size;
+        }
+        return pos;
+    }
+
+    // Detaches the recorded commands for a flush, leaving buf_ empty but with the spare's
+    // capacity. Pair with recycle() once the commands have been applied.
+    ByteBuffer take_commands() {
+        ByteBuffer cmds(std::move(spare_));
+        cmds.swap(buf_);
+        relocate_on_growth_ = false;
+        return cmds;
+    }
+
+    void recycle(ByteBuffer& cmds) {
+        cmds.clear();
+        if (cmds.capacity() > spare_.capacity())
+            spare_.swap(cmds);
+    }
+
+    // Calls `fn(offset, move_fn, destroy_fn)` for every component payload fully written to
+    // `buf` (a command being recorded may have its header but not yet its payload).
+    template <typename Fn>
+    static void for_each_payload(const ByteBuffer& buf, Fn&& fn) {
         size_t pos = 0;
-        while (pos < buf_.size()) {
-            pos = align_up(pos, alignof(CmdHeader));
-            if (pos + sizeof(CmdHeader) > buf_.size())
+        while (pos < buf.size()) {
+            pos = align_up(pos, CMD_ALIGN);
+            if (pos + sizeof(CmdHeader) > buf.size())
                 break;
-            auto* hdr = reinterpret_cast<CmdHeader*>(buf_.data() + pos);
+            auto* hdr = reinterpret_cast<const CmdHeader*>(buf.data() + pos);
             pos += sizeof(CmdHeader);
 
             switch (hdr->tag) {
@@ -168,8 +295,8 @@ private:
                 break;
             case CmdTag::Add: {
                 pos = align_up(pos, alignof(std::max_align_t));
-                if (hdr->destroy_fn && pos + hdr->payload <= buf_.size())
-                    hdr->destroy_fn(buf_.data() + pos);
+                if (pos + hdr->payload <= buf.size())
+                    fn(pos, hdr->move_fn, hdr->destroy_fn);
                 pos += hdr->payload;
                 break;
             }
@@ -177,20 +304,29 @@ private:
                 size_t count = hdr->payload;
                 for (size_t i = 0; i < count; ++i) {
                     pos = align_up(pos, alignof(SubEntry));
-                    if (pos + sizeof(SubEntry) > buf_.size())
+                    if (pos + sizeof(SubEntry) > buf.size())
                         break;
-                    auto* sub = reinterpret_cast<SubEntry*>(buf_.data() + pos);
+                    auto* sub = reinterpret_cast<const SubEntry*>(buf.data() + pos);
                     pos += sizeof(SubEntry);
                     pos = align_up(pos, alignof(std::max_align_t));
-                    if (sub->destroy_fn && pos + sub->elem_size <= buf_.size())
-                        sub->destroy_fn(buf_.data() + pos);
+                    if (pos + sub->elem_size <= buf.size())
+                        fn(pos, sub->move_fn, sub->destroy_fn);
                     pos += sub->elem_size;
                 }
                 break;
             }
             }
         }
+    }
+
+    void destroy_unflushed() {
+        for_each_payload(buf_, [&](size_t pos, ComponentColumn::MoveFunc,
+                                   ComponentColumn::DestroyFunc destroy_fn) {
+            if (destroy_fn)
+                destroy_fn(buf_.data() + pos);
+        });
         buf_.clear();
+        relocate_on_growth_ = false;
     }
 };
 
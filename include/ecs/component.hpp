@@ -1,6 +1,12 @@
 #pragma once
 
+#include "component_mask.hpp"
+#include "lanes.hpp"
+
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -11,6 +17,7 @@
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #ifndef ECS_ASSERT
 #define ECS_ASSERT(expr, msg) assert((expr) && (msg))
@@ -18,6 +25,31 @@
 
 namespace ecs {
 
+namespace detail {
+// Change ticks are written by mutable access that parallel systems may perform on the same
+// column at once (SPEC §4.2), so every non-structural tick read and write is a relaxed atomic.
+// A store is skipped when the slot already holds the tick, which keeps concurrent readers
+// from bouncing the cache line.
+inline uint32_t load_tick(const uint32_t& slot) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(&slot, __ATOMIC_RELAXED);
+#else
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "atomic tick layout");
+    return reinterpret_cast<const std::atomic<uint32_t>&>(slot).load(std::memory_order_relaxed);
+#endif
+}
+
+inline void store_tick(uint32_t& slot, uint32_t tick) {
+    if (load_tick(slot) == tick)
+        return;
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(&slot, tick, __ATOMIC_RELAXED);
+#else
+    reinterpret_cast<std::atomic<uint32_t>&>(slot).store(tick, std::memory_order_relaxed);
+#endif
+}
+} // namespace detail
+
 /**
  * @brief Unique identifier type for component types.
  */
@@ -40,48 +72,173 @@ inline ComponentTypeID next_component_id() {
  */
 template <typename T>
 ComponentTypeID component_id() {
-    static ComponentTypeID id = next_component_id();
-    return id;
+    static_assert(!is_split_component_v<T>,
+                  "split components have no column of their own; use add/remove/has, load/store "
+                  "or each_lanes (see split_fields)");
+    if constexpr (std::is_const_v<T>) {
+        return component_id<std::remove_const_t<T>>(); // `const T` names the same component
+    } else {
+        static ComponentTypeID id = next_component_id();
+        return id;
+    }
 }
 
+/**
+ * @brief Opt-in trait: a `T` can be moved to a new address by copying its bytes, with the old
+ * bytes abandoned (no destructor call on the source).
+ * @details Defaults to trivially copyable types. Specialize it as `std::true_type` for types
+ * that own memory but never point into themselves (a `std::unique_ptr`, a handle wrapper, an
+ * intrusive-free container) so columns move them with `memcpy` instead of `move_fn`. Do not
+ * specialize it for self-referential types, such as libstdc++'s `std::string` (its
+ * small-string buffer) or node-based containers with an in-object sentinel.
+ * @code
+ *   template <> struct ecs::is_trivially_relocatable<MyHandle> : std::true_type {};
+ * @endcode
+ * The specialization must be visible before the type's first use as a component.
+ */
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+/**
+ * @brief Tag components: empty, trivially copyable types such as `struct Selected {};`.
+ * @details A tag is part of its archetype's signature but stores nothing: its column has
+ * `elem_size` 0 and no archetype storage, so tags cost nothing per row and are never
+ * constructed, moved or destroyed per row. Every row's element is one shared dummy object,
+ * aligned to `alignof(std::max_align_t)`; over-aligned empty types are stored as ordinary
+ * columns so references to them stay aligned.
+ */
+template <typename T>
+inline constexpr bool is_tag_component_v = std::is_empty_v<T> && std::is_trivially_copyable_v<T> &&
+                                           alignof(T) <= alignof(std::max_align_t);
+
+/**
+ * @brief Opt-in trait: keep `T` in a per-World sparse set keyed by `Entity::index` instead of
+ * in archetype columns.
+ * @details Adding or removing a sparse component is O(1) and never migrates the entity, so it
+ * suits components that toggle every few frames (status effects, targets, transient timers).
+ * The cost is an indirection per access and no archetype contiguity when iterating.
+ * @code
+ *   template <> struct ecs::is_sparse_component<Stunned> : std::true_type {};
+ * @endcode
+ * The specialization must be visible before the type's first use as a component.
+ */
+template <typename T>
+struct is_sparse_component : std::false_type {};
+
+template <typename T>
+inline constexpr bool is_sparse_component_v = is_sparse_component<std::remove_const_t<T>>::value;
+
+/**
+ * @brief Opt-in trait: start `T`'s column storage on an `N`-byte boundary (a power of two).
+ * @details Every contiguous run of a column (the whole column in block storage, one chunk's
+ * slice in chunked storage) begins at a multiple of `max(N, alignof(T))`, so loops over
+ * `each_chunk` or `each_lanes` pointers can use aligned vector loads. 0 (the default) keeps
+ * `Archetype::CHUNK_ALIGN`. The default allocator pools blocks up to `BlockPool::ALIGN` (64)
+ * and serves larger alignments from aligned `operator new`.
+ * @code
+ *   template <> struct ecs::column_alignment<Particle> : std::integral_constant<size_t, 64> {};
+ * @endcode
+ * The specialization must be visible before the type's first use as a component.
+ */
+template <typename T>
+struct column_alignment : std::integral_constant<size_t, 0> {};
+
+/** @brief Lanes of a split type start on a cache line, or on the type's own alignment. */
+template <typename T, size_t I>
+struct column_alignment<Lane<T, I>>
+    : std::integral_constant<size_t, std::max<size_t>(64, column_alignment<T>::value)> {};
+
+template <typename T>
+inline constexpr size_t column_alignment_v = column_alignment<std::remove_const_t<T>>::value;
+
 /**
  * @brief Type-erased column storage for a single component type within an archetype.
  *
  * @details This struct manages the operations (move, destroy, swap, serialize) for a column of components
  * without knowing the concrete type at compile time. It acts as a vtable and metadata holder
- * for a contiguous array of components.
+ * for the column's component arrays.
+ *
+ * Rows are stored in one or more chunks of `1 << chunk_shift` rows each. Block storage uses a
+ * single chunk (`BLOCK_SHIFT`), so every row maps to `chunks[0]`.
  *
- * @warning The actual memory buffer (`data`) is NOT owned by this struct. It is typically a pointer
- * into a larger memory block managed by an `Archetype`.
+ * @warning The actual memory buffers (`chunks`) are NOT owned by this struct. They point into
+ * memory blocks managed by an `Archetype`.
  */
 struct ComponentColumn {
-    /** @brief Pointer to the start of the component data array. */
-    uint8_t* data = nullptr;
+    /** @brief Shift that maps every row to chunk 0 (single contiguous block). */
+    static constexpr uint32_t BLOCK_SHIFT = sizeof(size_t) * 8 - 1;
+
+    /** @brief Start of this column's slice in each storage chunk. */
+    std::vector<uint8_t*> chunks;
+    /** @brief log2 of the number of rows per chunk. */
+    uint32_t chunk_shift = BLOCK_SHIFT;
     /** @brief Size of a single component element in bytes. */
     size_t elem_size = 0;
     /** @brief Number of active elements in the column. */
     size_t count = 0;
     /** @brief Allocated capacity of the column (in elements). */
     size_t capacity = 0;
-    /** @brief Alignment requirement of the component type. */
+    /** @brief Alignment of the column's storage runs: `alignof(T)` or `column_alignment<T>`. */
     size_t alignment = 1;
 
+    using ConstructFunc = void (*)(void* ptr);
     using MoveFunc = void (*)(void* dst, void* src);
     using DestroyFunc = void (*)(void* ptr);
     using SwapFunc = void (*)(void* a, void* b);
+    using CopyFunc = void (*)(void* dst, const void* src);
     using SerializeFunc = void (*)(const void* elem, std::ostream& out);
     using DeserializeFunc = void (*)(void* elem, std::istream& in);
 
+    /** @brief Function pointer to default-construct an element (null if not constructible). */
+    ConstructFunc construct_fn = nullptr;
     /** @brief Function pointer to move-construct an element. */
     MoveFunc move_fn = nullptr;
     /** @brief Function pointer to destroy (call destructor) an element. */
     DestroyFunc destroy_fn = nullptr;
     /** @brief Function pointer to swap two elements. */
     SwapFunc swap_fn = nullptr;
+    /** @brief Copy-constructs an element into uninitialized storage (null if not copyable). */
+    CopyFunc copy_fn = nullptr;
     /** @brief Function pointer to serialize an element. */
     SerializeFunc serialize_fn = nullptr;
     /** @brief Function pointer to deserialize an element. */
     DeserializeFunc deserialize_fn = nullptr;
+    /**
+     * @brief Rows serialize as their raw bytes (trivially copyable, no custom serializer).
+     * @details Lets snapshot formats copy whole runs of rows instead of one element at a time.
+     */
+    bool raw_serializable = false;
+    /** @brief Elements move with `memcpy` (see `is_trivially_relocatable`). */
+    bool trivially_relocatable = false;
+    /** @brief Elements need no destructor call; `destroy_elem` is a no-op. */
+    bool trivially_destructible = false;
+    /** @brief Elements copy with `memcpy` (`std::is_trivially_copyable`). */
+    bool trivially_copyable = false;
+    /** @brief Tag column (see `is_tag_component_v`): no storage, every row is `tag_storage()`. */
+    bool tag = false;
+
+    /** @brief log2 of the rows covered by one entry of `block_changed_ticks`. */
+    static constexpr size_t TICK_BLOCK_SHIFT = 6;
+
+    /** @brief Per-row change tick at which the component was added to its entity. */
+    std::vector<uint32_t> added_ticks;
+    /** @brief Per-row change tick of the last single-entity write (`get<T>`, overwriting add). */
+    std::vector<uint32_t> changed_ticks;
+    /**
+     * @brief Change tick per block of 64 rows, stamped by whole-column mutable iteration.
+     * @details A row's effective changed tick is the max of its own entry and its block's (see
+     * `changed_tick`), so iterating a column costs one store per 64 rows instead of one per row.
+     */
+    std::vector<uint32_t> block_changed_ticks;
+    /** @brief Upper bound of `added_ticks` (lets tick filters skip the whole column). */
+    uint32_t last_added = 0;
+    /** @brief Upper bound of every row's effective changed tick. */
+    uint32_t last_changed = 0;
+    /** @brief The owning World's current change tick (null: rows are stamped with tick 0). */
+    const uint32_t* tick_source = nullptr;
 
     ComponentColumn() = default;
 
@@ -90,17 +247,31 @@ struct ComponentColumn {
      * @details Transfers ownership of metadata. Data pointer is copied, but ownership remains external.
      */
     ComponentColumn(ComponentColumn&& o) noexcept
-        : data(o.data),
+        : chunks(std::move(o.chunks)),
+          chunk_shift(o.chunk_shift),
           elem_size(o.elem_size),
           count(o.count),
           capacity(o.capacity),
           alignment(o.alignment),
+          construct_fn(o.construct_fn),
           move_fn(o.move_fn),
           destroy_fn(o.destroy_fn),
           swap_fn(o.swap_fn),
+          copy_fn(o.copy_fn),
           serialize_fn(o.serialize_fn),
-          deserialize_fn(o.deserialize_fn) {
-        o.data = nullptr;
+          deserialize_fn(o.deserialize_fn),
+          raw_serializable(o.raw_serializable),
+          trivially_relocatable(o.trivially_relocatable),
+          trivially_destructible(o.trivially_destructible),
+          trivially_copyable(o.trivially_copyable),
+          tag(o.tag),
+          added_ticks(std::move(o.added_ticks)),
+          changed_ticks(std::move(o.changed_ticks)),
+          block_changed_ticks(std::move(o.block_changed_ticks)),
+          last_added(o.last_added),
+          last_changed(o.last_changed),
+          tick_source(o.tick_source) {
+        o.chunks.clear();
         o.count = 0;
         o.capacity = 0;
     }
@@ -112,18 +283,32 @@ struct ComponentColumn {
     ComponentColumn& operator=(ComponentColumn&& o) noexcept {
         if (this != &o) {
             destroy_all();
-            // data is owned by Archetype's block_ — do NOT free here
-            data = o.data;
+            // chunks are owned by Archetype's blocks_ — do NOT free here
+            chunks = std::move(o.chunks);
+            chunk_shift = o.chunk_shift;
             elem_size = o.elem_size;
             count = o.count;
             capacity = o.capacity;
             alignment = o.alignment;
+            construct_fn = o.construct_fn;
             move_fn = o.move_fn;
             destroy_fn = o.destroy_fn;
             swap_fn = o.swap_fn;
+            copy_fn = o.copy_fn;
             serialize_fn = o.serialize_fn;
             deserialize_fn = o.deserialize_fn;
-            o.data = nullptr;
+            raw_serializable = o.raw_serializable;
+            trivially_relocatable = o.trivially_relocatable;
+            trivially_destructible = o.trivially_destructible;
+            trivially_copyable = o.trivially_copyable;
+            tag = o.tag;
+            added_ticks = std::move(o.added_ticks);
+            changed_ticks = std::move(o.changed_ticks);
+            block_changed_ticks = std::move(o.block_changed_ticks);
+            last_added = o.last_added;
+            last_changed = o.last_changed;
+            tick_source = o.tick_source;
+            o.chunks.clear();
             o.count = 0;
             o.capacity = 0;
         }
@@ -132,40 +317,163 @@ struct ComponentColumn {
 
     /**
      * @brief Destructor.
-     * @details Calls destructors on all active elements but does not free `data`.
+     * @details Calls destructors on all active elements but does not free `chunks`.
      */
     ~ComponentColumn() {
         destroy_all();
-        // data is owned by Archetype's block_ — do NOT free here
+        // chunks are owned by Archetype's blocks_ — do NOT free here
     }
 
     ComponentColumn(const ComponentColumn&) = delete;
     ComponentColumn& operator=(const ComponentColumn&) = delete;
 
+    /** @brief The shared element of every tag column row (never written). */
+    static uint8_t* tag_storage() {
+        alignas(std::max_align_t) static uint8_t storage[alignof(std::max_align_t)];
+        return storage;
+    }
+
+    /**
+     * @brief Moves the element at `src` into uninitialized storage at `dst`, ending the
+     * source's lifetime (its storage is dead afterwards and must not be destroyed again).
+     */
+    void relocate_elem(void* dst, void* src) const {
+        if (trivially_relocatable)
+            std::memcpy(dst, src, elem_size);
+        else
+            move_fn(dst, src);
+    }
+
+    /** @brief Destroys the element at `ptr` (nothing to do for trivially destructible types). */
+    void destroy_elem(void* ptr) const {
+        if (!trivially_destructible)
+            destroy_fn(ptr);
+    }
+
     /**
-     * @brief Pushes a new element into the column via move construction.
-     * @param src Pointer to the source object.
+     * @brief Pushes a new element into the column by relocating `src` (see `relocate_elem`).
+     * @param src Pointer to the source object; its storage is dead afterwards.
      * @warning Assumes capacity is sufficient. The caller must ensure space exists.
      */
     void push_raw(void* src) {
         ECS_ASSERT(count < capacity, "push_raw: column at capacity (archetype should have grown)");
-        move_fn(data + count * elem_size, src);
+        relocate_elem(get(count), src);
+        commit_rows(1);
+    }
+
+    /**
+     * @brief Constructs a new element from `args` at the end of the column.
+     * @tparam T The column's component type.
+     * @warning Assumes capacity is sufficient. The caller must ensure space exists.
+     */
+    template <typename T, typename... Args>
+    void emplace_back(Args&&... args) {
+        ECS_ASSERT(count < capacity, "emplace_back: column at capacity (archetype should have grown)");
+        if constexpr (!is_tag_component_v<T>)
+            new (get(count)) T(std::forward<Args>(args)...);
+        commit_rows(1);
+    }
+
+    /**
+     * @brief Moves row `row` of another column (same type) onto the end of this column.
+     * @details Carries the row's added/changed ticks along, so archetype migration does not
+     * look like a write. The source row's storage is dead afterwards (see `relocate_elem`).
+     */
+    void push_moved(ComponentColumn& from, size_t row) {
+        ECS_ASSERT(count < capacity, "push_moved: column at capacity (archetype should have grown)");
+        relocate_elem(get(count), from.get(row));
         ++count;
+        uint32_t changed = from.changed_tick(row);
+        added_ticks.push_back(from.added_ticks[row]);
+        changed_ticks.push_back(changed);
+        block_changed_ticks.resize(tick_blocks(count), 0);
+        last_added = std::max(last_added, from.added_ticks[row]);
+        last_changed = std::max(last_changed, changed);
+    }
+
+    /**
+     * @brief Marks `n` elements constructed in place at rows `[count, count + n)` as live.
+     * @details Stamps them as added and changed at the current tick.
+     */
+    void commit_rows(size_t n) {
+        uint32_t tick = current_tick();
+        count += n;
+        added_ticks.resize(count, tick);
+        changed_ticks.resize(count, tick);
+        block_changed_ticks.resize(tick_blocks(count), 0);
+        last_added = last_changed = tick;
+    }
+
+    /** @brief Returns the owning World's current change tick. */
+    uint32_t current_tick() const { return tick_source ? *tick_source : 0; }
+
+    /** @brief Number of `block_changed_ticks` entries covering `rows` rows. */
+    static size_t tick_blocks(size_t rows) {
+        return (rows + (size_t(1) << TICK_BLOCK_SHIFT) - 1) >> TICK_BLOCK_SHIFT;
+    }
+
+    /** @brief Returns the effective changed tick of `row`. */
+    uint32_t changed_tick(size_t row) const {
+        return std::max(detail::load_tick(changed_ticks[row]),
+                        detail::load_tick(block_changed_ticks[row >> TICK_BLOCK_SHIFT]));
+    }
+
+    /** @brief Returns `last_changed`; safe while other threads stamp the column. */
+    uint32_t last_changed_tick() const { return detail::load_tick(last_changed); }
+
+    /**
+     * @brief Stamps one row as changed at the current tick.
+     * @details Relaxed atomic, so concurrent mutable access from parallel systems is not a race.
+     */
+    void mark_changed(size_t row) {
+        uint32_t tick = current_tick();
+        detail::store_tick(changed_ticks[row], tick);
+        detail::store_tick(last_changed, tick);
+    }
+
+    /** @brief Stamps every row as changed at the current tick (block granularity). */
+    void mark_all_changed() {
+        uint32_t tick = current_tick();
+        for (uint32_t& block : block_changed_ticks)
+            detail::store_tick(block, tick);
+        detail::store_tick(last_changed, tick);
+    }
+
+    /** @brief Copies row `src`'s ticks onto row `dst` (used when compacting). */
+    void move_ticks(size_t dst, size_t src) {
+        added_ticks[dst] = added_ticks[src];
+        changed_ticks[dst] = changed_tick(src);
+    }
+
+    /** @brief Drops the ticks of rows at or past `n`. */
+    void truncate_ticks(size_t n) {
+        added_ticks.resize(n);
+        changed_ticks.resize(n);
+        block_changed_ticks.resize(tick_blocks(n));
+    }
+
+    /** @brief Folds block ticks into the per-row ticks so rows can be permuted freely. */
+    void flatten_ticks() {
+        for (size_t i = 0; i < count; ++i)
+            changed_ticks[i] = changed_tick(i);
+        std::fill(block_changed_ticks.begin(), block_changed_ticks.end(), 0);
     }
 
     /**
      * @brief Removes an element at a specific index using the "swap and pop" idiom.
      * @details The element at `row` is destroyed, and the last element is moved into its place.
      * @param row Index of the element to remove.
+     * @param relocated The element at `row` was already moved out; it is not destroyed.
      */
-    void swap_remove(size_t row) {
+    void swap_remove(size_t row, bool relocated = false) {
+        if (!relocated)
+            destroy_elem(get(row));
         if (row < count - 1) {
-            destroy_fn(data + row * elem_size);
-            move_fn(data + row * elem_size, data + (count - 1) * elem_size);
-        } else {
-            destroy_fn(data + row * elem_size);
+            relocate_elem(get(row), get(count - 1));
+            move_ticks(row, count - 1);
         }
         --count;
+        truncate_ticks(count);
     }
 
     /**
@@ -173,18 +481,24 @@ struct ComponentColumn {
      * @param row Index of the element.
      * @return void* pointer to the element data.
      */
-    void* get(size_t row) { return data + row * elem_size; }
+    void* get(size_t row) {
+        return chunks[row >> chunk_shift] + (row & ((size_t(1) << chunk_shift) - 1)) * elem_size;
+    }
+    const void* get(size_t row) const {
+        return chunks[row >> chunk_shift] + (row & ((size_t(1) << chunk_shift) - 1)) * elem_size;
+    }
 
     /**
      * @brief Destroys all elements in the column.
      * @details Resets count to 0. Does not free memory.
      */
     void destroy_all() {
-        if (data && destroy_fn) {
+        if (!chunks.empty() && destroy_fn && !trivially_destructible) {
             for (size_t i = 0; i < count; ++i)
-                destroy_fn(data + i * elem_size);
+                destroy_fn(get(i));
         }
         count = 0;
+        truncate_ticks(0);
     }
 };
 
@@ -196,8 +510,13 @@ struct ComponentColumn {
 template <typename T>
 ComponentColumn make_column() {
     ComponentColumn col;
-    col.elem_size = sizeof(T);
-    col.alignment = alignof(T);
+    col.elem_size = is_tag_component_v<T> ? 0 : sizeof(T);
+    static_assert((column_alignment_v<T> & (column_alignment_v<T> - 1)) == 0,
+                  "column_alignment must be a power of two");
+    col.alignment = std::max(alignof(T), column_alignment_v<T>);
+    if constexpr (std::is_default_constructible_v<T>) {
+        col.construct_fn = [](void* ptr) { new (ptr) T(); };
+    }
     col.move_fn = [](void* dst, void* src) {
         new (dst) T(std::move(*static_cast<T*>(src)));
         static_cast<T*>(src)->~T();
@@ -209,13 +528,25 @@ ComponentColumn make_column() {
         using std::swap;
         swap(*static_cast<T*>(a), *static_cast<T*>(b));
     };
-    if constexpr (std::is_trivially_copyable_v<T>) {
+    col.trivially_relocatable = is_trivially_relocatable_v<T>;
+    col.trivially_destructible = std::is_trivially_destructible_v<T>;
+    col.trivially_copyable = std::is_trivially_copyable_v<T>;
+    if constexpr (std::is_copy_constructible_v<T>) {
+        col.copy_fn = [](void* dst, const void* src) { new (dst) T(*static_cast<const T*>(src)); };
+    }
+    col.tag = is_tag_component_v<T>;
+    if constexpr (is_tag_component_v<T>) {
+        col.serialize_fn = [](const void*, std::ostream&) {};
+        col.deserialize_fn = [](void*, std::istream&) {};
+        col.raw_serializable = true;
+    } else if constexpr (std::is_trivially_copyable_v<T>) {
         col.serialize_fn = [](const void* elem, std::ostream& out) {
             out.write(static_cast<const char*>(elem), sizeof(T));
         };
         col.deserialize_fn = [](void* elem, std::istream& in) {
             in.read(static_cast<char*>(elem), sizeof(T));
         };
+        col.raw_serializable = true;
     }
     return col;
 }
@@ -235,6 +566,21 @@ inline std::map<ComponentTypeID, ColumnFactory>& column_factory_registry() {
     return reg;
 }
 
+/**
+ * @brief IDs of the component types stored in sparse sets (see `is_sparse_component`).
+ * @details Filled in by `ensure_column_factory` and `register_component`, so type-erased paths
+ * (deferred commands, prefabs) can route a component ID without its type.
+ */
+inline ComponentMask& sparse_component_registry() {
+    static ComponentMask mask;
+    return mask;
+}
+
+/** @brief Checks whether component `id` is stored in sparse sets. */
+inline bool is_sparse_component_id(ComponentTypeID id) {
+    return sparse_component_registry().test(id);
+}
+
 /**
  * @brief Ensures a column factory exists for type T.
  * @tparam T The component type.
@@ -247,6 +593,8 @@ void ensure_column_factory() {
         reg[id] = []() -> ComponentColumn {
             return make_column<T>();
         };
+        if constexpr (is_sparse_component_v<T>)
+            sparse_component_registry().set(id);
     }
 }
 
@@ -298,28 +646,20 @@ void register_component(const char* name, ComponentColumn::SerializeFunc ser = n
     n2i[name] = id;
     i2n[id] = name;
 
-    // Determine serialize/deserialize functions
-    ComponentColumn::SerializeFunc actual_ser = ser;
-    ComponentColumn::DeserializeFunc actual_deser = deser;
-    if constexpr (std::is_trivially_copyable_v<T>) {
-        if (!actual_ser) {
-            actual_ser = [](const void* elem, std::ostream& out) {
-                out.write(static_cast<const char*>(elem), sizeof(T));
-            };
-        }
-        if (!actual_deser) {
-            actual_deser = [](void* elem, std::istream& in) {
-                in.read(static_cast<char*>(elem), sizeof(T));
-            };
-        }
-    }
-
-    // Update the column factory to capture serialize/deserialize functions
+    // Update the column factory to capture custom serialize/deserialize functions; the
+    // defaults from make_column<T>() (raw bytes for trivially copyable types, nothing for tags)
+    // cover the rest
+    if constexpr (is_sparse_component_v<T>)
+        sparse_component_registry().set(id);
     auto& reg = column_factory_registry();
-    reg[id] = [actual_ser, actual_deser]() -> ComponentColumn {
+    reg[id] = [ser, deser]() -> ComponentColumn {
         auto col = make_column<T>();
-        col.serialize_fn = actual_ser;
-        col.deserialize_fn = actual_deser;
+        if (ser)
+            col.serialize_fn = ser;
+        if (deser)
+            col.deserialize_fn = deser;
+        if (ser || deser)
+            col.raw_serializable = false;
         return col;
     };
 }
@@ -337,6 +677,19 @@ inline ComponentTypeID component_id_by_name(const std::string& name) {
     return it->second;
 }
 
+/**
+ * @brief Looks up a component ID by its registered name, for untrusted input.
+ * @return false if the name is not registered; `id` is then unchanged.
+ */
+inline bool find_component_id_by_name(const std::string& name, ComponentTypeID& id) {
+    auto& n2i = name_to_id_registry();
+    auto it = n2i.find(name);
+    if (it == n2i.end())
+        return false;
+    id = it->second;
+    return true;
+}
+
 /**
  * @brief Lookups a registered name by component ID.
  * @param id The component ID.
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ecs {
+
+/**
+ * @brief Set of component type IDs used for archetype signatures and query masks.
+ *
+ * @details Two-level layout: IDs below `INLINE_BITS` live in a fixed inline word array, so the
+ * common case (small programs, early-registered types) matches with a handful of word ANDs and
+ * no heap access. Higher IDs spill into a heap-allocated word vector that grows on demand, so
+ * there is no upper bound on the number of component types.
+ *
+ * The overflow vector never holds trailing zero words, so an empty overflow means "no high IDs"
+ * and the inline-only fast path can be taken from a single `empty()` check.
+ */
+class ComponentMask {
+public:
+    static constexpr size_t INLINE_WORDS = 4;
+    static constexpr size_t INLINE_BITS = INLINE_WORDS * 64;
+
+    /** @brief Adds `id` to the set. */
+    void set(uint32_t id) {
+        if (id < INLINE_BITS) {
+            inline_[id >> 6] |= bit(id);
+            return;
+        }
+        size_t w = (id - INLINE_BITS) >> 6;
+        if (w >= overflow_.size())
+            overflow_.resize(w + 1, 0);
+        overflow_[w] |= bit(id);
+    }
+
+    /** @brief Removes `id` from the set. */
+    void reset(uint32_t id) {
+        if (id < INLINE_BITS) {
+            inline_[id >> 6] &= ~bit(id);
+            return;
+        }
+        size_t w = (id - INLINE_BITS) >> 6;
+        if (w >= overflow_.size())
+            return;
+        overflow_[w] &= ~bit(id);
+        while (!overflow_.empty() && overflow_.back() == 0)
+            overflow_.pop_back();
+    }
+
+    /** @brief Checks whether `id` is in the set. */
+    bool test(uint32_t id) const {
+        if (id < INLINE_BITS)
+            return (inline_[id >> 6] & bit(id)) != 0;
+        size_t w = (id - INLINE_BITS) >> 6;
+        return w < overflow_.size() && (overflow_[w] & bit(id)) != 0;
+    }
+
+    /** @brief Checks whether the set is empty. */
+    bool none() const {
+        return overflow_.empty() && (inline_[0] | inline_[1] | inline_[2] | inline_[3]) == 0;
+    }
+
+    /** @brief Checks whether every ID in `other` is also in this set. */
+    bool contains_all(const ComponentMask& other) const {
+        for (size_t i = 0; i < INLINE_WORDS; ++i)
+            if ((inline_[i] & other.inline_[i]) != other.inline_[i])
+                return false;
+        if (other.overflow_.empty())
+            return true;
+        if (other.overflow_.size() > overflow_.size())
+            return false; // other's last word is non-zero and lies beyond our storage
+        for (size_t i = 0; i < other.overflow_.size(); ++i)
+            if ((overflow_[i] & other.overflow_[i]) != other.overflow_[i])
+                return false;
+        return true;
+    }
+
+    /** @brief Checks whether this set and `other` share at least one ID. */
+    bool intersects(const ComponentMask& other) const {
+        for (size_t i = 0; i < INLINE_WORDS; ++i)
+            if (inline_[i] & other.inline_[i])
+                return true;
+        size_t n = overflow_.size() < other.overflow_.size() ? overflow_.size()
+                                                             : other.overflow_.size();
+        for (size_t i = 0; i < n; ++i)
+            if (overflow_[i] & other.overflow_[i])
+                return true;
+        return false;
+    }
+
+    bool operator==(const ComponentMask& o) const {
+        for (size_t i = 0; i < INLINE_WORDS; ++i)
+            if (inline_[i] != o.inline_[i])
+                return false;
+        return overflow_ == o.overflow_;
+    }
+    bool operator!=(const ComponentMask& o) const { return !(*this == o); }
+
+private:
+    uint64_t inline_[INLINE_WORDS] = {0, 0, 0, 0};
+    std::vector<uint64_t> overflow_; // words for IDs >= INLINE_BITS; no trailing zero words
+
+    static uint64_t bit(uint32_t id) { return uint64_t(1) << (id & 63); }
+};
+
+} // namespace ecs
@@ -3,15 +3,25 @@
 /**
  * @file ecs.hpp
  * @brief Main entry point for the ECS library kernel.
- * @details Includes the core ECS functionality (Entity, Component, World, Systems).
+ * @details Includes the core ECS functionality (Entity, Component, World, Systems,
+ * ThreadPool).
  * Builtin modules like Transform and Hierarchy must be included separately.
  */
 
+#include "allocator.hpp"
 #include "archetype.hpp"
+#include "checkpoint.hpp"
 #include "command_buffer.hpp"
 #include "component.hpp"
+#include "component_mask.hpp"
 #include "entity.hpp"
+#include "lanes.hpp"
 #include "prefab.hpp"
+#include "profile.hpp"
 #include "serialization.hpp"
+#include "span.hpp"
+#include "sparse_set.hpp"
 #include "system.hpp"
+#include "thread_pool.hpp"
+#include "value_index.hpp"
 #include "world.hpp"
@@ -41,7 +41,10 @@ inline Mat4 mat4_multiply(const Mat4& a, const Mat4& b) {
     const glm::mat4& ga = to_glm(a);
     const glm::mat4& gb = to_glm(b);
     glm::mat4 r = ga * gb;
-    return reinterpret_cast<Mat4&>(r);
+    // Copy out bitwise: reading a glm::mat4 through a Mat4& breaks strict aliasing under -O2
+    Mat4 out;
+    std::memcpy(out.m, &r, sizeof(out.m));
+    return out;
 }
 
 /** @brief Composes a matrix from PRS. Inlined GLM implementation. */
@@ -57,7 +60,9 @@ inline Mat4 mat4_compose(const Vec3& pos, const Quat& rot, const Vec3& scale) {
     m[2] *= g_scale.z;
     m[3] = glm::vec4(g_pos, 1.0f);
 
-    return reinterpret_cast<Mat4&>(m);
+    Mat4 out;
+    std::memcpy(out.m, &m, sizeof(out.m));
+    return out;
 }
 
 } // namespace ecs
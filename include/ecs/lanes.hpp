@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * @file lanes.hpp
+ * @brief Field-split storage for plain-data components (see `split_fields`).
+ */
+
+namespace ecs {
+
+/**
+ * @brief Member list for `split_fields`: `fields<&Vec3::x, &Vec3::y, &Vec3::z>`.
+ */
+template <auto... Members>
+struct fields {
+    static constexpr size_t count = sizeof...(Members);
+    static constexpr auto members = std::make_tuple(Members...);
+};
+
+/**
+ * @brief Opt-in trait: store a plain-data component one field per column ("lane").
+ * @details A split `T` is never stored whole. Each listed member `I` lives in its own column
+ * of `Lane<T, I>`, so a loop over one field reads a dense, cache-line-aligned array instead of
+ * striding over whole structs. Under chunked storage each chunk holds one short array per
+ * field (AoSoA). Fields that are not listed are not stored.
+ * @code
+ *   template <> struct ecs::split_fields<Vec3> : ecs::fields<&Vec3::x, &Vec3::y, &Vec3::z> {};
+ * @endcode
+ * `T` must be trivially copyable and default constructible. Split types are added, removed
+ * and tested with `World::add`, `remove` and `has`. They are read and written with
+ * `World::load` and `store`, and iterated with `World::each_lanes`. There is no `T&` to hand
+ * out, so `get<T>`, `each<T>` and the other paths that take a component ID reject split
+ * types at compile time. The specialization must be visible before the type's first use.
+ */
+template <typename T>
+struct split_fields {};
+
+namespace detail {
+template <typename T, typename = void>
+struct is_split : std::false_type {};
+template <typename T>
+struct is_split<T, std::void_t<decltype(split_fields<T>::count)>> : std::true_type {};
+
+template <typename M>
+struct member_field;
+template <typename C, typename F>
+struct member_field<F C::*> {
+    using type = F;
+};
+} // namespace detail
+
+/** @brief Whether `T` (or `const T`) is declared field-split. */
+template <typename T>
+inline constexpr bool is_split_component_v = detail::is_split<std::remove_const_t<T>>::value;
+
+/** @brief Number of lanes of a split type; 1 for any other type. */
+template <typename T>
+constexpr size_t lane_count() {
+    if constexpr (is_split_component_v<T>)
+        return split_fields<std::remove_const_t<T>>::count;
+    else
+        return 1;
+}
+
+/** @brief Pointer to member `I` of split type `T`. */
+template <typename T, size_t I>
+inline constexpr auto split_member = std::get<I>(split_fields<T>::members);
+
+/** @brief Type of member `I` of split type `T`. */
+template <typename T, size_t I>
+using lane_field_t =
+    typename detail::member_field<std::decay_t<decltype(split_member<T, I>)>>::type;
+
+/**
+ * @brief The component that stores field `I` of split type `T`.
+ * @details An ordinary component with one member, so lanes get columns, migrations, change
+ * ticks, observers, serialization and checkpoints like any other component. Lanes of one
+ * entity are added and removed together by the World.
+ */
+template <typename T, size_t I>
+struct Lane {
+    using value_type = lane_field_t<T, I>;
+    value_type value;
+};
+
+/**
+ * @brief One run of a split type's lanes, as handed out by `World::each_lanes`.
+ * @details `lane<I>()[i]` is field `I` of the run's row `i`. Every lane starts on a cache line
+ * (or on `column_alignment<T>` if larger), so loops over them vectorize without peeling.
+ * With `const T` the lanes are read-only.
+ */
+template <typename T>
+class Lanes {
+    using Base = std::remove_const_t<T>;
+    template <size_t I>
+    using Field = std::conditional_t<std::is_const_v<T>, const lane_field_t<Base, I>,
+                                     lane_field_t<Base, I>>;
+
+public:
+    static constexpr size_t count = lane_count<Base>();
+
+    Lanes() = default;
+    explicit Lanes(const std::array<void*, count>& lanes) : lanes_(lanes) {}
+
+    /** @brief Start of field `I`'s array for this run. */
+    template <size_t I>
+    Field<I>* lane() const {
+        return static_cast<Field<I>*>(lanes_[I]);
+    }
+
+    /** @brief Assembles row `i` from its lanes. */
+    Base load(size_t i) const { return load(i, std::make_index_sequence<count>{}); }
+
+    /** @brief Scatters `value` into row `i`'s lanes. */
+    void store(size_t i, const Base& value) const {
+        static_assert(!std::is_const_v<T>, "Lanes::store on read-only lanes");
+        store(i, value, std::make_index_sequence<count>{});
+    }
+
+private:
+    std::array<void*, count> lanes_{};
+
+    template <size_t... Is>
+    Base load(size_t i, std::index_sequence<Is...>) const {
+        Base value{};
+        ((value.*split_member<Base, Is> = lane<Is>()[i]), ...);
+        return value;
+    }
+
+    template <size_t... Is>
+    void store(size_t i, const Base& value, std::index_sequence<Is...>) const {
+        ((lane<Is>()[i] = value.*split_member<Base, Is>), ...);
+    }
+};
+
+} // namespace ecs
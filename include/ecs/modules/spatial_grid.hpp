@@ -0,0 +1,452 @@
+#pragma once
+#include "../span.hpp"
+#include "../world.hpp"
+#include "transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+/**
+ * @brief Uniform-grid spatial index over the translation of every `WorldTransform`.
+ *
+ * @details Each entity with a `WorldTransform` is bucketed into the cubic cell containing its
+ * world position (`matrix.m[12..14]`). Only occupied cells exist: a hash map takes packed cell
+ * coordinates to an index into a flat cell array, and each cell keeps its entities and their
+ * positions in two parallel arrays. A query visits the cells its shape overlaps and tests the
+ * stored positions, so it never touches component storage.
+ *
+ * `update()` keeps the grid in step with the World:
+ *
+ * 1. The first run, and any run after `invalidate()`, inserts every `WorldTransform`.
+ * 2. Later runs visit only `Changed<WorldTransform>` rows since the previous run. An entity
+ *    that stayed in its cell has its position overwritten; one that crossed a boundary is
+ *    swap-removed from the old cell and appended to the new one.
+ * 3. If the grid then holds more entities than `count<WorldTransform>()`, some were destroyed
+ *    or lost the component, and one sweep over the cells drops them.
+ *
+ * Call it once per frame after transform propagation. It reads through `const WorldTransform`
+ * and, like `TransformPropagator`, never advances the change tick: an update sees writes
+ * stamped after the tick of the previous update. The application calls
+ * `World::advance_tick()` once per frame, after both have run. Writes made after an update but
+ * before that advance are not seen by the next update. After `Checkpoint::restore` or
+ * deserialization, whose ticks do not describe the jump, call `invalidate()`.
+ *
+ * Queries return a `Span` over a caller-supplied vector (or an internal one for the overloads
+ * without it). The const overloads may run concurrently with each other, e.g. from `par_each`,
+ * but not with `update()`.
+ *
+ * @note Pick a cell size near the typical query radius. Much smaller cells make queries visit
+ * many cells; much larger ones make them test many far-away positions.
+ */
+class SpatialGrid {
+public:
+    /** @brief Creates an empty grid with cubic cells of edge `cell_size` (world units). */
+    explicit SpatialGrid(float cell_size = 1.0f)
+        : cell_size_(cell_size), inv_cell_size_(1.0f / cell_size) {
+        ECS_ASSERT(cell_size > 0.0f, "SpatialGrid cell size must be positive");
+    }
+
+    /** @brief Brings the grid up to date with the World's `WorldTransform`s. */
+    void update(World& world) { update_impl(world, nullptr); }
+
+    /** @brief Same as `update(world)`, computing the cells of changed entities in parallel. */
+    void update(World& world, ThreadPool& pool) { update_impl(world, &pool); }
+
+    /** @brief Forces the next update to rebuild the grid from every `WorldTransform`. */
+    void invalidate() { built_ = false; }
+
+    /** @brief Edge length of a cell. */
+    float cell_size() const { return cell_size_; }
+
+    /** @brief Number of entities in the grid. */
+    size_t size() const { return size_; }
+
+    /** @brief Number of cells that have held an entity since the last rebuild. */
+    size_t cell_count() const { return cells_.size(); }
+
+    /** @brief Number of entities inserted, moved or removed by the last update. */
+    size_t last_updated() const { return last_updated_; }
+
+    /** @brief Returns true if `e` (this generation) is in the grid. */
+    bool contains(Entity e) const {
+        if (e.index >= slots_.size() || slots_[e.index].cell == NO_CELL)
+            return false;
+        const Slot& s = slots_[e.index];
+        return cells_[s.cell].entities[s.row] == e;
+    }
+
+    /** @brief The world position of a transform matrix (its translation column). */
+    static Vec3 position_of(const Mat4& m) { return {m.m[12], m.m[13], m.m[14]}; }
+
+    /**
+     * @brief Entities within `radius` of `center` (inclusive), in no particular order.
+     * @param out Receives the result; its previous contents are discarded.
+     * @return A view of `out`.
+     */
+    Span<const Entity> query_radius(const Vec3& center, float radius,
+                                    std::vector<Entity>& out) const {
+        out.clear();
+        float r2 = radius * radius;
+        Vec3 lo{center.x - radius, center.y - radius, center.z - radius};
+        Vec3 hi{center.x + radius, center.y + radius, center.z + radius};
+        for_cells(coord_of(lo), coord_of(hi), [&](const Cell& cell) {
+            for (size_t i = 0; i < cell.positions.size(); ++i)
+                if (distance2(cell.positions[i], center) <= r2)
+                    out.push_back(cell.entities[i]);
+        });
+        return out;
+    }
+
+    /**
+     * @brief Entities whose position lies in the box `[min, max]` (inclusive), in no particular
+     * order.
+     * @param out Receives the result; its previous contents are discarded.
+     * @return A view of `out`.
+     */
+    Span<const Entity> query_aabb(const Vec3& min, const Vec3& max,
+                                  std::vector<Entity>& out) const {
+        out.clear();
+        for_cells(coord_of(min), coord_of(max), [&](const Cell& cell) {
+            for (size_t i = 0; i < cell.positions.size(); ++i) {
+                const Vec3& p = cell.positions[i];
+                if (p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y &&
+                    p.z >= min.z && p.z <= max.z)
+                    out.push_back(cell.entities[i]);
+            }
+        });
+        return out;
+    }
+
+    /**
+     * @brief The `k` entities nearest to `center`, closest first.
+     * @details Cells are visited in cubic shells of growing radius around the center's cell.
+     * The search stops once the k-th best distance is no larger than the nearest point any
+     * unvisited shell could hold. Ties are broken by entity index, so results are
+     * deterministic. Fewer than `k` entities are returned only if the grid holds fewer.
+     * @param out Receives the result; its previous contents are discarded.
+     * @return A view of `out`.
+     */
+    Span<const Entity> query_nearest(const Vec3& center, size_t k,
+                                     std::vector<Entity>& out) const {
+        out.clear();
+        if (k == 0 || size_ == 0)
+            return out;
+
+        // Max-heap of the best k candidates so far, ordered by (distance², entity index)
+        std::vector<Candidate> best;
+        best.reserve(std::min(k, size_));
+        auto consider = [&](const Cell& cell) {
+            for (size_t i = 0; i < cell.positions.size(); ++i) {
+                Candidate c{distance2(cell.positions[i], center), cell.entities[i]};
+                if (best.size() < k) {
+                    best.push_back(c);
+                    std::push_heap(best.begin(), best.end());
+                } else if (c < best.front()) {
+                    std::pop_heap(best.begin(), best.end());
+                    best.back() = c;
+                    std::push_heap(best.begin(), best.end());
+                }
+            }
+        };
+
+        // Shells closer than the occupied bounds are empty, so start at the first that reaches them
+        Coord c0 = coord_of(center);
+        int32_t first = std::max({0, min_.x - c0.x, c0.x - max_.x, min_.y - c0.y, c0.y - max_.y,
+                                  min_.z - c0.z, c0.z - max_.z});
+        for (int32_t r = first;; ++r) {
+            Coord lo{std::max(c0.x - r, min_.x), std::max(c0.y - r, min_.y),
+                     std::max(c0.z - r, min_.z)};
+            Coord hi{std::min(c0.x + r, max_.x), std::min(c0.y + r, max_.y),
+                     std::min(c0.z + r, max_.z)};
+            bool covers_all = c0.x - r <= min_.x && c0.y - r <= min_.y && c0.z - r <= min_.z &&
+                              c0.x + r >= max_.x && c0.y + r >= max_.y && c0.z + r >= max_.z;
+            if (box_volume(lo, hi) > cells_.size()) {
+                // The shells now span more cells than exist: finish with one pass over all
+                // cells not visited yet (those at least r away)
+                for (const Cell& cell : cells_)
+                    if (chebyshev(cell.coord, c0) >= r)
+                        consider(cell);
+                break;
+            }
+            for_shell(c0, r, lo, hi, consider);
+            // Every unvisited cell is at least r full cells away from the center
+            float reach = float(r) * cell_size_;
+            if (covers_all || (best.size() == k && best.front().d2 <= reach * reach))
+                break;
+        }
+
+        std::sort_heap(best.begin(), best.end());
+        for (const Candidate& c : best)
+            out.push_back(c.entity);
+        return out;
+    }
+
+    /** @brief `query_radius` into an internal buffer, valid until the next query on this grid. */
+    Span<const Entity> query_radius(const Vec3& center, float radius) {
+        return query_radius(center, radius, results_);
+    }
+
+    /** @brief `query_aabb` into an internal buffer, valid until the next query on this grid. */
+    Span<const Entity> query_aabb(const Vec3& min, const Vec3& max) {
+        return query_aabb(min, max, results_);
+    }
+
+    /** @brief `query_nearest` into an internal buffer, valid until the next query on this grid. */
+    Span<const Entity> query_nearest(const Vec3& center, size_t k) {
+        return query_nearest(center, k, results_);
+    }
+
+private:
+    static constexpr uint32_t NO_CELL = UINT32_MAX;
+    static constexpr int32_t COORD_LIMIT = (1 << 20) - 1; // 21 bits per packed axis
+    static constexpr size_t PARALLEL_GRAIN = 1024;        // changed entities per work item
+
+    struct Coord {
+        int32_t x, y, z;
+    };
+
+    struct Cell {
+        Coord coord;
+        std::vector<Entity> entities;
+        std::vector<Vec3> positions; // parallel to entities
+    };
+
+    struct Slot {
+        uint32_t cell = NO_CELL;
+        uint32_t row = 0;
+    };
+
+    struct Pending {
+        Entity entity;
+        Vec3 position;
+        Coord coord;
+    };
+
+    struct Candidate {
+        float d2;
+        Entity entity;
+        bool operator<(const Candidate& o) const {
+            return d2 < o.d2 || (d2 == o.d2 && entity.index < o.entity.index);
+        }
+    };
+
+    float cell_size_;
+    float inv_cell_size_;
+    std::vector<Cell> cells_;
+    std::unordered_map<uint64_t, uint32_t> cell_of_key_;
+    std::vector<Slot> slots_; // entity index -> cell and row
+    std::vector<Pending> pending_;
+    std::vector<Entity> results_;
+    Coord min_{0, 0, 0}; // bounds of the occupied cells, valid while size_ > 0
+    Coord max_{0, 0, 0};
+    size_t size_ = 0;
+    size_t last_updated_ = 0;
+    uint32_t since_ = 0;
+    bool built_ = false;
+
+    static float distance2(const Vec3& a, const Vec3& b) {
+        float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    static int32_t chebyshev(const Coord& a, const Coord& b) {
+        return std::max({std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z)});
+    }
+
+    static size_t box_volume(const Coord& lo, const Coord& hi) {
+        if (lo.x > hi.x || lo.y > hi.y || lo.z > hi.z)
+            return 0;
+        return size_t(hi.x - lo.x + 1) * size_t(hi.y - lo.y + 1) * size_t(hi.z - lo.z + 1);
+    }
+
+    static uint64_t key_of(const Coord& c) {
+        constexpr uint64_t mask = (uint64_t(1) << 21) - 1;
+        return (uint64_t(c.x + COORD_LIMIT) & mask) |
+               (uint64_t(c.y + COORD_LIMIT) & mask) << 21 |
+               (uint64_t(c.z + COORD_LIMIT) & mask) << 42;
+    }
+
+    // Clamped so far-away or non-finite positions still land in a valid (edge) cell
+    int32_t axis_of(float v) const {
+        float c = std::floor(v * inv_cell_size_);
+        if (!(c >= float(-COORD_LIMIT)))
+            return -COORD_LIMIT;
+        if (c > float(COORD_LIMIT))
+            return COORD_LIMIT;
+        return int32_t(c);
+    }
+
+    Coord coord_of(const Vec3& p) const { return {axis_of(p.x), axis_of(p.y), axis_of(p.z)}; }
+
+    // Calls fn(cell) for every occupied cell in the box [lo, hi] of cell coordinates
+    template <typename Fn>
+    void for_cells(Coord lo, Coord hi, Fn&& fn) const {
+        if (size_ == 0)
+            return;
+        lo = {std::max(lo.x, min_.x), std::max(lo.y, min_.y), std::max(lo.z, min_.z)};
+        hi = {std::min(hi.x, max_.x), std::min(hi.y, max_.y), std::min(hi.z, max_.z)};
+        size_t volume = box_volume(lo, hi);
+        if (volume == 0)
+            return;
+        if (volume > cells_.size()) {
+            // Cheaper to filter the occupied cells than to probe every coordinate in the box
+            for (const Cell& cell : cells_) {
+                const Coord& c = cell.coord;
+                if (c.x >= lo.x && c.x <= hi.x && c.y >= lo.y && c.y <= hi.y && c.z >= lo.z &&
+                    c.z <= hi.z)
+                    fn(cell);
+            }
+            return;
+        }
+        for (int32_t z = lo.z; z <= hi.z; ++z)
+            for (int32_t y = lo.y; y <= hi.y; ++y)
+                for (int32_t x = lo.x; x <= hi.x; ++x)
+                    visit(Coord{x, y, z}, fn);
+    }
+
+    // Calls fn(cell) for the occupied cells exactly r away from c0, clipped to [lo, hi]
+    template <typename Fn>
+    void for_shell(const Coord& c0, int32_t r, const Coord& lo, const Coord& hi, Fn&& fn) const {
+        for (int32_t z = lo.z; z <= hi.z; ++z) {
+            bool z_face = std::abs(z - c0.z) == r;
+            for (int32_t y = lo.y; y <= hi.y; ++y) {
+                if (z_face || std::abs(y - c0.y) == r) {
+                    for (int32_t x = lo.x; x <= hi.x; ++x)
+                        visit(Coord{x, y, z}, fn);
+                } else {
+                    // Interior rows of the shell only touch its two x faces
+                    if (c0.x - r >= lo.x)
+                        visit(Coord{c0.x - r, y, z}, fn);
+                    if (c0.x + r <= hi.x)
+                        visit(Coord{c0.x + r, y, z}, fn);
+                }
+            }
+        }
+    }
+
+    template <typename Fn>
+    void visit(const Coord& c, Fn& fn) const {
+        auto it = cell_of_key_.find(key_of(c));
+        if (it != cell_of_key_.end())
+            fn(cells_[it->second]);
+    }
+
+    uint32_t find_or_add_cell(const Coord& c) {
+        auto [it, inserted] = cell_of_key_.try_emplace(key_of(c), uint32_t(cells_.size()));
+        if (inserted) {
+            cells_.push_back(Cell{c, {}, {}});
+            if (cells_.size() == 1) {
+                min_ = max_ = c;
+            } else {
+                min_ = {std::min(min_.x, c.x), std::min(min_.y, c.y), std::min(min_.z, c.z)};
+                max_ = {std::max(max_.x, c.x), std::max(max_.y, c.y), std::max(max_.z, c.z)};
+            }
+        }
+        return it->second;
+    }
+
+    // Swap-removes a row, re-pointing the slot of the entity that moved into it
+    void erase_row(uint32_t cell_index, uint32_t row) {
+        Cell& cell = cells_[cell_index];
+        uint32_t last = uint32_t(cell.entities.size() - 1);
+        if (row != last) {
+            cell.entities[row] = cell.entities[last];
+            cell.positions[row] = cell.positions[last];
+            slots_[cell.entities[row].index].row = row;
+        }
+        cell.entities.pop_back();
+        cell.positions.pop_back();
+    }
+
+    void place(const Pending& p) {
+        Entity e = p.entity;
+        if (e.index >= slots_.size())
+            slots_.resize(e.index + 1);
+        uint32_t cell_index = find_or_add_cell(p.coord);
+        Slot& slot = slots_[e.index];
+        if (slot.cell == cell_index) {
+            // Same cell: overwrite in place (this also replaces a destroyed entity whose index
+            // was reused)
+            cells_[cell_index].entities[slot.row] = e;
+            cells_[cell_index].positions[slot.row] = p.position;
+            return;
+        }
+        if (slot.cell != NO_CELL)
+            erase_row(slot.cell, slot.row);
+        else
+            ++size_;
+        Cell& cell = cells_[cell_index];
+        slot = {cell_index, uint32_t(cell.entities.size())};
+        cell.entities.push_back(e);
+        cell.positions.push_back(p.position);
+    }
+
+    // Drops entities that were destroyed or lost their WorldTransform
+    void sweep(const World& reader) {
+        for (uint32_t ci = 0; ci < cells_.size(); ++ci) {
+            Cell& cell = cells_[ci];
+            for (uint32_t row = 0; row < cell.entities.size();) {
+                Entity e = cell.entities[row];
+                if (reader.has<WorldTransform>(e)) {
+                    ++row;
+                    continue;
+                }
+                erase_row(ci, row);
+                slots_[e.index].cell = NO_CELL;
+                --size_;
+                ++last_updated_;
+            }
+        }
+    }
+
+    void update_impl(World& world, ThreadPool* pool) {
+        if (!built_) {
+            cells_.clear();
+            cell_of_key_.clear();
+            slots_.assign(slots_.size(), Slot{});
+            size_ = 0;
+        }
+
+        // Gather the rows to place: everything on a rebuild, otherwise what changed
+        pending_.clear();
+        auto gather = [&](Entity e, const WorldTransform& wt) {
+            pending_.push_back({e, position_of(wt.matrix), {}});
+        };
+        if (built_)
+            world.each<const WorldTransform>(World::Changed<WorldTransform>{since_}, gather);
+        else
+            world.each<const WorldTransform>(gather);
+
+        // Cell coordinates are independent per entity; insertion below stays sequential
+        size_t n = pending_.size();
+        if (pool && n > PARALLEL_GRAIN) {
+            size_t items = (n + PARALLEL_GRAIN - 1) / PARALLEL_GRAIN;
+            pool->parallel_for(items, [&](size_t item) {
+                size_t last = std::min(n, (item + 1) * PARALLEL_GRAIN);
+                for (size_t i = item * PARALLEL_GRAIN; i < last; ++i)
+                    pending_[i].coord = coord_of(pending_[i].position);
+            });
+        } else {
+            for (Pending& p : pending_)
+                p.coord = coord_of(p.position);
+        }
+        for (const Pending& p : pending_)
+            place(p);
+        last_updated_ = n;
+
+        if (size_ != world.count<WorldTransform>())
+            sweep(world);
+
+        // The next update sees writes stamped after this tick (see the class note)
+        since_ = world.change_tick();
+        built_ = true;
+    }
+};
+
+} // namespace ecs
@@ -0,0 +1,264 @@
+#pragma once
+#include "../math.hpp"
+#include "transform.hpp"
+
+#include <cstddef>
+
+// Backend selection. Define ECS_NO_SIMD to force the scalar kernels.
+#if !defined(ECS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || \
+                              (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define ECS_SIMD_SSE2 1
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define ECS_SIMD_AVX 1
+#include <immintrin.h>
+#endif
+#elif !defined(ECS_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define ECS_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+/**
+ * @file transform_batch.hpp
+ * @brief Batch kernels that compose and multiply many transform matrices per call.
+ * @details `mat4_compose_batch` turns N LocalTransforms into N matrices four at a time (one
+ * transform per SIMD lane, transposed into column-major output). `mat4_multiply_batch` computes
+ * N independent products `a[i] * b[i]`, one matrix per iteration with whole columns in
+ * registers (two columns at once with AVX).
+ *
+ * Backends: SSE2 (always on x86-64), AVX for the multiply, NEON on ARM, and a scalar fallback.
+ * Every backend performs the same float operations in the same order as the scalar code (which
+ * follows `glm::mat4_cast` and GLM's `mat4 * mat4`), so results are bitwise identical across
+ * backends as long as the compiler does not contract multiply-adds into FMAs.
+ *
+ * Does not depend on GLM.
+ */
+
+namespace ecs {
+
+namespace simd {
+
+#if defined(ECS_SIMD_SSE2)
+
+using f32x4 = __m128;
+inline f32x4 set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+inline f32x4 splat(float a) { return _mm_set1_ps(a); }
+inline f32x4 add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+inline f32x4 sub(f32x4 a, f32x4 b) { return _mm_sub_ps(a, b); }
+inline f32x4 mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+inline f32x4 load(const float* p) { return _mm_load_ps(p); }
+inline void store(float* p, f32x4 v) { _mm_store_ps(p, v); }
+inline void transpose(f32x4& r0, f32x4& r1, f32x4& r2, f32x4& r3) {
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+#elif defined(ECS_SIMD_NEON)
+
+using f32x4 = float32x4_t;
+inline f32x4 set(float a, float b, float c, float d) {
+    const float v[4] = {a, b, c, d};
+    return vld1q_f32(v);
+}
+inline f32x4 splat(float a) { return vdupq_n_f32(a); }
+inline f32x4 add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+inline f32x4 sub(f32x4 a, f32x4 b) { return vsubq_f32(a, b); }
+inline f32x4 mul(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+inline f32x4 load(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, f32x4 v) { vst1q_f32(p, v); }
+inline void transpose(f32x4& r0, f32x4& r1, f32x4& r2, f32x4& r3) {
+    float32x4x2_t t01 = vtrnq_f32(r0, r1); // r0.0 r1.0 r0.2 r1.2 | r0.1 r1.1 r0.3 r1.3
+    float32x4x2_t t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+#endif
+
+} // namespace simd
+
+/** @brief Name of the kernel backend selected at compile time ("avx", "sse2", "neon", "scalar"). */
+inline const char* mat4_batch_backend() {
+#if defined(ECS_SIMD_AVX)
+    return "avx";
+#elif defined(ECS_SIMD_SSE2)
+    return "sse2";
+#elif defined(ECS_SIMD_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+/** @brief Composes one PRS transform into a matrix (scalar reference for the batch kernel). */
+inline void mat4_compose_scalar(const LocalTransform& local, Mat4& out) {
+    const Quat& q = local.rotation;
+    const Vec3& s = local.scale;
+    float qxx = q.x * q.x, qyy = q.y * q.y, qzz = q.z * q.z;
+    float qxz = q.x * q.z, qxy = q.x * q.y, qyz = q.y * q.z;
+    float qwx = q.w * q.x, qwy = q.w * q.y, qwz = q.w * q.z;
+    float* m = out.m;
+    m[0] = (1.0f - 2.0f * (qyy + qzz)) * s.x;
+    m[1] = (2.0f * (qxy + qwz)) * s.x;
+    m[2] = (2.0f * (qxz - qwy)) * s.x;
+    m[3] = 0.0f * s.x;
+    m[4] = (2.0f * (qxy - qwz)) * s.y;
+    m[5] = (1.0f - 2.0f * (qxx + qzz)) * s.y;
+    m[6] = (2.0f * (qyz + qwx)) * s.y;
+    m[7] = 0.0f * s.y;
+    m[8] = (2.0f * (qxz + qwy)) * s.z;
+    m[9] = (2.0f * (qyz - qwx)) * s.z;
+    m[10] = (1.0f - 2.0f * (qxx + qyy)) * s.z;
+    m[11] = 0.0f * s.z;
+    m[12] = local.position.x;
+    m[13] = local.position.y;
+    m[14] = local.position.z;
+    m[15] = 1.0f;
+}
+
+/**
+ * @brief Computes `out = a * b` for one matrix pair (scalar reference for the batch kernel).
+ * @details `out` may alias `a` or `b`.
+ */
+inline void mat4_multiply_scalar(const Mat4& a, const Mat4& b, Mat4& out) {
+    Mat4 r;
+    for (int j = 0; j < 4; ++j) {
+        const float* bj = b.m + 4 * j;
+        for (int i = 0; i < 4; ++i)
+            r.m[4 * j + i] = a.m[i] * bj[0] + a.m[4 + i] * bj[1] + a.m[8 + i] * bj[2] +
+                             a.m[12 + i] * bj[3];
+    }
+    out = r;
+}
+
+/**
+ * @brief Composes `n` LocalTransforms into `n` column-major matrices.
+ * @details Same result as `mat4_compose(position, rotation, scale)` for each element. `in` and
+ * `out` must not overlap.
+ */
+inline void mat4_compose_batch(const LocalTransform* in, Mat4* out, size_t n) {
+    size_t i = 0;
+#if defined(ECS_SIMD_SSE2) || defined(ECS_SIMD_NEON)
+    using namespace simd;
+    const f32x4 one = splat(1.0f);
+    const f32x4 two = splat(2.0f);
+    const f32x4 zero = splat(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        const LocalTransform* l = in + i;
+        f32x4 qx = set(l[0].rotation.x, l[1].rotation.x, l[2].rotation.x, l[3].rotation.x);
+        f32x4 qy = set(l[0].rotation.y, l[1].rotation.y, l[2].rotation.y, l[3].rotation.y);
+        f32x4 qz = set(l[0].rotation.z, l[1].rotation.z, l[2].rotation.z, l[3].rotation.z);
+        f32x4 qw = set(l[0].rotation.w, l[1].rotation.w, l[2].rotation.w, l[3].rotation.w);
+        f32x4 sx = set(l[0].scale.x, l[1].scale.x, l[2].scale.x, l[3].scale.x);
+        f32x4 sy = set(l[0].scale.y, l[1].scale.y, l[2].scale.y, l[3].scale.y);
+        f32x4 sz = set(l[0].scale.z, l[1].scale.z, l[2].scale.z, l[3].scale.z);
+
+        f32x4 qxx = mul(qx, qx), qyy = mul(qy, qy), qzz = mul(qz, qz);
+        f32x4 qxz = mul(qx, qz), qxy = mul(qx, qy), qyz = mul(qy, qz);
+        f32x4 qwx = mul(qw, qx), qwy = mul(qw, qy), qwz = mul(qw, qz);
+
+        // Lane k holds element [col][row] of matrix k; transposing gives whole columns
+        f32x4 c0 = mul(sub(one, mul(two, add(qyy, qzz))), sx);
+        f32x4 c1 = mul(mul(two, add(qxy, qwz)), sx);
+        f32x4 c2 = mul(mul(two, sub(qxz, qwy)), sx);
+        f32x4 c3 = mul(zero, sx);
+        transpose(c0, c1, c2, c3);
+        store(out[i + 0].m, c0);
+        store(out[i + 1].m, c1);
+        store(out[i + 2].m, c2);
+        store(out[i + 3].m, c3);
+
+        c0 = mul(mul(two, sub(qxy, qwz)), sy);
+        c1 = mul(sub(one, mul(two, add(qxx, qzz))), sy);
+        c2 = mul(mul(two, add(qyz, qwx)), sy);
+        c3 = mul(zero, sy);
+        transpose(c0, c1, c2, c3);
+        store(out[i + 0].m + 4, c0);
+        store(out[i + 1].m + 4, c1);
+        store(out[i + 2].m + 4, c2);
+        store(out[i + 3].m + 4, c3);
+
+        c0 = mul(mul(two, add(qxz, qwy)), sz);
+        c1 = mul(mul(two, sub(qyz, qwx)), sz);
+        c2 = mul(sub(one, mul(two, add(qxx, qyy))), sz);
+        c3 = mul(zero, sz);
+        transpose(c0, c1, c2, c3);
+        store(out[i + 0].m + 8, c0);
+        store(out[i + 1].m + 8, c1);
+        store(out[i + 2].m + 8, c2);
+        store(out[i + 3].m + 8, c3);
+
+        c0 = set(l[0].position.x, l[1].position.x, l[2].position.x, l[3].position.x);
+        c1 = set(l[0].position.y, l[1].position.y, l[2].position.y, l[3].position.y);
+        c2 = set(l[0].position.z, l[1].position.z, l[2].position.z, l[3].position.z);
+        c3 = one;
+        transpose(c0, c1, c2, c3);
+        store(out[i + 0].m + 12, c0);
+        store(out[i + 1].m + 12, c1);
+        store(out[i + 2].m + 12, c2);
+        store(out[i + 3].m + 12, c3);
+    }
+#endif
+    for (; i < n; ++i)
+        mat4_compose_scalar(in[i], out[i]);
+}
+
+/**
+ * @brief Computes `out[i] = a[i] * b[i]` for `n` matrix pairs.
+ * @details Same result as `mat4_multiply(a[i], b[i])` for each element. `out` may alias `a` or
+ * `b` element-for-element (e.g. `mat4_multiply_batch(parents, locals, locals, n)`).
+ */
+inline void mat4_multiply_batch(const Mat4* a, const Mat4* b, Mat4* out, size_t n) {
+#if defined(ECS_SIMD_AVX)
+    for (size_t i = 0; i < n; ++i) {
+        const float* am = a[i].m;
+        const float* bm = b[i].m;
+        // Each 128-bit half holds one column of a; each half of b is one of two columns
+        __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(am + 0));
+        __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(am + 4));
+        __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(am + 8));
+        __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(am + 12));
+        __m256 b01 = _mm256_loadu_ps(bm + 0);
+        __m256 b23 = _mm256_loadu_ps(bm + 8);
+        __m256 r01 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+        __m256 r23 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, 0x00));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, 0x55)));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(a1, _mm256_shuffle_ps(b23, b23, 0x55)));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, 0xAA)));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(a2, _mm256_shuffle_ps(b23, b23, 0xAA)));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, 0xFF)));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(a3, _mm256_shuffle_ps(b23, b23, 0xFF)));
+        _mm256_storeu_ps(out[i].m + 0, r01);
+        _mm256_storeu_ps(out[i].m + 8, r23);
+    }
+#elif defined(ECS_SIMD_SSE2) || defined(ECS_SIMD_NEON)
+    using namespace simd;
+    for (size_t i = 0; i < n; ++i) {
+        const float* bm = b[i].m;
+        f32x4 a0 = load(a[i].m + 0);
+        f32x4 a1 = load(a[i].m + 4);
+        f32x4 a2 = load(a[i].m + 8);
+        f32x4 a3 = load(a[i].m + 12);
+        // Column j of the product: a0 * b[j][0] + a1 * b[j][1] + a2 * b[j][2] + a3 * b[j][3]
+        auto column = [&](const float* bj) {
+            return add(add(add(mul(a0, splat(bj[0])), mul(a1, splat(bj[1]))),
+                           mul(a2, splat(bj[2]))),
+                       mul(a3, splat(bj[3])));
+        };
+        f32x4 r0 = column(bm + 0);
+        f32x4 r1 = column(bm + 4);
+        f32x4 r2 = column(bm + 8);
+        f32x4 r3 = column(bm + 12);
+        store(out[i].m + 0, r0);
+        store(out[i].m + 4, r1);
+        store(out[i].m + 8, r2);
+        store(out[i].m + 12, r3);
+    }
+#else
+    for (size_t i = 0; i < n; ++i)
+        mat4_multiply_scalar(a[i], b[i], out[i]);
+#endif
+}
+
+} // namespace ecs
@@ -3,11 +3,50 @@
 #include "../integration/glm.hpp"
 #include "hierarchy.hpp"
 #include "transform.hpp"
+#include "transform_batch.hpp"
 
-#include <queue>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
 
 namespace ecs {
 
+namespace detail {
+// Gathered inputs for one kernel call over nodes of one depth level. Filled per level, so the
+// arrays stay uninitialized; `Target` says where each result goes.
+template <typename Target>
+struct TransformBatch {
+    static constexpr size_t CAPACITY = 64;
+
+    TransformBatch() {}
+    union {
+        LocalTransform locals[CAPACITY];
+    };
+    Mat4 parents[CAPACITY];
+    Mat4 results[CAPACITY];
+    Target targets[CAPACITY];
+    size_t size = 0;
+
+    // Appends a node; returns true when the batch is full
+    bool push(const LocalTransform& local, Target target) {
+        new (&locals[size]) LocalTransform(local);
+        targets[size] = target;
+        return ++size == CAPACITY;
+    }
+    bool push(const LocalTransform& local, const Mat4& parent, Target target) {
+        parents[size] = parent;
+        return push(local, target);
+    }
+
+    // Composes the gathered locals into `results`, times their parents unless `roots`
+    void compute(bool roots) {
+        mat4_compose_batch(locals, results, size);
+        if (!roots)
+            mat4_multiply_batch(parents, results, results, size);
+    }
+};
+} // namespace detail
+
 /**
  * @brief Propagates LocalTransforms to WorldTransforms through the hierarchy.
  * @details Performs a Breadth-First Search (BFS) starting from root entities (entities with
@@ -16,50 +55,270 @@ namespace ecs {
  * 
  * Roots: WorldTransform = Compose(LocalTransform)
  * Children: WorldTransform = Parent.WorldTransform * Compose(LocalTransform)
+ *
+ * The BFS advances one depth level at a time and feeds each level through
+ * `mat4_compose_batch` / `mat4_multiply_batch` in groups of 64.
  * 
  * @param world The ECS world to process.
  */
 inline void propagate_transforms(World& world) {
-    std::queue<Entity> queue;
+    const World& reader = world; // read-only lookups do not mark components changed
+
+    // Matrices are computed 64 at a time through the batch kernels
+    detail::TransformBatch<WorldTransform*> batch;
+    auto flush = [&](bool roots) {
+        batch.compute(roots);
+        for (size_t k = 0; k < batch.size; ++k)
+            batch.targets[k]->matrix = batch.results[k];
+        batch.size = 0;
+    };
+
+    // The BFS runs one level at a time, so every parent is final before its children batch
+    std::vector<Entity> level;
+    std::vector<Entity> next;
+    auto enqueue_children = [&](Entity e, std::vector<Entity>& out) {
+        auto* children = reader.try_get<Children>(e);
+        if (children)
+            out.insert(out.end(), children->entities.begin(), children->entities.end());
+    };
 
     // Find roots (entities with transforms but no Parent) and seed the BFS
-    world.each<LocalTransform, WorldTransform>(
-        World::Exclude<Parent>{}, [&](Entity e, LocalTransform& local, WorldTransform& wt) {
+    world.each<const LocalTransform, WorldTransform>(
+        World::Exclude<Parent>{}, [&](Entity e, const LocalTransform& local, WorldTransform& wt) {
             // Root entity: World = Local (composed)
-            wt.matrix = mat4_compose(local.position, local.rotation, local.scale);
-            
-            auto* children = world.try_get<Children>(e);
-            if (children) {
-                for (auto child : children->entities)
-                    queue.push(child);
-            }
+            if (batch.push(local, &wt))
+                flush(true);
+            enqueue_children(e, level);
         });
+    flush(true);
 
     // BFS through children
-    while (!queue.empty()) {
-        Entity e = queue.front();
-        queue.pop();
-
-        auto* parent_comp = world.try_get<Parent>(e);
-        if (!parent_comp)
-            continue;
-
-        auto* parent_wt = world.try_get<WorldTransform>(parent_comp->entity);
-        auto* local = world.try_get<LocalTransform>(e);
-        auto* wt = world.try_get<WorldTransform>(e);
-        if (!parent_wt || !local || !wt)
-            continue;
-
-        // Child World = Parent World * Local Matrix
-        Mat4 local_mat = mat4_compose(local->position, local->rotation, local->scale);
-        wt->matrix = mat4_multiply(parent_wt->matrix, local_mat);
-
-        auto* children = world.try_get<Children>(e);
-        if (children) {
-            for (auto child : children->entities)
-                queue.push(child);
+    while (!level.empty()) {
+        next.clear();
+        for (Entity e : level) {
+            auto* parent_comp = reader.try_get<Parent>(e);
+            if (!parent_comp)
+                continue;
+
+            auto* parent_wt = reader.try_get<WorldTransform>(parent_comp->entity);
+            auto* local = reader.try_get<LocalTransform>(e);
+            auto* wt = world.try_get<WorldTransform>(e);
+            if (!parent_wt || !local || !wt)
+                continue;
+
+            // Child World = Parent World * Local Matrix
+            if (batch.push(*local, parent_wt->matrix, wt))
+                flush(false);
+            enqueue_children(e, next);
         }
+        flush(false);
+        level.swap(next);
     }
 }
 
+/**
+ * @brief Incremental transform propagation over a cached, depth-ordered copy of the hierarchy.
+ *
+ * @details Keeps every transform node (an entity with LocalTransform + WorldTransform that is a
+ * root or reachable through `Children`) in one flat array sorted by depth, with each node's
+ * parent stored as an array index and its last world matrix cached inline. A run:
+ *
+ * 1. Rebuilds the array if the hierarchy may have changed since the last run: any `Parent` or
+ *    `Children` added/changed, any transform node added, or the number of transform or `Parent`
+ *    components differs (catches removals and destruction).
+ * 2. Marks nodes whose `LocalTransform` changed since the last run (via `World::Changed`).
+ * 3. Walks the levels in order; a node is recomposed when it or its parent is dirty. Parent
+ *    matrices come from the flat array, not from component lookups. Dirty nodes are gathered
+ *    64 at a time and run through `mat4_compose_batch` / `mat4_multiply_batch`. With a pool,
+ *    each level's nodes are recomposed in parallel.
+ * 4. Writes the recomposed matrices back to `WorldTransform` (marking them changed) and
+ *    remembers the world's change tick.
+ *
+ * Results match `propagate_transforms`. Unchanged subtrees cost one flag test per node. The
+ * first run, and any run after a hierarchy change, recomputes everything.
+ *
+ * @note Use one propagator per World. Read-only lookups go through a `const World&`, so the
+ * propagator's own reads never count as changes. The propagator never advances the change
+ * tick: a run sees writes stamped after the tick of the previous run, so the application must
+ * call `World::advance_tick()` between runs (once per frame, after propagation). Writes made
+ * after a run but before that advance are not seen by the next run. `Checkpoint::restore`
+ * rewinds the tick, so call `invalidate()` after it.
+ */
+class TransformPropagator {
+public:
+    /** @brief Propagates changed transforms on the calling thread. */
+    void run(World& world) { run_impl(world, nullptr); }
+
+    /** @brief Propagates changed transforms, recomposing each depth level in parallel. */
+    void run(World& world, ThreadPool& pool) { run_impl(world, &pool); }
+
+    /** @brief Forces the next run to rebuild the hierarchy and recompute every node. */
+    void invalidate() { built_ = false; }
+
+    /** @brief Number of transform nodes in the cached hierarchy. */
+    size_t node_count() const { return nodes_.size(); }
+
+    /** @brief Number of depth levels in the cached hierarchy (roots are level 0). */
+    size_t depth() const { return level_begin_.empty() ? 0 : level_begin_.size() - 1; }
+
+    /** @brief Number of nodes recomposed by the last run. */
+    size_t last_updated() const { return last_updated_; }
+
+private:
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+    static constexpr size_t PARALLEL_GRAIN = 256; // nodes per parallel work item
+
+    struct Node {
+        Entity entity;
+        uint32_t parent; // index into nodes_, NO_NODE for roots
+    };
+
+    using Batch = detail::TransformBatch<uint32_t>; // targets are node indices
+
+    std::vector<Node> nodes_;          // depth-ordered
+    std::vector<Mat4> world_;          // per node: last computed world matrix
+    std::vector<size_t> level_begin_;  // level d is nodes_[level_begin_[d], level_begin_[d + 1])
+    std::vector<uint32_t> node_of_;    // entity index -> node index
+    std::vector<uint8_t> dirty_;       // per node
+    size_t transform_count_ = 0;
+    size_t parent_count_ = 0;
+    uint32_t since_ = 0;
+    size_t last_updated_ = 0;
+    bool built_ = false;
+
+    template <typename T, typename Filter>
+    static bool any_rows(World& world, Filter filter) {
+        bool any = false;
+        world.each<const T>(filter, [&](Entity, const T&) { any = true; });
+        return any;
+    }
+
+    bool hierarchy_changed(World& world) const {
+        return !built_ || world.count<LocalTransform, WorldTransform>() != transform_count_ ||
+               world.count<Parent>() != parent_count_ ||
+               any_rows<LocalTransform>(world, World::Added<LocalTransform, WorldTransform>{since_}) ||
+               any_rows<Parent>(world, World::Changed<Parent>{since_}) ||
+               any_rows<Children>(world, World::Changed<Children>{since_});
+    }
+
+    void rebuild(World& world) {
+        const World& reader = world;
+        nodes_.clear();
+        level_begin_.assign(1, 0);
+        node_of_.assign(node_of_.size(), NO_NODE);
+
+        auto add_node = [&](Entity e, uint32_t parent) {
+            if (e.index >= node_of_.size())
+                node_of_.resize(e.index + 1, NO_NODE);
+            node_of_[e.index] = static_cast<uint32_t>(nodes_.size());
+            nodes_.push_back({e, parent});
+        };
+
+        world.each<const LocalTransform, const WorldTransform>(
+            World::Exclude<Parent>{},
+            [&](Entity e, const LocalTransform&, const WorldTransform&) { add_node(e, NO_NODE); });
+
+        // Breadth-first expansion, one level at a time, so levels are contiguous ranges
+        size_t begin = 0;
+        while (begin < nodes_.size()) {
+            size_t end = nodes_.size();
+            level_begin_.push_back(end);
+            for (size_t i = begin; i < end; ++i) {
+                auto* children = reader.try_get<Children>(nodes_[i].entity);
+                if (!children)
+                    continue;
+                for (Entity child : children->entities) {
+                    auto* parent = reader.try_get<Parent>(child);
+                    if (!parent || !reader.has<LocalTransform>(child) ||
+                        !reader.has<WorldTransform>(child))
+                        continue;
+                    if (child.index < node_of_.size() && node_of_[child.index] != NO_NODE)
+                        continue; // already placed (duplicate link or cycle)
+                    // Compose against the entity the child names as its parent (as the BFS does)
+                    Entity p = parent->entity;
+                    if (p.index >= node_of_.size() || node_of_[p.index] == NO_NODE ||
+                        nodes_[node_of_[p.index]].entity != p)
+                        continue;
+                    add_node(child, node_of_[p.index]);
+                }
+            }
+            begin = end;
+        }
+
+        world_.resize(nodes_.size());
+        dirty_.assign(nodes_.size(), 1);
+        transform_count_ = world.count<LocalTransform, WorldTransform>();
+        parent_count_ = world.count<Parent>();
+        built_ = true;
+    }
+
+    void flush(Batch& batch, bool roots) {
+        if (batch.size == 0)
+            return;
+        batch.compute(roots);
+        for (size_t k = 0; k < batch.size; ++k)
+            world_[batch.targets[k]] = batch.results[k];
+        batch.size = 0;
+    }
+
+    // Recomposes the dirty nodes in [first, last), which all lie on one level
+    void recompose(const World& reader, size_t first, size_t last, bool roots) {
+        Batch batch;
+        for (size_t i = first; i < last; ++i) {
+            const Node& node = nodes_[i];
+            if (!roots && dirty_[node.parent])
+                dirty_[i] = 1;
+            if (!dirty_[i])
+                continue;
+            const LocalTransform& local = reader.get<LocalTransform>(node.entity);
+            uint32_t target = static_cast<uint32_t>(i);
+            bool full = roots ? batch.push(local, target)
+                              : batch.push(local, world_[node.parent], target);
+            if (full)
+                flush(batch, roots);
+        }
+        flush(batch, roots);
+    }
+
+    void run_impl(World& world, ThreadPool* pool) {
+        const World& reader = world;
+        if (hierarchy_changed(world)) {
+            rebuild(world);
+        } else {
+            world.each<const LocalTransform>(
+                World::Changed<LocalTransform>{since_}, [&](Entity e, const LocalTransform&) {
+                    if (e.index < node_of_.size() && node_of_[e.index] != NO_NODE)
+                        dirty_[node_of_[e.index]] = 1;
+                });
+        }
+
+        // Levels in order: a node's parent is always finished before the node is visited
+        for (size_t d = 0; d + 1 < level_begin_.size(); ++d) {
+            size_t begin = level_begin_[d];
+            size_t n = level_begin_[d + 1] - begin;
+            bool roots = d == 0; // level 0 holds exactly the roots
+            if (pool && n > PARALLEL_GRAIN) {
+                size_t items = (n + PARALLEL_GRAIN - 1) / PARALLEL_GRAIN;
+                pool->parallel_for(items, [&](size_t item) {
+                    size_t first = begin + item * PARALLEL_GRAIN;
+                    size_t last = std::min(begin + n, first + PARALLEL_GRAIN);
+                    recompose(reader, first, last, roots);
+                });
+            } else {
+                recompose(reader, begin, begin + n, roots);
+            }
+        }
+
+        last_updated_ = 0;
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            if (!dirty_[i])
+                continue;
+            world.get<WorldTransform>(nodes_[i].entity).matrix = world_[i];
+            dirty_[i] = 0;
+            ++last_updated_;
+        }
+        since_ = world.change_tick();
+    }
+};
+
 } // namespace ecs
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "allocator.hpp"
 #include "component.hpp"
 #include "entity.hpp"
+#include "span.hpp"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <new>
 #include <type_traits>
@@ -30,6 +33,7 @@ public:
         ComponentColumn::MoveFunc move_fn;
         ComponentColumn::DestroyFunc destroy_fn;
         void (*copy_fn)(void* dst, const void* src);
+        bool trivially_copyable; // instantiate_n broadcasts the default with memcpy
     };
 
     Prefab() = default;
@@ -40,7 +44,8 @@ public:
         }
     }
 
-    Prefab(const Prefab& o) : entries_(o.entries_), buf_(o.buf_.size()) {
+    Prefab(const Prefab& o)
+        : entries_(o.entries_), types_(o.types_), buf_(o.buf_.size(), 0, o.buf_.get_allocator()) {
         // Copy-construct each component from o's buffer into ours
         for (auto& entry : entries_) {
             entry.copy_fn(buf_.data() + entry.buf_offset, o.buf_.data() + entry.buf_offset);
@@ -54,6 +59,7 @@ public:
                 entry.destroy_fn(buf_.data() + entry.buf_offset);
 
             entries_ = o.entries_;
+            types_ = o.types_;
             buf_.resize(o.buf_.size());
             for (auto& entry : entries_) {
                 entry.copy_fn(buf_.data() + entry.buf_offset, o.buf_.data() + entry.buf_offset);
@@ -62,8 +68,10 @@ public:
         return *this;
     }
 
-    Prefab(Prefab&& o) noexcept : entries_(std::move(o.entries_)), buf_(std::move(o.buf_)) {
+    Prefab(Prefab&& o) noexcept
+        : entries_(std::move(o.entries_)), types_(std::move(o.types_)), buf_(std::move(o.buf_)) {
         o.entries_.clear();
+        o.types_.clear();
     }
 
     Prefab& operator=(Prefab&& o) noexcept {
@@ -71,8 +79,10 @@ public:
             for (auto& entry : entries_)
                 entry.destroy_fn(buf_.data() + entry.buf_offset);
             entries_ = std::move(o.entries_);
+            types_ = std::move(o.types_);
             buf_ = std::move(o.buf_);
             o.entries_.clear();
+            o.types_.clear();
         }
         return *this;
     }
@@ -85,11 +95,28 @@ public:
      */
     template <typename... Ts>
     static Prefab create(Ts&&... components) {
+        return create_using(default_allocator(), std::forward<Ts>(components)...);
+    }
+
+    /**
+     * @brief Creates a new Prefab whose component data is stored via `allocator`.
+     * @details E.g. `Prefab::create_using(world.allocator(), ...)`. The allocator must outlive
+     * the prefab and its copies.
+     */
+    template <typename... Ts>
+    static Prefab create_using(const Allocator& allocator, Ts&&... components) {
         static_assert(sizeof...(Ts) > 0, "Prefab::create requires at least one component");
         (static_assert_copyable<std::decay_t<Ts>>(), ...);
 
         Prefab p;
+        p.buf_ = ByteBuffer(StlAllocator<uint8_t>(&allocator));
+        // One allocation: the buffer never grows (and never relocates components) while filling
+        p.buf_.reserve((align_up(sizeof(std::decay_t<Ts>), alignof(std::max_align_t)) + ...));
         (p.add_component<std::decay_t<Ts>>(std::forward<Ts>(components)), ...);
+        for (auto& entry : p.entries_)
+            if (!is_sparse_component_id(entry.cid))
+                p.types_.push_back(entry.cid);
+        std::sort(p.types_.begin(), p.types_.end());
         return p;
     }
 
@@ -108,9 +135,17 @@ public:
     const std::vector<Entry>& entries() const { return entries_; }
     const uint8_t* data() const { return buf_.data(); }
 
+    /**
+     * @brief The sorted IDs of the non-sparse entries: the archetype key of an instance.
+     * @details Built once by `create`, so `instantiate` looks the archetype up without
+     * rebuilding or sorting a type set.
+     */
+    const std::vector<ComponentTypeID>& types() const { return types_; }
+
 private:
     std::vector<Entry> entries_;
-    std::vector<uint8_t> buf_;
+    std::vector<ComponentTypeID> types_; // sorted non-sparse entry IDs
+    ByteBuffer buf_;
 
     template <typename T>
     static void static_assert_copyable() {
@@ -140,6 +175,7 @@ private:
             col.move_fn,
             col.destroy_fn,
             [](void* dst, const void* src) { new (dst) U(*static_cast<const U*>(src)); },
+            std::is_trivially_copyable_v<U>,
         });
     }
 };
@@ -165,4 +201,22 @@ Entity instantiate(World& world, const Prefab& prefab);
 template <typename... Overrides>
 Entity instantiate(World& world, const Prefab& prefab, Overrides&&... overrides);
 
+/**
+ * @brief Creates `n` entities from a prefab in one batch.
+ * @details Looks the archetype up once by the prefab's sorted type set, reserves capacity once
+ * and copies each default into whole column runs — with `memcpy` for trivially copyable types.
+ * Observers see the batch as `create_n` does.
+ * @return The new entities in creation order (see `World::create_n` for lifetime).
+ */
+Span<const Entity> instantiate_n(World& world, const Prefab& prefab, size_t n);
+
+/**
+ * @brief Creates `n` entities from a prefab with per-instance overrides from a generator.
+ * @tparam Overrides Component types to override or add (must be given explicitly; not sparse).
+ * @tparam Gen Callable `std::tuple<Overrides...>(size_t index)`, called once per entity in order.
+ * @return The new entities in creation order (see `World::create_n` for lifetime).
+ */
+template <typename... Overrides, typename Gen>
+Span<const Entity> instantiate_n(World& world, const Prefab& prefab, size_t n, Gen&& gen);
+
 } // namespace ecs
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @file profile.hpp
+ * @brief Opt-in instrumentation: World counters, per-system timings and trace events.
+ * @details Define `ECS_PROFILE` (CMake: `-DECS_PROFILE=ON`) identically in every translation
+ * unit to compile the instrumentation in. Without it the counters and trace scopes compile to
+ * nothing: `World::stats()` and `SystemRegistry::stats()` report zeros and no events are sent.
+ */
+
+namespace ecs {
+
+/** @brief Snapshot of a World's instrumentation counters (see `World::stats`). */
+struct WorldStats {
+    uint64_t entities_visited = 0;    ///< Rows passed to `each`/`par_each` callbacks.
+    uint64_t query_cache_hits = 0;    ///< Query lookups answered by an existing cache entry.
+    uint64_t query_cache_misses = 0;  ///< Lookups that built a new entry (full archetype scan).
+    uint64_t query_cache_updates = 0; ///< Archetypes appended to cached entries on creation.
+    uint64_t entities_migrated = 0;   ///< Rows moved to another archetype by add/remove.
+    uint64_t storage_allocations = 0; ///< Blocks or chunks allocated for archetype rows.
+    uint64_t bytes_moved = 0;         ///< Component bytes relocated by block reallocation.
+    uint64_t commands_flushed = 0;    ///< `CommandBuffer` commands applied to the world.
+};
+
+/**
+ * @brief Live counters behind `WorldStats`.
+ * @details Relaxed atomics: parallel queries and systems count concurrently, and only totals
+ * are reported.
+ */
+struct ProfileCounters {
+    std::atomic<uint64_t> entities_visited{0};
+    std::atomic<uint64_t> query_cache_hits{0};
+    std::atomic<uint64_t> query_cache_misses{0};
+    std::atomic<uint64_t> query_cache_updates{0};
+    std::atomic<uint64_t> entities_migrated{0};
+    std::atomic<uint64_t> storage_allocations{0};
+    std::atomic<uint64_t> bytes_moved{0};
+    std::atomic<uint64_t> commands_flushed{0};
+
+    WorldStats snapshot() const {
+        auto get = [](const std::atomic<uint64_t>& c) { return c.load(std::memory_order_relaxed); };
+        return {get(entities_visited),    get(query_cache_hits),  get(query_cache_misses),
+                get(query_cache_updates), get(entities_migrated), get(storage_allocations),
+                get(bytes_moved),         get(commands_flushed)};
+    }
+
+    void reset() {
+        for (auto* c : {&entities_visited, &query_cache_hits, &query_cache_misses,
+                        &query_cache_updates, &entities_migrated, &storage_allocations,
+                        &bytes_moved, &commands_flushed})
+            c->store(0, std::memory_order_relaxed);
+    }
+};
+
+/** @brief Counters of one query key (see `World::query_stats`). */
+struct QueryStats {
+    std::vector<uint32_t> include;    ///< Included component IDs, in query order.
+    std::vector<uint32_t> exclude;    ///< Excluded component IDs, in query order.
+    uint64_t entities_visited = 0;    ///< Rows passed to callbacks through this query.
+    uint64_t query_cache_hits = 0;    ///< Lookups answered by the existing entry.
+    uint64_t query_cache_misses = 0;  ///< Lookups that built the entry (full archetype scan).
+    uint64_t query_cache_updates = 0; ///< Archetypes appended to the entry on creation.
+};
+
+/** @brief Live counters behind one `QueryStats`; relaxed atomics, as in `ProfileCounters`. */
+struct QueryCounters {
+    std::atomic<uint64_t> entities_visited{0};
+    std::atomic<uint64_t> query_cache_hits{0};
+    std::atomic<uint64_t> query_cache_misses{0};
+    std::atomic<uint64_t> query_cache_updates{0};
+
+    void add_to(QueryStats& s) const {
+        auto get = [](const std::atomic<uint64_t>& c) { return c.load(std::memory_order_relaxed); };
+        s.entities_visited += get(entities_visited);
+        s.query_cache_hits += get(query_cache_hits);
+        s.query_cache_misses += get(query_cache_misses);
+        s.query_cache_updates += get(query_cache_updates);
+    }
+
+    void reset() {
+        for (auto* c : {&entities_visited, &query_cache_hits, &query_cache_misses,
+                        &query_cache_updates})
+            c->store(0, std::memory_order_relaxed);
+    }
+};
+
+/** @brief Accumulated wall time of one system (see `SystemRegistry::stats`). */
+struct SystemStats {
+    uint64_t calls = 0;
+    uint64_t total_ns = 0;
+    uint64_t last_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+/**
+ * @brief Receives begin/end events of instrumented scopes (systems, deferred flushes).
+ * @details Events arrive on the thread that runs the scope and nest properly per thread, so
+ * they map directly onto Chrome trace "B"/"E" events (`ChromeTraceWriter`) or Tracy zones
+ * (e.g. a thread-local stack of `TracyCZoneCtx`). Callbacks may be invoked concurrently from
+ * pool threads. `name` is only valid during the call.
+ */
+struct TraceSink {
+    void* user = nullptr;
+    void (*begin)(void* user, const char* name) = nullptr;
+    void (*end)(void* user, const char* name) = nullptr;
+};
+
+/** @brief Sends `begin` on construction and `end` on destruction; a null sink does nothing. */
+class TraceScope {
+public:
+    TraceScope(const TraceSink* sink, const char* name) : sink_(sink), name_(name) {
+        if (sink_)
+            sink_->begin(sink_->user, name_);
+    }
+    ~TraceScope() {
+        if (sink_)
+            sink_->end(sink_->user, name_);
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const TraceSink* sink_;
+    const char* name_;
+};
+
+#if defined(ECS_PROFILE)
+#define ECS_PROFILE_ADD(counters, field, n)                                                        \
+    ((counters).field.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed))
+#define ECS_TRACE_SCOPE(sink, name) ::ecs::TraceScope ecs_trace_scope_(sink, name)
+#else
+#define ECS_PROFILE_ADD(counters, field, n) ((void)0)
+#define ECS_TRACE_SCOPE(sink, name) ((void)0)
+#endif
+
+/**
+ * @brief A `TraceSink` that records events in memory and writes them as a Chrome trace.
+ * @details The output loads in `chrome://tracing` and Perfetto. Thread ids are small integers
+ * in order of first appearance. Recording takes a mutex, which is fine at system granularity.
+ */
+class ChromeTraceWriter {
+public:
+    ChromeTraceWriter() : origin_(std::chrono::steady_clock::now()) {}
+
+    /** @brief Returns a sink bound to this writer; pass it to `World::set_trace_sink`. */
+    TraceSink sink() { return {this, &on_begin, &on_end}; }
+
+    /** @brief Number of events recorded so far. */
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return events_.size();
+    }
+
+    /** @brief Discards the recorded events. Timestamps keep counting from construction. */
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_.clear();
+    }
+
+    /** @brief Writes `{"traceEvents": [...]}` with one "B"/"E" event per recorded event. */
+    void write(std::ostream& out) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out << "{\"traceEvents\": [";
+        for (size_t i = 0; i < events_.size(); ++i) {
+            const Event& e = events_[i];
+            char ts[32];
+            std::snprintf(ts, sizeof(ts), "%.3f", e.ts_us);
+            out << (i ? ",\n" : "\n") << "{\"name\": \"";
+            write_escaped(out, e.name);
+            out << "\", \"ph\": \"" << e.phase << "\", \"ts\": " << ts
+                << ", \"pid\": 1, \"tid\": " << e.tid << "}";
+        }
+        out << "\n]}\n";
+    }
+
+private:
+    struct Event {
+        std::string name;
+        char phase;
+        uint32_t tid;
+        double ts_us;
+    };
+
+    std::chrono::steady_clock::time_point origin_;
+    mutable std::mutex mutex_;
+    std::vector<Event> events_;
+    std::vector<std::thread::id> threads_;
+
+    static void on_begin(void* self, const char* name) {
+        static_cast<ChromeTraceWriter*>(self)->record(name, 'B');
+    }
+    static void on_end(void* self, const char* name) {
+        static_cast<ChromeTraceWriter*>(self)->record(name, 'E');
+    }
+
+    void record(const char* name, char phase) {
+        double ts = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                               origin_)
+                        .count();
+        std::thread::id id = std::this_thread::get_id();
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint32_t tid = 0;
+        while (tid < threads_.size() && threads_[tid] != id)
+            ++tid;
+        if (tid == threads_.size())
+            threads_.push_back(id);
+        events_.push_back({name, phase, tid, ts});
+    }
+
+    static void write_escaped(std::ostream& out, const std::string& s) {
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                out << buf;
+            } else {
+                out << c;
+            }
+        }
+    }
+};
+
+} // namespace ecs
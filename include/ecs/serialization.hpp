@@ -1,17 +1,95 @@
 #pragma once
 #include "world.hpp"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
+#include <streambuf>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ECS_SNAPSHOT_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace ecs {
 
+// Tag columns store no data and are written with element size 0. Files from before tags lost
+// their storage record sizeof(T) bytes per row instead; loaders accept and skip them.
+inline bool stored_size_matches(const ComponentColumn& col, uint32_t stored) {
+    return col.elem_size == stored || col.tag;
+}
+
+// --- v2 snapshot format ---
+
+/** @brief Format version written by `serialize_snapshot`. */
+inline constexpr uint32_t SNAPSHOT_VERSION = 2;
+/** @brief Version written by `serialize`: the v1 layout followed by the generation floor. */
+inline constexpr uint32_t SERIALIZE_VERSION = 3;
+/** @brief Alignment of every blob in a v2 snapshot (one page on common platforms). */
+inline constexpr uint64_t SNAPSHOT_ALIGN = 4096;
+
+/** @brief How a column's blob is encoded in a v2 snapshot. */
+enum SnapshotEncoding : uint32_t {
+    SnapshotRaw,    ///< `count * elem_size` bytes, the rows exactly as stored in memory.
+    SnapshotStream, ///< The concatenated output of the component's `serialize_fn`.
+};
+
+/** @brief Fixed header at offset 0 of a v2 snapshot. */
+struct SnapshotHeader {
+    char magic[4];            ///< "ECS\0", as in v1.
+    uint32_t version;         ///< `SNAPSHOT_VERSION`.
+    uint32_t align;           ///< Blob alignment used by the writer.
+    uint32_t archetype_count; ///< Entries in the archetype table.
+    uint32_t slot_count;      ///< Entity slots (length of the generations blob).
+    uint32_t free_count;      ///< Length of the free-list blob.
+    uint64_t table_offset;    ///< Offset of the archetype table.
+    uint64_t generations_offset;
+    uint64_t free_list_offset; ///< Free list, then the generation floor (uint32_t each).
+    uint64_t size;             ///< Total snapshot size in bytes.
+};
+
+/** @brief Archetype table entry; followed by `component_count` column entries. */
+struct SnapshotArchetype {
+    uint32_t component_count;
+    uint32_t entity_count;
+    uint64_t entities_offset; ///< `entity_count` Entities (index, generation).
+};
+
+/** @brief Column table entry; followed by the name, zero-padded to a multiple of 8 bytes. */
+struct SnapshotColumn {
+    uint32_t name_len;
+    uint32_t elem_size;
+    uint32_t encoding; ///< A `SnapshotEncoding`.
+    uint32_t reserved;
+    uint64_t offset; ///< Blob offset.
+    uint64_t size;   ///< Blob size in bytes.
+};
+
+static_assert(sizeof(SnapshotHeader) == 56 && sizeof(SnapshotArchetype) == 16 &&
+                  sizeof(SnapshotColumn) == 32,
+              "snapshot table layout must not depend on padding");
+static_assert(sizeof(Entity) == 8 && std::is_trivially_copyable_v<Entity>,
+              "snapshot entity blobs are copied as raw bytes");
+
+bool deserialize_snapshot(World& world, const void* data, size_t size);
+
 /**
  * @brief Serializes the entire World state to an output stream.
  *
  * @details The binary format is:
  * - Header: "ECS\0" (4 bytes)
- * - Version: uint32_t (currently 1)
+ * - Version: uint32_t (`SERIALIZE_VERSION`, 3; version 1 ends after the free list)
  * - Archetype Count: uint32_t
  * - Entity Slot Count: uint32_t
  * - Per Archetype:
@@ -31,6 +109,8 @@ namespace ecs {
  *   - Generations: uint32_t[]
  *   - Free List Count: uint32_t
  *   - Free List: uint32_t[]
+ *   - Generation Floor: uint32_t (first generation of slots created past the table's end,
+ *     raised by `World::compact`)
  *
  * @param world The world to serialize.
  * @param out The output stream.
@@ -38,6 +118,7 @@ namespace ecs {
  * valid serialization functions, or this function will assert/fail.
  */
 inline void serialize(const World& world, std::ostream& out) {
+    ECS_ASSERT(!world.has_sparse_values(), "serialize: sparse components are not serializable");
     // Validate: all component types in all archetypes are registered and serializable
     for (auto& [ts, arch] : world.archetypes_) {
         if (arch->count() == 0)
@@ -52,7 +133,7 @@ inline void serialize(const World& world, std::ostream& out) {
 
     // Header
     out.write("ECS\0", 4);
-    uint32_t version = 1;
+    uint32_t version = SERIALIZE_VERSION;
     out.write(reinterpret_cast<const char*>(&version), sizeof(version));
 
     // Count non-empty archetypes
@@ -89,7 +170,7 @@ inline void serialize(const World& world, std::ostream& out) {
         // Serialized column data
         for (auto& [cid, col] : arch->columns) {
             for (size_t i = 0; i < entity_count; ++i) {
-                col.serialize_fn(col.data + i * col.elem_size, out);
+                col.serialize_fn(col.get(i), out);
             }
         }
 
@@ -112,6 +193,8 @@ inline void serialize(const World& world, std::ostream& out) {
     for (auto idx : world.free_list_) {
         out.write(reinterpret_cast<const char*>(&idx), sizeof(idx));
     }
+    out.write(reinterpret_cast<const char*>(&world.generation_floor_),
+              sizeof(world.generation_floor_));
 }
 
 /**
@@ -120,6 +203,9 @@ inline void serialize(const World& world, std::ostream& out) {
  * @details Reconstructs archetypes, entities, and components.
  * Matches components by name using `component_id_by_name`.
  *
+ * Also accepts a v2 snapshot (see `serialize_snapshot`), which is buffered and loaded with
+ * `deserialize_snapshot`.
+ *
  * @param world The target world (must be empty).
  * @param in The input stream.
  * @warning The target world must be empty. All components present in the stream
@@ -136,7 +222,17 @@ inline void deserialize(World& world, std::istream& in) {
 
     uint32_t version;
     in.read(reinterpret_cast<char*>(&version), sizeof(version));
-    ECS_ASSERT(version == 1, "deserialize: unsupported version");
+    if (version == SNAPSHOT_VERSION) {
+        // v2 snapshot: buffer the rest of the stream and load it from memory
+        std::vector<char> buf(8);
+        std::memcpy(buf.data(), magic, 4);
+        std::memcpy(buf.data() + 4, &version, 4);
+        buf.insert(buf.end(), std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        bool loaded = deserialize_snapshot(world, buf.data(), buf.size());
+        ECS_ASSERT(loaded, "deserialize: malformed snapshot");
+        return;
+    }
+    ECS_ASSERT(version == 1 || version == SERIALIZE_VERSION, "deserialize: unsupported version");
 
     uint32_t archetype_count;
     in.read(reinterpret_cast<char*>(&archetype_count), sizeof(archetype_count));
@@ -189,12 +285,21 @@ inline void deserialize(World& world, std::istream& in) {
             auto& col = *arch->find_column(metas[c].id);
             ECS_ASSERT(col.deserialize_fn != nullptr,
                        "deserialize: component type has no deserialize function");
-            ECS_ASSERT(col.elem_size == metas[c].elem_size, "deserialize: component size mismatch");
+            ECS_ASSERT(stored_size_matches(col, metas[c].elem_size),
+                       "deserialize: component size mismatch");
+            if (col.tag) {
+                in.ignore(std::streamsize(metas[c].elem_size) * entity_count);
+                col.commit_rows(entity_count);
+                continue;
+            }
             for (uint32_t i = 0; i < entity_count; ++i) {
-                void* dst = col.data + i * col.elem_size;
+                // Deserializers expect a live object (e.g. Children resizes its vector)
+                void* dst = col.get(i);
+                if (col.construct_fn)
+                    col.construct_fn(dst);
                 col.deserialize_fn(dst, in);
             }
-            col.count = entity_count;
+            col.commit_rows(entity_count);
         }
 
         // Read entity list
@@ -219,19 +324,1183 @@ inline void deserialize(World& world, std::istream& in) {
     for (uint32_t i = 0; i < free_list_count; ++i) {
         in.read(reinterpret_cast<char*>(&world.free_list_[i]), sizeof(uint32_t));
     }
+    if (version == SERIALIZE_VERSION)
+        in.read(reinterpret_cast<char*>(&world.generation_floor_), sizeof(uint32_t));
 
-    // Rebuild records from archetype entity lists
-    world.records_.resize(slot_count);
-    for (auto& rec : world.records_) {
-        rec.archetype = nullptr;
-        rec.row = 0;
+    world.rebuild_records();
+    world.rebuild_indexes();
+}
+
+/** @brief Read-only `std::streambuf` over a memory range (no copy). */
+class MemoryReadBuffer : public std::streambuf {
+public:
+    MemoryReadBuffer(const void* data, size_t size) {
+        char* p = const_cast<char*>(static_cast<const char*>(data));
+        setg(p, p, p + size);
+    }
+};
+
+/**
+ * @brief Serializes the World as a v2 snapshot: a header and tables, then page-aligned blobs.
+ *
+ * @details Layout (all offsets are absolute, all blobs start on a `SNAPSHOT_ALIGN` boundary):
+ * - `SnapshotHeader`
+ * - Archetype table: per non-empty archetype, a `SnapshotArchetype` followed by one
+ *   `SnapshotColumn` (plus padded name) per component
+ * - Blobs: per archetype, its entity list and one blob per column; then the generations and
+ *   the free list
+ *
+ * Columns of trivially copyable components without a custom serializer
+ * (`raw_serializable`) are written as raw row bytes, one write per storage run. Other
+ * columns are encoded with their `serialize_fn` (as in v1) into a blob of known size. The
+ * result can be loaded with `deserialize_snapshot` from memory, `load_snapshot` from a
+ * memory-mapped file, or `deserialize` from a stream.
+ *
+ * @warning Same requirements as `serialize`: every component must be registered and
+ * serializable.
+ */
+inline void serialize_snapshot(const World& world, std::ostream& out) {
+    ECS_ASSERT(!world.has_sparse_values(), "serialize: sparse components are not serializable");
+    struct ColumnPlan {
+        const ComponentColumn* col;
+        const std::string* name;
+        SnapshotColumn entry;
+        std::string encoded; // SnapshotStream only
+    };
+    struct ArchetypePlan {
+        const Archetype* arch;
+        SnapshotArchetype entry;
+        std::vector<ColumnPlan> columns;
+    };
+    auto align = [](uint64_t v) { return (v + SNAPSHOT_ALIGN - 1) & ~(SNAPSHOT_ALIGN - 1); };
+    auto padded = [](uint64_t v) { return (v + 7) & ~uint64_t(7); };
+
+    // Pass 1: encode non-raw columns and lay out the tables and blobs
+    std::vector<ArchetypePlan> plans;
+    uint64_t table_size = 0;
+    for (auto& [ts, arch] : world.archetypes_) {
+        if (arch->count() == 0)
+            continue;
+        ArchetypePlan plan{arch.get(), {}, {}};
+        plan.entry.component_count = static_cast<uint32_t>(arch->columns.size());
+        plan.entry.entity_count = static_cast<uint32_t>(arch->count());
+        table_size += sizeof(SnapshotArchetype);
+        for (auto& [cid, col] : arch->columns) {
+            ECS_ASSERT(component_registered(cid),
+                       "serialize: archetype contains unregistered component type");
+            ECS_ASSERT(col.serialize_fn != nullptr,
+                       "serialize: component type has no serialize function");
+            ColumnPlan cp{&col, &component_name(cid), {}, {}};
+            cp.entry.name_len = static_cast<uint32_t>(cp.name->size());
+            cp.entry.elem_size = static_cast<uint32_t>(col.elem_size);
+            cp.entry.reserved = 0;
+            if (col.raw_serializable) {
+                cp.entry.encoding = SnapshotRaw;
+                cp.entry.size = uint64_t(col.elem_size) * arch->count();
+            } else {
+                std::ostringstream encoded;
+                for (size_t i = 0; i < arch->count(); ++i)
+                    col.serialize_fn(col.get(i), encoded);
+                cp.encoded = std::move(encoded).str();
+                cp.entry.encoding = SnapshotStream;
+                cp.entry.size = cp.encoded.size();
+            }
+            table_size += sizeof(SnapshotColumn) + padded(cp.entry.name_len);
+            plan.columns.push_back(std::move(cp));
+        }
+        plans.push_back(std::move(plan));
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, "ECS\0", 4);
+    header.version = SNAPSHOT_VERSION;
+    header.align = static_cast<uint32_t>(SNAPSHOT_ALIGN);
+    header.archetype_count = static_cast<uint32_t>(plans.size());
+    header.slot_count = static_cast<uint32_t>(world.generations_.size());
+    header.free_count = static_cast<uint32_t>(world.free_list_.size());
+    header.table_offset = sizeof(SnapshotHeader);
+
+    uint64_t offset = align(header.table_offset + table_size);
+    for (auto& plan : plans) {
+        plan.entry.entities_offset = offset;
+        offset = align(offset + uint64_t(plan.entry.entity_count) * sizeof(Entity));
+        for (auto& cp : plan.columns) {
+            cp.entry.offset = offset;
+            offset = align(offset + cp.entry.size);
+        }
+    }
+    header.generations_offset = offset;
+    offset = align(offset + uint64_t(header.slot_count) * sizeof(uint32_t));
+    header.free_list_offset = offset;
+    header.size = offset + uint64_t(header.free_count) * sizeof(uint32_t) + sizeof(uint32_t);
+
+    // Pass 2: write everything in offset order
+    uint64_t pos = 0;
+    auto write = [&](const void* data, uint64_t n) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(n));
+        pos += n;
+    };
+    auto pad_to = [&](uint64_t target) {
+        static const char zeros[SNAPSHOT_ALIGN] = {};
+        while (pos < target)
+            write(zeros, std::min<uint64_t>(target - pos, SNAPSHOT_ALIGN));
+    };
+
+    write(&header, sizeof(header));
+    for (auto& plan : plans) {
+        write(&plan.entry, sizeof(plan.entry));
+        for (auto& cp : plan.columns) {
+            write(&cp.entry, sizeof(cp.entry));
+            write(cp.name->data(), cp.entry.name_len);
+            pad_to(padded(pos));
+        }
+    }
+    for (auto& plan : plans) {
+        const Archetype& arch = *plan.arch;
+        pad_to(plan.entry.entities_offset);
+        write(arch.entities.data(), uint64_t(arch.count()) * sizeof(Entity));
+        for (auto& cp : plan.columns) {
+            pad_to(cp.entry.offset);
+            if (cp.entry.encoding == SnapshotStream) {
+                write(cp.encoded.data(), cp.encoded.size());
+                continue;
+            }
+            const ComponentColumn& col = *cp.col;
+            arch.for_each_run(0, arch.count(), [&](size_t first, size_t n) {
+                write(col.get(first), uint64_t(n) * col.elem_size);
+            });
+        }
+    }
+    pad_to(header.generations_offset);
+    write(world.generations_.data(), uint64_t(header.slot_count) * sizeof(uint32_t));
+    pad_to(header.free_list_offset);
+    write(world.free_list_.data(), uint64_t(header.free_count) * sizeof(uint32_t));
+    write(&world.generation_floor_, sizeof(world.generation_floor_));
+}
+
+namespace detail {
+// A column of a loaded block or archetype, checked against the registered component type
+inline bool column_meta_valid(const ComponentColumn& col, uint32_t elem_size, uint32_t encoding,
+                              uint64_t size, uint64_t rows) {
+    if (!stored_size_matches(col, elem_size))
+        return false;
+    if (col.tag)
+        return true;
+    if (encoding == SnapshotRaw)
+        return col.raw_serializable && size == rows * col.elem_size;
+    return encoding == SnapshotStream && col.deserialize_fn != nullptr;
+}
+
+// Resolves a stored component name to a registered, archetype-stored component
+inline bool find_dense_factory(const std::string& name, ComponentTypeID& id) {
+    return find_component_id_by_name(name, id) && !is_sparse_component_id(id) &&
+           column_factory_registry().count(id) != 0;
+}
+
+// Sorts one loaded archetype's type set. Duplicate IDs cannot come from a writer.
+inline bool sort_loaded_types(TypeSet& ts) {
+    std::sort(ts.begin(), ts.end());
+    return std::adjacent_find(ts.begin(), ts.end()) == ts.end();
+}
+} // namespace detail
+
+/**
+ * @brief Restores the World from a v2 snapshot held in memory (e.g. a mapped file).
+ *
+ * @details Raw column blobs are copied into the archetype's storage with one `memcpy` per
+ * storage run, and entity lists, generations and the free list with one `memcpy` each.
+ * Stream-encoded columns are decoded in place through a `MemoryReadBuffer`. Components are
+ * matched by name.
+ *
+ * The snapshot may be truncated or hostile: the whole table is validated before the World is
+ * touched. Every table read and blob range must lie inside `size`, counts must match blob
+ * sizes, names must be registered, and column sizes and encodings must match their types.
+ * Every entity and free-list index must lie inside the entity table and not be the reserved
+ * index 0; an index may appear in only one entity list row or once in the free list, and
+ * entities must carry their slot's generation. A stream-encoded column that runs out of bytes
+ * is detected after decoding, and the World is emptied again.
+ *
+ * @param world The target world (must be empty).
+ * @param data Start of the snapshot. No alignment is required.
+ * @param size Size of the snapshot in bytes.
+ * @return false if the snapshot is malformed; the World is then left empty.
+ */
+inline bool deserialize_snapshot(World& world, const void* data, size_t size) {
+    ECS_ASSERT(world.count() == 0, "deserialize: world must be empty");
+    const uint8_t* base = static_cast<const uint8_t*>(data);
+    auto in_bounds = [&](uint64_t offset, uint64_t n) {
+        return offset <= size && n <= size - offset;
+    };
+
+    struct Column {
+        ComponentTypeID id;
+        SnapshotColumn meta;
+    };
+    struct Entry {
+        SnapshotArchetype archetype;
+        TypeSet types;
+        std::vector<Column> columns;
+    };
+
+    // Pass 1: validate every table entry and range without touching the World
+    SnapshotHeader header;
+    if (!in_bounds(0, sizeof(header)))
+        return false;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, "ECS\0", 4) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.size > size)
+        return false;
+    uint64_t slots = header.slot_count;
+    uint64_t free_end = header.free_list_offset + uint64_t(header.free_count) * sizeof(uint32_t);
+    if (!in_bounds(header.generations_offset, slots * sizeof(uint32_t)) ||
+        !in_bounds(header.free_list_offset, uint64_t(header.free_count) * sizeof(uint32_t)))
+        return false;
+    // Snapshots written before the floor was stored end at the free list
+    uint32_t floor = 0;
+    if (header.size >= free_end + sizeof(floor))
+        std::memcpy(&floor, base + free_end, sizeof(floor));
+    // Each slot is live in one row or free once; index 0 is reserved for INVALID_ENTITY
+    std::vector<bool> seen(static_cast<size_t>(slots));
+    auto claim = [&](uint32_t idx) {
+        if (idx == 0 || idx >= slots || seen[idx])
+            return false;
+        seen[idx] = true;
+        return true;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t cursor = header.table_offset;
+    for (uint32_t a = 0; a < header.archetype_count; ++a) {
+        Entry entry;
+        if (!in_bounds(cursor, sizeof(SnapshotArchetype)))
+            return false;
+        std::memcpy(&entry.archetype, base + cursor, sizeof(SnapshotArchetype));
+        cursor += sizeof(SnapshotArchetype);
+        uint64_t n = entry.archetype.entity_count;
+        if (!in_bounds(entry.archetype.entities_offset, n * sizeof(Entity)))
+            return false;
+        for (uint64_t i = 0; i < n; ++i) {
+            Entity e;
+            uint32_t generation;
+            std::memcpy(&e, base + entry.archetype.entities_offset + i * sizeof(Entity), sizeof(e));
+            if (!claim(e.index))
+                return false;
+            std::memcpy(&generation, base + header.generations_offset + uint64_t(e.index) * 4, 4);
+            if (generation != e.generation)
+                return false;
+        }
+
+        for (uint32_t c = 0; c < entry.archetype.component_count; ++c) {
+            Column column;
+            if (!in_bounds(cursor, sizeof(SnapshotColumn)))
+                return false;
+            std::memcpy(&column.meta, base + cursor, sizeof(SnapshotColumn));
+            cursor += sizeof(SnapshotColumn);
+            if (!in_bounds(cursor, column.meta.name_len) ||
+                !in_bounds(column.meta.offset, column.meta.size))
+                return false;
+            std::string name(reinterpret_cast<const char*>(base + cursor), column.meta.name_len);
+            cursor += (uint64_t(column.meta.name_len) + 7) & ~uint64_t(7);
+            if (!detail::find_dense_factory(name, column.id) ||
+                !detail::column_meta_valid(column_factory_registry()[column.id](),
+                                           column.meta.elem_size, column.meta.encoding,
+                                           column.meta.size, n))
+                return false;
+            entry.types.push_back(column.id);
+            entry.columns.push_back(column);
+        }
+        if (!detail::sort_loaded_types(entry.types))
+            return false;
+        entries.push_back(std::move(entry));
+    }
+    for (uint32_t i = 0; i < header.free_count; ++i) {
+        uint32_t idx;
+        std::memcpy(&idx, base + header.free_list_offset + uint64_t(i) * sizeof(idx), sizeof(idx));
+        if (!claim(idx))
+            return false;
+    }
+
+    // Pass 2: build the World from the validated table
+    bool decoded = true;
+    for (const Entry& entry : entries) {
+        uint32_t n = entry.archetype.entity_count;
+        Archetype* arch = world.get_or_create_archetype(entry.types);
+        arch->ensure_capacity(n);
+
+        for (const Column& column : entry.columns) {
+            const SnapshotColumn& meta = column.meta;
+            auto& col = *arch->find_column(column.id);
+            const uint8_t* blob = base + meta.offset;
+            if (col.tag) {
+                col.commit_rows(n);
+                continue;
+            }
+            if (meta.encoding == SnapshotRaw) {
+                arch->for_each_run(0, n, [&](size_t first, size_t rows) {
+                    std::memcpy(col.get(first), blob + first * col.elem_size, rows * col.elem_size);
+                });
+            } else {
+                MemoryReadBuffer buf(blob, static_cast<size_t>(meta.size));
+                std::istream in(&buf);
+                for (uint32_t i = 0; i < n; ++i) {
+                    void* dst = col.get(i);
+                    if (col.construct_fn)
+                        col.construct_fn(dst);
+                    col.deserialize_fn(dst, in);
+                }
+                decoded &= !in.fail();
+            }
+            col.commit_rows(n);
+        }
+
+        arch->entities.resize(n);
+        if (n > 0)
+            std::memcpy(arch->entities.data(), base + entry.archetype.entities_offset,
+                        size_t(n) * sizeof(Entity));
+    }
+
+    world.generations_.resize(header.slot_count);
+    if (slots > 0)
+        std::memcpy(world.generations_.data(), base + header.generations_offset,
+                    size_t(slots) * sizeof(uint32_t));
+    world.free_list_.resize(header.free_count);
+    if (header.free_count > 0)
+        std::memcpy(world.free_list_.data(), base + header.free_list_offset,
+                    size_t(header.free_count) * sizeof(uint32_t));
+    if (!decoded) {
+        world.discard_load();
+        return false;
+    }
+
+    world.generation_floor_ = floor;
+    world.rebuild_records();
+    world.rebuild_indexes();
+    return true;
+}
+
+/**
+ * @brief Writes a v2 snapshot of the World to the file at `path`.
+ * @return false if the file could not be created or written.
+ */
+inline bool save_snapshot(const World& world, const char* path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    serialize_snapshot(world, out);
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief Loads a v2 snapshot file into an empty World.
+ * @details On POSIX systems the file is memory-mapped read-only and the blobs are copied
+ * straight from the mapping; elsewhere it is read into one buffer first.
+ * @return false if the file could not be opened or read, or is not a valid snapshot (see
+ * `deserialize_snapshot`).
+ */
+inline bool load_snapshot(World& world, const char* path) {
+#if defined(ECS_SNAPSHOT_MMAP)
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return false;
+    ::madvise(map, size, MADV_SEQUENTIAL);
+    bool loaded = deserialize_snapshot(world, map, size);
+    ::munmap(map, size);
+    return loaded;
+#else
+    std::FILE* f = std::fopen(path, "rb");
+    if (!f)
+        return false;
+    std::vector<char> buf;
+    char chunk[1 << 16];
+    size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0)
+        buf.insert(buf.end(), chunk, chunk + n);
+    bool ok = !std::ferror(f) && !buf.empty();
+    std::fclose(f);
+    return ok && deserialize_snapshot(world, buf.data(), buf.size());
+#endif
+}
+
+// --- Streamed (framed) serialization ---
+
+/** @brief Format version written by `write_stream`. */
+inline constexpr uint32_t STREAM_VERSION = 1;
+
+/**
+ * @brief Optional block compressor for streamed serialization.
+ * @details The signatures follow the usual one-shot block APIs (e.g. LZ4, zstd), so a codec is
+ * a few lines of glue. The functions are called concurrently from pool threads and must be
+ * thread-safe. `id` is stored in every compressed frame and must be nonzero; the reader needs
+ * a compressor with the same id.
+ */
+struct BlockCompressor {
+    uint32_t id = 0;
+    /** @brief Upper bound of the compressed size of `raw_size` bytes. */
+    size_t (*bound)(size_t raw_size) = nullptr;
+    /** @brief Compresses into `dst` (`capacity` bytes); returns the size, or 0 to store raw. */
+    size_t (*compress)(const void* src, size_t size, void* dst, size_t capacity) = nullptr;
+    /** @brief Restores exactly `raw_size` bytes into `dst`; returns false on corrupt input. */
+    bool (*decompress)(const void* src, size_t size, void* dst, size_t raw_size) = nullptr;
+};
+
+/** @brief Options of the streamed serialization functions. */
+struct StreamOptions {
+    /** @brief Target uncompressed size of one block; larger archetypes are split by rows. */
+    size_t block_bytes = size_t(1) << 20;
+    /** @brief Compresses written blocks; must be given to read compressed blocks. */
+    const BlockCompressor* compressor = nullptr;
+    /** @brief Encodes, compresses and decodes blocks in parallel (null: calling thread). */
+    ThreadPool* pool = nullptr;
+};
+
+/** @brief Kind of a frame in a streamed world. */
+enum StreamFrameKind : uint32_t {
+    StreamEnd,         ///< Last frame; empty payload.
+    StreamBlock,       ///< A row range of one archetype: entities and every column.
+    StreamEntityTable, ///< Generations, free list and generation floor.
+};
+
+/** @brief Header in front of every frame's payload. */
+struct StreamFrame {
+    uint32_t kind;        ///< A `StreamFrameKind`.
+    uint32_t codec;       ///< 0 if stored uncompressed, else the `BlockCompressor::id`.
+    uint64_t raw_size;    ///< Payload size after decompression.
+    uint64_t stored_size; ///< Payload bytes following the header.
+};
+
+static_assert(sizeof(StreamFrame) == 24, "stream frame layout must not depend on padding");
+
+/**
+ * @brief A self-contained copy of a World's state as uncompressed frame payloads.
+ * @details Made by `capture_stream` and written by `write_stream`. Writing does not touch the
+ * World, so a capture can be compressed and written on another thread while the world runs.
+ */
+struct StreamCapture {
+    std::vector<std::string> blocks; ///< `StreamBlock` payloads, in write order.
+    std::string entity_table;        ///< `StreamEntityTable` payload.
+
+    /** @brief Total uncompressed payload size in bytes. */
+    size_t raw_bytes() const {
+        size_t total = entity_table.size();
+        for (auto& b : blocks)
+            total += b.size();
+        return total;
+    }
+};
+
+/**
+ * @brief Copies the World into a `StreamCapture`, one block payload per archetype row range.
+ *
+ * @details Each archetype is split into ranges of about `options.block_bytes` and every range
+ * becomes an independent block:
+ * - Component count, entity count (uint32_t each)
+ * - Per component: name length, name, element size, `SnapshotEncoding` (uint32_t each except
+ *   the name), data size (uint64_t)
+ * - The range's entities, then each column's data: raw row bytes for `raw_serializable`
+ *   columns, `serialize_fn` output otherwise
+ *
+ * Blocks are encoded on `options.pool` when given. Raw columns cost one `memcpy` per storage
+ * run, so the capture is the only part that must happen while the world is paused.
+ *
+ * @warning Same requirements as `serialize`. `serialize_fn`s may run concurrently (on
+ * different rows) and must only read the component.
+ */
+inline StreamCapture capture_stream(const World& world, const StreamOptions& options = {}) {
+    ECS_ASSERT(!world.has_sparse_values(), "serialize: sparse components are not serializable");
+    struct Range {
+        const Archetype* arch;
+        size_t first, count;
+    };
+    std::vector<Range> ranges;
+    for (auto& [ts, arch] : world.archetypes_) {
+        if (arch->count() == 0)
+            continue;
+        size_t row_bytes = sizeof(Entity);
+        for (auto& [cid, col] : arch->columns) {
+            ECS_ASSERT(component_registered(cid),
+                       "serialize: archetype contains unregistered component type");
+            ECS_ASSERT(col.serialize_fn != nullptr,
+                       "serialize: component type has no serialize function");
+            row_bytes += col.elem_size;
+        }
+        size_t rows = std::max<size_t>(1, options.block_bytes / row_bytes);
+        for (size_t first = 0; first < arch->count(); first += rows)
+            ranges.push_back({arch.get(), first, std::min(rows, arch->count() - first)});
+    }
+
+    StreamCapture capture;
+    capture.blocks.resize(ranges.size());
+    auto encode = [&](size_t b) {
+        const Range& r = ranges[b];
+        const Archetype& arch = *r.arch;
+        std::string& out = capture.blocks[b];
+        auto put = [&](const void* data, size_t n) { out.append(static_cast<const char*>(data), n); };
+        auto put_u32 = [&](uint32_t v) { put(&v, sizeof(v)); };
+
+        std::vector<std::string> encoded(arch.columns.size());
+        size_t c = 0;
+        for (auto& [cid, col] : arch.columns) {
+            if (!col.raw_serializable) {
+                std::ostringstream stream;
+                for (size_t i = r.first; i < r.first + r.count; ++i)
+                    col.serialize_fn(col.get(i), stream);
+                encoded[c] = std::move(stream).str();
+            }
+            ++c;
+        }
+
+        put_u32(static_cast<uint32_t>(arch.columns.size()));
+        put_u32(static_cast<uint32_t>(r.count));
+        c = 0;
+        for (auto& [cid, col] : arch.columns) {
+            const std::string& name = component_name(cid);
+            put_u32(static_cast<uint32_t>(name.size()));
+            put(name.data(), name.size());
+            put_u32(static_cast<uint32_t>(col.elem_size));
+            put_u32(col.raw_serializable ? SnapshotRaw : SnapshotStream);
+            uint64_t size = col.raw_serializable ? uint64_t(r.count) * col.elem_size
+                                                 : encoded[c].size();
+            put(&size, sizeof(size));
+            ++c;
+        }
+        put(arch.entities.data() + r.first, r.count * sizeof(Entity));
+        c = 0;
+        for (auto& [cid, col] : arch.columns) {
+            if (col.raw_serializable) {
+                arch.for_each_run(r.first, r.first + r.count, [&](size_t first, size_t n) {
+                    put(col.get(first), n * col.elem_size);
+                });
+            } else {
+                put(encoded[c].data(), encoded[c].size());
+            }
+            ++c;
+        }
+    };
+    if (options.pool)
+        options.pool->parallel_for(ranges.size(), encode);
+    else
+        for (size_t b = 0; b < ranges.size(); ++b)
+            encode(b);
+
+    std::string& table = capture.entity_table;
+    uint32_t counts[2] = {static_cast<uint32_t>(world.generations_.size()),
+                          static_cast<uint32_t>(world.free_list_.size())};
+    table.append(reinterpret_cast<const char*>(counts), sizeof(counts));
+    table.append(reinterpret_cast<const char*>(world.generations_.data()),
+                 world.generations_.size() * sizeof(uint32_t));
+    table.append(reinterpret_cast<const char*>(world.free_list_.data()),
+                 world.free_list_.size() * sizeof(uint32_t));
+    table.append(reinterpret_cast<const char*>(&world.generation_floor_),
+                 sizeof(world.generation_floor_));
+    return capture;
+}
+
+/**
+ * @brief Writes a capture as a framed stream: "ECSF", version, then one `StreamFrame` and
+ * payload per block, the entity table frame, and a `StreamEnd` frame.
+ *
+ * @details With `options.compressor`, blocks are compressed on `options.pool` a window at a
+ * time (two blocks per pool thread) and written in order, so memory use stays bounded by the
+ * window. A block the compressor cannot shrink is stored raw.
+ */
+inline void write_stream(const StreamCapture& capture, std::ostream& out,
+                         const StreamOptions& options = {}) {
+    const BlockCompressor* codec = options.compressor;
+    ECS_ASSERT(!codec || (codec->id != 0 && codec->bound && codec->compress),
+               "write_stream: incomplete block compressor");
+    auto write_frame = [&](uint32_t kind, const std::string& raw, const std::string* packed) {
+        StreamFrame frame{kind, packed ? codec->id : 0u, raw.size(),
+                          packed ? packed->size() : raw.size()};
+        out.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+        const std::string& payload = packed ? *packed : raw;
+        out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+    };
+    // Returns false (store raw) if the compressor fails or does not shrink the payload
+    auto pack = [&](const std::string& raw, std::string& packed) {
+        if (!codec || raw.empty())
+            return false;
+        packed.resize(codec->bound(raw.size()));
+        size_t n = codec->compress(raw.data(), raw.size(), &packed[0], packed.size());
+        if (n == 0 || n >= raw.size())
+            return false;
+        packed.resize(n);
+        return true;
+    };
+
+    out.write("ECSF", 4);
+    out.write(reinterpret_cast<const char*>(&STREAM_VERSION), sizeof(STREAM_VERSION));
+
+    const size_t window = options.pool ? options.pool->size() * 2 : 1;
+    std::vector<std::string> packed(window);
+    std::vector<char> ok(window);
+    for (size_t base = 0; base < capture.blocks.size(); base += window) {
+        size_t n = std::min(window, capture.blocks.size() - base);
+        auto compress = [&](size_t i) { ok[i] = pack(capture.blocks[base + i], packed[i]); };
+        if (options.pool)
+            options.pool->parallel_for(n, compress);
+        else
+            for (size_t i = 0; i < n; ++i)
+                compress(i);
+        for (size_t i = 0; i < n; ++i)
+            write_frame(StreamBlock, capture.blocks[base + i], ok[i] ? &packed[i] : nullptr);
+    }
+    std::string table;
+    write_frame(StreamEntityTable, capture.entity_table,
+                pack(capture.entity_table, table) ? &table : nullptr);
+    write_frame(StreamEnd, std::string(), nullptr);
+}
+
+/**
+ * @brief Serializes the World as a framed stream (`capture_stream` + `write_stream`).
+ * @details To keep the frame short, call `capture_stream` on the frame thread and hand the
+ * capture to `write_stream` on another thread instead.
+ */
+inline void serialize_stream(const World& world, std::ostream& out,
+                             const StreamOptions& options = {}) {
+    write_stream(capture_stream(world, options), out, options);
+}
+
+/**
+ * @brief Restores the World from a framed stream written by `write_stream`.
+ *
+ * @details Frames are read in windows of two blocks per pool thread. Each window is
+ * decompressed in parallel, then its archetypes are created and reserved on the calling
+ * thread, then the blocks are decoded in parallel straight into their rows (raw columns with
+ * one `memcpy` per storage run), then rows are committed in stream order. Components are
+ * matched by name; no hooks fire.
+ *
+ * The stream may be truncated or hostile. Every frame, block header and payload read is
+ * checked, and so are names, column sizes and encodings, and stream columns that run short.
+ * Entity and free-list indices get the snapshot checks (see `deserialize_snapshot`): inside
+ * the table, not 0, each slot live once or free once, and generations matching the table.
+ *
+ * @param world The target world (must be empty).
+ * @param in The input stream.
+ * @param options `compressor` must match the writer's if blocks are compressed; `pool` is
+ * optional. `deserialize_fn`s may run concurrently on different rows.
+ * @return false if the stream is malformed; the World is then left empty.
+ */
+inline bool deserialize_stream(World& world, std::istream& in,
+                               const StreamOptions& options = {}) {
+    ECS_ASSERT(world.count() == 0, "deserialize: world must be empty");
+    char magic[4];
+    uint32_t version = 0;
+    in.read(magic, 4);
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!in || std::memcmp(magic, "ECSF", 4) != 0 || version != STREAM_VERSION)
+        return false;
+
+    struct Column {
+        ComponentColumn* col;
+        uint32_t encoding;
+        size_t offset, size;
+    };
+    struct Block {
+        StreamFrame frame;
+        std::string data;
+        Archetype* arch = nullptr;
+        size_t first = 0;
+        uint32_t count = 0;
+        size_t entities_offset = 0;
+        std::vector<Column> columns;
+        bool decoded = true;
+    };
+    auto for_each = [&](size_t n, auto&& fn) {
+        if (options.pool)
+            options.pool->parallel_for(n, fn);
+        else
+            for (size_t i = 0; i < n; ++i)
+                fn(i);
+    };
+    // Returns false if the frame's codec is unknown or its payload does not decode
+    auto unpack = [&](StreamFrame& frame, std::string& data) {
+        if (frame.codec == 0)
+            return frame.raw_size == frame.stored_size;
+        const BlockCompressor* codec = options.compressor;
+        if (!codec || codec->id != frame.codec || !codec->decompress)
+            return false;
+        std::string raw(static_cast<size_t>(frame.raw_size), '\0');
+        if (!codec->decompress(data.data(), data.size(), &raw[0], raw.size()))
+            return false;
+        data.swap(raw);
+        return true;
+    };
+    // Parses a block's header and finds its archetype. Every size is checked against the
+    // payload, so a block that parses can be decoded without further checks.
+    auto parse = [&](Block& b) {
+        size_t cursor = 0;
+        auto take = [&](size_t n, const char*& p) {
+            if (n > b.data.size() - cursor)
+                return false;
+            p = b.data.data() + cursor;
+            cursor += n;
+            return true;
+        };
+        auto take_u32 = [&](uint32_t& v) {
+            const char* p;
+            if (!take(sizeof(v), p))
+                return false;
+            std::memcpy(&v, p, sizeof(v));
+            return true;
+        };
+        struct Meta {
+            ComponentTypeID id;
+            uint32_t elem_size, encoding;
+            uint64_t size;
+        };
+        uint32_t component_count;
+        if (!take_u32(component_count) || !take_u32(b.count))
+            return false;
+        std::vector<Meta> metas;
+        TypeSet ts;
+        for (uint32_t c = 0; c < component_count; ++c) {
+            Meta m;
+            uint32_t name_len;
+            const char *name, *size;
+            if (!take_u32(name_len) || !take(name_len, name) ||
+                !detail::find_dense_factory(std::string(name, name_len), m.id) ||
+                !take_u32(m.elem_size) || !take_u32(m.encoding) || !take(sizeof(m.size), size))
+                return false;
+            std::memcpy(&m.size, size, sizeof(m.size));
+            metas.push_back(m);
+            ts.push_back(m.id);
+        }
+        if (!detail::sort_loaded_types(ts))
+            return false;
+        b.arch = world.get_or_create_archetype(ts);
+
+        const char* p;
+        b.entities_offset = cursor;
+        if (!take(size_t(b.count) * sizeof(Entity), p))
+            return false;
+        b.columns.clear();
+        for (auto& m : metas) {
+            ComponentColumn* col = b.arch->find_column(m.id);
+            if (!detail::column_meta_valid(*col, m.elem_size, m.encoding, m.size, b.count) ||
+                m.size > b.data.size())
+                return false;
+            b.columns.push_back({col, m.encoding, cursor, static_cast<size_t>(m.size)});
+            if (!take(static_cast<size_t>(m.size), p))
+                return false;
+        }
+        return true;
+    };
+
+    // Parses block headers and reserves rows (serial), decodes (parallel), commits (serial)
+    std::vector<Block> window;
+    std::vector<char> unpacked;
+    std::unordered_map<Archetype*, size_t> next_row;
+    auto flush = [&] {
+        unpacked.assign(window.size(), 0);
+        for_each(window.size(),
+                 [&](size_t i) { unpacked[i] = unpack(window[i].frame, window[i].data); });
+        next_row.clear();
+        for (size_t i = 0; i < window.size(); ++i) {
+            Block& b = window[i];
+            if (!unpacked[i] || !parse(b))
+                return false;
+            auto it = next_row.emplace(b.arch, b.arch->count()).first;
+            b.first = it->second;
+            it->second += b.count;
+        }
+        for (auto& [arch, rows] : next_row)
+            arch->ensure_capacity(rows);
+
+        for_each(window.size(), [&](size_t i) {
+            Block& b = window[i];
+            for (Column& c : b.columns) {
+                const char* src = b.data.data() + c.offset;
+                ComponentColumn& col = *c.col;
+                if (col.tag)
+                    continue;
+                if (c.encoding == SnapshotRaw) {
+                    b.arch->for_each_run(b.first, b.first + b.count, [&](size_t first, size_t n) {
+                        std::memcpy(col.get(first), src + (first - b.first) * col.elem_size,
+                                    n * col.elem_size);
+                    });
+                    continue;
+                }
+                MemoryReadBuffer buf(src, c.size);
+                std::istream stream(&buf);
+                for (size_t row = b.first; row < b.first + b.count; ++row) {
+                    void* dst = col.get(row);
+                    if (col.construct_fn)
+                        col.construct_fn(dst);
+                    col.deserialize_fn(dst, stream);
+                }
+                b.decoded &= !stream.fail();
+            }
+        });
+
+        // Decoded rows are committed even if a column ran short, so that they are destroyed
+        bool decoded = true;
+        for (Block& b : window) {
+            for (Column& c : b.columns)
+                c.col->commit_rows(b.count);
+            const Entity* es = reinterpret_cast<const Entity*>(b.data.data() + b.entities_offset);
+            size_t first = b.arch->entities.size();
+            b.arch->entities.resize(first + b.count);
+            if (b.count > 0)
+                std::memcpy(&b.arch->entities[first], es, b.count * sizeof(Entity));
+            decoded &= b.decoded;
+        }
+        window.clear();
+        return decoded;
+    };
+    // Reads `n` payload bytes, growing the buffer as they arrive, so a bad length in a
+    // truncated stream fails at end of input instead of allocating it up front.
+    auto read_payload = [&](std::string& data, uint64_t n) {
+        constexpr size_t CHUNK = size_t(1) << 20;
+        while (n > data.size()) {
+            size_t have = data.size();
+            size_t step = static_cast<size_t>(std::min<uint64_t>(CHUNK, n - have));
+            data.resize(have + step);
+            if (!in.read(&data[have], static_cast<std::streamsize>(step)))
+                return false;
+        }
+        return true;
+    };
+    auto fail = [&] {
+        window.clear();
+        world.discard_load();
+        return false;
+    };
+
+    const size_t window_size = options.pool ? options.pool->size() * 2 : 1;
+    bool have_table = false;
+    uint32_t floor = 0;
+    for (;;) {
+        Block b;
+        if (!in.read(reinterpret_cast<char*>(&b.frame), sizeof(b.frame)) ||
+            !read_payload(b.data, b.frame.stored_size))
+            return fail();
+
+        if (b.frame.kind == StreamBlock) {
+            window.push_back(std::move(b));
+            if (window.size() == window_size && !flush())
+                return fail();
+            continue;
+        }
+        if (!flush())
+            return fail();
+        if (b.frame.kind == StreamEnd)
+            break;
+        if (b.frame.kind != StreamEntityTable || !unpack(b.frame, b.data))
+            return fail();
+        uint32_t counts[2];
+        if (b.data.size() < sizeof(counts))
+            return fail();
+        std::memcpy(counts, b.data.data(), sizeof(counts));
+        // Generations, free list, then the generation floor (absent in older streams)
+        size_t table_bytes = sizeof(counts) + (size_t(counts[0]) + counts[1]) * 4;
+        if (b.data.size() != table_bytes && b.data.size() != table_bytes + 4)
+            return fail();
+        floor = 0;
+        if (b.data.size() > table_bytes)
+            std::memcpy(&floor, b.data.data() + table_bytes, 4);
+        const char* p = b.data.data() + sizeof(counts);
+        world.generations_.resize(counts[0]);
+        world.free_list_.resize(counts[1]);
+        if (counts[0] > 0)
+            std::memcpy(world.generations_.data(), p, counts[0] * sizeof(uint32_t));
+        if (counts[1] > 0)
+            std::memcpy(world.free_list_.data(), p + counts[0] * 4, counts[1] * sizeof(uint32_t));
+        have_table = true;
+    }
+    if (!have_table || !world.loaded_indices_valid())
+        return fail();
+    world.generation_floor_ = floor;
+    world.rebuild_records();
+    world.rebuild_indexes();
+    return true;
+}
+
+// --- Delta snapshots ---
+
+/** @brief Format version written by `serialize_delta`. */
+inline constexpr uint32_t DELTA_VERSION = 2;
+
+/**
+ * @brief Serializes what changed in the World after tick `since`.
+ *
+ * @details Applying the delta with `apply_delta` to a world that matches this one as of `since`
+ * (loaded from a snapshot, or kept in sync by earlier deltas) brings it up to date. Changes are
+ * found from the world's change ticks:
+ * - Slots created, destroyed or migrated between archetypes after `since` are listed with
+ *   their generation. Alive ones are then sent whole (type names and every component, grouped
+ *   by archetype), and the free list is sent in full.
+ * - For every other entity, the components whose changed tick is after `since` are sent as
+ *   (entity index, value) pairs, grouped by archetype and column. Columns stamped by a
+ *   mutable `each`/`query` are changed at block granularity, so their rows are sent in full.
+ *
+ * The format is:
+ * - Header: "ECSD", version, since, slot count (uint32_t each)
+ * - Slot changes: count, then per slot index, generation, alive (uint32_t each)
+ * - Free list (only if there were slot changes): count, indices
+ * - Upserts: archetype count, then per archetype the component count, per component its name
+ *   length, name and element size, the entity count, per entity its index and generation, and
+ *   the column values (component-major, via `serialize_fn`)
+ * - Changed rows: column count, then per column its name length, name, row count, and per row
+ *   the entity index and value
+ *
+ * Typical replication loop, starting from a full snapshot:
+ * @code
+ *   serialize_snapshot(world, out);
+ *   uint32_t baseline = world.advance_tick();
+ *   // ... each frame:
+ *   serialize_delta(world, baseline, out);
+ *   baseline = world.advance_tick();
+ * @endcode
+ *
+ * @param world The world to diff.
+ * @param since Tick of the baseline, as returned by `World::advance_tick`.
+ * @param out The output stream.
+ * @warning Same requirements as `serialize`. The receiver must have registered the same
+ * component types (matched by name).
+ */
+inline void serialize_delta(const World& world, uint32_t since, std::ostream& out) {
+    ECS_ASSERT(!world.has_sparse_values(), "serialize: sparse components are not serializable");
+    auto put = [&](uint32_t v) { out.write(reinterpret_cast<const char*>(&v), sizeof(v)); };
+    auto put_name = [&](ComponentTypeID cid) {
+        const std::string& name = component_name(cid);
+        put(static_cast<uint32_t>(name.size()));
+        out.write(name.data(), static_cast<std::streamsize>(name.size()));
+    };
+    auto serializable = [](ComponentTypeID cid, const ComponentColumn& col) {
+        ECS_ASSERT(component_registered(cid),
+                   "serialize_delta: archetype contains unregistered component type");
+        ECS_ASSERT(col.serialize_fn != nullptr,
+                   "serialize_delta: component type has no serialize function");
+    };
+
+    out.write("ECSD", 4);
+    put(DELTA_VERSION);
+    put(since);
+    uint32_t slot_count = static_cast<uint32_t>(world.generations_.size());
+    put(slot_count);
+
+    // Slot changes; alive ones are grouped by archetype for the upsert section
+    std::vector<uint32_t> slots;
+    std::unordered_map<const Archetype*, std::vector<size_t>> upserts;
+    for (uint32_t i = 1; i < slot_count; ++i) {
+        if (world.structure_ticks_[i] <= since)
+            continue;
+        slots.push_back(i);
+        const auto& rec = world.records_[i];
+        if (rec.archetype)
+            upserts[rec.archetype].push_back(rec.row);
+    }
+    put(static_cast<uint32_t>(slots.size()));
+    for (uint32_t i : slots) {
+        put(i);
+        put(world.generations_[i]);
+        put(world.records_[i].archetype ? 1u : 0u);
     }
+    if (!slots.empty()) {
+        put(static_cast<uint32_t>(world.free_list_.size()));
+        for (uint32_t idx : world.free_list_)
+            put(idx);
+    }
+
+    put(static_cast<uint32_t>(upserts.size()));
     for (auto& [ts, arch] : world.archetypes_) {
-        for (size_t i = 0; i < arch->count(); ++i) {
-            Entity e = arch->entities[i];
-            world.records_[e.index] = {arch.get(), i};
+        auto it = upserts.find(arch.get());
+        if (it == upserts.end())
+            continue;
+        std::vector<size_t>& rows = it->second;
+        std::sort(rows.begin(), rows.end());
+        put(static_cast<uint32_t>(arch->columns.size()));
+        for (auto& [cid, col] : arch->columns) {
+            serializable(cid, col);
+            put_name(cid);
+            put(static_cast<uint32_t>(col.elem_size));
+        }
+        put(static_cast<uint32_t>(rows.size()));
+        for (size_t row : rows) {
+            put(arch->entities[row].index);
+            put(arch->entities[row].generation);
+        }
+        for (auto& [cid, col] : arch->columns)
+            for (size_t row : rows)
+                col.serialize_fn(col.get(row), out);
+    }
+
+    // Changed rows of entities whose slot did not change
+    struct ChangedColumn {
+        const Archetype* arch;
+        ComponentTypeID cid;
+        const ComponentColumn* col;
+        std::vector<size_t> rows;
+    };
+    std::vector<ChangedColumn> changed;
+    for (auto& [ts, arch] : world.archetypes_) {
+        for (auto& [cid, col] : arch->columns) {
+            if (col.last_changed_tick() <= since || col.count == 0 || col.tag)
+                continue; // a tag has no value to send
+            ChangedColumn cc{arch.get(), cid, &col, {}};
+            for (size_t row = 0; row < col.count; ++row) {
+                if (col.changed_tick(row) > since &&
+                    world.structure_ticks_[arch->entities[row].index] <= since)
+                    cc.rows.push_back(row);
+            }
+            if (!cc.rows.empty()) {
+                serializable(cid, col);
+                changed.push_back(std::move(cc));
+            }
+        }
+    }
+    put(static_cast<uint32_t>(changed.size()));
+    for (auto& cc : changed) {
+        put_name(cc.cid);
+        put(static_cast<uint32_t>(cc.rows.size()));
+        for (size_t row : cc.rows) {
+            put(cc.arch->entities[row].index);
+            cc.col->serialize_fn(cc.col->get(row), out);
+        }
+    }
+}
+
+/**
+ * @brief Applies a delta written by `serialize_delta` to the World.
+ *
+ * @details The world must match the sender as of the delta's `since` tick. Entities in the
+ * slot-change list lose their old row (if any) and are re-inserted whole; changed components
+ * are overwritten in place through their `deserialize_fn` and stamped as changed at this
+ * world's current tick. Hooks are not fired, as in `deserialize`.
+ *
+ * @param world The receiving world.
+ * @param in The input stream, positioned at the start of a delta.
+ */
+inline void apply_delta(World& world, std::istream& in) {
+    auto get = [&]() {
+        uint32_t v = 0;
+        in.read(reinterpret_cast<char*>(&v), sizeof(v));
+        return v;
+    };
+    auto get_id = [&]() {
+        std::string name(get(), '\0');
+        in.read(&name[0], static_cast<std::streamsize>(name.size()));
+        return component_id_by_name(name);
+    };
+
+    char magic[4];
+    in.read(magic, 4);
+    ECS_ASSERT(in && std::memcmp(magic, "ECSD", 4) == 0, "apply_delta: invalid magic");
+    ECS_ASSERT(get() == DELTA_VERSION, "apply_delta: unsupported version");
+    get(); // since: informational
+    auto drop_row = [&](uint32_t idx) {
+        auto& rec = world.records_[idx];
+        if (rec.archetype) {
+            Entity swapped = rec.archetype->swap_remove(rec.row);
+            if (swapped != INVALID_ENTITY)
+                world.records_[swapped.index].row = rec.row;
+        }
+        rec = {};
+    };
+    uint32_t slot_count = get();
+    ECS_ASSERT(slot_count > 0, "apply_delta: empty entity table");
+    // A compacted sender drops dead trailing slots without reporting them individually
+    // (the sender destroyed any occupant still alive here, bumping its generation)
+    for (size_t idx = slot_count; idx < world.records_.size(); ++idx) {
+        uint32_t generation = world.generations_[idx] + (world.records_[idx].archetype ? 1 : 0);
+        world.generation_floor_ = std::max(world.generation_floor_, generation);
+        drop_row(static_cast<uint32_t>(idx));
+    }
+    world.free_list_.erase(std::remove_if(world.free_list_.begin(), world.free_list_.end(),
+                                          [&](uint32_t idx) { return idx >= slot_count; }),
+                           world.free_list_.end());
+    world.generations_.resize(slot_count, 0);
+    world.records_.resize(slot_count);
+    world.structure_ticks_.resize(slot_count, world.change_tick_);
+
+    // Slot changes: drop the old occupant's row, then adopt the sender's generation
+    uint32_t slot_changes = get();
+    for (uint32_t s = 0; s < slot_changes; ++s) {
+        uint32_t idx = get();
+        uint32_t generation = get();
+        get(); // alive: the entity (if any) follows in the upsert section
+        ECS_ASSERT(idx > 0 && idx < slot_count, "apply_delta: slot index out of range");
+        drop_row(idx);
+        world.generations_[idx] = generation;
+        world.structure_ticks_[idx] = world.change_tick_;
+    }
+    if (slot_changes > 0) {
+        world.free_list_.resize(get());
+        for (auto& idx : world.free_list_)
+            idx = get();
+    }
+
+    uint32_t upsert_archetypes = get();
+    for (uint32_t a = 0; a < upsert_archetypes; ++a) {
+        uint32_t component_count = get();
+        std::vector<ComponentTypeID> ids(component_count);
+        std::vector<uint32_t> sizes(component_count);
+        for (uint32_t c = 0; c < component_count; ++c) {
+            ids[c] = get_id();
+            sizes[c] = get();
+        }
+        TypeSet ts(ids.begin(), ids.end());
+        std::sort(ts.begin(), ts.end());
+        Archetype* arch = world.get_or_create_archetype(ts);
+
+        uint32_t n = get();
+        size_t first = arch->count();
+        arch->ensure_capacity(first + n);
+        arch->order.rows_moved = true;
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t idx = get();
+            uint32_t generation = get();
+            ECS_ASSERT(idx > 0 && idx < slot_count && world.generations_[idx] == generation &&
+                           world.records_[idx].archetype == nullptr,
+                       "apply_delta: upsert of an entity missing from the slot changes");
+            arch->entities.push_back(Entity{idx, generation});
+            world.place_record(idx, arch, first + i);
+        }
+        for (uint32_t c = 0; c < component_count; ++c) {
+            auto& col = *arch->find_column(ids[c]);
+            ECS_ASSERT(col.deserialize_fn != nullptr,
+                       "apply_delta: component type has no deserialize function");
+            ECS_ASSERT(col.elem_size == sizes[c], "apply_delta: component size mismatch");
+            for (uint32_t i = 0; i < n; ++i) {
+                void* dst = col.get(first + i);
+                if (col.construct_fn)
+                    col.construct_fn(dst);
+                col.deserialize_fn(dst, in);
+            }
+            col.commit_rows(n);
+        }
+    }
+
+    uint32_t changed_columns = get();
+    for (uint32_t c = 0; c < changed_columns; ++c) {
+        ComponentTypeID cid = get_id();
+        uint32_t rows = get();
+        for (uint32_t r = 0; r < rows; ++r) {
+            uint32_t idx = get();
+            ECS_ASSERT(idx < slot_count && world.records_[idx].archetype != nullptr,
+                       "apply_delta: changed row of a dead entity");
+            auto& rec = world.records_[idx];
+            ComponentColumn* col = rec.archetype->find_column(cid);
+            ECS_ASSERT(col != nullptr && col->deserialize_fn != nullptr,
+                       "apply_delta: changed component missing on the receiver");
+            // Deserializers write into a live object (as for a freshly constructed one)
+            col->deserialize_fn(col->get(rec.row), in);
+            col->mark_changed(rec.row);
         }
     }
+    ECS_ASSERT(static_cast<bool>(in), "apply_delta: truncated delta");
+    world.rebuild_indexes();
 }
 
 } // namespace ecs
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace ecs {
+
+/**
+ * @brief Non-owning view over a contiguous array (a minimal C++17 stand-in for `std::span`).
+ * @details Converts implicitly from any container exposing `data()` and `size()` (e.g.
+ * `std::vector`, `std::array`) whose element pointer converts to `T*`.
+ */
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(T* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename Container,
+              typename = std::enable_if_t<std::is_convertible_v<
+                  decltype(std::declval<Container&>().data()), T*>>>
+    Span(Container& c) : data_(c.data()), size_(c.size()) {}
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](size_t i) const { return data_[i]; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace ecs
@@ -0,0 +1,152 @@
+#pragma once
+#include "allocator.hpp"
+#include "component.hpp"
+#include "entity.hpp"
+#include "span.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ecs {
+
+/**
+ * @brief Storage for one sparse component type (see `is_sparse_component`).
+ *
+ * @details A sparse set keyed by `Entity::index`: `sparse_[index]` is the entity's row or
+ * `NONE`, and rows are dense, in insertion order, with their owners in `entities()`. Values
+ * live in a `ComponentColumn` over fixed-size pages from the world's allocator, so they get
+ * the column's lifecycle helpers and change ticks. Insertion appends a row and removal
+ * swap-removes one: both are O(1) and never touch the entity's archetype. Pages never move,
+ * so growth keeps value pointers valid.
+ */
+class SparseSet {
+public:
+    /** @brief `sparse_` entry of an entity index without a value. */
+    static constexpr uint32_t NONE = UINT32_MAX;
+    /** @brief log2 of the rows per page. */
+    static constexpr uint32_t PAGE_SHIFT = 8;
+
+    /**
+     * @param column Empty column for the component type (from its column factory).
+     * @param allocator Source of value pages; must outlive the set.
+     */
+    SparseSet(ComponentColumn column, const Allocator* allocator)
+        : column_(std::move(column)), allocator_(allocator) {
+        column_.chunk_shift = PAGE_SHIFT;
+    }
+
+    ~SparseSet() {
+        column_.destroy_all();
+        for (auto* page : pages_)
+            allocator_->deallocate(allocator_->user, page, page_bytes(), page_align());
+    }
+
+    SparseSet(const SparseSet&) = delete;
+    SparseSet& operator=(const SparseSet&) = delete;
+
+    /** @brief Number of entities holding a value. */
+    size_t size() const { return dense_.size(); }
+
+    /** @brief The entities holding a value, in row order. */
+    Span<const Entity> entities() const { return {dense_.data(), dense_.size()}; }
+
+    /** @brief Checks whether the entity at `index` holds a value. */
+    bool contains(uint32_t index) const {
+        return index < sparse_.size() && sparse_[index] != NONE;
+    }
+
+    /** @brief Row of the entity at `index`, which must hold a value. */
+    size_t row(uint32_t index) const { return sparse_[index]; }
+
+    /** @brief The value of the entity at `index`, which must hold one. */
+    void* get(uint32_t index) { return column_.get(sparse_[index]); }
+    const void* get(uint32_t index) const { return column_.get(sparse_[index]); }
+
+    /** @brief The value column (rows match `entities()`). */
+    ComponentColumn& column() { return column_; }
+    const ComponentColumn& column() const { return column_; }
+
+    /**
+     * @brief Adds a row for `e`, which must not hold a value yet.
+     * @param push Called as `push(column)`; must append exactly one element (`emplace_back`,
+     * `push_raw`, or construct at `get(count)` then `commit_rows(1)`).
+     */
+    template <typename Push>
+    void insert(Entity e, Push&& push) {
+        ECS_ASSERT(!contains(e.index), "SparseSet::insert: entity already holds a value");
+        if (column_.count == column_.capacity)
+            add_page();
+        push(column_);
+        if (e.index >= sparse_.size())
+            sparse_.resize(size_t(e.index) + 1, NONE);
+        sparse_[e.index] = static_cast<uint32_t>(dense_.size());
+        dense_.push_back(e);
+    }
+
+    /** @brief Destroys the value of the entity at `index` (which must hold one). */
+    void erase(uint32_t index) {
+        uint32_t row = sparse_[index];
+        column_.swap_remove(row);
+        if (row + 1 < dense_.size()) {
+            dense_[row] = dense_.back();
+            sparse_[dense_[row].index] = row;
+        }
+        dense_.pop_back();
+        sparse_[index] = NONE;
+    }
+
+    /** @brief Destroys every value; keeps the pages. */
+    void clear() {
+        column_.destroy_all();
+        for (Entity e : dense_)
+            sparse_[e.index] = NONE;
+        dense_.clear();
+    }
+
+    /** @brief Adds pages until the column can hold `rows` values. */
+    void reserve(size_t rows) {
+        while (column_.capacity < rows)
+            add_page();
+    }
+
+    /**
+     * @brief Sets the row owners after the column was refilled directly (by a `Checkpoint`).
+     * @details The set must have been cleared; row `i` of the column belongs to `dense[i]`.
+     */
+    void assign_entities(Span<const Entity> dense) {
+        ECS_ASSERT(dense_.empty(), "SparseSet::assign_entities: set is not empty");
+        dense_.assign(dense.begin(), dense.end());
+        for (size_t row = 0; row < dense_.size(); ++row) {
+            uint32_t index = dense_[row].index;
+            if (index >= sparse_.size())
+                sparse_.resize(size_t(index) + 1, NONE);
+            sparse_[index] = static_cast<uint32_t>(row);
+        }
+    }
+
+private:
+    ComponentColumn column_;
+    const Allocator* allocator_;
+    std::vector<uint8_t*> pages_;
+    std::vector<Entity> dense_;
+    std::vector<uint32_t> sparse_; // by entity index
+
+    size_t page_bytes() const { return column_.elem_size << PAGE_SHIFT; }
+    size_t page_align() const { return std::max(column_.alignment, alignof(std::max_align_t)); }
+
+    void add_page() {
+        uint8_t* page = ComponentColumn::tag_storage(); // tags store nothing
+        if (!column_.tag) {
+            void* p = allocator_->allocate(allocator_->user, page_bytes(), page_align());
+            ECS_ASSERT(p, "sparse set page allocation failed");
+            page = static_cast<uint8_t*>(p);
+            pages_.push_back(page);
+        }
+        column_.chunks.push_back(page);
+        column_.capacity += size_t(1) << PAGE_SHIFT;
+    }
+};
+
+} // namespace ecs
@@ -1,28 +1,74 @@
 #pragma once
+#include "thread_pool.hpp"
 #include "world.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <string>
 #include <vector>
 
 namespace ecs {
 
+/** @brief How a system touches a component type. */
+enum AccessMode : uint8_t { ReadOnly, ReadWrite };
+
+/** @brief One entry of a system's access declaration. */
+struct ComponentAccess {
+    ComponentTypeID id;
+    AccessMode mode;
+};
+
+/**
+ * @brief Declares that a system accesses component T with the given mode.
+ * @details Usage: `systems.add("movement", {access<Position>(ReadWrite),
+ * access<Velocity>(ReadOnly)}, fn);`
+ */
+template <typename T>
+ComponentAccess access(AccessMode mode) {
+    return {component_id<T>(), mode};
+}
+
 /**
- * @brief Manages a collection of systems (logic functions) to be executed sequentially.
+ * @brief Manages a collection of systems (logic functions) to be executed in order.
  * @details Systems are simple functions that operate on the World. This registry provides
- * a way to organize and run them in a loop.
+ * a way to organize and run them in a loop, either sequentially (`run_all`) or in parallel
+ * stages derived from each system's declared component access (`run_all_parallel`).
  */
 class SystemRegistry {
 public:
     using SystemFunc = std::function<void(World&)>;
 
     /**
-     * @brief Registers a new system.
+     * @brief Registers a new system without an access declaration.
+     * @details Undeclared systems are exclusive: they conflict with every other system and
+     * always run alone in their own stage.
      * @param name Diagnostic name for the system.
      * @param fn The system function `void(World&)`.
      */
     void add(std::string name, SystemFunc fn) {
-        systems_.push_back({std::move(name), std::move(fn)});
+        SystemEntry entry;
+        entry.name = std::move(name);
+        entry.fn = std::move(fn);
+        entry.exclusive = true;
+        register_system(std::move(entry));
+    }
+
+    /**
+     * @brief Registers a system together with the component types it reads and writes.
+     * @details Two systems conflict when they share a component and at least one of them
+     * writes it. Conflicting systems keep their registration order; non-conflicting systems
+     * may run concurrently under `run_all_parallel`.
+     * @param name Diagnostic name for the system.
+     * @param accesses The system's component access declaration.
+     * @param fn The system function `void(World&)`.
+     */
+    void add(std::string name, std::vector<ComponentAccess> accesses, SystemFunc fn) {
+        SystemEntry entry;
+        entry.name = std::move(name);
+        entry.fn = std::move(fn);
+        entry.accesses = std::move(accesses);
+        register_system(std::move(entry));
     }
 
     /**
@@ -31,14 +77,121 @@ public:
      * @param world The world to update.
      */
     void run_all(World& world) {
-        for (auto& [name, fn] : systems_) {
-            fn(world);
+        for (auto& sys : systems_) {
+            run_system(sys, world);
+            world.flush_deferred();
+        }
+    }
+
+    /**
+     * @brief Executes all registered systems, running each stage's systems concurrently.
+     * @details Stages run in order. Each system records `world.deferred()` commands into its
+     * own buffer (see `World::par_for`); at the barrier after each stage the buffers are merged
+     * in registration order and flushed, so the result does not depend on scheduling and
+     * systems within a stage do not observe each other's deferred commands.
+     * @param world The world to update.
+     * @param pool The thread pool to dispatch systems on.
+     */
+    void run_all_parallel(World& world, ThreadPool& pool) {
+        for (auto& stage : stages_) {
+            world.par_for(pool, stage.size(),
+                          [&](size_t i) { run_system(systems_[stage[i]], world); });
             world.flush_deferred();
         }
     }
 
+    /** @brief Returns the number of registered systems. */
+    size_t size() const { return systems_.size(); }
+
+    /** @brief Returns the diagnostic name of the system at `index` (registration order). */
+    const std::string& name(size_t index) const { return systems_[index].name; }
+
+    /**
+     * @brief Returns the accumulated wall time of the system at `index`.
+     * @details Timed around the system function only (deferred flushes are excluded). All zero
+     * unless built with `ECS_PROFILE`.
+     */
+    const SystemStats& stats(size_t index) const { return systems_[index].stats; }
+
+    /** @brief Zeroes every system's timings. */
+    void reset_stats() {
+        for (auto& sys : systems_)
+            sys.stats = {};
+    }
+
+    /** @brief Checks whether two systems (by registration index) may not run concurrently. */
+    bool conflicts(size_t a, size_t b) const {
+        for (size_t other : systems_[a].conflicts)
+            if (other == b)
+                return true;
+        for (size_t other : systems_[b].conflicts)
+            if (other == a)
+                return true;
+        return false;
+    }
+
+    /**
+     * @brief Returns the execution stages as lists of system indices.
+     * @details Every system runs in a later stage than all earlier-registered systems it
+     * conflicts with. Built incrementally at registration time.
+     */
+    const std::vector<std::vector<size_t>>& stages() const { return stages_; }
+
 private:
-    std::vector<std::pair<std::string, SystemFunc>> systems_;
+    struct SystemEntry {
+        std::string name;
+        SystemFunc fn;
+        std::vector<ComponentAccess> accesses;
+        bool exclusive = false;
+        size_t stage = 0;
+        std::vector<size_t> conflicts; // earlier systems this one must run after
+        SystemStats stats;
+    };
+
+    std::vector<SystemEntry> systems_;
+    std::vector<std::vector<size_t>> stages_;
+
+    // Each entry is written only by the thread running it, so parallel stages need no locking.
+    static void run_system(SystemEntry& sys, World& world) {
+#if defined(ECS_PROFILE)
+        TraceScope scope(world.trace_sink(), sys.name.c_str());
+        auto start = std::chrono::steady_clock::now();
+        sys.fn(world);
+        uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                std::chrono::steady_clock::now() - start)
+                                                .count());
+        sys.stats.calls++;
+        sys.stats.total_ns += ns;
+        sys.stats.last_ns = ns;
+        sys.stats.max_ns = std::max(sys.stats.max_ns, ns);
+#else
+        sys.fn(world);
+#endif
+    }
+
+    static bool accesses_conflict(const SystemEntry& a, const SystemEntry& b) {
+        if (a.exclusive || b.exclusive)
+            return true;
+        for (auto& x : a.accesses)
+            for (auto& y : b.accesses)
+                if (x.id == y.id && (x.mode == ReadWrite || y.mode == ReadWrite))
+                    return true;
+        return false;
+    }
+
+    void register_system(SystemEntry entry) {
+        size_t index = systems_.size();
+        for (size_t i = 0; i < index; ++i) {
+            if (accesses_conflict(entry, systems_[i])) {
+                entry.conflicts.push_back(i);
+                entry.stage = std::max(entry.stage, systems_[i].stage + 1);
+            }
+        }
+        if (entry.stage >= stages_.size())
+            stages_.resize(entry.stage + 1);
+        stages_[entry.stage].push_back(index);
+        systems_.push_back(std::move(entry));
+    }
 };
 
 } // namespace ecs
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ecs {
+
+/**
+ * @brief Fixed-size pool of worker threads for fork-join parallelism.
+ *
+ * @details The pool runs one job at a time. `parallel_for` publishes a job, the calling thread
+ * participates as an extra worker, and the call blocks until every index has been processed.
+ * Jobs are stored as a function pointer + context pointer, so dispatch never allocates.
+ *
+ * The index range is split into one contiguous slice per participant. Each participant drains
+ * its own slice first (good locality for chunked iteration), then steals remaining indices from
+ * the other slices, so uneven work still balances.
+ *
+ * Calls made from inside a running job (e.g. a system calling a parallel query) execute
+ * inline on the current thread instead of deadlocking on the single job slot.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Spawns the worker threads.
+     * @param threads Total participant count, including the thread that calls `parallel_for`.
+     * A value of 0 or 1 creates no workers (everything runs inline).
+     */
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()) {
+        if (threads == 0)
+            threads = 1;
+        slices_.reset(new Slice[threads]);
+        workers_.reserve(threads - 1);
+        for (size_t i = 1; i < threads; ++i)
+            workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : workers_)
+            t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** @brief Number of threads that participate in a job (workers + caller). */
+    size_t size() const { return workers_.size() + 1; }
+
+    /**
+     * @brief Invokes `fn(i)` for every `i` in `[0, n)`, distributing indices across the pool.
+     * @details Blocks until all invocations have returned. Invocation order is unspecified.
+     */
+    template <typename Func>
+    void parallel_for(size_t n, Func&& fn) {
+        if (n == 0)
+            return;
+        if (n == 1 || workers_.empty() || in_job()) {
+            for (size_t i = 0; i < n; ++i)
+                fn(i);
+            return;
+        }
+
+        using F = std::remove_reference_t<Func>;
+        std::lock_guard<std::mutex> dispatch(dispatch_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_fn_ = [](void* ctx, size_t i) { (*static_cast<F*>(ctx))(i); };
+            job_ctx_ = const_cast<void*>(static_cast<const void*>(&fn));
+            size_t participants = size();
+            for (size_t p = 0; p < participants; ++p) {
+                slices_[p].next.store(n * p / participants, std::memory_order_relaxed);
+                slices_[p].end = n * (p + 1) / participants;
+            }
+            pending_ = workers_.size();
+            ++job_generation_;
+        }
+        wake_.notify_all();
+
+        in_job() = true;
+        run_job(0);
+        in_job() = false;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+private:
+    using JobFunc = void (*)(void* ctx, size_t index);
+
+    // One participant's share of the index range. Owner and thieves both claim with fetch_add.
+    struct alignas(64) Slice {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+
+    std::vector<std::thread> workers_;
+    std::mutex dispatch_mutex_; // serializes jobs submitted from different external threads
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    bool stopping_ = false;
+    uint64_t job_generation_ = 0;
+    size_t pending_ = 0;
+
+    JobFunc job_fn_ = nullptr;
+    void* job_ctx_ = nullptr;
+    std::unique_ptr<Slice[]> slices_; // indexed by participant: 0 = caller, 1.. = workers
+
+    static bool& in_job() {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    void drain(Slice& slice) {
+        for (size_t i = slice.next.fetch_add(1, std::memory_order_relaxed); i < slice.end;
+             i = slice.next.fetch_add(1, std::memory_order_relaxed))
+            job_fn_(job_ctx_, i);
+    }
+
+    void run_job(size_t self) {
+        size_t participants = size();
+        drain(slices_[self]);
+        for (size_t k = 1; k < participants; ++k)
+            drain(slices_[(self + k) % participants]);
+    }
+
+    void worker_loop(size_t self) {
+        in_job() = true;
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stopping_ || job_generation_ != seen; });
+                if (stopping_)
+                    return;
+                seen = job_generation_;
+            }
+            run_job(self);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--pending_ == 0)
+                    done_.notify_one();
+            }
+        }
+    }
+};
+
+} // namespace ecs
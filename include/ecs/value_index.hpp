@@ -0,0 +1,126 @@
+#pragma once
+#include "component.hpp"
+#include "entity.hpp"
+#include "span.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+/** @brief How a value index maps keys to entities (see `World::index_by`). */
+enum class IndexKind : uint8_t {
+    Unique,  ///< At most one entity per key; a duplicate key asserts.
+    Grouped, ///< Any number of entities per key.
+};
+
+namespace detail {
+
+// One address per key type: tells index key types apart without spending a component ID
+template <typename Key>
+inline const char index_key_tag = 0;
+
+} // namespace detail
+
+/**
+ * @brief Hash index from a key derived from a component value to the entities holding it.
+ *
+ * @details Owned by the World, which calls `insert`/`erase` from the same add, remove,
+ * destroy and migration paths that fire observers. The key each entity was indexed under
+ * is kept per entity index, so `erase` never needs the (possibly modified) value. Unique
+ * keys map to one entity; grouped keys map to a vector of entities in no particular order.
+ */
+template <typename Key>
+class ValueIndex {
+public:
+    explicit ValueIndex(IndexKind kind) : kind_(kind) {}
+
+    IndexKind kind() const { return kind_; }
+
+    /** @brief Number of indexed entities. */
+    size_t size() const { return size_; }
+
+    /** @brief An entity indexed under `key`, or `INVALID_ENTITY`. */
+    Entity find(const Key& key) const {
+        if (kind_ == IndexKind::Unique) {
+            auto it = unique_.find(key);
+            return it != unique_.end() ? it->second : INVALID_ENTITY;
+        }
+        auto it = groups_.find(key);
+        return it != groups_.end() ? it->second.front() : INVALID_ENTITY;
+    }
+
+    /** @brief Every entity indexed under `key`; valid until the index next changes. */
+    Span<const Entity> find_all(const Key& key) const {
+        if (kind_ == IndexKind::Unique) {
+            auto it = unique_.find(key);
+            return it != unique_.end() ? Span<const Entity>(&it->second, 1)
+                                       : Span<const Entity>();
+        }
+        auto it = groups_.find(key);
+        return it != groups_.end() ? Span<const Entity>(it->second.data(), it->second.size())
+                                   : Span<const Entity>();
+    }
+
+    /** @brief Indexes `e` under `key`, replacing the key it had. */
+    void insert(Entity e, Key key) {
+        erase(e);
+        if (kind_ == IndexKind::Unique) {
+            bool fresh = unique_.emplace(key, e).second;
+            ECS_ASSERT(fresh, "index_by: duplicate key in a unique index");
+            if (!fresh)
+                return;
+        } else {
+            groups_[key].push_back(e);
+        }
+        if (e.index >= keys_.size())
+            keys_.resize(size_t(e.index) + 1);
+        keys_[e.index] = std::move(key);
+        ++size_;
+    }
+
+    /** @brief Drops `e` from the index; does nothing if it is not indexed. */
+    void erase(Entity e) {
+        if (e.index >= keys_.size() || !keys_[e.index])
+            return;
+        const Key& key = *keys_[e.index];
+        if (kind_ == IndexKind::Unique) {
+            unique_.erase(key);
+        } else {
+            auto it = groups_.find(key);
+            auto& group = it->second;
+            for (size_t i = 0; i < group.size(); ++i) {
+                if (group[i] == e) {
+                    group[i] = group.back();
+                    group.pop_back();
+                    break;
+                }
+            }
+            if (group.empty())
+                groups_.erase(it);
+        }
+        keys_[e.index].reset();
+        --size_;
+    }
+
+    /** @brief Removes every entry; keeps the per-entity key storage. */
+    void clear() {
+        unique_.clear();
+        groups_.clear();
+        for (auto& key : keys_)
+            key.reset();
+        size_ = 0;
+    }
+
+private:
+    IndexKind kind_;
+    size_t size_ = 0;
+    std::unordered_map<Key, Entity> unique_;
+    std::unordered_map<Key, std::vector<Entity>> groups_;
+    std::vector<std::optional<Key>> keys_; // key each entity is indexed under, by entity index
+};
+
+} // namespace ecs
@@ -3,16 +3,27 @@
 #include "command_buffer.hpp"
 #include "component.hpp"
 #include "entity.hpp"
+#include "lanes.hpp"
 #include "prefab.hpp"
+#include "profile.hpp"
+#include "span.hpp"
+#include "sparse_set.hpp"
+#include "thread_pool.hpp"
+#include "value_index.hpp"
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <cstring>
 #include <functional>
 #include <iosfwd>
 #include <memory>
+#include <mutex>
 #include <numeric>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace ecs {
@@ -26,6 +37,29 @@ struct EntityRecord {
     size_t row = 0;
 };
 
+/** @brief Archetype storage layout (see `Archetype`). */
+enum class StorageMode : uint8_t {
+    Block,   ///< One contiguous block per archetype, reallocated at 2x on growth.
+    Chunked, ///< Fixed-size chunks; growth never moves existing rows.
+};
+
+struct StreamCapture; // forward declarations — defined in serialization.hpp
+struct StreamOptions;
+template <typename... Ts>
+class Query; // defined after World
+
+/** @brief Construction-time options for a World. */
+struct WorldConfig {
+    StorageMode storage = StorageMode::Block;
+    /** @brief Byte budget of one chunk in `StorageMode::Chunked`. */
+    size_t chunk_bytes = Archetype::CHUNK_BYTES;
+    /**
+     * @brief Allocator for archetype storage and the deferred command buffer; null selects
+     * `default_allocator()`, the process-wide pool. Must outlive the World.
+     */
+    const Allocator* allocator = nullptr;
+};
+
 /**
  * @brief The central manager for the Entity Component System.
  *
@@ -38,7 +72,9 @@ struct EntityRecord {
  * archetypes.
  * - Registering and invoking lifecycle hooks (observers).
  *
- * It is not thread-safe for write operations.
+ * It is not thread-safe for write operations. Read-only access and queries (`each`, `get`,
+ * `has`) may run concurrently from multiple threads as long as no structural change happens
+ * at the same time (see `SystemRegistry::run_all_parallel`).
  */
 class World {
 public:
@@ -47,12 +83,29 @@ public:
      * @details Initializes the entity index generation array. Index 0 is reserved for
      * INVALID_ENTITY.
      */
-    World() {
+    World() : World(WorldConfig{}) {}
+
+    /**
+     * @brief Constructs a new World with the given storage options.
+     * @param config Applies to every archetype this world creates.
+     */
+    explicit World(const WorldConfig& config)
+        : config_(config), deferred_commands_(config.allocator) {
+        ECS_ASSERT(config_.chunk_bytes > 0, "WorldConfig: chunk_bytes must be non-zero");
+        if (!config_.allocator)
+            config_.allocator = &default_allocator();
         // Reserve index 0 so INVALID_ENTITY (index=0, gen=0) is never a live entity.
         generations_.push_back(1);
         records_.push_back({});
+        structure_ticks_.push_back(0);
     }
 
+    /** @brief Returns the options this world was constructed with. */
+    const WorldConfig& config() const { return config_; }
+
+    /** @brief Returns the allocator backing this world's storage (see `WorldConfig`). */
+    const Allocator& allocator() const { return *config_.allocator; }
+
     /**
      * @brief Destructor.
      * @details Clears all resources and destroys the world.
@@ -75,15 +128,7 @@ public:
      */
     Entity create() {
         ECS_ASSERT(iterating_ == 0, "structural change during iteration");
-        uint32_t idx;
-        if (!free_list_.empty()) {
-            idx = free_list_.back();
-            free_list_.pop_back();
-        } else {
-            idx = static_cast<uint32_t>(generations_.size());
-            generations_.push_back(0);
-            records_.push_back({});
-        }
+        uint32_t idx = acquire_slot();
         uint32_t gen = generations_[idx];
         Entity e{idx, gen};
 
@@ -91,7 +136,7 @@ public:
         Archetype* arch = get_or_create_archetype({});
         size_t row = arch->count();
         arch->push_entity(e);
-        records_[idx] = {arch, row};
+        place_record(idx, arch, row);
         return e;
     }
 
@@ -108,37 +153,89 @@ public:
         // Ensure column factories are registered for all types
         (ensure_column_factory<std::decay_t<Ts>>(), ...);
 
-        TypeSet ts = make_typeset({component_id<std::decay_t<Ts>>()...});
-        Archetype* arch = get_or_create_archetype(ts);
+        // Sparse components live outside the archetype
+        ComponentTypeID ids[] = {component_id<std::decay_t<Ts>>()...};
+        Archetype* arch = archetype_for_ids(ids, sizeof...(Ts));
 
-        uint32_t idx;
-        if (!free_list_.empty()) {
-            idx = free_list_.back();
-            free_list_.pop_back();
-        } else {
-            idx = static_cast<uint32_t>(generations_.size());
-            generations_.push_back(0);
-            records_.push_back({});
-        }
+        uint32_t idx = acquire_slot();
         uint32_t gen = generations_[idx];
         Entity e{idx, gen};
 
         size_t row = arch->count();
         arch->push_entity(e);
-        // Push each component into its column
-        (push_component_to_archetype<std::decay_t<Ts>>(arch, std::forward<Ts>(components)), ...);
+        // Push each component into its column (or sparse set)
+        (push_component<std::decay_t<Ts>>(arch, e, std::forward<Ts>(components)), ...);
         arch->assert_parity();
 
-        records_[idx] = {arch, row};
+        place_record(idx, arch, row);
 
         // Fire on_add hooks after record is set (so get<T>(e) works in hooks)
-        (fire_hooks(on_add_hooks_, component_id<std::decay_t<Ts>>(), e,
-                    arch->find_column(component_id<std::decay_t<Ts>>())->get(row)),
-         ...);
+        notify_created(arch, row, e, ids, sizeof...(Ts));
 
         return e;
     }
 
+    // -- Batch creation --
+
+    /**
+     * @brief Creates `n` entities that all start with copies of the given component values.
+     * @details Reserves archetype capacity once, assigns entity slots in bulk (recycled indices
+     * first, then a contiguous range of fresh indices) and copy-constructs every component
+     * directly into its column. `on_add` hooks run after all rows are in place, one pass per
+     * component type.
+     * @return The new entities in creation order. The span points into a World-owned buffer that
+     * is filled before any hook runs, so hooks that change structure do not affect it. It is
+     * valid until the next batch creation (`create_n*` or `instantiate_n`).
+     * @warning Asserts if called during query iteration.
+     */
+    template <typename... Ts>
+    Span<const Entity> create_n(size_t n, const Ts&... values) {
+        Archetype* arch = reserve_batch<Ts...>(n);
+        size_t first = arch->count() - n;
+        (broadcast_column<Ts>(arch, first, n, values), ...);
+        return finish_batch<Ts...>(arch, first, n);
+    }
+
+    /**
+     * @brief Creates `n` entities whose components are produced by a generator.
+     * @details Same allocation and hook behaviour as `create_n`. `gen(i)` is called once per
+     * entity, in order, and its result is moved into the columns.
+     * @tparam Ts Component types (must be given explicitly).
+     * @tparam Gen Callable `std::tuple<Ts...>(size_t index)`.
+     * @return The new entities in creation order (see `create_n` for lifetime).
+     */
+    template <typename... Ts, typename Gen>
+    Span<const Entity> create_n_generate(size_t n, Gen&& gen) {
+        Archetype* arch = reserve_batch<Ts...>(n);
+        size_t first = arch->count() - n;
+        auto cols = std::make_tuple(TypedColumn<Ts>{arch->find_column(component_id<Ts>())}...);
+        for (size_t i = 0; i < n; ++i) {
+            std::tuple<Ts...> values = gen(i);
+            (new (std::get<TypedColumn<Ts>>(cols).col->get(first + i))
+                 Ts(std::move(std::get<Ts>(values))),
+             ...);
+        }
+        (std::get<TypedColumn<Ts>>(cols).col->commit_rows(n), ...);
+        return finish_batch<Ts...>(arch, first, n);
+    }
+
+    /**
+     * @brief Creates one entity per element of the input spans, copying component values.
+     * @details All spans must have the same length. Same allocation and hook behaviour as
+     * `create_n`.
+     * @return The new entities in creation order (see `create_n` for lifetime).
+     */
+    template <typename... Ts>
+    Span<const Entity> create_n_from(Span<const Ts>... inputs) {
+        static_assert(sizeof...(Ts) > 0, "create_n_from requires at least one component span");
+        size_t n = std::get<0>(std::make_tuple(inputs.size()...));
+        ECS_ASSERT(((inputs.size() == n) && ...), "create_n_from: input spans differ in length");
+        Archetype* arch = reserve_batch<Ts...>(n);
+        size_t first = arch->count() - n;
+        (copy_column<Ts>(arch, first, n, inputs.data()), ...);
+        return finish_batch<Ts...>(arch, first, n);
+    }
+
     // -- Entity destruction --
 
     /**
@@ -155,17 +252,17 @@ public:
         Archetype* arch = rec.archetype;
 
         // Fire on_remove hooks before data is destroyed
-        for (auto& [cid, col] : arch->columns)
-            fire_hooks(on_remove_hooks_, cid, e, col.get(rec.row));
+        if (arch->observed_remove) {
+            for (auto& [cid, col] : arch->columns)
+                notify_remove(cid, e, col.get(rec.row));
+        }
+        destroy_sparse(e);
 
         Entity swapped = arch->swap_remove(rec.row);
         if (swapped != INVALID_ENTITY) {
             records_[swapped.index].row = rec.row;
         }
-        rec.archetype = nullptr;
-        rec.row = 0;
-        generations_[e.index]++;
-        free_list_.push_back(e.index);
+        release_slot(e.index);
     }
 
     /**
@@ -179,6 +276,14 @@ public:
         ECS_ASSERT(iterating_ == 0, "structural change during iteration");
         ComponentTypeID cid = component_id<T>();
         size_t destroyed = 0;
+        if constexpr (is_sparse_component_v<T>) {
+            SparseSet* set = find_sparse(cid);
+            while (set && set->size() > 0) {
+                destroy(set->entities()[set->size() - 1]);
+                ++destroyed;
+            }
+            return destroyed;
+        }
 
         // Collect matching archetypes (can't iterate archetypes_ while modifying entities)
         std::vector<Archetype*> matches;
@@ -188,19 +293,27 @@ public:
         }
 
         for (auto* arch : matches) {
+            // Batched observers and queues see the whole archetype before any row goes
+            if (arch->observed_remove) {
+                for (auto& [col_cid, col] : arch->columns)
+                    if (observed_remove_.test(col_cid))
+                        notify_rows(remove_observers_, col_cid, arch, 0, arch->count());
+            }
             // Destroy back-to-front to avoid swap-remove invalidation
             while (arch->count() > 0) {
                 size_t row = arch->count() - 1;
                 Entity e = arch->entities[row];
 
-                for (auto& [col_cid, col] : arch->columns)
-                    fire_hooks(on_remove_hooks_, col_cid, e, col.get(row));
+                if (arch->observed_remove) {
+                    for (auto& [col_cid, col] : arch->columns)
+                        if (observed_remove_.test(col_cid))
+                            for (auto& fn : remove_observers_[col_cid]->each)
+                                fn(*this, e, col.get(row));
+                }
+                destroy_sparse(e);
 
                 arch->swap_remove(row);
-                records_[e.index].archetype = nullptr;
-                records_[e.index].row = 0;
-                generations_[e.index]++;
-                free_list_.push_back(e.index);
+                release_slot(e.index);
                 ++destroyed;
             }
         }
@@ -222,33 +335,37 @@ public:
 
     /**
      * @brief Returns the total number of living entities in the world.
+     * @details Sums the row counts of the archetypes in the query cache's match-all entry.
      */
     size_t count() const {
         size_t total = 0;
-        for (auto& [ts, arch] : archetypes_)
+        for (const Archetype* arch : cached_query(nullptr, 0, nullptr, 0))
             total += arch->count();
         return total;
     }
 
+    /** @brief Returns the number of archetypes, including empty ones. */
+    size_t archetype_count() const { return archetypes_.size(); }
+
     /**
      * @brief Returns the number of entities that possess all specified components.
+     * @details Sums the row counts of the matching archetypes from the query cache (the same
+     * entry `each<Ts...>` uses), so only matching archetypes are visited. With a sparse term the
+     * smallest sparse set is scanned instead.
      * @tparam Ts Component types to query for.
      */
     template <typename... Ts>
     size_t count() const {
         ComponentTypeID ids[] = {component_id<Ts>()...};
         size_t total = 0;
-        for (auto& [ts, arch] : archetypes_) {
-            bool matches = true;
-            for (auto id : ids) {
-                if (!arch->has_component(id)) {
-                    matches = false;
-                    break;
-                }
-            }
-            if (matches)
-                total += arch->count();
+        if constexpr (any_sparse_v<Ts...>) {
+            SparseTerms terms = sparse_terms(ids, sizeof...(Ts), nullptr, 0);
+            for (size_t i = 0; terms.driver && i < terms.driver->size(); ++i)
+                total += terms.match(terms.driver->entities()[i].index, records_);
+            return total;
         }
+        for (const Archetype* arch : cached_query(ids, sizeof...(Ts), nullptr, 0))
+            total += arch->count();
         return total;
     }
 
@@ -269,13 +386,188 @@ public:
         ECS_ASSERT(found == 1, "single<Ts...>() matched zero entities");
     }
 
+    // -- Memory reclamation --
+
+    /**
+     * @brief Releases spare archetype capacity.
+     * @details Every archetype whose occupancy (`count / capacity`) is below `min_occupancy` is
+     * shrunk to fit its rows (`Archetype::shrink_to_fit`). Block storage reallocates and moves
+     * its components, invalidating component pointers as growth does. Chunked storage only
+     * frees trailing empty chunks. `1.0f` shrinks every archetype with spare capacity.
+     * @return The number of archetypes that released storage.
+     * @warning Asserts if called during query iteration.
+     */
+    size_t shrink_to_fit(float min_occupancy = 0.5f) {
+        ECS_ASSERT(iterating_ == 0, "shrink_to_fit during iteration");
+        size_t shrunk = 0;
+        for (auto& [ts, arch] : archetypes_) {
+            size_t n = arch->count();
+            if (double(n) < double(arch->capacity()) * min_occupancy && arch->shrink_to_fit())
+                ++shrunk;
+        }
+        return shrunk;
+    }
+
+    /**
+     * @brief Deletes every archetype that holds no entities, returning its storage to the
+     * allocator.
+     * @details Archetype edges pointing at deleted archetypes are cleared and cached queries
+     * drop them; they are recreated on demand by the next structural change that needs them.
+     * @return The number of archetypes deleted.
+     * @warning Asserts if called during query iteration.
+     */
+    size_t remove_empty_archetypes() {
+        ECS_ASSERT(iterating_ == 0, "remove_empty_archetypes during iteration");
+        std::vector<Archetype*> dead;
+        for (auto& [ts, arch] : archetypes_)
+            if (arch->count() == 0)
+                dead.push_back(arch.get());
+        if (dead.empty())
+            return 0;
+        ++archetype_epoch_;
+        std::sort(dead.begin(), dead.end());
+        auto is_dead = [&](const Archetype* arch) {
+            return arch && std::binary_search(dead.begin(), dead.end(), arch);
+        };
+
+        for (auto& [ts, arch] : archetypes_) {
+            auto& edges = arch->edges;
+            for (auto& [cid, edge] : edges) {
+                if (is_dead(edge.add_target))
+                    edge.add_target = nullptr;
+                if (is_dead(edge.remove_target))
+                    edge.remove_target = nullptr;
+            }
+            edges.erase(std::remove_if(edges.begin(), edges.end(),
+                                       [](const auto& p) {
+                                           return !p.second.add_target && !p.second.remove_target;
+                                       }),
+                        edges.end());
+        }
+        {
+            std::lock_guard<std::mutex> lock(query_mutex_);
+            for (auto& [key, entry] : query_cache_) {
+                auto& list = entry.archetypes;
+                list.erase(std::remove_if(list.begin(), list.end(), is_dead), list.end());
+            }
+            for (auto& [key, state] : query_states_) {
+                size_t n = state->ids.size(), kept = 0;
+                for (size_t i = 0; i < state->archetypes.size(); ++i) {
+                    if (is_dead(state->archetypes[i]))
+                        continue;
+                    state->archetypes[kept] = state->archetypes[i];
+                    std::copy_n(state->columns.begin() + i * n, n,
+                                state->columns.begin() + kept * n);
+                    ++kept;
+                }
+                state->archetypes.resize(kept);
+                state->columns.resize(kept * n);
+            }
+        }
+        for (auto it = archetypes_.begin(); it != archetypes_.end();) {
+            if (is_dead(it->second.get()))
+                it = archetypes_.erase(it);
+            else
+                ++it;
+        }
+        return dead.size();
+    }
+
+    /**
+     * @brief Full reclamation pass for long-running worlds.
+     * @details Deletes empty archetypes, shrinks every archetype to fit, clears the query cache
+     * (entries are rebuilt on next use) and releases the deferred buffers' spare capacity. It
+     * then defragments the entity index space: dead slots at the end of the entity table are
+     * dropped, and the free list is ordered so the lowest free indices are reused first, which
+     * keeps the table dense over time. Live entities and their handles are untouched. Slots
+     * created past the trimmed end start at a generation above every dropped slot's, so stale
+     * handles never match new entities. Finally the allocator's cache is trimmed
+     * (`Allocator::trim`), so the memory freed here returns to the system.
+     * @warning Asserts if called during query iteration.
+     */
+    void compact() {
+        ECS_ASSERT(iterating_ == 0, "compact during iteration");
+        remove_empty_archetypes();
+        shrink_to_fit(1.0f);
+        {
+            std::lock_guard<std::mutex> lock(query_mutex_);
+            query_cache_.clear();
+        }
+        deferred_commands_.shrink_to_fit();
+        {
+            std::lock_guard<std::mutex> lock(job_buffers_mutex_);
+            job_buffers_.clear();
+        }
+
+        size_t slots = generations_.size();
+        while (slots > 1 && records_[slots - 1].archetype == nullptr)
+            --slots;
+        for (size_t i = slots; i < generations_.size(); ++i)
+            generation_floor_ = std::max(generation_floor_, generations_[i]);
+        generations_.resize(slots);
+        records_.resize(slots);
+        structure_ticks_.resize(slots);
+        free_list_.erase(std::remove_if(free_list_.begin(), free_list_.end(),
+                                        [&](uint32_t idx) { return idx >= slots; }),
+                         free_list_.end());
+        std::sort(free_list_.begin(), free_list_.end(), std::greater<uint32_t>());
+        // Marks a free slot changed so the next delta resends the reordered free list
+        if (!free_list_.empty())
+            structure_ticks_[free_list_.back()] = change_tick_;
+        for (auto* v : {&generations_, &structure_ticks_, &free_list_})
+            v->shrink_to_fit();
+        records_.shrink_to_fit();
+        run_marks_.clear();
+        run_marks_.shrink_to_fit();
+        if (config_.allocator->trim)
+            config_.allocator->trim(config_.allocator->user);
+    }
+
     // -- Deferred commands --
 
     /**
      * @brief Gets the command buffer for deferred operations.
      * @details Use this to queue structural changes (add/remove/destroy) during iteration.
+     * Inside a job of `par_for`, `par_each` or `SystemRegistry::run_all_parallel` it returns
+     * that job's private buffer, so parallel callbacks can record without synchronizing.
+     */
+    CommandBuffer& deferred() {
+        JobCommands& job = job_commands();
+        return job.world == this ? *job.buffer : deferred_commands_;
+    }
+
+    /**
+     * @brief Runs `job(i)` for every `i` in `[0, n)` on `pool`, each with its own deferred
+     * buffer.
+     * @details While job `i` runs, `deferred()` on its thread records into a buffer private to
+     * `i`. When every job has returned, the buffers are appended to the enclosing `deferred()`
+     * buffer in index order, so the merged commands are the ones a sequential loop would have
+     * recorded, whichever threads ran the jobs. Nested calls merge into the enclosing job's
+     * buffer. Job buffers are kept between calls and reuse their capacity.
+     * @param pool The thread pool to run on. Calls from inside a pool job run inline.
      */
-    CommandBuffer& deferred() { return deferred_commands_; }
+    template <typename Job>
+    void par_for(ThreadPool& pool, size_t n, Job&& job) {
+        if (n == 0)
+            return;
+        CommandBuffer& target = deferred();
+        std::vector<CommandBuffer> nested;
+        std::vector<CommandBuffer>* buffers = &nested;
+        std::unique_lock<std::mutex> lock(job_buffers_mutex_, std::defer_lock);
+        if (job_commands().world != this) {
+            // Top level: the shared buffers and the target are guarded for the whole call
+            lock.lock();
+            buffers = &job_buffers_;
+        }
+        while (buffers->size() < n)
+            buffers->emplace_back(config_.allocator);
+        pool.parallel_for(n, [&](size_t i) {
+            JobScope scope(this, &(*buffers)[i]);
+            job(i);
+        });
+        for (size_t i = 0; i < n; ++i)
+            target.append((*buffers)[i]);
+    }
 
     /**
      * @brief Executes all queued commands in the deferred buffer.
@@ -283,9 +575,90 @@ public:
      */
     void flush_deferred() {
         ECS_ASSERT(iterating_ == 0, "flush during iteration");
+        ECS_TRACE_SCOPE(trace_sink_, "flush_deferred");
         deferred_commands_.flush(*this);
     }
 
+    // -- Instrumentation --
+
+    /**
+     * @brief Returns the instrumentation counters accumulated since construction or the last
+     * `reset_stats()`.
+     * @details All zero unless built with `ECS_PROFILE` (see profile.hpp).
+     */
+    WorldStats stats() const {
+#if defined(ECS_PROFILE)
+        return profile_.snapshot();
+#else
+        return {};
+#endif
+    }
+
+    /**
+     * @brief Returns the counters of every query key, in no particular order.
+     * @details A key is an include/exclude list as passed to `each`, `par_each`, `each_lanes`
+     * or `query` (change filters add their filter IDs to the includes). `each<Ts...>` calls
+     * and a `Query<Ts...>` over the same terms report one entry. `compact()` drops the query
+     * cache and with it the counters of keys that no `Query` holds. Empty unless built with
+     * `ECS_PROFILE`.
+     */
+    std::vector<QueryStats> query_stats() const {
+        std::vector<QueryStats> out;
+#if defined(ECS_PROFILE)
+        std::unordered_map<QueryKey, size_t, QueryKeyHash> slots;
+        auto slot = [&](const QueryKey& key) -> QueryStats& {
+            auto [it, inserted] = slots.try_emplace(key, out.size());
+            if (inserted) {
+                out.emplace_back();
+                out.back().include.assign(key.include_ids.begin(),
+                                          key.include_ids.begin() + key.n_include);
+                out.back().exclude.assign(key.exclude_ids.begin(),
+                                          key.exclude_ids.begin() + key.n_exclude);
+            }
+            return out[it->second];
+        };
+        std::lock_guard<std::mutex> lock(query_mutex_);
+        for (auto& [key, entry] : query_cache_)
+            entry.profile.add_to(slot(key));
+        for (auto& [key, state] : query_states_)
+            state->profile.add_to(slot(key));
+#endif
+        return out;
+    }
+
+    /** @brief Zeroes the instrumentation counters, including every query's. */
+    void reset_stats() {
+#if defined(ECS_PROFILE)
+        profile_.reset();
+        std::lock_guard<std::mutex> lock(query_mutex_);
+        for (auto& [key, entry] : query_cache_)
+            entry.profile.reset();
+        for (auto& [key, state] : query_states_)
+            state->profile.reset();
+#endif
+    }
+
+    /**
+     * @brief Routes trace events (systems, deferred flushes) to `sink`; pass nullptr to stop.
+     * @details The sink is not copied and must outlive its use. Ignored without `ECS_PROFILE`.
+     */
+    void set_trace_sink(const TraceSink* sink) {
+#if defined(ECS_PROFILE)
+        trace_sink_ = sink;
+#else
+        (void)sink;
+#endif
+    }
+
+    /** @brief Returns the current trace sink (always nullptr without `ECS_PROFILE`). */
+    const TraceSink* trace_sink() const {
+#if defined(ECS_PROFILE)
+        return trace_sink_;
+#else
+        return nullptr;
+#endif
+    }
+
     // -- Resources --
 
     /**
@@ -364,13 +737,16 @@ public:
      * @brief Registers a callback invoked whenever a component of type T is added to an entity.
      * @tparam T The component type.
      * @param fn Callback signature `void(World&, Entity, T&)`.
+     * @details The callback may make structural changes. Batched observers and event queues
+     * (below) are cheaper for hot types.
      */
     template <typename T>
     void on_add(std::function<void(World&, Entity, T&)> fn) {
-        auto cid = component_id<std::decay_t<T>>();
-        on_add_hooks_[cid].push_back([fn = std::move(fn)](World& w, Entity e, void* ptr) {
-            fn(w, e, *static_cast<T*>(ptr));
-        });
+        observers(add_observers_, observed_add_, component_id<std::decay_t<T>>())
+            .each.push_back([fn = std::move(fn)](World& w, Entity e, void* ptr) {
+                fn(w, e, *static_cast<T*>(ptr));
+            });
+        refresh_observed();
     }
 
     /**
@@ -381,10 +757,155 @@ public:
      */
     template <typename T>
     void on_remove(std::function<void(World&, Entity, T&)> fn) {
-        auto cid = component_id<std::decay_t<T>>();
-        on_remove_hooks_[cid].push_back([fn = std::move(fn)](World& w, Entity e, void* ptr) {
-            fn(w, e, *static_cast<T*>(ptr));
-        });
+        observers(remove_observers_, observed_remove_, component_id<std::decay_t<T>>())
+            .each.push_back([fn = std::move(fn)](World& w, Entity e, void* ptr) {
+                fn(w, e, *static_cast<T*>(ptr));
+            });
+        refresh_observed();
+    }
+
+    /**
+     * @brief Registers a batched observer for additions of T.
+     * @param fn Callback signature `void(World&, Span<const Entity>, T*)`: `values[i]` belongs
+     * to `entities[i]` (for tag types every entity shares `values[0]`).
+     * @details Called once per contiguous run of rows that gained T in one structural
+     * operation: `create_n*` and `flush_batched` add runs deliver whole runs, single-entity
+     * operations deliver spans of one. Both spans point into the archetype, so the callback
+     * must not make structural changes (use `deferred()`); it asserts if it does. Batched
+     * observers run before `on_add` callbacks of the same event.
+     */
+    template <typename T>
+    void on_add_batch(std::function<void(World&, Span<const Entity>, T*)> fn) {
+        observers(add_observers_, observed_add_, component_id<std::decay_t<T>>())
+            .batch.push_back([fn = std::move(fn)](World& w, Span<const Entity> es, void* ptr) {
+                fn(w, es, static_cast<T*>(ptr));
+            });
+        refresh_observed();
+    }
+
+    /**
+     * @brief Registers a batched observer for removals of T (see `on_add_batch`).
+     * @details `destroy_all<T>` delivers each archetype's rows as whole runs before any is
+     * destroyed. The values are valid during the callback.
+     */
+    template <typename T>
+    void on_remove_batch(std::function<void(World&, Span<const Entity>, T*)> fn) {
+        observers(remove_observers_, observed_remove_, component_id<std::decay_t<T>>())
+            .batch.push_back([fn = std::move(fn)](World& w, Span<const Entity> es, void* ptr) {
+                fn(w, es, static_cast<T*>(ptr));
+            });
+        refresh_observed();
+    }
+
+    /**
+     * @brief Starts queueing the entities that gain T, for `drain_added<T>`.
+     * @details Recording an event appends the entity handle to a per-type queue, so observer
+     * work can run in bulk later in the frame. Queues keep their capacity across drains.
+     */
+    template <typename T>
+    void queue_on_add() {
+        observers(add_observers_, observed_add_, component_id<std::decay_t<T>>()).queued = true;
+        refresh_observed();
+    }
+
+    /** @brief Starts queueing the entities that lose T (or are destroyed with it), for `drain_removed<T>`. */
+    template <typename T>
+    void queue_on_remove() {
+        observers(remove_observers_, observed_remove_, component_id<std::decay_t<T>>()).queued =
+            true;
+        refresh_observed();
+    }
+
+    /**
+     * @brief Hands the queued additions of T to `fn(World&, Span<const Entity>)` and empties
+     * the queue.
+     * @details Entities appear in event order, once per event: they may have lost T or died
+     * since. Events raised while `fn` runs are queued for the next drain.
+     * @return Number of events drained.
+     */
+    template <typename T, typename Fn>
+    size_t drain_added(Fn&& fn) {
+        return drain(add_observers_, component_id<std::decay_t<T>>(), fn);
+    }
+
+    /** @brief Hands the queued removals of T to `fn` and empties the queue (see `drain_added`). */
+    template <typename T, typename Fn>
+    size_t drain_removed(Fn&& fn) {
+        return drain(remove_observers_, component_id<std::decay_t<T>>(), fn);
+    }
+
+    // -- Value indexes --
+
+    /**
+     * @brief Indexes the entities holding T by `key(value)`, for `find_by<T>`.
+     * @param key Callable `Key(const T&)` (or a pointer to a member of T); `Key` needs
+     * `std::hash` and `==`.
+     * @param kind `Unique` asserts on a duplicate key; `Grouped` allows any number per key.
+     * @details The index is built from the current entities and then kept up to date by every
+     * path that fires observers — add, remove, destroy, `create*`, prefabs, deferred and
+     * batched flushes — plus `add<T>` overwrites and loads. It runs before the observers of
+     * the same event. Writes through `get<T>`, `each` or `single` are not seen: change an
+     * indexed value with `add<T>`, or call `reindex<T>()` after writing in place. Replaces any
+     * previous index on T.
+     * @warning Asserts if called during query iteration.
+     */
+    template <typename T, typename KeyFn>
+    void index_by(KeyFn key, IndexKind kind = IndexKind::Unique) {
+        ECS_ASSERT(iterating_ == 0, "index_by during iteration");
+        static_assert(!std::is_empty_v<T>, "index_by: tag components carry no value");
+        using Key = std::decay_t<std::invoke_result_t<KeyFn&, const T&>>;
+        ComponentTypeID cid = component_id<T>();
+        auto index = std::make_shared<ValueIndex<Key>>(kind);
+        ValueIndex<Key>* raw = index.get();
+        observers(add_observers_, observed_add_, cid).index =
+            [raw, key = std::move(key)](Entity e, void* ptr) {
+                raw->insert(e, std::invoke(key, *static_cast<const T*>(ptr)));
+            };
+        observers(remove_observers_, observed_remove_, cid).index = [raw](Entity e, void*) {
+            raw->erase(e);
+        };
+        if (cid >= value_indexes_.size())
+            value_indexes_.resize(size_t(cid) + 1);
+        value_indexes_[cid] = {std::move(index), &detail::index_key_tag<Key>,
+                               [](void* p) { static_cast<ValueIndex<Key>*>(p)->clear(); }};
+        indexed_.set(cid);
+        refresh_observed();
+        rebuild_index(cid);
+    }
+
+    /** @brief Indexes the entities holding T by the whole value (see `index_by(key, kind)`). */
+    template <typename T>
+    void index_by(IndexKind kind = IndexKind::Unique) {
+        index_by<T>([](const T& value) -> const T& { return value; }, kind);
+    }
+
+    /**
+     * @brief The entity whose T is indexed under `key`, or `INVALID_ENTITY`.
+     * @details O(1) on average. For a grouped index, returns one of the matching entities.
+     * `K` must be the index's key type (e.g. `find_by<NetworkId>(uint64_t{7})`).
+     * @warning Asserts if T has no index or `K` is not its key type.
+     */
+    template <typename T, typename K>
+    Entity find_by(const K& key) const {
+        return value_index<T, K>().find(key);
+    }
+
+    /**
+     * @brief Every entity whose T is indexed under `key` (at most one for a unique index).
+     * @details The span points into the index and is valid until the next structural change
+     * to T or write through `add<T>`.
+     */
+    template <typename T, typename K>
+    Span<const Entity> find_all_by(const K& key) const {
+        return value_index<T, K>().find_all(key);
+    }
+
+    /** @brief Rebuilds T's index from the current values, after in-place writes. */
+    template <typename T>
+    void reindex() {
+        ComponentTypeID cid = component_id<T>();
+        ECS_ASSERT(indexed_.test(cid), "reindex: T has no index");
+        rebuild_index(cid);
     }
 
     // -- Component access --
@@ -399,7 +920,15 @@ public:
     bool has(Entity e) const {
         if (!alive(e))
             return false;
-        return records_[e.index].archetype->has_component(component_id<T>());
+        if constexpr (is_split_component_v<T>) {
+            using S = std::remove_const_t<T>;
+            return has_lanes<S>(e, std::make_index_sequence<lane_count<S>()>{});
+        } else if constexpr (is_sparse_component_v<T>) {
+            const SparseSet* set = find_sparse(component_id<T>());
+            return set && set->contains(e.index);
+        } else {
+            return records_[e.index].archetype->has_component(component_id<T>());
+        }
     }
 
     /**
@@ -407,17 +936,41 @@ public:
      * @tparam T The component type.
      * @param e The entity.
      * @return Reference to the component.
+     * @details Marks the component as changed at the current tick (see `Changed`), even if the
+     * caller only reads it. Read through a `const World&` to leave the ticks untouched. The
+     * stamp is a relaxed atomic, so parallel systems may call this on the same column.
      * @warning Asserts if the entity is dead or missing the component.
      */
     template <typename T>
     T& get(Entity e) {
         ECS_ASSERT(alive(e), "get<T> on dead entity");
         ECS_ASSERT(has<T>(e), "get<T> on entity missing component");
+        if constexpr (is_sparse_component_v<T>) {
+            SparseSet& set = *find_sparse(component_id<T>());
+            set.column().mark_changed(set.row(e.index));
+            return *static_cast<T*>(set.get(e.index));
+        }
         auto& rec = records_[e.index];
         auto* col = rec.archetype->find_column(component_id<T>());
+        col->mark_changed(rec.row);
         return *static_cast<T*>(col->get(rec.row));
     }
 
+    /**
+     * @brief Read-only component access. Unlike the mutable overload, does not mark the component
+     * as changed.
+     */
+    template <typename T>
+    const T& get(Entity e) const {
+        ECS_ASSERT(alive(e), "get<T> on dead entity");
+        ECS_ASSERT(has<T>(e), "get<T> on entity missing component");
+        if constexpr (is_sparse_component_v<T>)
+            return *static_cast<const T*>(find_sparse(component_id<T>())->get(e.index));
+        auto& rec = records_[e.index];
+        auto* col = rec.archetype->find_column(component_id<T>());
+        return *static_cast<const T*>(col->get(rec.row));
+    }
+
     /**
      * @brief Tries to retrieve a pointer to an entity's component.
      * @tparam T The component type.
@@ -426,9 +979,66 @@ public:
      */
     template <typename T>
     T* try_get(Entity e) {
-        if (!has<T>(e))
-            return nullptr;
-        return &get<T>(e);
+        if constexpr (is_sparse_component_v<T>) {
+            if (!has<T>(e))
+                return nullptr;
+            return &get<T>(e);
+        } else {
+            // The column lookup doubles as the presence test
+            if (!alive(e))
+                return nullptr;
+            auto& rec = records_[e.index];
+            auto* col = rec.archetype->find_column(component_id<T>());
+            if (!col)
+                return nullptr;
+            col->mark_changed(rec.row);
+            return static_cast<T*>(col->get(rec.row));
+        }
+    }
+
+    /** @brief Read-only variant of `try_get`; does not mark the component as changed. */
+    template <typename T>
+    const T* try_get(Entity e) const {
+        if constexpr (is_sparse_component_v<T>) {
+            if (!has<T>(e))
+                return nullptr;
+            return &get<T>(e);
+        } else {
+            if (!alive(e))
+                return nullptr;
+            auto& rec = records_[e.index];
+            const auto* col = rec.archetype->find_column(component_id<T>());
+            return col ? static_cast<const T*>(col->get(rec.row)) : nullptr;
+        }
+    }
+
+    /**
+     * @brief Returns a copy of an entity's component.
+     * @details The way to read a split component (see `split_fields`): the value is assembled
+     * from its lanes. For other types it is `get<T>` on a const World. Does not mark anything
+     * as changed.
+     * @warning Asserts if the entity is dead or missing the component.
+     */
+    template <typename T>
+    T load(Entity e) const {
+        if constexpr (is_split_component_v<T>)
+            return load_lanes<T>(e, std::make_index_sequence<lane_count<T>()>{});
+        else
+            return get<T>(e);
+    }
+
+    /**
+     * @brief Overwrites an entity's existing component.
+     * @details For a split component, scatters `value` into its lanes and marks every lane as
+     * changed. For other types it is assignment through `get<T>`.
+     * @warning Asserts if the entity is dead or missing the component.
+     */
+    template <typename T>
+    void store(Entity e, const T& value) {
+        if constexpr (is_split_component_v<T>)
+            store_lanes<T>(e, value, std::make_index_sequence<lane_count<T>()>{});
+        else
+            get<T>(e) = value;
     }
 
     // -- Add component (archetype migration) --
@@ -439,37 +1049,62 @@ public:
      * @param e The entity.
      * @param component The component data.
      * @details If the entity already has T, the data is overwritten (assignment).
-     * If not, the entity is migrated to a new archetype containing T.
+     * If not, the entity is migrated to a new archetype containing T. A split T adds all of
+     * its lanes with a single migration.
      * @warning Asserts if called during query iteration.
      */
     template <typename T>
     void add(Entity e, T&& component) {
-        ECS_ASSERT(iterating_ == 0, "structural change during iteration");
-        if (!alive(e))
-            return;
-        ensure_column_factory<std::decay_t<T>>();
-        ComponentTypeID cid = component_id<std::decay_t<T>>();
+        if constexpr (is_split_component_v<std::decay_t<T>>) {
+            using S = std::decay_t<T>;
+            add_lanes<S>(e, component, std::make_index_sequence<lane_count<S>()>{});
+        } else {
+            ECS_ASSERT(iterating_ == 0, "structural change during iteration");
+            if (!alive(e))
+                return;
+            ensure_column_factory<std::decay_t<T>>();
+            ComponentTypeID cid = component_id<std::decay_t<T>>();
+
+            if constexpr (is_sparse_component_v<std::decay_t<T>>) {
+                // No migration: the value goes into (or overwrites) the entity's sparse row
+                SparseSet& set = sparse_set(cid);
+                if (set.contains(e.index)) {
+                    *static_cast<std::decay_t<T>*>(set.get(e.index)) = std::forward<T>(component);
+                    set.column().mark_changed(set.row(e.index));
+                    notify_overwrite(cid, e, set.get(e.index));
+                    return;
+                }
+                set.insert(e, [&](ComponentColumn& col) {
+                    col.emplace_back<std::decay_t<T>>(std::forward<T>(component));
+                });
+                notify_add(cid, e, set.get(e.index));
+                return;
+            }
 
-        auto& rec = records_[e.index];
-        Archetype* old_arch = rec.archetype;
-        if (old_arch->has_component(cid)) {
-            // Already has it, just overwrite
-            auto* col = old_arch->find_column(cid);
-            T* ptr = static_cast<T*>(col->get(rec.row));
-            *ptr = std::forward<T>(component);
-            return;
-        }
+            auto& rec = records_[e.index];
+            Archetype* old_arch = rec.archetype;
+            if (old_arch->has_component(cid)) {
+                // Already has it, just overwrite
+                auto* col = old_arch->find_column(cid);
+                T* ptr = static_cast<T*>(col->get(rec.row));
+                *ptr = std::forward<T>(component);
+                col->mark_changed(rec.row);
+                notify_overwrite(cid, e, ptr);
+                return;
+            }
 
-        Archetype* new_arch = find_add_target(old_arch, cid);
-        migrate_entity(e, old_arch, new_arch, rec.row);
+            Archetype* new_arch = find_add_target(old_arch, cid);
+            migrate_entity(e, old_arch, new_arch, rec.row);
 
-        // Push the new component
-        auto* col = new_arch->find_column(cid);
-        std::decay_t<T> tmp = std::forward<T>(component);
-        col->push_raw(&tmp);
+            // Construct the new component in place
+            new_arch->find_column(cid)->emplace_back<std::decay_t<T>>(std::forward<T>(component));
 
-        // Fire on_add after data is in place and record is updated
-        fire_hooks(on_add_hooks_, cid, e, new_arch->find_column(cid)->get(records_[e.index].row));
+            // Fire on_add after data is in place and record is updated
+            if (observed_add_.test(cid)) {
+                void* data = new_arch->find_column(cid)->get(records_[e.index].row);
+                notify(add_observers_, cid, e, data);
+            }
+        }
     }
 
     // -- Remove component (archetype migration) --
@@ -479,28 +1114,38 @@ public:
      * @tparam T The component type.
      * @param e The entity.
      * @details Migrates the entity to an archetype without T. If the entity doesn't have T, does
-     * nothing.
+     * nothing. A split T removes all of its lanes with a single migration.
      * @warning Asserts if called during query iteration.
      */
     template <typename T>
     void remove(Entity e) {
-        ECS_ASSERT(iterating_ == 0, "structural change during iteration");
-        if (!alive(e))
-            return;
-        ComponentTypeID cid = component_id<T>();
+        if constexpr (is_split_component_v<T>) {
+            using S = std::remove_const_t<T>;
+            remove_lanes<S>(e, std::make_index_sequence<lane_count<S>()>{});
+        } else {
+            ECS_ASSERT(iterating_ == 0, "structural change during iteration");
+            if (!alive(e))
+                return;
+            ComponentTypeID cid = component_id<T>();
+            if constexpr (is_sparse_component_v<T>) {
+                remove_sparse(e, cid);
+                return;
+            }
 
-        auto& rec = records_[e.index];
-        Archetype* old_arch = rec.archetype;
-        if (!old_arch->has_component(cid))
-            return;
+            auto& rec = records_[e.index];
+            Archetype* old_arch = rec.archetype;
+            if (!old_arch->has_component(cid))
+                return;
 
-        Archetype* new_arch = find_remove_target(old_arch, cid);
-        size_t old_row = rec.row;
+            Archetype* new_arch = find_remove_target(old_arch, cid);
+            size_t old_row = rec.row;
 
-        // Fire on_remove before data is destroyed
-        fire_hooks(on_remove_hooks_, cid, e, old_arch->find_column(cid)->get(old_row));
+            // Fire on_remove before data is destroyed
+            if (observed_remove_.test(cid))
+                notify(remove_observers_, cid, e, old_arch->find_column(cid)->get(old_row));
 
-        migrate_entity_removing(e, old_arch, new_arch, old_row, cid);
+            migrate_entity_removing(e, old_arch, new_arch, old_row, cid);
+        }
     }
 
     // -- Query iteration --
@@ -509,6 +1154,46 @@ public:
     template <typename... Ts>
     struct Exclude {};
 
+    /**
+     * @brief Change filter: `each<A>(Changed<B>{since}, fn)` visits entities with A and B whose B
+     * was added or written after tick `since`. With several types, any one of them qualifies.
+     */
+    template <typename... Ts>
+    struct Changed {
+        uint32_t since = 0;
+    };
+
+    /**
+     * @brief Add filter: `each<A>(Added<B>{since}, fn)` visits entities with A and B whose B was
+     * added after tick `since`. With several types, any one of them qualifies.
+     */
+    template <typename... Ts>
+    struct Added {
+        uint32_t since = 0;
+    };
+
+    // -- Change detection --
+
+    /**
+     * @brief Returns the current change tick.
+     * @details Every column row records the tick at which its component was added and last
+     * changed. Adding a component (`add`, `create_with`, batch creation, prefab instantiation,
+     * deserialization) stamps both; mutable access (`get<T>`, `each` over non-const `T`, and
+     * overwriting `add`) stamps the changed tick. Read-only access (`each<const T>`, `get` on a
+     * const World) and archetype migration leave ticks untouched.
+     */
+    uint32_t change_tick() const { return change_tick_; }
+
+    /**
+     * @brief Ends the current tick and starts the next one.
+     * @return The tick that just ended. Passing it as `since` to a later `Changed`/`Added`
+     * filter selects exactly the writes made after this call.
+     */
+    uint32_t advance_tick() {
+        ECS_ASSERT(iterating_ == 0, "advance_tick during iteration");
+        return change_tick_++;
+    }
+
     /**
      * @brief Iterates over all entities possessing components Ts...
      * @tparam Ts Component types to match.
@@ -517,21 +1202,24 @@ public:
      */
     template <typename... Ts, typename Func>
     void each(Func&& fn) {
+        if constexpr (any_sparse_v<Ts...>) {
+            each_sparse<true, Ts...>(nullptr, 0, fn);
+            return;
+        }
         ++iterating_;
         struct Guard {
-            int& count;
+            std::atomic<int>& count;
             ~Guard() { --count; }
         } guard{iterating_};
 
         ComponentTypeID ids[] = {component_id<Ts>()...};
-        for (auto* arch : cached_query(ids, sizeof...(Ts), nullptr, 0)) {
-            size_t n = arch->count();
-            if (n == 0)
+        const QueryCacheEntry& q = query_entry(ids, sizeof...(Ts), nullptr, 0);
+        for (auto* arch : q.archetypes) {
+            if (arch->count() == 0)
                 continue;
-            auto ptrs = std::make_tuple(static_cast<Ts*>(
-                static_cast<void*>(arch->find_column(component_id<Ts>())->data))...);
-            for (size_t i = 0; i < n; ++i)
-                fn(arch->entities[i], std::get<Ts*>(ptrs)[i]...);
+            (mark_mutable_column<Ts>(arch), ...);
+            ECS_PROFILE_ADD(q.profile, entities_visited, arch->count());
+            iterate_rows<true, Ts...>(arch, 0, arch->count(), fn);
         }
     }
 
@@ -543,21 +1231,24 @@ public:
      */
     template <typename... Ts, typename Func>
     void each_no_entity(Func&& fn) {
+        if constexpr (any_sparse_v<Ts...>) {
+            each_sparse<false, Ts...>(nullptr, 0, fn);
+            return;
+        }
         ++iterating_;
         struct Guard {
-            int& count;
+            std::atomic<int>& count;
             ~Guard() { --count; }
         } guard{iterating_};
 
         ComponentTypeID ids[] = {component_id<Ts>()...};
-        for (auto* arch : cached_query(ids, sizeof...(Ts), nullptr, 0)) {
-            size_t n = arch->count();
-            if (n == 0)
+        const QueryCacheEntry& q = query_entry(ids, sizeof...(Ts), nullptr, 0);
+        for (auto* arch : q.archetypes) {
+            if (arch->count() == 0)
                 continue;
-            auto ptrs = std::make_tuple(static_cast<Ts*>(
-                static_cast<void*>(arch->find_column(component_id<Ts>())->data))...);
-            for (size_t i = 0; i < n; ++i)
-                fn(std::get<Ts*>(ptrs)[i]...);
+            (mark_mutable_column<Ts>(arch), ...);
+            ECS_PROFILE_ADD(q.profile, entities_visited, arch->count());
+            iterate_rows<false, Ts...>(arch, 0, arch->count(), fn);
         }
     }
 
@@ -572,22 +1263,26 @@ public:
      */
     template <typename... Ts, typename... Ex, typename Func>
     void each(Exclude<Ex...>, Func&& fn) {
-        ++iterating_;
+        ComponentTypeID include_ids[] = {component_id<Ts>()...};
+        ComponentTypeID exclude_ids[] = {component_id<Ex>()...};
+        if constexpr (any_sparse_v<Ts..., Ex...>) {
+            each_sparse<true, Ts...>(exclude_ids, sizeof...(Ex), fn);
+            return;
+        }
+        ++iterating_;
         struct Guard {
-            int& count;
+            std::atomic<int>& count;
             ~Guard() { --count; }
         } guard{iterating_};
 
-        ComponentTypeID include_ids[] = {component_id<Ts>()...};
-        ComponentTypeID exclude_ids[] = {component_id<Ex>()...};
-        for (auto* arch : cached_query(include_ids, sizeof...(Ts), exclude_ids, sizeof...(Ex))) {
-            size_t n = arch->count();
-            if (n == 0)
+        const QueryCacheEntry& q =
+            query_entry(include_ids, sizeof...(Ts), exclude_ids, sizeof...(Ex));
+        for (auto* arch : q.archetypes) {
+            if (arch->count() == 0)
                 continue;
-            auto ptrs = std::make_tuple(static_cast<Ts*>(
-                static_cast<void*>(arch->find_column(component_id<Ts>())->data))...);
-            for (size_t i = 0; i < n; ++i)
-                fn(arch->entities[i], std::get<Ts*>(ptrs)[i]...);
+            (mark_mutable_column<Ts>(arch), ...);
+            ECS_PROFILE_ADD(q.profile, entities_visited, arch->count());
+            iterate_rows<true, Ts...>(arch, 0, arch->count(), fn);
         }
     }
 
@@ -600,25 +1295,193 @@ public:
      */
     template <typename... Ts, typename... Ex, typename Func>
     void each_no_entity(Exclude<Ex...>, Func&& fn) {
+        ComponentTypeID include_ids[] = {component_id<Ts>()...};
+        ComponentTypeID exclude_ids[] = {component_id<Ex>()...};
+        if constexpr (any_sparse_v<Ts..., Ex...>) {
+            each_sparse<false, Ts...>(exclude_ids, sizeof...(Ex), fn);
+            return;
+        }
         ++iterating_;
         struct Guard {
-            int& count;
+            std::atomic<int>& count;
             ~Guard() { --count; }
         } guard{iterating_};
 
-        ComponentTypeID include_ids[] = {component_id<Ts>()...};
-        ComponentTypeID exclude_ids[] = {component_id<Ex>()...};
-        for (auto* arch : cached_query(include_ids, sizeof...(Ts), exclude_ids, sizeof...(Ex))) {
-            size_t n = arch->count();
-            if (n == 0)
+        const QueryCacheEntry& q =
+            query_entry(include_ids, sizeof...(Ts), exclude_ids, sizeof...(Ex));
+        for (auto* arch : q.archetypes) {
+            if (arch->count() == 0)
                 continue;
-            auto ptrs = std::make_tuple(static_cast<Ts*>(
-                static_cast<void*>(arch->find_column(component_id<Ts>())->data))...);
-            for (size_t i = 0; i < n; ++i)
-                fn(std::get<Ts*>(ptrs)[i]...);
+            (mark_mutable_column<Ts>(arch), ...);
+            ECS_PROFILE_ADD(q.profile, entities_visited, arch->count());
+            iterate_rows<false, Ts...>(arch, 0, arch->count(), fn);
         }
     }
 
+    // -- Change-filtered overloads --
+
+    /**
+     * @brief Iterates entities with Ts... whose filter components changed after `filter.since`.
+     * @details Archetypes whose filter columns have not changed since then are skipped without
+     * touching their rows. Mutable Ts are stamped as changed only for the rows visited.
+     * @tparam Ts Component types to match.
+     * @tparam Cs Filter component types (implicitly required).
+     * @tparam Func Callback signature `void(Entity, Ts&...)`.
+     */
+    template <typename... Ts, typename... Cs, typename Func>
+    void each(Changed<Cs...> filter, Func&& fn) {
+        static_assert(!any_sparse_v<Ts..., Cs...>, "change filters require archetype components");
+        ComponentTypeID filter_ids[] = {component_id<Cs>()...};
+        each_since<true, Ts...>(filter_ids, sizeof...(Cs), false, filter.since, fn);
+    }
+
+    /** @brief Visits entities with Ts... whose filter components were added after `since`. */
+    template <typename... Ts, typename... Cs, typename Func>
+    void each(Added<Cs...> filter, Func&& fn) {
+        static_assert(!any_sparse_v<Ts..., Cs...>, "change filters require archetype components");
+        ComponentTypeID filter_ids[] = {component_id<Cs>()...};
+        each_since<true, Ts...>(filter_ids, sizeof...(Cs), true, filter.since, fn);
+    }
+
+    /** @brief `each(Changed<Cs...>, fn)` ignoring the Entity ID. */
+    template <typename... Ts, typename... Cs, typename Func>
+    void each_no_entity(Changed<Cs...> filter, Func&& fn) {
+        static_assert(!any_sparse_v<Ts..., Cs...>, "change filters require archetype components");
+        ComponentTypeID filter_ids[] = {component_id<Cs>()...};
+        each_since<false, Ts...>(filter_ids, sizeof...(Cs), false, filter.since, fn);
+    }
+
+    /** @brief `each(Added<Cs...>, fn)` ignoring the Entity ID. */
+    template <typename... Ts, typename... Cs, typename Func>
+    void each_no_entity(Added<Cs...> filter, Func&& fn) {
+        static_assert(!any_sparse_v<Ts..., Cs...>, "change filters require archetype components");
+        ComponentTypeID filter_ids[] = {component_id<Cs>()...};
+        each_since<false, Ts...>(filter_ids, sizeof...(Cs), true, filter.since, fn);
+    }
+
+    // -- Parallel query iteration --
+
+    /**
+     * @brief Iterates over all entities possessing components Ts..., spread across a thread pool.
+     * @details Each matched archetype is split into row ranges of `Archetype::chunk_rows()` rows
+     * (about `CHUNK_BYTES` of component data), which the pool distributes with work stealing.
+     * Blocks until every entity has been visited. Structural changes remain forbidden; queue
+     * them with `deferred()`, which records per range and merges in archetype and row order.
+     * @warning `fn` is invoked concurrently and must only touch the entity it is given (or
+     * otherwise synchronize). Visit order is unspecified.
+     * @tparam Ts Component types to match.
+     * @tparam Func Callback signature `void(Entity, Ts&...)`.
+     * @param pool The thread pool to run on. Calls from inside a pool job run inline.
+     * @param fn The callback to invoke for each matching entity.
+     */
+    template <typename... Ts, typename Func>
+    void par_each(ThreadPool& pool, Func&& fn) {
+        ComponentTypeID ids[] = {component_id<Ts>()...};
+        const QueryCacheEntry& q = query_entry(ids, sizeof...(Ts), nullptr, 0);
+        par_for_row_ranges<Ts...>(pool, q.archetypes, [&](size_t a, size_t begin, size_t end) {
+            ECS_PROFILE_ADD(q.profile, entities_visited, end - begin);
+            iterate_rows<true, Ts...>(q.archetypes[a], begin, end, fn);
+        });
+    }
+
+    /**
+     * @brief Parallel variant of `each_no_entity`. See `par_each`.
+     * @tparam Func Callback signature `void(Ts&...)`.
+     */
+    template <typename... Ts, typename Func>
+    void par_each_no_entity(ThreadPool& pool, Func&& fn) {
+        ComponentTypeID ids[] = {component_id<Ts>()...};
+        const QueryCacheEntry& q = query_entry(ids, sizeof...(Ts), nullptr, 0);
+        par_for_row_ranges<Ts...>(pool, q.archetypes, [&](size_t a, size_t begin, size_t end) {
+            ECS_PROFILE_ADD(q.profile, entities_visited, end - begin);
+            iterate_rows<false, Ts...>(q.archetypes[a], begin, end, fn);
+        });
+    }
+
+    /**
+     * @brief Parallel variant of `each(Exclude<Ex...>, fn)`. See `par_each`.
+     * @tparam Func Callback signature `void(Entity, Ts&...)`.
+     */
+    template <typename... Ts, typename... Ex, typename Func>
+    void par_each(ThreadPool& pool, Exclude<Ex...>, Func&& fn) {
+        static_assert(!any_sparse_v<Ex...>, "par_each requires archetype components");
+        ComponentTypeID include_ids[] = {component_id<Ts>()...};
+        ComponentTypeID exclude_ids[] = {component_id<Ex>()...};
+        const QueryCacheEntry& q =
+            query_entry(include_ids, sizeof...(Ts), exclude_ids, sizeof...(Ex));
+        par_for_row_ranges<Ts...>(pool, q.archetypes, [&](size_t a, size_t begin, size_t end) {
+            ECS_PROFILE_ADD(q.profile, entities_visited, end - begin);
+            iterate_rows<true, Ts...>(q.archetypes[a], begin, end, fn);
+        });
+    }
+
+    /**
+     * @brief Parallel variant of `each_no_entity(Exclude<Ex...>, fn)`. See `par_each`.
+     * @tparam Func Callback signature `void(Ts&...)`.
+     */
+    template <typename... Ts, typename... Ex, typename Func>
+    void par_each_no_entity(ThreadPool& pool, Exclude<Ex...>, Func&& fn) {
+        static_assert(!any_sparse_v<Ex...>, "par_each requires archetype components");
+        ComponentTypeID include_ids[] = {component_id<Ts>()...};
+        ComponentTypeID exclude_ids[] = {component_id<Ex>()...};
+        const QueryCacheEntry& q =
+            query_entry(include_ids, sizeof...(Ts), exclude_ids, sizeof...(Ex));
+        par_for_row_ranges<Ts...>(pool, q.archetypes, [&](size_t a, size_t begin, size_t end) {
+            ECS_PROFILE_ADD(q.profile, entities_visited, end - begin);
+            iterate_rows<false, Ts...>(q.archetypes[a], begin, end, fn);
+        });
+    }
+
+    // -- Lane iteration --
+
+    /**
+     * @brief Calls `fn(Span<const Entity>, Args...)` once per contiguous run of entities with
+     * all of Ts..., handing out arrays instead of elements.
+     * @details For a split type (see `split_fields`) the argument is a `Lanes<T>` with one
+     * aligned array per field. For any other type it is a `T*` to the run's first row, as in
+     * `Query::each_chunk`. Element `i` of every array belongs to `entities[i]`. A run is a
+     * whole archetype in block storage and one chunk in chunked storage. Mutable Ts mark all
+     * of their columns (every lane, for split types) as changed, as in `each`.
+     * @code
+     *   world.each_lanes<Position3, const Velocity3>(
+     *       [&](Span<const Entity> es, Lanes<Position3> p, Lanes<const Velocity3> v) {
+     *           float* px = p.lane<0>();
+     *           const float* vx = v.lane<0>();
+     *           for (size_t i = 0; i < es.size(); ++i)
+     *               px[i] += vx[i] * dt;
+     *       });
+     * @endcode
+     */
+    template <typename... Ts, typename Func>
+    void each_lanes(Func&& fn) {
+        static_assert(!any_sparse_v<Ts...>, "each_lanes requires archetype components");
+        each_lanes_impl<Ts...>(fn, std::index_sequence_for<Ts...>{});
+    }
+
+    // -- Persistent queries --
+
+    /**
+     * @brief Compiles a persistent query over archetype components Ts... (see `Query`).
+     * @details The matching archetypes and their columns are resolved here and kept current
+     * as archetypes are created or deleted, so iterating the query needs no hashing or column
+     * lookup. Equal queries share one state, which lives as long as the World.
+     */
+    template <typename... Ts>
+    Query<Ts...> query() {
+        return query<Ts...>(Exclude<>{});
+    }
+
+    /** @brief Compiles a persistent query over Ts... without Ex... (see `query()`). */
+    template <typename... Ts, typename... Ex>
+    Query<Ts...> query(Exclude<Ex...>) {
+        static_assert(sizeof...(Ts) > 0, "query requires at least one component");
+        static_assert(!any_sparse_v<Ts..., Ex...>, "queries require archetype components");
+        ComponentTypeID include_ids[] = {component_id<Ts>()...};
+        ComponentTypeID exclude_ids[sizeof...(Ex) + 1] = {component_id<Ex>()...};
+        return Query<Ts...>(this, &query_state(include_ids, sizeof...(Ts), exclude_ids,
+                                               sizeof...(Ex)));
+    }
+
     // -- Sorting --
 
     /**
@@ -627,11 +1490,14 @@ public:
      * @tparam Compare Comparator type (e.g., lambda `bool(const T&, const T&)`).
      * @param cmp The comparator function.
      * @details This performs an in-place sort within each archetype containing T.
-     * This improves data locality for subsequent iterations.
+     * This improves data locality for subsequent iterations. The permutation is applied as a
+     * column-wise gather. To keep an order across frames, prefer `order_by<T>`, which only
+     * reorders the rows that broke it.
      * @warning Asserts if called during query iteration.
      */
     template <typename T, typename Compare>
     void sort(Compare&& cmp) {
+        static_assert(!is_sparse_component_v<T>, "sort<T> requires an archetype component");
         ECS_ASSERT(iterating_ == 0, "sort during iteration");
         ComponentTypeID cid = component_id<T>();
 
@@ -643,50 +1509,116 @@ public:
                 continue;
 
             // Build index array
-            std::vector<size_t> perm(n);
+            std::vector<size_t>& perm = order_perm_;
+            perm.resize(n);
             std::iota(perm.begin(), perm.end(), size_t(0));
 
             // Sort indices by comparing T column elements
             auto& sort_col = *arch->find_column(cid);
-            uint8_t* sort_data = sort_col.data;
-            size_t sort_elem = sort_col.elem_size;
             std::sort(perm.begin(), perm.end(), [&](size_t a, size_t b) {
-                return cmp(*static_cast<T*>(static_cast<void*>(sort_data + a * sort_elem)),
-                           *static_cast<T*>(static_cast<void*>(sort_data + b * sort_elem)));
+                return cmp(*static_cast<T*>(sort_col.get(a)), *static_cast<T*>(sort_col.get(b)));
             });
 
-            // Invert the gather permutation to get a scatter permutation
-            // perm[i] = "source index for destination i" (gather)
-            // inv[i] = "destination index for source i" (scatter)
-            std::vector<size_t> inv(n);
-            for (size_t i = 0; i < n; ++i)
-                inv[perm[i]] = i;
-
-            // Apply scatter permutation via cycle-chasing swaps
-            for (size_t i = 0; i < n; ++i) {
-                while (inv[i] != i) {
-                    size_t j = inv[i];
-                    std::swap(arch->entities[i], arch->entities[j]);
-                    for (auto& [col_id, col] : arch->columns) {
-                        col.swap_fn(col.get(i), col.get(j));
-                    }
-                    std::swap(inv[i], inv[j]);
-                }
-            }
+            // Block-level change ticks are positional; fold them into the rows before moving rows
+            for (auto& [col_id, col] : arch->columns)
+                col.flatten_ticks();
 
-            // Update entity records
-            for (size_t i = 0; i < n; ++i) {
-                records_[arch->entities[i].index].row = i;
+            gather_rows(*arch, perm.data(), 0, n);
+        }
+    }
+
+    // -- Maintained order --
+
+    /**
+     * @brief Keeps the rows of every archetype containing T ordered by `key(const T&)`.
+     * @tparam T The component holding the key (not sparse).
+     * @param key Returns a value ordered by `operator<`, e.g. `std::make_tuple(m.material,
+     * m.depth)`. It must be a pure function of the component.
+     * @details Sorts every matching archetype now, then `refresh_order()` restores the order
+     * after structural changes and key writes. Unlike `sort<T>`, a refresh only reorders the
+     * rows that broke the order: appended rows (creation, migration in), rows moved by
+     * swap-removal, and rows whose key changed. An archetype whose rows stayed in place and
+     * whose T column was last written before the tick of the previous refresh is skipped
+     * without reading it (so with one `advance_tick` per frame, quiet archetypes cost nothing
+     * from their second quiet frame on). Registering T again replaces its key. An archetype
+     * containing several ordered components follows the one registered first.
+     * @warning Asserts if called during query iteration.
+     */
+    template <typename T, typename KeyFn>
+    void order_by(KeyFn key) {
+        static_assert(!is_sparse_component_v<T>, "order_by<T> requires an archetype component");
+        ECS_ASSERT(iterating_ == 0, "order_by during iteration");
+        ensure_column_factory<T>();
+        ComponentTypeID cid = component_id<T>();
+        auto refresh = [key = std::move(key)](World& w, Archetype& arch) {
+            return w.refresh_archetype_order<T>(arch, key);
+        };
+        auto it = std::find_if(order_policies_.begin(), order_policies_.end(),
+                               [&](const OrderPolicy& p) { return p.cid == cid; });
+        if (it != order_policies_.end())
+            it->refresh = std::move(refresh);
+        else
+            order_policies_.push_back({cid, std::move(refresh)});
+        for (auto& [ts, arch] : archetypes_)
+            if (arch->has_component(cid))
+                arch->order.rows_moved = true; // the old order says nothing about the new key
+        refresh_order();
+    }
+
+    /** @brief Stops maintaining the order registered by `order_by<T>` (rows stay where they are). */
+    template <typename T>
+    void clear_order() {
+        ComponentTypeID cid = component_id<T>();
+        order_policies_.erase(std::remove_if(order_policies_.begin(), order_policies_.end(),
+                                             [&](const OrderPolicy& p) { return p.cid == cid; }),
+                              order_policies_.end());
+        for (auto& [ts, arch] : archetypes_)
+            arch->order.rows_moved = true; // another policy may now apply
+    }
+
+    /**
+     * @brief Restores every order registered with `order_by` (see there).
+     * @details Call once per frame, after structural changes and before the ordered
+     * iteration. Each archetype is checked in one pass over its keys; the rows breaking the
+     * order are sorted and merged back, and only the affected row range is gathered.
+     * @return Number of rows that moved.
+     * @warning Asserts if called during query iteration.
+     */
+    size_t refresh_order() {
+        ECS_ASSERT(iterating_ == 0, "refresh_order during iteration");
+        if (order_policies_.empty())
+            return 0;
+        size_t moved = 0;
+        for (auto& [ts, arch] : archetypes_) {
+            for (auto& policy : order_policies_) {
+                if (arch->has_component(policy.cid)) {
+                    moved += policy.refresh(*this, *arch);
+                    break;
+                }
             }
         }
+        return moved;
     }
 
     friend void serialize(const World& world, std::ostream& out);
     friend void deserialize(World& world, std::istream& in);
+    friend void serialize_snapshot(const World& world, std::ostream& out);
+    friend bool deserialize_snapshot(World& world, const void* data, size_t size);
+    friend void serialize_delta(const World& world, uint32_t since, std::ostream& out);
+    friend void apply_delta(World& world, std::istream& in);
+    friend StreamCapture capture_stream(const World& world, const StreamOptions& options);
+    friend bool deserialize_stream(World& world, std::istream& in, const StreamOptions& options);
     friend class CommandBuffer;
+    friend class Checkpoint;
+    template <typename... Ts>
+    friend class Query;
     friend Entity instantiate(World& world, const Prefab& prefab);
     template <typename... Overrides>
     friend Entity instantiate(World& world, const Prefab& prefab, Overrides&&... overrides);
+    friend Span<const Entity> instantiate_n(World& world, const Prefab& prefab, size_t n);
+    template <typename... Overrides, typename Gen>
+    friend Span<const Entity> instantiate_n(World& world, const Prefab& prefab, size_t n,
+                                            Gen&& gen);
 
 private:
     struct ErasedResource {
@@ -714,31 +1646,275 @@ private:
         ErasedResource& operator=(const ErasedResource&) = delete;
     };
 
+    WorldConfig config_;
     std::vector<uint32_t> generations_;
+    std::vector<uint32_t> structure_ticks_; // per slot: tick of the last create/destroy/migration
     std::vector<EntityRecord> records_;
     std::vector<uint32_t> free_list_;
+    uint32_t generation_floor_ = 0; // first generation of new slots; raised by compact()
     std::unordered_map<TypeSet, std::unique_ptr<Archetype>, TypeSetHash> archetypes_;
+    uint64_t archetype_epoch_ = 0; // bumped when archetypes are deleted (checkpoints compare it)
     std::unordered_map<ComponentTypeID, ErasedResource> resources_;
-    int iterating_ = 0;
+    std::atomic<int> iterating_{0};
     CommandBuffer deferred_commands_;
+    // Per-job buffers of top-level par_for calls, by job index; the mutex serializes such calls
+    std::vector<CommandBuffer> job_buffers_;
+    std::mutex job_buffers_mutex_;
+
+    // The buffer `deferred()` returns on this thread while a par_for job of `world` runs
+    struct JobCommands {
+        const World* world = nullptr;
+        CommandBuffer* buffer = nullptr;
+    };
+    static JobCommands& job_commands() {
+        thread_local JobCommands current;
+        return current;
+    }
+    struct JobScope {
+        JobCommands saved;
+        JobScope(const World* world, CommandBuffer* buffer) : saved(job_commands()) {
+            job_commands() = {world, buffer};
+        }
+        ~JobScope() { job_commands() = saved; }
+        JobScope(const JobScope&) = delete;
+        JobScope& operator=(const JobScope&) = delete;
+    };
+    std::vector<uint32_t> run_marks_; // flush_batched duplicate detection, by entity index
+    uint32_t run_epoch_ = 0;
+    uint32_t change_tick_ = 1; // stamped into column ticks on writes; see advance_tick()
+    std::vector<std::unique_ptr<SparseSet>> sparse_sets_; // by component ID; null until used
+    std::vector<ComponentTypeID> sparse_ids_;             // IDs with a set, in creation order
+    struct OrderPolicy {
+        ComponentTypeID cid;
+        std::function<size_t(World&, Archetype&)> refresh; // returns the rows moved
+    };
+    std::vector<OrderPolicy> order_policies_; // in registration order
+    std::vector<size_t> order_perm_, order_kept_, order_out_; // sort scratch, reused
+    std::vector<size_t> gather_moved_;                        // gather_rows scratch, reused
+    std::vector<uint32_t> gather_ticks_;
+    std::vector<Entity> gather_entities_;
+    std::vector<Entity> batch_created_; // entities returned by the last batch creation
+#if defined(ECS_PROFILE)
+    mutable ProfileCounters profile_; // counted from const queries too
+    const TraceSink* trace_sink_ = nullptr;
+#endif
 
     // -- Observer hooks --
-    std::unordered_map<ComponentTypeID, std::vector<std::function<void(World&, Entity, void*)>>>
-        on_add_hooks_;
-    std::unordered_map<ComponentTypeID, std::vector<std::function<void(World&, Entity, void*)>>>
-        on_remove_hooks_;
-
-    void fire_hooks(
-        const std::unordered_map<ComponentTypeID,
-                                 std::vector<std::function<void(World&, Entity, void*)>>>& hooks,
-        ComponentTypeID cid, Entity e, void* data) {
-        auto it = hooks.find(cid);
-        if (it == hooks.end())
-            return;
-        for (auto& fn : it->second)
+
+    // The observers of one component ID for one event kind
+    struct ObserverList {
+        std::vector<std::function<void(World&, Entity, void*)>> each;
+        std::vector<std::function<void(World&, Span<const Entity>, void*)>> batch;
+        bool queued = false;
+        std::vector<Entity> queue;    // events since the last drain
+        std::vector<Entity> draining; // the previous queue, handed to a drain; kept for capacity
+        std::function<void(Entity, void*)> index; // value index upkeep; runs before observers
+    };
+    using ObserverLists = std::vector<std::unique_ptr<ObserverList>>; // stable across growth
+    ObserverLists add_observers_;    // by component ID; null if never observed
+    ObserverLists remove_observers_; // by component ID; null if never observed
+    ComponentMask observed_add_;                 // IDs with any add observer
+    ComponentMask observed_remove_;              // IDs with any remove observer
+    struct IndexSlot {
+        std::shared_ptr<void> index;   // ValueIndex<Key>
+        const void* key_tag = nullptr; // &detail::index_key_tag<Key>, checked by lookups
+        void (*clear)(void*) = nullptr;
+    };
+    std::vector<IndexSlot> value_indexes_; // by component ID
+    ComponentMask indexed_;                // IDs with a value index
+
+    static ObserverList& observers(ObserverLists& lists, ComponentMask& observed,
+                                   ComponentTypeID cid) {
+        if (cid >= lists.size())
+            lists.resize(size_t(cid) + 1);
+        if (!lists[cid])
+            lists[cid] = std::make_unique<ObserverList>();
+        observed.set(cid);
+        return *lists[cid];
+    }
+
+    void refresh_observed() {
+        for (auto& [ts, arch] : archetypes_)
+            set_observed(*arch);
+    }
+
+    void set_observed(Archetype& arch) const {
+        arch.observed_add = arch.component_bits.intersects(observed_add_);
+        arch.observed_remove = arch.component_bits.intersects(observed_remove_);
+    }
+
+    // Batched observers run under the iteration guard: their spans point into archetype storage
+    template <typename Fn>
+    void guarded(Fn&& fn) {
+        ++iterating_;
+        struct Guard {
+            std::atomic<int>& count;
+            ~Guard() { --count; }
+        } guard{iterating_};
+        fn();
+    }
+
+    // One event for entity `e`, whose component `cid` is at `data`. Callers check the
+    // observed mask first so unobserved types cost no pointer lookup.
+    void notify(ObserverLists& lists, ComponentTypeID cid, Entity e, void* data) {
+        ObserverList& list = *lists[cid];
+        if (list.index)
+            list.index(e, data);
+        if (!list.batch.empty()) {
+            guarded([&] {
+                for (auto& fn : list.batch)
+                    fn(*this, Span<const Entity>(&e, 1), data);
+            });
+        }
+        if (list.queued)
+            list.queue.push_back(e);
+        for (auto& fn : list.each)
             fn(*this, e, data);
     }
 
+    void notify_add(ComponentTypeID cid, Entity e, void* data) {
+        if (observed_add_.test(cid))
+            notify(add_observers_, cid, e, data);
+    }
+    void notify_remove(ComponentTypeID cid, Entity e, void* data) {
+        if (observed_remove_.test(cid))
+            notify(remove_observers_, cid, e, data);
+    }
+
+    // Re-keys `e` after its `cid` value at `data` was overwritten in place (no observer fires)
+    void notify_overwrite(ComponentTypeID cid, Entity e, void* data) {
+        if (indexed_.test(cid))
+            add_observers_[cid]->index(e, data);
+    }
+
+    // on_add events for a new entity at `arch[row]` created with components ids[0..count)
+    void notify_created(Archetype* arch, size_t row, Entity e, const ComponentTypeID* ids,
+                        size_t count) {
+        for (size_t i = 0; i < count; ++i)
+            if (observed_add_.test(ids[i]))
+                notify(add_observers_, ids[i], e, component_ptr(arch, row, e, ids[i]));
+    }
+
+    // Batched observers and queues for rows [first, first + n) of `arch` and component `cid`:
+    // one call per contiguous run. `each` callbacks are left to the caller.
+    void notify_rows(ObserverLists& lists, ComponentTypeID cid, Archetype* arch, size_t first,
+                     size_t n) {
+        ObserverList& list = *lists[cid];
+        if (list.index) {
+            ComponentColumn* col = arch->find_column(cid);
+            for (size_t row = first; row < first + n; ++row)
+                list.index(arch->entities[row], col->get(row));
+        }
+        if (!list.batch.empty()) {
+            ComponentColumn* col = arch->find_column(cid);
+            guarded([&] {
+                arch->for_each_run(first, first + n, [&](size_t run, size_t len) {
+                    Span<const Entity> es(arch->entities.data() + run, len);
+                    for (auto& fn : list.batch)
+                        fn(*this, es, col->get(run));
+                });
+            });
+        }
+        if (list.queued)
+            list.queue.insert(list.queue.end(), arch->entities.begin() + first,
+                              arch->entities.begin() + first + n);
+    }
+
+    // `each` callbacks for a set of entities that gained or are losing `cid`. Callbacks may
+    // change structure, so every entity's row is re-resolved and skipped if gone.
+    void notify_each(ObserverLists& lists, ComponentTypeID cid, const std::vector<Entity>& batch) {
+        ObserverList& list = *lists[cid];
+        if (list.each.empty())
+            return;
+        for (Entity e : batch) {
+            if (!alive(e))
+                continue;
+            auto& rec = records_[e.index];
+            auto* col = rec.archetype->find_column(cid);
+            if (!col)
+                continue;
+            for (auto& fn : list.each)
+                fn(*this, e, col->get(rec.row));
+        }
+    }
+
+    // Every observer kind for a scattered set of entities (rows re-resolved per entity)
+    void notify_entities(ObserverLists& lists, const ComponentMask& observed, ComponentTypeID cid,
+                         const std::vector<Entity>& batch) {
+        if (!observed.test(cid))
+            return;
+        ObserverList& list = *lists[cid];
+        if (list.index) {
+            for (Entity e : batch) {
+                auto& rec = records_[e.index];
+                list.index(e, rec.archetype->find_column(cid)->get(rec.row));
+            }
+        }
+        if (!list.batch.empty()) {
+            guarded([&] {
+                for (const Entity& e : batch) {
+                    auto& rec = records_[e.index];
+                    void* data = rec.archetype->find_column(cid)->get(rec.row);
+                    for (auto& fn : list.batch)
+                        fn(*this, Span<const Entity>(&e, 1), data);
+                }
+            });
+        }
+        if (list.queued)
+            list.queue.insert(list.queue.end(), batch.begin(), batch.end());
+        notify_each(lists, cid, batch);
+    }
+
+    template <typename T, typename K>
+    const ValueIndex<K>& value_index() const {
+        ComponentTypeID cid = component_id<T>();
+        ECS_ASSERT(indexed_.test(cid), "find_by: T has no index (see index_by)");
+        const IndexSlot& slot = value_indexes_[cid];
+        ECS_ASSERT(slot.key_tag == &detail::index_key_tag<K>,
+                   "find_by: key type differs from the index's");
+        return *static_cast<const ValueIndex<K>*>(slot.index.get());
+    }
+
+    // Refills the index on `cid` from every entity holding it
+    void rebuild_index(ComponentTypeID cid) {
+        IndexSlot& slot = value_indexes_[cid];
+        slot.clear(slot.index.get());
+        auto& insert = add_observers_[cid]->index;
+        if (is_sparse_component_id(cid)) {
+            if (SparseSet* set = find_sparse(cid))
+                for (Entity e : set->entities())
+                    insert(e, set->get(e.index));
+            return;
+        }
+        for (auto& [ts, arch] : archetypes_) {
+            ComponentColumn* col = arch->find_column(cid);
+            if (!col)
+                continue;
+            for (size_t row = 0; row < arch->count(); ++row)
+                insert(arch->entities[row], col->get(row));
+        }
+    }
+
+    // Loads write storage directly, so every index is refilled afterwards
+    void rebuild_indexes() {
+        for (ComponentTypeID cid = 0; cid < value_indexes_.size(); ++cid)
+            if (indexed_.test(cid))
+                rebuild_index(cid);
+    }
+
+    template <typename Fn>
+    size_t drain(ObserverLists& lists, ComponentTypeID cid, Fn& fn) {
+        if (cid >= lists.size() || !lists[cid])
+            return 0;
+        std::vector<Entity>& events = lists[cid]->draining;
+        events.swap(lists[cid]->queue);
+        size_t n = events.size();
+        if (n > 0)
+            fn(*this, Span<const Entity>(events.data(), n));
+        events.clear();
+        return n;
+    }
+
     // -- Query cache --
     static constexpr size_t MAX_QUERY_TERMS = 16;
 
@@ -785,107 +1961,1123 @@ private:
             return h;
         }
     };
-    struct QueryCacheEntry {
-        std::vector<Archetype*> archetypes;
-        uint64_t generation = 0;
-    };
-    uint64_t archetype_generation_ = 0;
-    mutable std::unordered_map<QueryKey, QueryCacheEntry, QueryKeyHash> query_cache_;
+    struct QueryCacheEntry {
+        std::vector<Archetype*> archetypes;
+        ComponentMask include_mask;
+        ComponentMask exclude_mask;
+#if defined(ECS_PROFILE)
+        mutable QueryCounters profile;
+#endif
+    };
+    mutable std::unordered_map<QueryKey, QueryCacheEntry, QueryKeyHash> query_cache_;
+    // Guards query_cache_ so systems running in parallel can issue queries concurrently.
+    // Cache entries are node-stable, and are only modified when an archetype is created or
+    // removed (structural changes, which cannot overlap with iteration), so the returned
+    // reference stays valid without the lock.
+    mutable std::mutex query_mutex_;
+
+    // A persistent query: its matching archetypes, each with the query's columns resolved
+    struct QueryState {
+        ComponentMask include_mask;
+        ComponentMask exclude_mask;
+        std::vector<ComponentTypeID> ids;      // include IDs in Ts order
+        std::vector<Archetype*> archetypes;
+        std::vector<ComponentColumn*> columns; // ids.size() per archetype, in `archetypes` order
+#if defined(ECS_PROFILE)
+        mutable QueryCounters profile;
+#endif
+
+        void add(Archetype* arch) {
+            archetypes.push_back(arch);
+            for (ComponentTypeID cid : ids)
+                columns.push_back(arch->find_column(cid));
+        }
+    };
+    // Node-stable and never cleared (compact keeps them), so Query handles stay valid
+    std::unordered_map<QueryKey, std::unique_ptr<QueryState>, QueryKeyHash> query_states_;
+
+    QueryState& query_state(const ComponentTypeID* include, size_t n_include,
+                            const ComponentTypeID* exclude, size_t n_exclude) {
+        QueryKey key(include, n_include, exclude, n_exclude);
+        std::lock_guard<std::mutex> lock(query_mutex_);
+        auto& state = query_states_[key];
+        if (state) {
+            ECS_PROFILE_ADD(state->profile, query_cache_hits, 1);
+        } else {
+            state = std::make_unique<QueryState>();
+            ECS_PROFILE_ADD(state->profile, query_cache_misses, 1);
+            state->ids.assign(include, include + n_include);
+            for (size_t i = 0; i < n_include; ++i)
+                state->include_mask.set(include[i]);
+            for (size_t i = 0; i < n_exclude; ++i)
+                state->exclude_mask.set(exclude[i]);
+            for (auto& [ts, arch] : archetypes_)
+                if (archetype_matches(arch->component_bits, state->include_mask,
+                                      state->exclude_mask))
+                    state->add(arch.get());
+        }
+        return *state;
+    }
+
+    // Returns the archetypes matching the query. The first call for a key scans all archetypes;
+    // afterwards the entry is kept current by register_archetype_in_queries.
+    const std::vector<Archetype*>& cached_query(const ComponentTypeID* include, size_t n_include,
+                                                const ComponentTypeID* exclude,
+                                                size_t n_exclude) const {
+        return query_entry(include, n_include, exclude, n_exclude).archetypes;
+    }
+
+    // cached_query's entry, for callers that count their visits in its counters
+    const QueryCacheEntry& query_entry(const ComponentTypeID* include, size_t n_include,
+                                       const ComponentTypeID* exclude, size_t n_exclude) const {
+        QueryKey key(include, n_include, exclude, n_exclude);
+        std::lock_guard<std::mutex> lock(query_mutex_);
+        auto [it, inserted] = query_cache_.try_emplace(key);
+        QueryCacheEntry& entry = it->second;
+        if (inserted) {
+            ECS_PROFILE_ADD(profile_, query_cache_misses, 1);
+            ECS_PROFILE_ADD(entry.profile, query_cache_misses, 1);
+            for (size_t i = 0; i < n_include; ++i)
+                entry.include_mask.set(include[i]);
+            for (size_t i = 0; i < n_exclude; ++i)
+                entry.exclude_mask.set(exclude[i]);
+            for (auto& [ts, arch] : archetypes_) {
+                if (archetype_matches(arch->component_bits, entry.include_mask,
+                                      entry.exclude_mask))
+                    entry.archetypes.push_back(arch.get());
+            }
+        } else {
+            ECS_PROFILE_ADD(profile_, query_cache_hits, 1);
+            ECS_PROFILE_ADD(entry.profile, query_cache_hits, 1);
+        }
+        return entry;
+    }
+
+    // Tests a newly created archetype against every cached query once, appending it to the
+    // entries it matches.
+    void register_archetype_in_queries(Archetype* arch) {
+        std::lock_guard<std::mutex> lock(query_mutex_);
+        for (auto& [key, entry] : query_cache_) {
+            if (archetype_matches(arch->component_bits, entry.include_mask, entry.exclude_mask)) {
+                entry.archetypes.push_back(arch);
+                ECS_PROFILE_ADD(profile_, query_cache_updates, 1);
+                ECS_PROFILE_ADD(entry.profile, query_cache_updates, 1);
+            }
+        }
+        for (auto& [key, state] : query_states_) {
+            if (archetype_matches(arch->component_bits, state->include_mask, state->exclude_mask)) {
+                state->add(arch);
+                ECS_PROFILE_ADD(state->profile, query_cache_updates, 1);
+            }
+        }
+    }
+
+    // -- Row order --
+
+    // Rearranges rows [lo, hi) of `arch` so that row i holds what was row perm[i]; perm must
+    // map [lo, hi) onto itself. Each column is gathered through one scratch buffer: rows that
+    // move are relocated out, then back into their new places (two sequential passes per
+    // column instead of one indirect swap per cycle step). Ticks move with their rows.
+    void gather_rows(Archetype& arch, const size_t* perm, size_t lo, size_t hi) {
+        std::vector<size_t>& moved = gather_moved_;
+        moved.clear();
+        for (size_t i = lo; i < hi; ++i)
+            if (perm[i] != i)
+                moved.push_back(i);
+        size_t m = moved.size();
+        if (m == 0)
+            return;
+
+        size_t bytes = 0;
+        size_t align = alignof(std::max_align_t);
+        for (auto& [cid, col] : arch.columns) {
+            if (!col.tag) {
+                bytes = std::max(bytes, col.elem_size * m);
+                align = std::max(align, col.alignment);
+            }
+        }
+        const Allocator* allocator = config_.allocator;
+        uint8_t* scratch = nullptr;
+        if (bytes > 0) {
+            scratch = static_cast<uint8_t*>(allocator->allocate(allocator->user, bytes, align));
+            ECS_ASSERT(scratch, "gather_rows: scratch allocation failed");
+        }
+
+        std::vector<uint32_t>& ticks = gather_ticks_;
+        ticks.resize(2 * m);
+        for (auto& [cid, col] : arch.columns) {
+            if (!col.tag) {
+                for (size_t k = 0; k < m; ++k)
+                    col.relocate_elem(scratch + k * col.elem_size, col.get(perm[moved[k]]));
+                for (size_t k = 0; k < m; ++k)
+                    col.relocate_elem(col.get(moved[k]), scratch + k * col.elem_size);
+            }
+            for (size_t k = 0; k < m; ++k) {
+                ticks[2 * k] = col.added_ticks[perm[moved[k]]];
+                ticks[2 * k + 1] = col.changed_tick(perm[moved[k]]);
+            }
+            for (size_t k = 0; k < m; ++k) {
+                col.added_ticks[moved[k]] = ticks[2 * k];
+                col.changed_ticks[moved[k]] = ticks[2 * k + 1];
+            }
+        }
+        if (scratch)
+            allocator->deallocate(allocator->user, scratch, bytes, align);
+
+        std::vector<Entity>& es = gather_entities_;
+        es.resize(m);
+        for (size_t k = 0; k < m; ++k)
+            es[k] = arch.entities[perm[moved[k]]];
+        for (size_t k = 0; k < m; ++k) {
+            arch.entities[moved[k]] = es[k];
+            records_[es[k].index].row = moved[k];
+        }
+        arch.order.rows_moved = true;
+    }
+
+    // Restores the order_by<T> order of one archetype; returns the rows moved. The rows are
+    // split in one pass into a sorted subsequence and the rows breaking it: at each descent
+    // both rows around it are taken out, so a row whose key grew or shrank costs two
+    // extractions rather than the run it would otherwise hide. The extracted rows are sorted
+    // and merged back, and only the span between the first and last displaced row is gathered.
+    template <typename T, typename KeyFn>
+    size_t refresh_archetype_order(Archetype& arch, const KeyFn& key) {
+        const ComponentColumn& col = *arch.find_column(component_id<T>());
+        size_t n = arch.count();
+        bool unchanged = !arch.order.rows_moved && arch.order.rows == n &&
+                         col.last_changed_tick() < arch.order.tick;
+        if (unchanged || n <= 1) {
+            arch.order = {false, n, change_tick_};
+            return 0;
+        }
+
+        auto less = [&](size_t a, size_t b) {
+            return key(*static_cast<const T*>(col.get(a))) < key(*static_cast<const T*>(col.get(b)));
+        };
+        std::vector<size_t>& kept = order_kept_;
+        std::vector<size_t>& out = order_out_;
+        kept.clear();
+        out.clear();
+        for (size_t i = 0; i < n; ++i) {
+            if (!kept.empty() && less(i, kept.back())) {
+                out.push_back(kept.back());
+                kept.pop_back();
+                out.push_back(i);
+            } else {
+                kept.push_back(i);
+            }
+        }
+
+        size_t moved = 0;
+        if (!out.empty()) {
+            std::sort(out.begin(), out.end(), less);
+            std::vector<size_t>& perm = order_perm_;
+            perm.resize(n);
+            std::merge(kept.begin(), kept.end(), out.begin(), out.end(), perm.begin(), less);
+            size_t lo = 0;
+            while (lo < n && perm[lo] == lo)
+                ++lo;
+            size_t hi = n;
+            while (hi > lo && perm[hi - 1] == hi - 1)
+                --hi;
+            gather_rows(arch, perm.data(), lo, hi);
+            moved = gather_moved_.size();
+        }
+        arch.order = {false, n, change_tick_};
+        return moved;
+    }
+
+    // -- Sparse components --
+
+    template <typename... Ts>
+    static constexpr bool any_sparse_v = (is_sparse_component_v<Ts> || ...);
+
+    const SparseSet* find_sparse(ComponentTypeID cid) const {
+        return cid < sparse_sets_.size() ? sparse_sets_[cid].get() : nullptr;
+    }
+    SparseSet* find_sparse(ComponentTypeID cid) {
+        return cid < sparse_sets_.size() ? sparse_sets_[cid].get() : nullptr;
+    }
+
+    // Returns the set for sparse component `cid`, creating it on first use
+    SparseSet& sparse_set(ComponentTypeID cid) {
+        if (cid >= sparse_sets_.size())
+            sparse_sets_.resize(size_t(cid) + 1);
+        auto& set = sparse_sets_[cid];
+        if (!set) {
+            set = std::make_unique<SparseSet>(column_factory_registry().at(cid)(),
+                                              config_.allocator);
+            set->column().tick_source = &change_tick_;
+            sparse_ids_.push_back(cid);
+        }
+        return *set;
+    }
+
+    // Whether any sparse set holds a value (snapshot formats do not carry them)
+    bool has_sparse_values() const {
+        for (ComponentTypeID cid : sparse_ids_)
+            if (sparse_sets_[cid]->size() > 0)
+                return true;
+        return false;
+    }
+
+    // Type-erased remove of sparse component `cid`; fires on_remove first
+    void remove_sparse(Entity e, ComponentTypeID cid) {
+        SparseSet* set = find_sparse(cid);
+        if (!set || !set->contains(e.index))
+            return;
+        notify_remove(cid, e, set->get(e.index));
+        if (set->contains(e.index)) // the hook may have removed it already
+            set->erase(e.index);
+    }
+
+    // Drops every sparse value of an entity that is being destroyed
+    void destroy_sparse(Entity e) {
+        for (ComponentTypeID cid : sparse_ids_)
+            remove_sparse(e, cid);
+    }
+
+    // Location of component `cid` of entity `e`, stored at `arch[row]` or in a sparse set
+    void* component_ptr(Archetype* arch, size_t row, Entity e, ComponentTypeID cid) {
+        if (is_sparse_component_id(cid))
+            return find_sparse(cid)->get(e.index);
+        return arch->find_column(cid)->get(row);
+    }
+
+    // A query split into archetype terms (matched through the signature) and sparse terms
+    // (looked up per entity). The smallest required set drives iteration.
+    struct SparseTerms {
+        ComponentTypeID include_ids[MAX_QUERY_TERMS];
+        ComponentTypeID exclude_ids[MAX_QUERY_TERMS];
+        size_t n_include = 0;
+        size_t n_exclude = 0;
+        ComponentMask include_mask;
+        ComponentMask exclude_mask;
+        const SparseSet* with[MAX_QUERY_TERMS];
+        const SparseSet* without[MAX_QUERY_TERMS];
+        size_t n_with = 0;
+        size_t n_without = 0;
+        const SparseSet* driver = nullptr; // null if no sparse type is required
+        bool empty = false;                // a required sparse type has no values at all
+
+        bool match(uint32_t index, const std::vector<EntityRecord>& records) const {
+            if (!archetype_matches(records[index].archetype->component_bits, include_mask,
+                                   exclude_mask))
+                return false;
+            for (size_t i = 0; i < n_with; ++i)
+                if (!with[i]->contains(index))
+                    return false;
+            for (size_t i = 0; i < n_without; ++i)
+                if (without[i]->contains(index))
+                    return false;
+            return true;
+        }
+    };
+
+    SparseTerms sparse_terms(const ComponentTypeID* include, size_t n_include,
+                             const ComponentTypeID* exclude, size_t n_exclude) const {
+        ECS_ASSERT(n_include <= MAX_QUERY_TERMS, "query exceeds max include terms");
+        ECS_ASSERT(n_exclude <= MAX_QUERY_TERMS, "query exceeds max exclude terms");
+        SparseTerms t;
+        for (size_t i = 0; i < n_include; ++i) {
+            if (!is_sparse_component_id(include[i])) {
+                t.include_ids[t.n_include++] = include[i];
+                t.include_mask.set(include[i]);
+                continue;
+            }
+            const SparseSet* set = find_sparse(include[i]);
+            if (!set || set->size() == 0) {
+                t.empty = true;
+                continue;
+            }
+            t.with[t.n_with++] = set;
+            if (!t.driver || set->size() < t.driver->size())
+                t.driver = set;
+        }
+        for (size_t i = 0; i < n_exclude; ++i) {
+            if (!is_sparse_component_id(exclude[i])) {
+                t.exclude_ids[t.n_exclude++] = exclude[i];
+                t.exclude_mask.set(exclude[i]);
+            } else if (const SparseSet* set = find_sparse(exclude[i])) {
+                t.without[t.n_without++] = set;
+            }
+        }
+        if (t.empty)
+            t.driver = nullptr;
+        return t;
+    }
+
+    // each/each_no_entity for queries with sparse terms. With a sparse include, walks the
+    // smallest set and checks each entity's archetype; with only sparse excludes, walks the
+    // matching archetypes and skips excluded rows.
+    template <bool WithEntity, typename... Ts, typename Func>
+    void each_sparse(const ComponentTypeID* exclude, size_t n_exclude, Func& fn) {
+        ++iterating_;
+        struct Guard {
+            std::atomic<int>& count;
+            ~Guard() { --count; }
+        } guard{iterating_};
+
+        ComponentTypeID ids[] = {component_id<Ts>()...};
+        SparseTerms terms = sparse_terms(ids, sizeof...(Ts), exclude, n_exclude);
+        if (terms.empty)
+            return;
+        (mark_mutable_sparse<Ts>(), ...);
+
+        Archetype* cached = nullptr;
+        std::tuple<TypedColumn<Ts>...> cols{};
+        auto visit = [&](Entity e, size_t row) {
+            Archetype* arch = records_[e.index].archetype;
+            if (arch != cached) {
+                cached = arch;
+                cols = std::make_tuple(TypedColumn<Ts>{query_column<Ts>(arch)}...);
+            }
+            ECS_PROFILE_ADD(profile_, entities_visited, 1);
+            if constexpr (WithEntity)
+                fn(e, query_elem<Ts>(std::get<TypedColumn<Ts>>(cols).col, e, row)...);
+            else
+                fn(query_elem<Ts>(std::get<TypedColumn<Ts>>(cols).col, e, row)...);
+        };
+
+        if (terms.driver) {
+            for (Entity e : terms.driver->entities())
+                if (terms.match(e.index, records_))
+                    visit(e, records_[e.index].row);
+            return;
+        }
+        const QueryCacheEntry& q =
+            query_entry(terms.include_ids, terms.n_include, terms.exclude_ids, terms.n_exclude);
+        for (auto* arch : q.archetypes) {
+            for (size_t row = 0; row < arch->count(); ++row) {
+                if (!terms.match(arch->entities[row].index, records_))
+                    continue;
+                ECS_PROFILE_ADD(q.profile, entities_visited, 1);
+                visit(arch->entities[row], row);
+            }
+        }
+    }
+
+    // Column of T for each_sparse: the sparse set's column or the archetype's
+    template <typename T>
+    ComponentColumn* query_column(Archetype* arch) {
+        if constexpr (is_sparse_component_v<T>)
+            return &find_sparse(component_id<T>())->column();
+        else
+            return arch->find_column(component_id<T>());
+    }
+
+    template <typename T>
+    T& query_elem(ComponentColumn* col, Entity e, size_t row) {
+        if constexpr (is_sparse_component_v<T>) {
+            return *static_cast<T*>(col->get(find_sparse(component_id<T>())->row(e.index)));
+        } else {
+            mark_row_changed<T>(col, row);
+            return *static_cast<T*>(col->get(row));
+        }
+    }
+
+    // Sparse rows are visited in no useful order, so mutable sets are stamped as a whole
+    template <typename T>
+    void mark_mutable_sparse() {
+        if constexpr (is_sparse_component_v<T> && !std::is_const_v<T>)
+            find_sparse(component_id<T>())->column().mark_all_changed();
+    }
+
+    // Invokes fn for rows [begin, end) of arch, resolving column pointers once per chunk run.
+    // Callers visiting whole archetypes stamp mutable columns first (mark_mutable_column).
+    template <bool WithEntity, typename... Ts, typename Func>
+    void iterate_rows(Archetype* arch, size_t begin, size_t end, Func& fn) {
+        ComponentColumn* cols[sizeof...(Ts) + 1] = {arch->find_column(component_id<Ts>())...};
+        iterate_columns<WithEntity, Ts...>(arch, cols, begin, end, fn,
+                                           std::index_sequence_for<Ts...>{});
+    }
+
+    // iterate_rows over already-resolved columns: cols[i] holds the i-th of Ts
+    template <bool WithEntity, typename... Ts, typename Func, size_t... Is>
+    void iterate_columns(Archetype* arch, ComponentColumn* const* cols, size_t begin, size_t end,
+                         Func& fn, std::index_sequence<Is...>) {
+        ECS_PROFILE_ADD(profile_, entities_visited, end - begin);
+        arch->for_each_run(begin, end, [&](size_t first, size_t len) {
+            auto ptrs = std::make_tuple(static_cast<Ts*>(cols[Is]->get(first))...);
+            if constexpr (WithEntity) {
+                const Entity* ents = arch->entities.data() + first;
+                for (size_t i = 0; i < len; ++i)
+                    fn(ents[i], run_elem(std::get<Is>(ptrs), i)...);
+            } else {
+                for (size_t i = 0; i < len; ++i)
+                    fn(run_elem(std::get<Is>(ptrs), i)...);
+            }
+        });
+    }
+
+    // -- Persistent query iteration (see Query) --
+
+    template <typename... Ts, size_t... Is>
+    static void mark_mutable_columns(ComponentColumn* const* cols, std::index_sequence<Is...>) {
+        (mark_if_mutable<Ts>(cols[Is]), ...);
+    }
+
+    template <typename T>
+    static void mark_if_mutable(ComponentColumn* col) {
+        if constexpr (!std::is_const_v<T>)
+            col->mark_all_changed();
+    }
+
+    template <bool WithEntity, typename... Ts, typename Func>
+    void each_state(const QueryState& q, Func& fn) {
+        guarded([&] {
+            constexpr size_t N = sizeof...(Ts);
+            for (size_t a = 0; a < q.archetypes.size(); ++a) {
+                Archetype* arch = q.archetypes[a];
+                if (arch->count() == 0)
+                    continue;
+                ComponentColumn* const* cols = q.columns.data() + a * N;
+                mark_mutable_columns<Ts...>(cols, std::index_sequence_for<Ts...>{});
+                ECS_PROFILE_ADD(q.profile, entities_visited, arch->count());
+                iterate_columns<WithEntity, Ts...>(arch, cols, 0, arch->count(), fn,
+                                                   std::index_sequence_for<Ts...>{});
+            }
+        });
+    }
+
+    template <bool WithEntity, typename... Ts, typename Func>
+    void par_each_state(ThreadPool& pool, const QueryState& q, Func& fn) {
+        constexpr size_t N = sizeof...(Ts);
+        for (size_t a = 0; a < q.archetypes.size(); ++a)
+            if (q.archetypes[a]->count() > 0)
+                mark_mutable_columns<Ts...>(q.columns.data() + a * N,
+                                            std::index_sequence_for<Ts...>{});
+        // Columns are marked above, so the dispatcher is given no types to mark
+        par_for_row_ranges<>(pool, q.archetypes, [&](size_t a, size_t begin, size_t end) {
+            ECS_PROFILE_ADD(q.profile, entities_visited, end - begin);
+            iterate_columns<WithEntity, Ts...>(q.archetypes[a], q.columns.data() + a * N, begin,
+                                               end, fn, std::index_sequence_for<Ts...>{});
+        });
+    }
+
+    template <typename... Ts, typename Func, size_t... Is>
+    void each_chunk_state(const QueryState& q, Func& fn, std::index_sequence<Is...> seq) {
+        guarded([&] {
+            for (size_t a = 0; a < q.archetypes.size(); ++a) {
+                Archetype* arch = q.archetypes[a];
+                if (arch->count() == 0)
+                    continue;
+                ComponentColumn* const* cols = q.columns.data() + a * sizeof...(Ts);
+                mark_mutable_columns<Ts...>(cols, seq);
+                ECS_PROFILE_ADD(profile_, entities_visited, arch->count());
+                ECS_PROFILE_ADD(q.profile, entities_visited, arch->count());
+                arch->for_each_run(0, arch->count(), [&](size_t first, size_t len) {
+                    fn(Span<const Entity>(arch->entities.data() + first, len),
+                       static_cast<Ts*>(cols[Is]->get(first))...);
+                });
+            }
+        });
+    }
+
+    // Appends the column IDs behind T: its lanes if split, otherwise its own ID
+    template <typename T>
+    static void append_lane_ids(ComponentTypeID*& out) {
+        using S = std::remove_const_t<T>;
+        if constexpr (is_split_component_v<S>)
+            append_lane_ids<S>(out, std::make_index_sequence<lane_count<S>()>{});
+        else
+            *out++ = component_id<S>();
+    }
+
+    template <typename S, size_t... Is>
+    static void append_lane_ids(ComponentTypeID*& out, std::index_sequence<Is...>) {
+        ((*out++ = component_id<Lane<S, Is>>()), ...);
+    }
+
+    // Index of each of Ts' first column in the concatenated lane IDs
+    template <typename... Ts>
+    static constexpr std::array<size_t, sizeof...(Ts)> lane_offsets() {
+        std::array<size_t, sizeof...(Ts)> offsets{};
+        size_t i = 0, offset = 0;
+        ((offsets[i++] = offset, offset += lane_count<Ts>()), ...);
+        return offsets;
+    }
+
+    template <typename... Ts, typename Func, size_t... Is>
+    void each_lanes_impl(Func& fn, std::index_sequence<Is...>) {
+        constexpr size_t N = (lane_count<Ts>() + ...);
+        constexpr std::array<size_t, sizeof...(Ts)> offsets = lane_offsets<Ts...>();
+        ComponentTypeID ids[N];
+        ComponentTypeID* out = ids;
+        (append_lane_ids<Ts>(out), ...);
+        guarded([&] {
+            const QueryCacheEntry& q = query_entry(ids, N, nullptr, 0);
+            for (Archetype* arch : q.archetypes) {
+                if (arch->count() == 0)
+                    continue;
+                ComponentColumn* cols[N];
+                for (size_t k = 0; k < N; ++k)
+                    cols[k] = arch->find_column(ids[k]);
+                (mark_lanes_changed<Ts>(cols + offsets[Is]), ...);
+                ECS_PROFILE_ADD(profile_, entities_visited, arch->count());
+                ECS_PROFILE_ADD(q.profile, entities_visited, arch->count());
+                arch->for_each_run(0, arch->count(), [&](size_t first, size_t len) {
+                    fn(Span<const Entity>(arch->entities.data() + first, len),
+                       run_lanes<Ts>(cols + offsets[Is], first)...);
+                });
+            }
+        });
+    }
+
+    // T's argument for one run of `each_lanes`: `Lanes<T>` if split, otherwise `T*`
+    template <typename T>
+    static auto run_lanes(ComponentColumn* const* cols, size_t first) {
+        if constexpr (is_split_component_v<T>) {
+            std::array<void*, lane_count<T>()> lanes;
+            for (size_t k = 0; k < lanes.size(); ++k)
+                lanes[k] = cols[k]->get(first);
+            return Lanes<T>(lanes);
+        } else {
+            return static_cast<T*>(cols[0]->get(first));
+        }
+    }
+
+    template <typename T>
+    static void mark_lanes_changed(ComponentColumn* const* cols) {
+        if constexpr (!std::is_const_v<T>)
+            for (size_t k = 0; k < lane_count<T>(); ++k)
+                cols[k]->mark_all_changed();
+    }
+
+    // Element `i` of a run starting at `base`; every row of a tag column is the same object.
+    template <typename T>
+    static T& run_elem(T* base, size_t i) {
+        if constexpr (is_tag_component_v<std::remove_const_t<T>>)
+            return *base;
+        else
+            return base[i];
+    }
+
+    // Stamps T's column as changed for every row if T is accessed mutably. Runs on the
+    // calling thread before any rows are visited, so parallel iteration never writes ticks.
+    template <typename T>
+    static void mark_mutable_column(Archetype* arch) {
+        if constexpr (!std::is_const_v<T>)
+            arch->find_column(component_id<T>())->mark_all_changed();
+    }
+
+    template <typename T>
+    static void mark_row_changed(ComponentColumn* col, size_t row) {
+        if constexpr (!std::is_const_v<T>)
+            col->mark_changed(row);
+    }
+
+    // Shared body of the Changed/Added overloads: visits the rows of Ts... archetypes where any
+    // filter column's added (or changed) tick is newer than `since`.
+    template <bool WithEntity, typename... Ts, typename Func>
+    void each_since(const ComponentTypeID* filter_ids, size_t n_filter, bool added,
+                    uint32_t since, Func& fn) {
+        ECS_ASSERT(n_filter <= MAX_QUERY_TERMS, "query exceeds max filter terms");
+        ++iterating_;
+        struct Guard {
+            std::atomic<int>& count;
+            ~Guard() { --count; }
+        } guard{iterating_};
+
+        ComponentTypeID include_ids[sizeof...(Ts) + MAX_QUERY_TERMS] = {component_id<Ts>()...};
+        for (size_t k = 0; k < n_filter; ++k)
+            include_ids[sizeof...(Ts) + k] = filter_ids[k];
+
+        const QueryCacheEntry& q = query_entry(include_ids, sizeof...(Ts) + n_filter, nullptr, 0);
+        for (auto* arch : q.archetypes) {
+            if (arch->count() == 0)
+                continue;
+            const ComponentColumn* filter_cols[MAX_QUERY_TERMS];
+            bool any = false;
+            for (size_t k = 0; k < n_filter; ++k) {
+                filter_cols[k] = arch->find_column(filter_ids[k]);
+                uint32_t last =
+                    added ? filter_cols[k]->last_added : filter_cols[k]->last_changed_tick();
+                any |= last > since;
+            }
+            if (!any)
+                continue;
+
+            auto cols = std::make_tuple(TypedColumn<Ts>{arch->find_column(component_id<Ts>())}...);
+            arch->for_each_run(0, arch->count(), [&](size_t first, size_t len) {
+                auto ptrs = std::make_tuple(
+                    static_cast<Ts*>(std::get<TypedColumn<Ts>>(cols).col->get(first))...);
+                for (size_t i = 0; i < len; ++i) {
+                    size_t row = first + i;
+                    bool hit = false;
+                    for (size_t k = 0; k < n_filter && !hit; ++k)
+                        hit = (added ? filter_cols[k]->added_ticks[row]
+                                     : filter_cols[k]->changed_tick(row)) > since;
+                    if (!hit)
+                        continue;
+                    (mark_row_changed<Ts>(std::get<TypedColumn<Ts>>(cols).col, row), ...);
+                    ECS_PROFILE_ADD(profile_, entities_visited, 1);
+                    ECS_PROFILE_ADD(q.profile, entities_visited, 1);
+                    if constexpr (WithEntity)
+                        fn(arch->entities[row], run_elem(std::get<Ts*>(ptrs), i)...);
+                    else
+                        fn(run_elem(std::get<Ts*>(ptrs), i)...);
+                }
+            });
+        }
+    }
+
+    // Splits the matched archetypes into chunk-sized row ranges and runs `body(arch, begin, end)`
+    // for each on the pool as `body(slot, begin, end)`, `slot` indexing `archetypes`. The
+    // iteration guard is held by the calling thread for the whole dispatch (parallel_for
+    // blocks), so it also covers the workers. Ts are the accessed components, whose mutable
+    // columns are marked changed here before dispatch. Ranges run as par_for jobs, so deferred
+    // commands merge in archetype and row order, as a sequential `each` records them.
+    template <typename... Ts, typename RangeFunc>
+    void par_for_row_ranges(ThreadPool& pool, const std::vector<Archetype*>& archetypes,
+                            RangeFunc&& body) {
+        static_assert(!any_sparse_v<Ts...>, "par_each requires archetype components");
+        ++iterating_;
+        struct Guard {
+            std::atomic<int>& count;
+            ~Guard() { --count; }
+        } guard{iterating_};
+
+        struct RowRange {
+            size_t slot; // index into `archetypes`
+            size_t begin;
+            size_t end;
+        };
+        std::vector<RowRange> ranges;
+        for (size_t a = 0; a < archetypes.size(); ++a) {
+            Archetype* arch = archetypes[a];
+            size_t n = arch->count();
+            if (n == 0)
+                continue;
+            (mark_mutable_column<Ts>(arch), ...);
+            size_t step = arch->chunk_rows();
+            for (size_t begin = 0; begin < n; begin += step)
+                ranges.push_back({a, begin, std::min(n, begin + step)});
+        }
+        par_for(pool, ranges.size(), [&](size_t i) {
+            body(ranges[i].slot, ranges[i].begin, ranges[i].end);
+        });
+    }
+
+    static bool archetype_matches(const ComponentMask& arch_bits, const ComponentMask& include_mask,
+                                  const ComponentMask& exclude_mask) {
+        return arch_bits.contains_all(include_mask) && !arch_bits.intersects(exclude_mask);
+    }
+
+    Archetype* get_or_create_archetype(const TypeSet& ts) {
+        auto it = archetypes_.find(ts);
+        if (it != archetypes_.end())
+            return it->second.get();
+
+        auto arch = std::make_unique<Archetype>();
+        arch->type_set = ts;
+        auto& factory_reg = column_factory_registry();
+        arch->columns.reserve(ts.size());
+        for (auto cid : ts) {
+            arch->columns.emplace_back(cid, factory_reg.at(cid)());
+            arch->columns.back().second.tick_source = &change_tick_;
+            arch->component_bits.set(cid);
+        }
+        // ts is already sorted, so columns are in sorted order
+        arch->index_columns();
+        if (config_.storage == StorageMode::Chunked)
+            arch->set_chunked_storage(config_.chunk_bytes);
+        arch->set_allocator(config_.allocator);
+        set_observed(*arch);
+#if defined(ECS_PROFILE)
+        arch->profile = &profile_;
+#endif
+        Archetype* ptr = arch.get();
+        archetypes_.emplace(ts, std::move(arch));
+        register_archetype_in_queries(ptr);
+        return ptr;
+    }
+
+    Archetype* find_add_target(Archetype* src, ComponentTypeID cid) {
+        auto* edge = src->find_edge(cid);
+        if (edge && edge->add_target)
+            return edge->add_target;
+
+        TypeSet new_ts = src->type_set;
+        new_ts.push_back(cid);
+        std::sort(new_ts.begin(), new_ts.end());
+        Archetype* target = get_or_create_archetype(new_ts);
+        src->edge_for(cid).add_target = target;
+        return target;
+    }
+
+    Archetype* find_remove_target(Archetype* src, ComponentTypeID cid) {
+        auto* edge = src->find_edge(cid);
+        if (edge && edge->remove_target)
+            return edge->remove_target;
+
+        TypeSet new_ts;
+        for (auto id : src->type_set) {
+            if (id != cid)
+                new_ts.push_back(id);
+        }
+        Archetype* target = get_or_create_archetype(new_ts);
+        src->edge_for(cid).remove_target = target;
+        return target;
+    }
+
+    // Pops a free entity slot, or appends a new one (generation 0)
+    uint32_t acquire_slot() {
+        if (!free_list_.empty()) {
+            uint32_t idx = free_list_.back();
+            free_list_.pop_back();
+            return idx;
+        }
+        uint32_t idx = static_cast<uint32_t>(generations_.size());
+        generations_.push_back(generation_floor_);
+        records_.push_back({});
+        structure_ticks_.push_back(0);
+        return idx;
+    }
+
+    // Points slot `idx` at a new archetype row: a create or a migration
+    void place_record(uint32_t idx, Archetype* arch, size_t row) {
+        records_[idx] = {arch, row};
+        structure_ticks_[idx] = change_tick_;
+    }
+
+    // Ends the current occupant of slot `idx` (its row is already removed)
+    void release_slot(uint32_t idx) {
+        records_[idx] = {};
+        generations_[idx]++;
+        free_list_.push_back(idx);
+        structure_ticks_[idx] = change_tick_;
+    }
+
+    // Empties a world that a rejected load wrote into, back to a fresh entity table with index 0
+    // reserved (empty archetypes may remain)
+    void discard_load() {
+        for (auto& [ts, arch] : archetypes_) {
+            for (auto& [cid, col] : arch->columns)
+                col.destroy_all();
+            arch->entities.clear();
+        }
+        generations_.assign(1, 1);
+        free_list_.clear();
+        records_.assign(1, EntityRecord{});
+        structure_ticks_.assign(1, 0);
+    }
+
+    // Whether a load's entity lists and free list describe one consistent table: every index
+    // lies inside it and is not the reserved 0, each slot is live in at most one row (with the
+    // table's generation) or free at most once, and never both
+    bool loaded_indices_valid() const {
+        size_t slots = generations_.size();
+        std::vector<bool> seen(slots);
+        auto claim = [&](uint32_t idx) {
+            if (idx == 0 || idx >= slots || seen[idx])
+                return false;
+            seen[idx] = true;
+            return true;
+        };
+        for (auto& [ts, arch] : archetypes_)
+            for (Entity e : arch->entities)
+                if (!claim(e.index) || generations_[e.index] != e.generation)
+                    return false;
+        for (uint32_t idx : free_list_)
+            if (!claim(idx))
+                return false;
+        return true;
+    }
+
+    // Points every entity record at its archetype row (after a load filled archetypes directly)
+    void rebuild_records() {
+        records_.assign(generations_.size(), EntityRecord{});
+        structure_ticks_.assign(generations_.size(), change_tick_);
+        for (auto& [ts, arch] : archetypes_)
+            for (size_t i = 0; i < arch->count(); ++i)
+                records_[arch->entities[i].index] = {arch.get(), i};
+    }
+
+    // Constructs a component of new entity `e` in its archetype column or sparse set
+    template <typename T, typename Arg>
+    void push_component(Archetype* arch, Entity e, Arg&& comp) {
+        auto emplace = [&](ComponentColumn& col) { col.emplace_back<T>(std::forward<Arg>(comp)); };
+        if constexpr (is_sparse_component_v<T>)
+            sparse_set(component_id<T>()).insert(e, emplace);
+        else
+            emplace(*arch->find_column(component_id<T>()));
+    }
+
+    // Copy-constructs a prefab default for new entity `e` in its column or sparse set
+    void push_prefab_default(Archetype* arch, Entity e, const Prefab::Entry& entry,
+                             const Prefab& prefab) {
+        auto copy = [&](ComponentColumn& col) {
+            // copy_fn placement-new constructs into the column slot
+            entry.copy_fn(col.get(col.count), prefab.data() + entry.buf_offset);
+            col.commit_rows(1);
+        };
+        if (is_sparse_component_id(entry.cid))
+            sparse_set(entry.cid).insert(e, copy);
+        else
+            copy(*arch->find_column(entry.cid));
+    }
+
+    // The archetype of a prefab's non-sparse entries, keyed by the type set the prefab sorted
+    Archetype* prefab_archetype(const Prefab& prefab) {
+        return get_or_create_archetype(prefab.types());
+    }
+
+    // Copies a prefab default into rows [first, first + n) of `arch` (or into each new entity's
+    // sparse row). Trivially copyable defaults are broadcast with doubling memcpys per run.
+    void broadcast_prefab_default(Archetype* arch, size_t first, size_t n,
+                                  const Prefab::Entry& entry, const Prefab& prefab) {
+        const uint8_t* src = prefab.data() + entry.buf_offset;
+        if (is_sparse_component_id(entry.cid)) {
+            SparseSet& set = sparse_set(entry.cid);
+            for (size_t row = first; row < first + n; ++row)
+                set.insert(arch->entities[row], [&](ComponentColumn& col) {
+                    entry.copy_fn(col.get(col.count), src);
+                    col.commit_rows(1);
+                });
+            return;
+        }
+        ComponentColumn* col = arch->find_column(entry.cid);
+        if (!col->tag) {
+            size_t size = entry.elem_size;
+            arch->for_each_run(first, first + n, [&](size_t run, size_t len) {
+                auto* dst = static_cast<uint8_t*>(col->get(run));
+                if (!entry.trivially_copyable) {
+                    for (size_t i = 0; i < len; ++i)
+                        entry.copy_fn(dst + i * size, src);
+                    return;
+                }
+                std::memcpy(dst, src, size);
+                for (size_t done = 1; done < len;) {
+                    size_t k = std::min(done, len - done);
+                    std::memcpy(dst + done * size, dst, k * size);
+                    done += k;
+                }
+            });
+        }
+        col->commit_rows(n);
+    }
+
+    // -- Batch creation helpers --
+
+    template <typename T>
+    struct TypedColumn {
+        ComponentColumn* col;
+    };
 
-    const std::vector<Archetype*>& cached_query(const ComponentTypeID* include, size_t n_include,
-                                                const ComponentTypeID* exclude, size_t n_exclude) {
-        QueryKey key(include, n_include, exclude, n_exclude);
-        auto& entry = query_cache_[key];
-        if (entry.generation != archetype_generation_) {
-            entry.archetypes.clear();
-            std::bitset<256> include_mask, exclude_mask;
-            for (size_t i = 0; i < n_include; ++i)
-                include_mask.set(include[i]);
-            for (size_t i = 0; i < n_exclude; ++i)
-                exclude_mask.set(exclude[i]);
-            for (auto& [ts, arch] : archetypes_) {
-                if (archetype_matches(arch->component_bits, include_mask, exclude_mask))
-                    entry.archetypes.push_back(arch.get());
-            }
-            entry.generation = archetype_generation_;
+    // Pushes n entity slots into the archetype for Ts... (capacity reserved once) and points
+    // their records at the new rows. Columns are filled by the caller.
+    template <typename... Ts>
+    Archetype* reserve_batch(size_t n) {
+        static_assert(!any_sparse_v<Ts...>, "batch creation requires archetype components");
+        ECS_ASSERT(iterating_ == 0, "structural change during iteration");
+        (ensure_column_factory<Ts>(), ...);
+        return reserve_rows(get_or_create_archetype(make_typeset({component_id<Ts>()...})), n);
+    }
+
+    Archetype* reserve_rows(Archetype* arch, size_t n) {
+        size_t first = arch->count();
+        arch->ensure_capacity(first + n);
+        arch->entities.reserve(first + n);
+        arch->order.rows_moved = true;
+
+        size_t reused = std::min(n, free_list_.size());
+        for (size_t i = 0; i < reused; ++i) {
+            uint32_t idx = free_list_.back();
+            free_list_.pop_back();
+            arch->entities.push_back(Entity{idx, generations_[idx]});
+            place_record(idx, arch, first + i);
         }
-        return entry.archetypes;
+        size_t fresh = n - reused;
+        uint32_t base = static_cast<uint32_t>(generations_.size());
+        generations_.resize(generations_.size() + fresh, generation_floor_);
+        records_.resize(records_.size() + fresh);
+        structure_ticks_.resize(structure_ticks_.size() + fresh);
+        for (size_t i = 0; i < fresh; ++i) {
+            uint32_t idx = base + static_cast<uint32_t>(i);
+            arch->entities.push_back(Entity{idx, generation_floor_});
+            place_record(idx, arch, first + reused + i);
+        }
+        return arch;
     }
 
-    static bool archetype_matches(const std::bitset<256>& arch_bits,
-                                  const std::bitset<256>& include_mask,
-                                  const std::bitset<256>& exclude_mask) {
-        return (arch_bits & include_mask) == include_mask && (arch_bits & exclude_mask).none();
+    template <typename T>
+    static void broadcast_column(Archetype* arch, size_t first, size_t n, const T& value) {
+        auto* col = arch->find_column(component_id<T>());
+        arch->for_each_run(first, first + n, [&](size_t run, size_t len) {
+            T* dst = static_cast<T*>(col->get(run));
+            for (size_t i = 0; i < len; ++i)
+                new (dst + i) T(value);
+        });
+        col->commit_rows(n);
     }
 
-    Archetype* get_or_create_archetype(const TypeSet& ts) {
-        auto it = archetypes_.find(ts);
-        if (it != archetypes_.end())
-            return it->second.get();
+    template <typename T>
+    static void copy_column(Archetype* arch, size_t first, size_t n, const T* src) {
+        auto* col = arch->find_column(component_id<T>());
+        arch->for_each_run(first, first + n, [&](size_t run, size_t len) {
+            T* dst = static_cast<T*>(col->get(run));
+            const T* from = src + (run - first);
+            for (size_t i = 0; i < len; ++i)
+                new (dst + i) T(from[i]);
+        });
+        col->commit_rows(n);
+    }
 
-        auto arch = std::make_unique<Archetype>();
-        arch->type_set = ts;
-        auto& factory_reg = column_factory_registry();
-        arch->columns.reserve(ts.size());
-        for (auto cid : ts) {
-            arch->columns.emplace_back(cid, factory_reg.at(cid)());
-            arch->component_bits.set(cid);
+    template <typename... Ts>
+    Span<const Entity> finish_batch(Archetype* arch, size_t first, size_t n) {
+        ComponentTypeID ids[] = {component_id<Ts>()...};
+        return finish_batch_ids(arch, first, n, ids, sizeof...(Ts));
+    }
+
+    // on_add events for rows [first, first + n) created with archetype components ids[0..count).
+    // Returns the rows' entities from `batch_created_`, which hooks cannot invalidate.
+    Span<const Entity> finish_batch_ids(Archetype* arch, size_t first, size_t n,
+                                        const ComponentTypeID* ids, size_t count) {
+        arch->assert_parity();
+        batch_created_.assign(arch->entities.begin() + first, arch->entities.begin() + first + n);
+        if (arch->observed_add) {
+            bool each = false;
+            for (ComponentTypeID cid : Span<const ComponentTypeID>(ids, count)) {
+                if (observed_add_.test(cid)) {
+                    notify_rows(add_observers_, cid, arch, first, n);
+                    each |= !add_observers_[cid]->each.empty();
+                }
+            }
+            if (each) {
+                // Hooks may change structure or create batches of their own, so iterate a
+                // private copy, re-resolve each row, and restore the result afterwards.
+                std::vector<Entity> batch(batch_created_);
+                for (ComponentTypeID cid : Span<const ComponentTypeID>(ids, count))
+                    if (observed_add_.test(cid))
+                        notify_each(add_observers_, cid, batch);
+                batch_created_ = std::move(batch);
+            }
         }
-        // ts is already sorted, so columns are in sorted order
-        Archetype* ptr = arch.get();
-        archetypes_.emplace(ts, std::move(arch));
-        ++archetype_generation_;
-        return ptr;
+        return Span<const Entity>(batch_created_.data(), batch_created_.size());
     }
 
-    Archetype* find_add_target(Archetype* src, ComponentTypeID cid) {
-        auto* edge = src->find_edge(cid);
-        if (edge && edge->add_target)
-            return edge->add_target;
+    // -- Split components (see split_fields) --
 
-        TypeSet new_ts = src->type_set;
-        new_ts.push_back(cid);
-        std::sort(new_ts.begin(), new_ts.end());
-        Archetype* target = get_or_create_archetype(new_ts);
-        src->edge_for(cid).add_target = target;
-        return target;
+    template <typename S, size_t... Is>
+    bool has_lanes(Entity e, std::index_sequence<Is...>) const {
+        const Archetype* arch = records_[e.index].archetype;
+        return (arch->has_component(component_id<Lane<S, Is>>()) && ...);
     }
 
-    Archetype* find_remove_target(Archetype* src, ComponentTypeID cid) {
-        auto* edge = src->find_edge(cid);
-        if (edge && edge->remove_target)
-            return edge->remove_target;
+    template <typename S, size_t... Is>
+    S load_lanes(Entity e, std::index_sequence<Is...>) const {
+        S value{};
+        ((value.*split_member<S, Is> = get<Lane<S, Is>>(e).value), ...);
+        return value;
+    }
 
-        TypeSet new_ts;
-        for (auto id : src->type_set) {
-            if (id != cid)
-                new_ts.push_back(id);
+    template <typename S, size_t... Is>
+    void store_lanes(Entity e, const S& value, std::index_sequence<Is...>) {
+        ((get<Lane<S, Is>>(e).value = value.*split_member<S, Is>), ...);
+    }
+
+    // Adds the missing lanes with one migration, then writes every lane. Observers run once
+    // all lanes are in place.
+    template <typename S, size_t... Is>
+    void add_lanes(Entity e, const S& value, std::index_sequence<Is...>) {
+        static_assert(std::is_trivially_copyable_v<S> && std::is_default_constructible_v<S>,
+                      "split components must be trivially copyable and default constructible");
+        ECS_ASSERT(iterating_ == 0, "structural change during iteration");
+        if (!alive(e))
+            return;
+        (ensure_column_factory<Lane<S, Is>>(), ...);
+        const ComponentTypeID ids[] = {component_id<Lane<S, Is>>()...};
+        Archetype* old_arch = records_[e.index].archetype;
+        Archetype* new_arch = old_arch;
+        for (ComponentTypeID cid : ids)
+            if (!new_arch->has_component(cid))
+                new_arch = find_add_target(new_arch, cid);
+        if (new_arch != old_arch)
+            migrate_entity(e, old_arch, new_arch, records_[e.index].row);
+
+        size_t row = records_[e.index].row;
+        (place_lane(old_arch, new_arch, row, Lane<S, Is>{value.*split_member<S, Is>}), ...);
+        for (ComponentTypeID cid : ids) {
+            // An observer may have moved or destroyed the entity
+            if (!alive(e))
+                return;
+            const auto& rec = records_[e.index];
+            ComponentColumn* col = rec.archetype->find_column(cid);
+            if (!col)
+                continue;
+            void* data = col->get(rec.row);
+            if (old_arch->has_component(cid))
+                notify_overwrite(cid, e, data);
+            else if (observed_add_.test(cid))
+                notify(add_observers_, cid, e, data);
         }
-        Archetype* target = get_or_create_archetype(new_ts);
-        src->edge_for(cid).remove_target = target;
-        return target;
     }
 
-    template <typename T>
-    void push_component_to_archetype(Archetype* arch, T&& comp) {
-        auto* col = arch->find_column(component_id<std::decay_t<T>>());
-        std::decay_t<T> tmp = std::forward<T>(comp);
-        col->push_raw(&tmp);
+    template <typename L>
+    static void place_lane(Archetype* old_arch, Archetype* new_arch, size_t row, const L& lane) {
+        ComponentColumn* col = new_arch->find_column(component_id<L>());
+        if (old_arch->has_component(component_id<L>())) {
+            *static_cast<L*>(col->get(row)) = lane;
+            col->mark_changed(row);
+        } else {
+            col->emplace_back<L>(lane);
+        }
     }
 
-    // Type-erased add: migrates entity and moves raw component data into the new archetype.
-    void add_raw(Entity e, ComponentTypeID cid, void* data, ComponentColumn::MoveFunc move_fn) {
+    template <typename S, size_t... Is>
+    void remove_lanes(Entity e, std::index_sequence<Is...>) {
         ECS_ASSERT(iterating_ == 0, "structural change during iteration");
         if (!alive(e))
             return;
+        const ComponentTypeID ids[] = {component_id<Lane<S, Is>>()...};
+        auto& rec = records_[e.index];
+        Archetype* old_arch = rec.archetype;
+        Archetype* new_arch = old_arch;
+        for (ComponentTypeID cid : ids)
+            if (new_arch->has_component(cid))
+                new_arch = find_remove_target(new_arch, cid);
+        if (new_arch == old_arch)
+            return;
+
+        size_t old_row = rec.row;
+        for (ComponentTypeID cid : ids)
+            if (old_arch->has_component(cid) && observed_remove_.test(cid))
+                notify(remove_observers_, cid, e, old_arch->find_column(cid)->get(old_row));
+        migrate_entity_removing(e, old_arch, new_arch, old_row, ids[0]);
+    }
+
+    // Type-erased add: migrates entity and moves raw component data into the new archetype.
+    // Returns false (data left untouched) if the entity is dead.
+    bool add_raw(Entity e, ComponentTypeID cid, void* data) {
+        ECS_ASSERT(iterating_ == 0, "structural change during iteration");
+        if (!alive(e))
+            return false;
+        if (is_sparse_component_id(cid)) {
+            SparseSet& set = sparse_set(cid);
+            if (set.contains(e.index)) {
+                ComponentColumn& col = set.column();
+                size_t row = set.row(e.index);
+                col.destroy_elem(col.get(row));
+                col.relocate_elem(col.get(row), data);
+                col.mark_changed(row);
+                notify_overwrite(cid, e, col.get(row));
+                return true;
+            }
+            set.insert(e, [&](ComponentColumn& col) { col.push_raw(data); });
+            notify_add(cid, e, set.get(e.index));
+            return true;
+        }
         auto& rec = records_[e.index];
         Archetype* old_arch = rec.archetype;
         if (old_arch->has_component(cid)) {
             // Already has it — overwrite via move
             auto* col = old_arch->find_column(cid);
-            col->destroy_fn(col->get(rec.row));
-            move_fn(col->get(rec.row), data);
-            return;
+            col->destroy_elem(col->get(rec.row));
+            col->relocate_elem(col->get(rec.row), data);
+            col->mark_changed(rec.row);
+            notify_overwrite(cid, e, col->get(rec.row));
+            return true;
         }
 
         Archetype* new_arch = find_add_target(old_arch, cid);
@@ -894,7 +3086,9 @@ private:
         auto* col = new_arch->find_column(cid);
         col->push_raw(data);
 
-        fire_hooks(on_add_hooks_, cid, e, new_arch->find_column(cid)->get(records_[e.index].row));
+        if (observed_add_.test(cid))
+            notify(add_observers_, cid, e, col->get(records_[e.index].row));
+        return true;
     }
 
     // Type-erased remove component.
@@ -902,6 +3096,10 @@ private:
         ECS_ASSERT(iterating_ == 0, "structural change during iteration");
         if (!alive(e))
             return;
+        if (is_sparse_component_id(cid)) {
+            remove_sparse(e, cid);
+            return;
+        }
         auto& rec = records_[e.index];
         Archetype* old_arch = rec.archetype;
         if (!old_arch->has_component(cid))
@@ -910,7 +3108,8 @@ private:
         Archetype* new_arch = find_remove_target(old_arch, cid);
         size_t old_row = rec.row;
 
-        fire_hooks(on_remove_hooks_, cid, e, old_arch->find_column(cid)->get(old_row));
+        if (observed_remove_.test(cid))
+            notify(remove_observers_, cid, e, old_arch->find_column(cid)->get(old_row));
         migrate_entity_removing(e, old_arch, new_arch, old_row, cid);
     }
 
@@ -918,94 +3117,328 @@ private:
     Entity create_with_raw(ComponentTypeID* ids, void** data, ComponentColumn::MoveFunc* /*moves*/,
                            size_t count) {
         ECS_ASSERT(iterating_ == 0, "structural change during iteration");
-        TypeSet ts(ids, ids + count);
+        return create_in_archetype_raw(archetype_for_ids(ids, count), ids, data, count);
+    }
+
+    // The archetype of an entity created with components ids[0..count); sparse ones are skipped
+    Archetype* archetype_for_ids(const ComponentTypeID* ids, size_t count) {
+        TypeSet ts;
+        ts.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+            if (!is_sparse_component_id(ids[i]))
+                ts.push_back(ids[i]);
         std::sort(ts.begin(), ts.end());
-        Archetype* arch = get_or_create_archetype(ts);
+        return get_or_create_archetype(ts);
+    }
 
-        uint32_t idx;
-        if (!free_list_.empty()) {
-            idx = free_list_.back();
-            free_list_.pop_back();
-        } else {
-            idx = static_cast<uint32_t>(generations_.size());
-            generations_.push_back(0);
-            records_.push_back({});
-        }
+    // Creates an entity in `arch`, which must be `archetype_for_ids(ids, count)`.
+    Entity create_in_archetype_raw(Archetype* arch, const ComponentTypeID* ids, void* const* data,
+                                   size_t count) {
+        ECS_ASSERT(iterating_ == 0, "structural change during iteration");
+        uint32_t idx = acquire_slot();
         uint32_t gen = generations_[idx];
         Entity e{idx, gen};
 
         size_t row = arch->count();
         arch->push_entity(e);
         for (size_t i = 0; i < count; ++i) {
-            auto* col = arch->find_column(ids[i]);
-            col->push_raw(data[i]);
+            auto push = [&](ComponentColumn& col) { col.push_raw(data[i]); };
+            if (is_sparse_component_id(ids[i]))
+                sparse_set(ids[i]).insert(e, push);
+            else
+                push(*arch->find_column(ids[i]));
         }
         arch->assert_parity();
 
-        records_[idx] = {arch, row};
+        place_record(idx, arch, row);
 
-        for (size_t i = 0; i < count; ++i) {
-            fire_hooks(on_add_hooks_, ids[i], e, arch->find_column(ids[i])->get(row));
-        }
+        notify_created(arch, row, e, ids, count);
 
         return e;
     }
 
+    // -- Batched command application (CommandBuffer::flush_batched) --
+
+    // Groups entities by their current archetype, in order of first appearance.
+    void group_by_archetype(const std::vector<Entity>& entities,
+                            std::vector<std::pair<Archetype*, std::vector<size_t>>>& groups) {
+        groups.clear();
+        std::unordered_map<Archetype*, size_t> slot;
+        Archetype* last = nullptr;
+        size_t last_slot = 0;
+        for (size_t i = 0; i < entities.size(); ++i) {
+            Archetype* arch = records_[entities[i].index].archetype;
+            if (arch != last) { // runs usually come from one archetype; skip the map lookup
+                auto [it, inserted] = slot.emplace(arch, groups.size());
+                if (inserted)
+                    groups.push_back({arch, {}});
+                last = arch;
+                last_slot = it->second;
+            }
+            groups[last_slot].second.push_back(i);
+        }
+    }
+
+    // Marks an entity index as part of the current batch run; false if already marked.
+    bool mark_in_run(uint32_t index) {
+        if (index >= records_.size())
+            return true; // never a live entity; flush drops the command anyway
+        if (run_marks_.size() < records_.size())
+            run_marks_.resize(records_.size(), 0);
+        if (run_marks_[index] == run_epoch_)
+            return false;
+        run_marks_[index] = run_epoch_;
+        return true;
+    }
+
+    // Starts a new batch run; all previous marks become stale.
+    void begin_run() {
+        if (++run_epoch_ == 0) {
+            std::fill(run_marks_.begin(), run_marks_.end(), 0);
+            run_epoch_ = 1;
+        }
+    }
+
+    // Moves the rows of `entities[picks...]` from src to dst as one batch: capacity is reserved
+    // once, columns are appended column by column, and src is compacted in a single pass. If
+    // `added_col` is set, data[pick] is pushed into it for each row.
+    void migrate_rows(Archetype* src, Archetype* dst, const std::vector<Entity>& entities,
+                      const std::vector<size_t>& picks, ComponentColumn* added_col,
+                      void* const* data) {
+        size_t base = dst->count();
+        dst->ensure_capacity(base + picks.size());
+        ECS_PROFILE_ADD(profile_, entities_migrated, picks.size());
+        std::vector<size_t> rows;
+        rows.reserve(picks.size());
+        for (size_t pick : picks)
+            rows.push_back(records_[entities[pick].index].row);
+
+        for (auto& [cid, dst_col] : dst->columns) {
+            auto* src_col = src->find_column(cid);
+            if (src_col) {
+                for (size_t row : rows)
+                    dst_col.push_moved(*src_col, row);
+            } else if (&dst_col == added_col) {
+                for (size_t pick : picks)
+                    dst_col.push_raw(data[pick]);
+            }
+        }
+        dst->entities.reserve(base + picks.size());
+        for (size_t i = 0; i < picks.size(); ++i) {
+            Entity e = entities[picks[i]];
+            dst->entities.push_back(e);
+            place_record(e.index, dst, base + i);
+        }
+        dst->order.rows_moved = true;
+        dst->assert_parity();
+
+        if (!std::is_sorted(rows.begin(), rows.end()))
+            std::sort(rows.begin(), rows.end());
+        src->remove_rows(rows, dst->component_bits,
+                         [&](Entity moved, size_t row) { records_[moved.index].row = row; });
+    }
+
+    // Applies `add(entities[i], data[i])` for one component type. Entities must be distinct.
+    // on_add hooks fire after every row has moved; batched observers get one run per target.
+    void apply_add_run(ComponentTypeID cid, const std::vector<Entity>& entities,
+                       const std::vector<void*>& data, ComponentColumn::DestroyFunc destroy_fn) {
+        ECS_ASSERT(iterating_ == 0, "structural change during iteration");
+        if (is_sparse_component_id(cid)) {
+            // Nothing to batch: sparse adds never migrate
+            for (size_t i = 0; i < entities.size(); ++i)
+                if (!add_raw(entities[i], cid, data[i]))
+                    destroy_fn(data[i]);
+            return;
+        }
+        std::vector<Entity> live;
+        std::vector<void*> live_data;
+        for (size_t i = 0; i < entities.size(); ++i) {
+            if (alive(entities[i])) {
+                live.push_back(entities[i]);
+                live_data.push_back(data[i]);
+            } else {
+                destroy_fn(data[i]);
+            }
+        }
+        std::vector<std::pair<Archetype*, std::vector<size_t>>> groups;
+        group_by_archetype(live, groups);
+        std::vector<Entity> added;
+        std::vector<std::pair<Archetype*, size_t>> runs; // (target, first new row)
+        for (auto& [src, picks] : groups) {
+            if (auto* col = src->find_column(cid)) {
+                // Already has it — overwrite in place, no hook (matches add_raw)
+                for (size_t pick : picks) {
+                    size_t row = records_[live[pick].index].row;
+                    void* dst = col->get(row);
+                    col->destroy_elem(dst);
+                    col->relocate_elem(dst, live_data[pick]);
+                    col->mark_changed(row);
+                    notify_overwrite(cid, live[pick], dst);
+                }
+                continue;
+            }
+            Archetype* dst = find_add_target(src, cid);
+            runs.push_back({dst, dst->count()});
+            migrate_rows(src, dst, live, picks, dst->find_column(cid), live_data.data());
+            for (size_t pick : picks)
+                added.push_back(live[pick]);
+        }
+        if (!observed_add_.test(cid))
+            return;
+        // Each target received its rows as one contiguous run at its end
+        for (auto& [dst, first] : runs)
+            notify_rows(add_observers_, cid, dst, first, dst->count() - first);
+        notify_each(add_observers_, cid, added);
+    }
+
+    // Applies `remove(entities[i])` for one component type. Entities must be distinct.
+    // on_remove hooks fire for every affected entity before any row moves.
+    void apply_remove_run(ComponentTypeID cid, const std::vector<Entity>& entities) {
+        ECS_ASSERT(iterating_ == 0, "structural change during iteration");
+        if (is_sparse_component_id(cid)) {
+            for (Entity e : entities)
+                remove_raw(e, cid);
+            return;
+        }
+        std::vector<Entity> affected;
+        for (Entity e : entities) {
+            if (alive(e) && records_[e.index].archetype->has_component(cid))
+                affected.push_back(e);
+        }
+        notify_entities(remove_observers_, observed_remove_, cid, affected);
+
+        // Hooks may have changed structure; re-filter before grouping.
+        std::vector<Entity> live;
+        for (Entity e : affected) {
+            if (alive(e) && records_[e.index].archetype->has_component(cid))
+                live.push_back(e);
+        }
+        std::vector<std::pair<Archetype*, std::vector<size_t>>> groups;
+        group_by_archetype(live, groups);
+        for (auto& [src, picks] : groups)
+            migrate_rows(src, find_remove_target(src, cid), live, picks, nullptr, nullptr);
+    }
+
     // Migrate entity from old_arch[old_row] to new_arch, moving all shared columns.
     // Does NOT handle the added component — caller pushes it after.
     void migrate_entity(Entity e, Archetype* old_arch, Archetype* new_arch, size_t old_row) {
         new_arch->ensure_capacity(new_arch->count() + 1);
+        ECS_PROFILE_ADD(profile_, entities_migrated, 1);
         // Move shared column data to new archetype
         for (auto& [cid, new_col] : new_arch->columns) {
             auto* old_col = old_arch->find_column(cid);
-            if (old_col) {
-                void* src = old_col->get(old_row);
-                new_col.push_raw(src);
-            }
+            if (old_col)
+                new_col.push_moved(*old_col, old_row);
         }
 
         new_arch->push_entity(e);
         size_t new_row = new_arch->count() - 1;
 
-        // Swap-remove from old archetype (entity + all columns)
-        Entity swapped = old_arch->swap_remove(old_row);
+        // Swap-remove from old archetype; the moved columns' storage at old_row is already dead
+        Entity swapped = old_arch->swap_remove(old_row, new_arch->component_bits);
         if (swapped != INVALID_ENTITY) {
             records_[swapped.index].row = old_row;
         }
 
-        records_[e.index] = {new_arch, new_row};
+        place_record(e.index, new_arch, new_row);
     }
 
     // Migrate removing a component: moves all columns except cid_to_remove.
     void migrate_entity_removing(Entity e, Archetype* old_arch, Archetype* new_arch, size_t old_row,
                                  ComponentTypeID /*cid_to_remove*/) {
         new_arch->ensure_capacity(new_arch->count() + 1);
+        ECS_PROFILE_ADD(profile_, entities_migrated, 1);
         // Move shared column data (all except the removed one)
         for (auto& [cid, new_col] : new_arch->columns) {
             auto* old_col = old_arch->find_column(cid);
-            if (old_col) {
-                void* src = old_col->get(old_row);
-                new_col.push_raw(src);
-            }
+            if (old_col)
+                new_col.push_moved(*old_col, old_row);
         }
 
         new_arch->push_entity(e);
         size_t new_row = new_arch->count() - 1;
 
-        // Destroy the removed component before swap-remove
-        // (swap_remove will destroy whatever is at old_row, but after the move
-        //  the shared columns at old_row are already moved-from shells.
-        //  The removed column still has live data at old_row.)
-        // Actually swap_remove destroys all columns at old_row, which is correct:
-        // moved-from objects get destroyed (no-op for most types), and the removed
-        // component gets properly destroyed.
-        Entity swapped = old_arch->swap_remove(old_row);
+        // Swap-remove from old archetype: the moved columns' storage at old_row is already
+        // dead, and only the removed component is destroyed
+        Entity swapped = old_arch->swap_remove(old_row, new_arch->component_bits);
         if (swapped != INVALID_ENTITY) {
             records_[swapped.index].row = old_row;
         }
 
-        records_[e.index] = {new_arch, new_row};
+        place_record(e.index, new_arch, new_row);
+    }
+};
+
+/**
+ * @brief A persistent query over archetype components Ts..., created by `World::query`.
+ *
+ * @details Holds the World's compiled state for the query: the matching archetypes, each with
+ * its columns for Ts... already resolved. The World appends archetypes as they are created
+ * and drops deleted ones, so a query built once (e.g. when a system is registered) stays
+ * current and every call goes straight to the rows. Iteration rules match `World::each`:
+ * structural changes assert, and mutable Ts stamp their columns as changed. Handles are
+ * cheap to copy and must not outlive their World. A default-constructed query is empty.
+ */
+template <typename... Ts>
+class Query {
+public:
+    Query() = default;
+
+    /** @brief Whether the query was created by a World. */
+    bool valid() const { return state_ != nullptr; }
+
+    /** @brief Calls `fn(Entity, Ts&...)` for every matching entity. */
+    template <typename Func>
+    void each(Func&& fn) {
+        world_->template each_state<true, Ts...>(*state_, fn);
+    }
+
+    /** @brief Calls `fn(Ts&...)` for every matching entity. */
+    template <typename Func>
+    void each_no_entity(Func&& fn) {
+        world_->template each_state<false, Ts...>(*state_, fn);
+    }
+
+    /** @brief Parallel `each`, with the rules and splitting of `World::par_each`. */
+    template <typename Func>
+    void par_each(ThreadPool& pool, Func&& fn) {
+        world_->template par_each_state<true, Ts...>(pool, *state_, fn);
+    }
+
+    /** @brief Parallel `each_no_entity` (see `par_each`). */
+    template <typename Func>
+    void par_each_no_entity(ThreadPool& pool, Func&& fn) {
+        world_->template par_each_state<false, Ts...>(pool, *state_, fn);
+    }
+
+    /**
+     * @brief Calls `fn(Span<const Entity>, Ts*...)` once per contiguous run of matching rows.
+     * @details A run is a whole archetype in block storage and one chunk in chunked storage;
+     * `ptr[i]` belongs to `entities[i]` (for tag types every row shares `ptr[0]`). Suited to
+     * loops the compiler should vectorize.
+     */
+    template <typename Func>
+    void each_chunk(Func&& fn) {
+        world_->template each_chunk_state<Ts...>(*state_, fn, std::index_sequence_for<Ts...>{});
+    }
+
+    /** @brief Number of matching entities. */
+    size_t count() const {
+        size_t total = 0;
+        for (const Archetype* arch : state_->archetypes)
+            total += arch->count();
+        return total;
     }
+
+    /** @brief Number of matching archetypes, including empty ones. */
+    size_t archetype_count() const { return state_->archetypes.size(); }
+
+private:
+    friend class World;
+    Query(World* world, const World::QueryState* state) : world_(world), state_(state) {}
+
+    World* world_ = nullptr;
+    const World::QueryState* state_ = nullptr;
 };
 
 // -- CommandBuffer::flush() definition (needs complete World type) --
@@ -1017,16 +3450,18 @@ private:
  */
 inline void CommandBuffer::flush(World& w) {
     // Take ownership of buffer to allow re-entrant commands during flush
-    std::vector<uint8_t> local_buf = std::move(buf_);
-    buf_.clear();
+    ByteBuffer local_buf = take_commands();
 
+    std::vector<ComponentTypeID> ids;
+    std::vector<void*> data_ptrs;
     size_t pos = 0;
     while (pos < local_buf.size()) {
-        pos = align_up(pos, alignof(CmdHeader));
+        pos = align_up(pos, CMD_ALIGN);
         if (pos + sizeof(CmdHeader) > local_buf.size())
             break;
         auto* hdr = reinterpret_cast<CmdHeader*>(local_buf.data() + pos);
         pos += sizeof(CmdHeader);
+        ECS_PROFILE_ADD(w.profile_, commands_flushed, 1);
 
         switch (hdr->tag) {
         case CmdTag::Destroy:
@@ -1035,13 +3470,9 @@ inline void CommandBuffer::flush(World& w) {
         case CmdTag::Add: {
             pos = align_up(pos, alignof(std::max_align_t));
             void* data = local_buf.data() + pos;
-            w.add_raw(hdr->entity, hdr->cid, data, hdr->move_fn);
-            // If add_raw consumed the data via move, the source is now moved-from.
-            // If the entity was dead and add_raw was a no-op, we must destroy the data.
-            // add_raw calls push_raw which move-constructs and destroys source, OR
-            // it overwrites via destroy+move. Either way the source is consumed.
-            // If entity was dead, add_raw returned early — destroy the unconsumed data.
-            if (!w.alive(hdr->entity))
+            // add_raw relocates the data out of the buffer; if the entity was dead it is left
+            // in place and destroyed here
+            if (!w.add_raw(hdr->entity, hdr->cid, data))
                 hdr->destroy_fn(data);
             pos += hdr->payload;
             break;
@@ -1050,39 +3481,113 @@ inline void CommandBuffer::flush(World& w) {
             w.remove_raw(hdr->entity, hdr->cid);
             break;
         case CmdTag::CreateWith: {
-            size_t count = hdr->payload;
-            // Collect sub-entries
-            struct Gathered {
-                ComponentTypeID cid;
-                void* data;
-                ComponentColumn::MoveFunc move_fn;
-                ComponentColumn::DestroyFunc destroy_fn;
-            };
-            std::vector<Gathered> entries;
-            entries.reserve(count);
-            for (size_t i = 0; i < count; ++i) {
+            pos = read_sub_entries(local_buf, pos, hdr->payload, ids, data_ptrs);
+            w.create_with_raw(ids.data(), data_ptrs.data(), nullptr, hdr->payload);
+            break;
+        }
+        }
+    }
+    recycle(local_buf);
+}
+
+inline void CommandBuffer::flush_batched(World& w) {
+    ByteBuffer local_buf = take_commands();
+
+    // Decode the command stream once so runs can be detected by looking ahead.
+    struct Decoded {
+        CmdHeader* hdr;
+        size_t pos; // Add: payload offset; CreateWith: first sub-entry offset
+    };
+    std::vector<Decoded> cmds;
+    cmds.reserve(local_buf.size() / (sizeof(CmdHeader) + 16));
+    size_t pos = 0;
+    while (pos < local_buf.size()) {
+        pos = align_up(pos, CMD_ALIGN);
+        if (pos + sizeof(CmdHeader) > local_buf.size())
+            break;
+        auto* hdr = reinterpret_cast<CmdHeader*>(local_buf.data() + pos);
+        pos += sizeof(CmdHeader);
+        switch (hdr->tag) {
+        case CmdTag::Destroy:
+        case CmdTag::Remove:
+            cmds.push_back({hdr, pos});
+            break;
+        case CmdTag::Add:
+            pos = align_up(pos, alignof(std::max_align_t));
+            cmds.push_back({hdr, pos});
+            pos += hdr->payload;
+            break;
+        case CmdTag::CreateWith: {
+            cmds.push_back({hdr, pos});
+            for (size_t i = 0; i < hdr->payload; ++i) {
                 pos = align_up(pos, alignof(SubEntry));
                 auto* sub = reinterpret_cast<SubEntry*>(local_buf.data() + pos);
-                pos += sizeof(SubEntry);
-                pos = align_up(pos, alignof(std::max_align_t));
-                void* data = local_buf.data() + pos;
-                entries.push_back({sub->cid, data, sub->move_fn, sub->destroy_fn});
-                pos += sub->elem_size;
+                pos = align_up(pos + sizeof(SubEntry), alignof(std::max_align_t)) + sub->elem_size;
             }
-            // Build parallel arrays for create_with_raw
-            std::vector<ComponentTypeID> ids(count);
-            std::vector<void*> data_ptrs(count);
-            std::vector<ComponentColumn::MoveFunc> moves(count);
-            for (size_t i = 0; i < count; ++i) {
-                ids[i] = entries[i].cid;
-                data_ptrs[i] = entries[i].data;
-                moves[i] = entries[i].move_fn;
+            break;
+        }
+        }
+    }
+
+    ECS_PROFILE_ADD(w.profile_, commands_flushed, cmds.size());
+    std::vector<Entity> run_entities;
+    std::vector<void*> run_data;
+    run_entities.reserve(cmds.size());
+    run_data.reserve(cmds.size());
+    std::vector<ComponentTypeID> ids, run_ids;
+    std::vector<void*> data_ptrs;
+    size_t i = 0;
+    while (i < cmds.size()) {
+        CmdHeader* hdr = cmds[i].hdr;
+        switch (hdr->tag) {
+        case CmdTag::Destroy:
+            w.destroy(hdr->entity);
+            ++i;
+            break;
+        case CmdTag::Add:
+        case CmdTag::Remove: {
+            // A run is consecutive commands of the same kind and component on distinct
+            // entities, so reordering rows within it cannot change the result.
+            run_entities.clear();
+            run_data.clear();
+            w.begin_run();
+            size_t j = i;
+            while (j < cmds.size() && cmds[j].hdr->tag == hdr->tag && cmds[j].hdr->cid == hdr->cid &&
+                   w.mark_in_run(cmds[j].hdr->entity.index)) {
+                run_entities.push_back(cmds[j].hdr->entity);
+                run_data.push_back(local_buf.data() + cmds[j].pos);
+                ++j;
+            }
+            if (hdr->tag == CmdTag::Add)
+                w.apply_add_run(hdr->cid, run_entities, run_data, hdr->destroy_fn);
+            else
+                w.apply_remove_run(hdr->cid, run_entities);
+            i = j;
+            break;
+        }
+        case CmdTag::CreateWith: {
+            // A run is consecutive create_with commands recorded with the same component list.
+            read_sub_entries(local_buf, cmds[i].pos, hdr->payload, run_ids, data_ptrs);
+            size_t j = i + 1;
+            while (j < cmds.size() && cmds[j].hdr->tag == CmdTag::CreateWith &&
+                   cmds[j].hdr->payload == hdr->payload) {
+                read_sub_entries(local_buf, cmds[j].pos, hdr->payload, ids, data_ptrs);
+                if (ids != run_ids)
+                    break;
+                ++j;
             }
-            w.create_with_raw(ids.data(), data_ptrs.data(), moves.data(), count);
+            Archetype* arch = w.archetype_for_ids(run_ids.data(), run_ids.size());
+            arch->ensure_capacity(arch->count() + (j - i));
+            for (size_t k = i; k < j; ++k) {
+                read_sub_entries(local_buf, cmds[k].pos, hdr->payload, ids, data_ptrs);
+                w.create_in_archetype_raw(arch, ids.data(), data_ptrs.data(), ids.size());
+            }
+            i = j;
             break;
         }
         }
     }
+    recycle(local_buf);
 }
 
 // -- Prefab instantiation (needs complete World) --
@@ -1097,25 +3602,10 @@ inline Entity instantiate(World& world, const Prefab& prefab) {
     ECS_ASSERT(world.iterating_ == 0, "structural change during iteration");
     ECS_ASSERT(prefab.component_count() > 0, "instantiate: empty prefab");
 
-    // Build TypeSet from prefab entries
-    TypeSet ts;
-    ts.reserve(prefab.component_count());
-    for (auto& entry : prefab.entries())
-        ts.push_back(entry.cid);
-    std::sort(ts.begin(), ts.end());
-
-    Archetype* arch = world.get_or_create_archetype(ts);
+    Archetype* arch = world.prefab_archetype(prefab);
 
     // Allocate entity
-    uint32_t idx;
-    if (!world.free_list_.empty()) {
-        idx = world.free_list_.back();
-        world.free_list_.pop_back();
-    } else {
-        idx = static_cast<uint32_t>(world.generations_.size());
-        world.generations_.push_back(0);
-        world.records_.push_back({});
-    }
+    uint32_t idx = world.acquire_slot();
     uint32_t gen = world.generations_[idx];
     Entity e{idx, gen};
 
@@ -1123,20 +3613,15 @@ inline Entity instantiate(World& world, const Prefab& prefab) {
     arch->push_entity(e);
 
     // Copy-construct each component from prefab defaults
-    for (auto& entry : prefab.entries()) {
-        auto* col = arch->find_column(entry.cid);
-        // copy_fn placement-new constructs into the column slot
-        entry.copy_fn(col->data + col->count * col->elem_size, prefab.data() + entry.buf_offset);
-        ++col->count;
-    }
+    for (auto& entry : prefab.entries())
+        world.push_prefab_default(arch, e, entry, prefab);
     arch->assert_parity();
 
-    world.records_[idx] = {arch, row};
+    world.place_record(idx, arch, row);
 
     // Fire on_add hooks
-    for (auto& entry : prefab.entries()) {
-        world.fire_hooks(world.on_add_hooks_, entry.cid, e, arch->find_column(entry.cid)->get(row));
-    }
+    for (auto& entry : prefab.entries())
+        world.notify_created(arch, row, e, &entry.cid, 1);
 
     return e;
 }
@@ -1176,20 +3661,10 @@ Entity instantiate(World& world, const Prefab& prefab, Overrides&&... overrides)
         if (!found)
             ts.push_back(oid);
     }
-    std::sort(ts.begin(), ts.end());
-
-    Archetype* arch = world.get_or_create_archetype(ts);
+    Archetype* arch = world.archetype_for_ids(ts.data(), ts.size());
 
     // Allocate entity
-    uint32_t idx;
-    if (!world.free_list_.empty()) {
-        idx = world.free_list_.back();
-        world.free_list_.pop_back();
-    } else {
-        idx = static_cast<uint32_t>(world.generations_.size());
-        world.generations_.push_back(0);
-        world.records_.push_back({});
-    }
+    uint32_t idx = world.acquire_slot();
     uint32_t gen = world.generations_[idx];
     Entity e{idx, gen};
 
@@ -1208,32 +3683,89 @@ Entity instantiate(World& world, const Prefab& prefab, Overrides&&... overrides)
                 break;
             }
         }
-        if (!overridden) {
-            auto* col = arch->find_column(entry.cid);
-            entry.copy_fn(col->data + col->count * col->elem_size,
-                          prefab.data() + entry.buf_offset);
-            ++col->count;
-        }
+        if (!overridden)
+            world.push_prefab_default(arch, e, entry, prefab);
     }
 
-    // Push overrides (move-construct)
-    auto push_override = [&](auto&& comp) {
-        using U = std::decay_t<decltype(comp)>;
-        auto* col = arch->find_column(component_id<U>());
-        U tmp = std::forward<decltype(comp)>(comp);
-        col->push_raw(&tmp);
-    };
-    (push_override(std::forward<Overrides>(overrides)), ...);
+    // Push overrides (constructed in place)
+    (world.push_component<std::decay_t<Overrides>>(arch, e,
+                                                    std::forward<Overrides>(overrides)),
+     ...);
 
     arch->assert_parity();
-    world.records_[idx] = {arch, row};
+    world.place_record(idx, arch, row);
 
     // Fire on_add hooks for all components
-    for (auto cid : ts) {
-        world.fire_hooks(world.on_add_hooks_, cid, e, arch->find_column(cid)->get(row));
-    }
+    world.notify_created(arch, row, e, ts.data(), ts.size());
 
     return e;
 }
 
+inline Span<const Entity> instantiate_n(World& world, const Prefab& prefab, size_t n) {
+    return instantiate_n<>(world, prefab, n, [](size_t) { return std::tuple<>(); });
+}
+
+template <typename... Overrides, typename Gen>
+Span<const Entity> instantiate_n(World& world, const Prefab& prefab, size_t n, Gen&& gen) {
+    static_assert(!World::any_sparse_v<Overrides...>,
+                  "instantiate_n: overrides must be archetype components");
+    ECS_ASSERT(world.iterating_ == 0, "structural change during iteration");
+    ECS_ASSERT(prefab.component_count() > 0, "instantiate: empty prefab");
+    (ensure_column_factory<Overrides>(), ...);
+
+    // Overrides the prefab lacks extend its archetype through the add edges
+    Archetype* arch = world.prefab_archetype(prefab);
+    const ComponentTypeID override_ids[] = {component_id<Overrides>()..., 0};
+    for (size_t i = 0; i < sizeof...(Overrides); ++i)
+        if (!arch->has_component(override_ids[i]))
+            arch = world.find_add_target(arch, override_ids[i]);
+    size_t first = arch->count();
+    world.reserve_rows(arch, n);
+
+    TypeSet ids; // archetype components, for the on_add pass
+    ids.reserve(prefab.component_count() + sizeof...(Overrides));
+    for (auto& entry : prefab.entries()) {
+        const ComponentTypeID* end = override_ids + sizeof...(Overrides);
+        if (std::find(override_ids, end, entry.cid) != end)
+            continue;
+        world.broadcast_prefab_default(arch, first, n, entry, prefab);
+        if (!is_sparse_component_id(entry.cid))
+            ids.push_back(entry.cid);
+    }
+    if constexpr (sizeof...(Overrides) > 0) {
+        auto cols = std::make_tuple(
+            World::TypedColumn<Overrides>{arch->find_column(component_id<Overrides>())}...);
+        for (size_t i = 0; i < n; ++i) {
+            std::tuple<Overrides...> values = gen(i);
+            (new (std::get<World::TypedColumn<Overrides>>(cols).col->get(first + i))
+                 Overrides(std::move(std::get<Overrides>(values))),
+             ...);
+        }
+        (std::get<World::TypedColumn<Overrides>>(cols).col->commit_rows(n), ...);
+        ids.insert(ids.end(), override_ids, override_ids + sizeof...(Overrides));
+    } else {
+        (void)gen;
+    }
+
+    // Sparse defaults raise their events per entity, after the archetype batch
+    Span<const Entity> created = world.finish_batch_ids(arch, first, n, ids.data(), ids.size());
+    bool sparse_observed = false;
+    for (auto& entry : prefab.entries())
+        sparse_observed |=
+            is_sparse_component_id(entry.cid) && world.observed_add_.test(entry.cid);
+    if (!sparse_observed)
+        return created;
+    std::vector<Entity> batch(created.begin(), created.end()); // hooks may start new batches
+    for (auto& entry : prefab.entries()) {
+        if (!is_sparse_component_id(entry.cid) || !world.observed_add_.test(entry.cid))
+            continue;
+        SparseSet* set = world.find_sparse(entry.cid);
+        for (Entity e : batch)
+            if (world.alive(e) && set->contains(e.index))
+                world.notify(world.add_observers_, entry.cid, e, set->get(e.index));
+    }
+    world.batch_created_ = std::move(batch);
+    return Span<const Entity>(world.batch_created_.data(), world.batch_created_.size());
+}
+
 } // namespace ecs
@@ -1,15 +1,22 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
 #include <csetjmp>
 #include <csignal>
 #include <cstdio>
+#include <cstring>
 #include <ecs/ecs.hpp>
 #include <ecs/modules/hierarchy.hpp>
 #include <ecs/modules/hierarchy_ops.hpp>
+#include <ecs/modules/spatial_grid.hpp>
 #include <ecs/modules/transform.hpp>
 #include <ecs/modules/transform_propagation.hpp>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <tuple>
+#include <utility>
 
 using namespace ecs;
 
@@ -524,6 +531,39 @@ void test_query_cache_invalidation() {
     std::printf("  query cache invalidation: OK\n");
 }
 
+void test_query_cache_incremental() {
+    World w;
+    w.create_with(Position{1, 0});
+    int with_pos = 0, pos_no_vel = 0;
+    auto run_queries = [&] {
+        with_pos = pos_no_vel = 0;
+        w.each<Position>([&](Entity, Position&) { ++with_pos; });
+        w.each<Position>(World::Exclude<Velocity>{}, [&](Entity, Position&) { ++pos_no_vel; });
+    };
+    run_queries();
+    assert(with_pos == 1 && pos_no_vel == 1);
+
+    // New archetypes are appended to the already-cached entries they match
+    w.create_with(Position{2, 0}, Velocity{0, 0});
+    w.create_with(Position{3, 0}, Health{1});
+    w.create_with(Velocity{0, 0}, Health{1});
+    run_queries();
+    assert(with_pos == 3 && pos_no_vel == 2);
+
+    // An archetype emptied by migration stays cached but contributes nothing
+    Entity e = w.create_with(Position{4, 0}, Velocity{0, 0}, Health{1});
+    w.remove<Health>(e);
+    run_queries();
+    assert(with_pos == 4 && pos_no_vel == 2);
+
+    // A query first issued after the archetypes exist scans them once
+    int health = 0;
+    w.each<Health>([&](Entity, Health&) { ++health; });
+    assert(health == 2);
+
+    std::printf("  query cache incremental: OK\n");
+}
+
 // -- Phase 2.1: CommandBuffer standalone --
 
 void test_command_buffer_basic() {
@@ -955,6 +995,314 @@ void test_hierarchy_propagation_with_set_parent() {
     std::printf("  hierarchy propagation with set_parent: OK\n");
 }
 
+// Runs the incremental propagator, then the full BFS, and checks they agree on every node.
+static bool propagation_matches_full(World& w, TransformPropagator& prop, ThreadPool* pool) {
+    if (pool)
+        prop.run(w, *pool);
+    else
+        prop.run(w);
+    std::vector<std::pair<Entity, Mat4>> incremental;
+    w.each<const WorldTransform>(
+        [&](Entity e, const WorldTransform& wt) { incremental.push_back({e, wt.matrix}); });
+    propagate_transforms(w);
+    const World& reader = w;
+    for (auto& [e, m] : incremental)
+        if (std::memcmp(&m, &reader.get<WorldTransform>(e).matrix, sizeof(Mat4)) != 0)
+            return false;
+    return true;
+}
+
+void test_incremental_propagation() {
+    World w;
+    ThreadPool pool(4);
+    TransformPropagator prop;
+
+    // Two roots: a wide fan (one level larger than the parallel grain) and a 6-deep chain
+    Entity fan = w.create_with(LocalTransform{{1, 0, 0}}, WorldTransform{});
+    std::vector<Entity> leaves;
+    for (int i = 0; i < 600; ++i) {
+        Entity leaf = w.create_with(LocalTransform{{0, float(i), 0}}, WorldTransform{});
+        set_parent(w, leaf, fan);
+        leaves.push_back(leaf);
+    }
+    std::vector<Entity> chain{w.create_with(LocalTransform{{0, 0, 1}}, WorldTransform{})};
+    for (int i = 1; i < 6; ++i) {
+        chain.push_back(w.create_with(LocalTransform{{0, 0, 1}}, WorldTransform{}));
+        set_parent(w, chain[i], chain[i - 1]);
+    }
+    uint32_t tick = w.change_tick();
+    assert(propagation_matches_full(w, prop, &pool));
+    assert(prop.node_count() == 607 && prop.depth() == 6 && prop.last_updated() == 607);
+    assert(w.change_tick() == tick); // advancing the tick is left to the application
+
+    // Each section below is one frame: the tick advances, then edits, then a run.
+    // Nothing changed: nothing recomposed
+    w.advance_tick();
+    prop.run(w, pool);
+    assert(prop.last_updated() == 0);
+
+    // A local edit recomposes exactly its subtree
+    w.advance_tick();
+    w.get<LocalTransform>(chain[3]).position.x = 5;
+    assert(propagation_matches_full(w, prop, nullptr));
+    assert(prop.last_updated() == 3);
+    w.advance_tick();
+    w.get<LocalTransform>(fan).scale = {2, 2, 2};
+    assert(propagation_matches_full(w, prop, &pool));
+    assert(prop.last_updated() == 601);
+
+    // Hierarchy edits rebuild: reparent, detach, destroy, and a new root
+    w.advance_tick();
+    set_parent(w, chain[2], leaves[10]);
+    assert(propagation_matches_full(w, prop, &pool));
+    assert(prop.depth() == 6);
+    w.advance_tick();
+    remove_parent(w, leaves[20]);
+    assert(propagation_matches_full(w, prop, &pool));
+    w.advance_tick();
+    destroy_recursive(w, leaves[10]);
+    assert(propagation_matches_full(w, prop, &pool));
+    assert(prop.node_count() == 607 - 5);
+    w.advance_tick();
+    w.create_with(LocalTransform{{7, 0, 0}}, WorldTransform{});
+    assert(propagation_matches_full(w, prop, &pool));
+    assert(prop.node_count() == 607 - 4);
+
+    std::printf("  incremental propagation: OK\n");
+}
+
+// The kernels repeat the scalar float operations in the same order, so every backend gives the
+// same bits unless the compiler may contract multiply-adds into FMAs
+static bool mat4_same(const Mat4& a, const Mat4& b) {
+#if defined(__FMA__) || defined(__ARM_FEATURE_FMA)
+    for (int i = 0; i < 16; ++i)
+        if (std::fabs(a.m[i] - b.m[i]) > 1e-5f * (1.0f + std::fabs(b.m[i])))
+            return false;
+    return true;
+#else
+    return std::memcmp(&a, &b, sizeof(Mat4)) == 0;
+#endif
+}
+
+void test_transform_batch_kernels() {
+    // 11 transforms: two full SIMD groups plus a scalar tail
+    std::vector<LocalTransform> locals;
+    for (int i = 0; i < 11; ++i) {
+        float t = 0.37f * float(i + 1);
+        float qx = std::sin(t), qy = std::cos(2 * t), qz = 0.5f * std::sin(3 * t), qw = 1.0f;
+        float len = std::sqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+        locals.push_back({{float(i), -2.5f * t, t * t},
+                          {qx / len, qy / len, qz / len, qw / len},
+                          {1.0f + t, i % 3 == 0 ? -1.0f : 0.5f, 2.0f - t}});
+    }
+    size_t n = locals.size();
+    std::vector<Mat4> composed(n), products(n);
+    mat4_compose_batch(locals.data(), composed.data(), n);
+    for (size_t i = 0; i < n; ++i) {
+        Mat4 scalar;
+        mat4_compose_scalar(locals[i], scalar);
+        assert(mat4_same(composed[i], scalar));
+        const LocalTransform& l = locals[i];
+        assert(mat4_same(composed[i], mat4_compose(l.position, l.rotation, l.scale)));
+    }
+
+    // Multiply each matrix by its neighbour; the in-place form must give the same result
+    std::vector<Mat4> parents(composed.rbegin(), composed.rend());
+    mat4_multiply_batch(parents.data(), composed.data(), products.data(), n);
+    for (size_t i = 0; i < n; ++i) {
+        Mat4 scalar;
+        mat4_multiply_scalar(parents[i], composed[i], scalar);
+        assert(mat4_same(products[i], scalar));
+        assert(mat4_same(products[i], mat4_multiply(parents[i], composed[i])));
+    }
+    mat4_multiply_batch(parents.data(), composed.data(), composed.data(), n);
+    assert(std::memcmp(composed.data(), products.data(), n * sizeof(Mat4)) == 0);
+
+    std::printf("  transform batch kernels (%s): OK\n", mat4_batch_backend());
+}
+
+static WorldTransform translation(float x, float y, float z) {
+    WorldTransform wt{};
+    wt.matrix.m[0] = wt.matrix.m[5] = wt.matrix.m[10] = wt.matrix.m[15] = 1.0f;
+    wt.matrix.m[12] = x;
+    wt.matrix.m[13] = y;
+    wt.matrix.m[14] = z;
+    return wt;
+}
+
+// Deterministic coordinates in [lo, hi) for the spatial tests
+static float grid_rand(uint32_t& state, float lo, float hi) {
+    state = state * 1664525u + 1013904223u;
+    return lo + float(state >> 8) / float(1u << 24) * (hi - lo);
+}
+
+static std::vector<Entity> sorted_by_index(Span<const Entity> span) {
+    std::vector<Entity> v(span.begin(), span.end());
+    std::sort(v.begin(), v.end(), [](Entity a, Entity b) { return a.index < b.index; });
+    return v;
+}
+
+// Checks radius, AABB and k-nearest queries against a scan of every WorldTransform.
+static bool grid_matches_scan(World& w, SpatialGrid& grid, uint32_t seed) {
+    std::vector<std::pair<Entity, Vec3>> all;
+    w.each<const WorldTransform>([&](Entity e, const WorldTransform& wt) {
+        all.push_back({e, SpatialGrid::position_of(wt.matrix)});
+    });
+    if (grid.size() != all.size())
+        return false;
+    auto d2 = [](const Vec3& a, const Vec3& b) {
+        float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+        return dx * dx + dy * dy + dz * dz;
+    };
+    std::vector<Entity> out;
+    for (int q = 0; q < 40; ++q) {
+        Vec3 c{grid_rand(seed, -25, 25), grid_rand(seed, -25, 25), grid_rand(seed, -25, 25)};
+        float radius = grid_rand(seed, 0, 9);
+        std::vector<Entity> expect;
+        for (auto& [e, p] : all)
+            if (d2(p, c) <= radius * radius)
+                expect.push_back(e);
+        if (sorted_by_index(grid.query_radius(c, radius, out)) != sorted_by_index(expect))
+            return false;
+
+        Vec3 lo{c.x - radius, c.y - 2 * radius, c.z - 0.5f * radius};
+        Vec3 hi{c.x + radius, c.y + radius, c.z + 3 * radius};
+        expect.clear();
+        for (auto& [e, p] : all)
+            if (p.x >= lo.x && p.x <= hi.x && p.y >= lo.y && p.y <= hi.y && p.z >= lo.z &&
+                p.z <= hi.z)
+                expect.push_back(e);
+        if (sorted_by_index(grid.query_aabb(lo, hi)) != sorted_by_index(expect))
+            return false;
+
+        // Nearest, including a center far outside the occupied cells
+        if (q % 10 == 9)
+            c = {400.0f, -30.0f, 5.0f};
+        size_t k = size_t(q % 4 == 0 ? 1 : q * 7);
+        std::vector<std::pair<float, Entity>> ranked;
+        for (auto& [e, p] : all)
+            ranked.push_back({d2(p, c), e});
+        std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first || (a.first == b.first && a.second.index < b.second.index);
+        });
+        ranked.resize(std::min(k, ranked.size()));
+        Span<const Entity> nearest = grid.query_nearest(c, k, out);
+        if (nearest.size() != ranked.size())
+            return false;
+        for (size_t i = 0; i < ranked.size(); ++i)
+            if (nearest[i] != ranked[i].second)
+                return false;
+    }
+    return true;
+}
+
+void test_spatial_grid_queries() {
+    World w;
+    uint32_t seed = 7;
+    // A cloud, a flat layer and points exactly on cell boundaries (cell size 2.5)
+    for (int i = 0; i < 1500; ++i)
+        w.create_with(translation(grid_rand(seed, -20, 20), grid_rand(seed, -20, 20),
+                                  grid_rand(seed, -20, 20)));
+    for (int i = 0; i < 300; ++i)
+        w.create_with(translation(grid_rand(seed, -20, 20), grid_rand(seed, -20, 20), 0.0f));
+    for (int i = -4; i <= 4; ++i)
+        w.create_with(translation(2.5f * float(i), -2.5f * float(i), 5.0f));
+    w.create_with(Position{0, 0}); // not spatial
+
+    SpatialGrid grid(2.5f);
+    grid.update(w);
+    assert(grid.size() == 1809 && grid.last_updated() == 1809);
+    assert(grid_matches_scan(w, grid, 11));
+
+    // Degenerate queries
+    std::vector<Entity> out{Entity{1, 1}};
+    assert(grid.query_nearest({0, 0, 0}, 0, out).empty() && out.empty());
+    assert(grid.query_radius({1000, 1000, 1000}, 5).empty());
+    assert(grid.query_aabb({1, 1, 1}, {0, 0, 0}).empty());
+    assert(grid.query_nearest({0, 0, 0}, 5000).size() == 1809);
+    SpatialGrid empty(1.0f);
+    assert(empty.query_nearest({0, 0, 0}, 3).empty() && empty.query_radius({0, 0, 0}, 9).empty());
+
+    std::printf("  spatial grid queries: OK\n");
+}
+
+void test_spatial_grid_incremental() {
+    World w;
+    ThreadPool pool(4);
+    TransformPropagator prop;
+    SpatialGrid grid(3.0f);
+
+    // 400 roots with 4 children each, spread over a 40-unit cube
+    uint32_t seed = 3;
+    std::vector<Entity> roots;
+    std::vector<Entity> children;
+    for (int i = 0; i < 400; ++i) {
+        Entity root = w.create_with(LocalTransform{{grid_rand(seed, -20, 20),
+                                                    grid_rand(seed, -20, 20),
+                                                    grid_rand(seed, -20, 20)}},
+                                    WorldTransform{});
+        roots.push_back(root);
+        for (int c = 0; c < 4; ++c) {
+            Entity child = w.create_with(LocalTransform{{float(c), 1.0f, 0.0f}}, WorldTransform{});
+            set_parent(w, child, root);
+            children.push_back(child);
+        }
+    }
+    prop.run(w);
+    grid.update(w);
+    assert(grid.size() == 2000 && grid_matches_scan(w, grid, 1));
+
+    // Each section is one frame: the application advances the tick, then edits and updates
+    // Idle frame: nothing to place
+    w.advance_tick();
+    prop.run(w);
+    grid.update(w);
+    assert(grid.last_updated() == 0);
+
+    // Moving a root moves its subtree: 5 entities each, within or across cells
+    w.advance_tick();
+    for (int i = 0; i < 10; ++i)
+        w.get<LocalTransform>(roots[i]).position.x += i % 2 ? 0.1f : 7.0f;
+    prop.run(w);
+    grid.update(w);
+    assert(grid.last_updated() == 50 && grid_matches_scan(w, grid, 2));
+
+    // Destruction, component removal, index reuse and new entities
+    w.advance_tick();
+    Entity gone = roots[20];
+    destroy_recursive(w, gone);
+    w.remove<WorldTransform>(children[100]);
+    w.destroy(children[200]);
+    Entity reused = w.create_with(LocalTransform{{-19, -19, -19}}, WorldTransform{});
+    Entity plain = w.create_with(Position{1, 2}); // reuses a slot without a transform
+    w.create_with(LocalTransform{{30, 30, 30}}, WorldTransform{});
+    prop.run(w);
+    grid.update(w);
+    assert(!grid.contains(gone) && !grid.contains(children[100]) && !grid.contains(plain));
+    assert(grid.contains(reused) && grid.size() == w.count<WorldTransform>());
+    assert(grid_matches_scan(w, grid, 3));
+
+    // Everything moves: the parallel path places over the grain in parallel
+    w.advance_tick();
+    for (Entity root : roots)
+        if (w.alive(root))
+            w.get<LocalTransform>(root).position.y -= 4.0f;
+    prop.run(w, pool);
+    grid.update(w, pool);
+    assert(grid.last_updated() == 2000 - 5 - 2 && grid_matches_scan(w, grid, 4));
+
+    // Writes made without the propagator are picked up too, and invalidate rebuilds
+    w.advance_tick();
+    w.get<WorldTransform>(children[0]) = translation(12, -12, 12);
+    grid.update(w);
+    assert(grid.last_updated() == 1 && grid_matches_scan(w, grid, 5));
+    grid.invalidate();
+    grid.update(w);
+    assert(grid.last_updated() == grid.size() && grid_matches_scan(w, grid, 6));
+
+    std::printf("  spatial grid incremental update: OK\n");
+}
+
 // --- Phase 6: Sorting ---
 
 struct Depth {
@@ -1136,201 +1484,2282 @@ void test_bitset_many_archetypes() {
     std::printf("  bitset many archetypes: OK\n");
 }
 
-// --- Phase 8.1: Stable Type Registration ---
-
-void test_register_component_lookup() {
-    register_component<Position>("Position");
-    register_component<Velocity>("Velocity");
+template <size_t N>
+struct Wide {
+    int v;
+};
 
-    assert(component_id_by_name("Position") == component_id<Position>());
-    assert(component_id_by_name("Velocity") == component_id<Velocity>());
-    assert(component_name(component_id<Position>()) == "Position");
-    assert(component_name(component_id<Velocity>()) == "Velocity");
-    assert(component_registered(component_id<Position>()));
-    assert(component_registered(component_id<Velocity>()));
-    std::printf("  register component lookup: OK\n");
+template <size_t... Ns>
+void register_wide(std::index_sequence<Ns...>) {
+    (component_id<Wide<Ns>>(), ...);
 }
 
-void test_register_component_idempotent() {
-    register_component<Position>("Position");
-    register_component<Position>("Position"); // same name, same type — no-op
-    assert(component_id_by_name("Position") == component_id<Position>());
-    std::printf("  register component idempotent: OK\n");
-}
+void test_component_mask_beyond_256() {
+    register_wide(std::make_index_sequence<300>{});
+    assert(component_id<Wide<299>>() >= ComponentMask::INLINE_BITS);
 
-void test_register_component_conflict() {
-    auto old_handler = signal(SIGABRT, abort_handler);
-    bool caught = false;
-    if (sigsetjmp(jump_buf, 1) == 0) {
-        register_component<Health>("Position"); // different type, same name as Position
-    } else {
-        caught = true;
-    }
-    signal(SIGABRT, old_handler);
-    assert(caught);
-    std::printf("  register component conflict: OK\n");
+    ComponentMask m;
+    m.set(3);
+    m.set(700);
+    assert(m.test(3) && m.test(700) && !m.test(701) && !m.test(5000));
+    ComponentMask high;
+    high.set(700);
+    assert(m.contains_all(high) && !high.contains_all(m) && m.intersects(high));
+    high.reset(700);
+    assert(high.none() && high == ComponentMask{});
+
+    World w;
+    w.create_with(Wide<0>{1}, Wide<299>{2});
+    w.create_with(Wide<0>{3}, Wide<298>{4});
+    w.create_with(Wide<299>{5}, Wide<298>{6});
+    assert(w.count<Wide<299>>() == 2);
+    assert((w.count<Wide<0>, Wide<299>>() == 1));
+    int count = 0;
+    w.each<Wide<0>>(World::Exclude<Wide<299>>{}, [&](Entity, Wide<0>& c) {
+        assert(c.v == 3);
+        ++count;
+    });
+    assert(count == 1);
+
+    Entity e = w.create_with(Wide<1>{7});
+    w.add(e, Wide<297>{8});
+    assert(w.has<Wide<297>>(e) && !w.has<Wide<296>>(e));
+    w.remove<Wide<1>>(e);
+    assert(w.get<Wide<297>>(e).v == 8 && w.count<Wide<1>>() == 0);
+
+    std::printf("  component mask beyond 256: OK\n");
 }
 
-// --- Phase 8.2: Serialization ---
+// --- Phase 7.3: Chunked storage mode ---
 
-void test_serialize_round_trip() {
-    register_component<Position>("Position");
-    register_component<Velocity>("Velocity");
-    register_component<Health>("Health");
+void test_chunked_storage_pointer_stability() {
+    World w(WorldConfig{StorageMode::Chunked, 1024}); // 128 rows of Position+Velocity per chunk
+    assert(w.config().storage == StorageMode::Chunked);
+    Entity first = w.create_with(Position{1, 2}, Velocity{0, 0});
+    Position* p = &w.get<Position>(first);
 
-    World w1;
-    Entity e1 = w1.create_with(Position{1.0f, 2.0f}, Velocity{3.0f, 4.0f});
-    Entity e2 = w1.create_with(Position{5.0f, 6.0f}, Health{100});
-    Entity e3 = w1.create_with(Health{50});
+    std::vector<Entity> es;
+    for (int i = 0; i < 5000; ++i)
+        es.push_back(w.create_with(Position{float(i), 0}, Velocity{1, 0}));
+    assert(&w.get<Position>(first) == p); // growth never moved the first row
+    assert(p->x == 1.0f && p->y == 2.0f);
 
-    std::stringstream ss;
-    serialize(w1, ss);
+    for (int i = 0; i < 5000; ++i)
+        assert(w.get<Position>(es[i]).x == float(i));
+    std::printf("  chunked storage pointer stability: OK\n");
+}
 
-    World w2;
-    deserialize(w2, ss);
+void test_chunked_storage_iteration_and_removal() {
+    World w(WorldConfig{StorageMode::Chunked, 512});
+    std::vector<Entity> es;
+    for (int i = 0; i < 3000; ++i)
+        es.push_back(w.create_with(Position{float(i), 0}, Velocity{1, 0}));
 
-    assert(w2.alive(e1));
-    assert(w2.alive(e2));
-    assert(w2.alive(e3));
-    assert(w2.get<Position>(e1).x == 1.0f && w2.get<Position>(e1).y == 2.0f);
-    assert(w2.get<Velocity>(e1).dx == 3.0f && w2.get<Velocity>(e1).dy == 4.0f);
-    assert(w2.get<Position>(e2).x == 5.0f && w2.get<Position>(e2).y == 6.0f);
-    assert(w2.get<Health>(e2).hp == 100);
-    assert(w2.get<Health>(e3).hp == 50);
-    assert(!w2.has<Velocity>(e2));
-    assert(!w2.has<Position>(e3));
-    assert(w2.count() == 3);
-    std::printf("  serialize round trip: OK\n");
+    int count = 0;
+    w.each<Position, Velocity>([&](Entity, Position& p, Velocity& v) {
+        p.y += v.dx;
+        ++count;
+    });
+    assert(count == 3000);
+
+    // Destroy every third entity: swap-remove pulls rows across chunk boundaries
+    for (int i = 0; i < 3000; i += 3)
+        w.destroy(es[i]);
+    for (int i = 0; i < 3000; ++i) {
+        if (i % 3 == 0)
+            continue;
+        assert(w.get<Position>(es[i]).x == float(i));
+        assert(w.get<Position>(es[i]).y == 1.0f);
+    }
+
+    // Migration between chunked archetypes
+    for (int i = 1; i < 3000; i += 3)
+        w.add(es[i], Health{i});
+    assert(w.count<Health>() == 1000);
+    for (int i = 1; i < 3000; i += 3) {
+        assert(w.get<Health>(es[i]).hp == i);
+        assert(w.get<Position>(es[i]).x == float(i));
+    }
+    w.remove<Velocity>(es[1]);
+    assert(!w.has<Velocity>(es[1]) && w.get<Health>(es[1]).hp == 1);
+
+    w.sort<Position>([](const Position& a, const Position& b) { return a.x > b.x; });
+    float last = 1e9f;
+    w.each<Position>(World::Exclude<Health>{}, [&](Entity e, Position& pos) {
+        assert(pos.x <= last);
+        last = pos.x;
+        assert(w.get<Position>(e).x == pos.x);
+    });
+
+    ThreadPool pool(4);
+    std::atomic<int> visited{0};
+    w.par_each<Position>(pool, [&](Entity, Position&) { ++visited; });
+    assert(visited == 2000);
+    std::printf("  chunked storage iteration and removal: OK\n");
 }
 
-void test_serialize_destroyed_entities() {
+void test_chunked_storage_serialize() {
     register_component<Position>("Position");
+    register_component<Velocity>("Velocity");
 
     World w1;
-    Entity e1 = w1.create_with(Position{1.0f, 0.0f});
-    Entity e2 = w1.create_with(Position{2.0f, 0.0f});
-    Entity e3 = w1.create_with(Position{3.0f, 0.0f});
-    w1.destroy(e2); // free list should contain e2's index
-
+    std::vector<Entity> es;
+    for (int i = 0; i < 1000; ++i)
+        es.push_back(w1.create_with(Position{float(i), 1}, Velocity{2, 3}));
     std::stringstream ss;
     serialize(w1, ss);
 
-    World w2;
+    World w2(WorldConfig{StorageMode::Chunked, 256});
     deserialize(w2, ss);
+    assert(w2.count() == 1000);
+    for (int i = 0; i < 1000; ++i)
+        assert(w2.get<Position>(es[i]).x == float(i) && w2.get<Velocity>(es[i]).dy == 3.0f);
+    std::printf("  chunked storage serialize: OK\n");
+}
 
-    assert(w2.alive(e1));
-    assert(!w2.alive(e2)); // destroyed
-    assert(w2.alive(e3));
-    assert(w2.get<Position>(e1).x == 1.0f);
-    assert(w2.get<Position>(e3).x == 3.0f);
-    assert(w2.count() == 2);
+// --- Phase 7.7: Pluggable Allocators ---
+
+// Forwards to the default pool, counting calls and outstanding bytes.
+struct CountingAllocator {
+    size_t allocs = 0;
+    size_t frees = 0;
+    size_t live_bytes = 0;
+    Allocator alloc{this,
+                    [](void* self, size_t bytes, size_t align) {
+                        auto* c = static_cast<CountingAllocator*>(self);
+                        ++c->allocs;
+                        c->live_bytes += bytes;
+                        return default_allocator().allocate(default_allocator().user, bytes, align);
+                    },
+                    [](void* self, void* ptr, size_t bytes, size_t align) {
+                        auto* c = static_cast<CountingAllocator*>(self);
+                        ++c->frees;
+                        c->live_bytes -= bytes;
+                        default_allocator().deallocate(default_allocator().user, ptr, bytes, align);
+                    }};
+};
 
-    // New entity should reuse the free slot
-    Entity e4 = w2.create();
-    assert(e4.index == e2.index);
-    assert(e4.generation == e2.generation + 1);
-    std::printf("  serialize destroyed entities: OK\n");
+void test_block_pool_size_classes() {
+    assert(BlockPool::rounded_size(1) == BlockPool::MIN_CLASS);
+    assert(BlockPool::rounded_size(256) == 256);
+    assert(BlockPool::rounded_size(257) == 320);
+    assert(BlockPool::rounded_size(4096) == 4096);
+    assert(BlockPool::rounded_size(4097) == 5120);
+    for (size_t n = 257; n < (size_t(1) << 24); n = n * 9 / 8 + 1) {
+        size_t r = BlockPool::rounded_size(n);
+        assert(r >= n && r % BlockPool::ALIGN == 0);
+        assert(r - n <= n / 4 + BlockPool::MIN_CLASS / 4);
+    }
+
+    // Freed blocks are reused by class, aligned, and bounded by the retention limit
+    BlockPool pool(8192);
+    void* a = pool.allocate(3000, 16);
+    assert(reinterpret_cast<uintptr_t>(a) % BlockPool::ALIGN == 0);
+    pool.deallocate(a, 3000, 16);
+    assert(pool.cached_bytes() == BlockPool::rounded_size(3000));
+    void* b = pool.allocate(2900, 16); // same class
+    assert(b == a && pool.reused() == 1 && pool.cached_bytes() == 0);
+    void* big = pool.allocate(10000, 16);
+    pool.deallocate(big, 10000, 16); // over the limit: released, not cached
+    assert(pool.cached_bytes() == 0);
+    pool.deallocate(b, 2900, 16);
+    pool.allocator().trim(pool.allocator().user);
+    assert(pool.cached_bytes() == 0);
+
+    // Stricter alignments bypass the pool
+    void* wide = pool.allocate(3000, 256);
+    assert(reinterpret_cast<uintptr_t>(wide) % 256 == 0);
+    pool.deallocate(wide, 3000, 256);
+    assert(pool.cached_bytes() == 0);
+    std::printf("  block pool size classes: OK\n");
 }
 
-void test_serialize_empty_world() {
-    World w1;
+void test_world_allocator() {
+    BlockPool pool;
+    WorldConfig config;
+    config.allocator = &pool.allocator();
+    auto populate = [](World& w) {
+        for (int i = 0; i < 5000; ++i)
+            w.create_with(Position{float(i), 0}, Health{i});
+    };
+    {
+        World w(config);
+        assert(&w.allocator() == &pool.allocator());
+        populate(w);
+    }
+    // Destroyed world's blocks are cached, then recycled by the next world
+    size_t cached = pool.cached_bytes();
+    assert(cached > 0);
+    {
+        World w(config);
+        populate(w);
+        assert(pool.reused() > 0);
+        assert(pool.cached_bytes() < cached);
+    }
+    {
+        World w;
+        assert(&w.allocator() == &default_allocator());
+    }
 
-    std::stringstream ss;
-    serialize(w1, ss);
+    // Over-aligned components are served by the default allocator
+    {
+        struct alignas(128) Wide {
+            float v[4];
+        };
+        World w;
+        for (int i = 0; i < 100; ++i)
+            w.create_with(Wide{{float(i)}});
+        w.each<Wide>([](Entity, Wide& x) { assert(reinterpret_cast<uintptr_t>(&x) % 128 == 0); });
+    }
 
-    World w2;
-    deserialize(w2, ss);
+    // compact() hands the allocator's cache back to the system
+    {
+        World w(config);
+        populate(w);
+        assert(pool.cached_bytes() > 0);
+        w.each<Health>([&](Entity e, Health&) { w.deferred().destroy(e); });
+        w.flush_deferred();
+        w.compact();
+        assert(pool.cached_bytes() == 0);
+    }
 
-    assert(w2.count() == 0);
-    std::printf("  serialize empty world: OK\n");
+    // Chunked storage returns every chunk to the allocator
+    CountingAllocator counting;
+    {
+        WorldConfig chunked;
+        chunked.storage = StorageMode::Chunked;
+        chunked.chunk_bytes = 1024;
+        chunked.allocator = &counting.alloc;
+        World w(chunked);
+        populate(w);
+        assert(counting.allocs > 4);
+    }
+    assert(counting.frees == counting.allocs && counting.live_bytes == 0);
+    std::printf("  world allocator: OK\n");
 }
 
-void test_serialize_with_hierarchy() {
-    register_component<Parent>("Parent");
-    register_component<Children>(
-        "Children",
-        // Custom serialize for Children (non-trivially-copyable)
-        [](const void* elem, std::ostream& out) {
-            auto& children = *static_cast<const Children*>(elem);
-            uint32_t count = static_cast<uint32_t>(children.entities.size());
-            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
-            for (auto& e : children.entities) {
-                out.write(reinterpret_cast<const char*>(&e.index), sizeof(uint32_t));
-                out.write(reinterpret_cast<const char*>(&e.generation), sizeof(uint32_t));
-            }
-        },
-        [](void* elem, std::istream& in) {
-            auto& children = *static_cast<Children*>(elem);
-            uint32_t count;
-            in.read(reinterpret_cast<char*>(&count), sizeof(count));
-            children.entities.resize(count);
-            for (uint32_t i = 0; i < count; ++i) {
-                in.read(reinterpret_cast<char*>(&children.entities[i].index), sizeof(uint32_t));
-                in.read(reinterpret_cast<char*>(&children.entities[i].generation),
-                        sizeof(uint32_t));
-            }
-        });
+void test_command_buffer_arena() {
+    CountingAllocator counting;
+    WorldConfig config;
+    config.allocator = &counting.alloc;
+    World w(config);
+    std::vector<Entity> ents;
+    for (int i = 0; i < 200; ++i)
+        ents.push_back(w.create_with(Health{i}));
+
+    // Overwriting adds: no migration, so only command storage can allocate
+    auto frame = [&] {
+        for (Entity e : ents)
+            w.deferred().add(e, Health{7});
+        w.flush_deferred();
+    };
+    frame();
+    frame();
+    size_t warm = counting.allocs;
+    for (int i = 0; i < 10; ++i)
+        frame();
+    assert(counting.allocs == warm);
+    assert(w.get<Health>(ents[0]).hp == 7);
+
+    // Prefab data comes from the chosen allocator, copies included
+    size_t before = counting.allocs;
+    Prefab p = Prefab::create_using(counting.alloc, Position{1, 2}, Health{3});
+    assert(counting.allocs == before + 1);
+    Prefab copy = p;
+    assert(counting.allocs == before + 2);
+    Entity e = instantiate(w, copy);
+    assert(w.get<Health>(e).hp == 3 && w.get<Position>(e).y == 2);
+    std::printf("  command buffer arena: OK\n");
+}
 
-    World w1;
-    Entity parent = w1.create_with(Position{10.0f, 0.0f});
-    Entity child = w1.create_with(Position{0.0f, 5.0f});
-    set_parent(w1, child, parent);
+// --- Phase 7.8: Memory Reclamation ---
+
+void test_shrink_to_fit() {
+    for (StorageMode mode : {StorageMode::Block, StorageMode::Chunked}) {
+        CountingAllocator counting;
+        WorldConfig config;
+        config.storage = mode;
+        config.chunk_bytes = 4096;
+        config.allocator = &counting.alloc;
+        World w(config);
+        std::vector<Entity> ents;
+        for (int i = 0; i < 10000; ++i)
+            ents.push_back(w.create_with(Position{float(i), 0}, Health{i}));
+        size_t peak = counting.live_bytes;
+
+        // Keep the first 100 rows: destroying from the back leaves them in place
+        for (size_t i = ents.size(); i-- > 100;)
+            w.destroy(ents[i]);
+        assert(w.shrink_to_fit() == 1);
+        assert(counting.live_bytes * 10 < peak);
+        assert(w.shrink_to_fit() == 0);
+        const World& cw = w;
+        for (int i = 0; i < 100; ++i)
+            assert(cw.get<Position>(ents[i]).x == float(i) && cw.get<Health>(ents[i]).hp == i);
+
+        // Storage grows again normally
+        for (int i = 0; i < 1000; ++i)
+            w.create_with(Position{}, Health{});
+        assert((w.count<Position, Health>() == 1100));
+    }
+    std::printf("  shrink_to_fit: OK\n");
+}
 
-    std::stringstream ss;
-    serialize(w1, ss);
+void test_remove_empty_archetypes() {
+    World w;
+    Entity e = w.create_with(Position{1, 1});
+    w.add(e, Velocity{2, 2});
+    w.add(e, Health{3});
+    w.remove<Health>(e);
+    Entity tmp = w.create_with(Health{0});
+    w.destroy(tmp);
+    size_t visits = 0;
+    w.each<Position, Velocity>([&](Entity, Position&, Velocity&) { ++visits; });
+    assert(visits == 1);
+
+    // {Position}, {Position, Velocity, Health} and {Health} are empty
+    size_t before = w.archetype_count();
+    assert(w.remove_empty_archetypes() == 3);
+    assert(w.archetype_count() == before - 3);
+    assert(w.remove_empty_archetypes() == 0);
+
+    // Edges and cached queries pick up recreated archetypes
+    w.add(e, Health{4});
+    visits = 0;
+    w.each<Position, Velocity>([&](Entity, Position&, Velocity&) { ++visits; });
+    w.each<Health>([&](Entity, Health& h) { visits += size_t(h.hp); });
+    assert(visits == 5);
+    w.remove<Velocity>(e);
+    w.remove<Health>(e);
+    assert(w.has<Position>(e) && !w.has<Velocity>(e) && w.count<Position>() == 1);
+    std::printf("  remove_empty_archetypes: OK\n");
+}
 
+void test_compact() {
+    register_component<Position>("Position");
+    World w1;
+    std::vector<Entity> es;
+    for (int i = 0; i < 100; ++i)
+        es.push_back(w1.create_with(Position{float(i), 0}));
+    std::stringstream full;
+    serialize_snapshot(w1, full);
+    std::string full_bytes = full.str();
     World w2;
-    deserialize(w2, ss);
+    deserialize_snapshot(w2, full_bytes.data(), full_bytes.size());
+    uint32_t baseline = w1.advance_tick();
+
+    for (size_t i = 10; i < es.size(); ++i)
+        w1.destroy(es[i]);
+    w1.destroy(es[5]);
+    w1.destroy(es[2]);
+    w1.compact();
+    for (size_t i = 0; i < es.size(); ++i)
+        assert(w1.alive(es[i]) == (i < 10 && i != 5 && i != 2));
+
+    // Every save format carries the generation floor
+    std::stringstream v1, v2, streamed;
+    serialize(w1, v1);
+    serialize_snapshot(w1, v2);
+    serialize_stream(w1, streamed);
+    std::string v2_bytes = v2.str();
+    World loaded[3];
+    deserialize(loaded[0], v1);
+    assert(deserialize_snapshot(loaded[1], v2_bytes.data(), v2_bytes.size()));
+    assert(deserialize_stream(loaded[2], streamed));
+
+    // Slots past the trimmed end come back with generations newer than any stale handle
+    std::vector<Entity> fresh;
+    for (int i = 0; i < 5; ++i)
+        fresh.push_back(w1.create_with(Position{-1, 0}));
+    assert(fresh[0].index == es[2].index && fresh[1].index == es[5].index);
+    assert(fresh[2].index == es[10].index && fresh[2].generation > es[10].generation);
+    for (size_t i = 10; i < es.size(); ++i)
+        assert(!w1.alive(es[i]));
+    for (World& w : loaded) {
+        for (int i = 0; i < 5; ++i)
+            assert(w.create() == fresh[i]);
+        assert(!w.alive(es[10]));
+    }
 
-    assert(w2.alive(parent));
-    assert(w2.alive(child));
-    assert(w2.has<Parent>(child));
-    assert(w2.get<Parent>(child).entity == parent);
-    assert(w2.has<Children>(parent));
-    assert(w2.get<Children>(parent).entities.size() == 1);
-    assert(w2.get<Children>(parent).entities[0] == child);
-    std::printf("  serialize with hierarchy: OK\n");
+    // Version 1 streams, which end at the free list, still load (with no floor)
+    std::string old = v1.str();
+    uint32_t version = 1;
+    std::memcpy(&old[4], &version, sizeof(version));
+    old.resize(old.size() - sizeof(uint32_t));
+    std::stringstream old_in(old);
+    World legacy;
+    deserialize(legacy, old_in);
+    assert(legacy.count() == 8 && legacy.create().index == es[2].index);
+
+    // Replication follows the shrunken entity table
+    std::stringstream delta;
+    serialize_delta(w1, baseline, delta);
+    apply_delta(w2, delta);
+    assert(w2.count() == w1.count() && w2.count() == 13);
+    const World& dst = w2;
+    for (Entity e : fresh)
+        assert(dst.alive(e) && dst.get<Position>(e).x == -1);
+    assert(dst.alive(es[9]) && dst.get<Position>(es[9]).x == 9);
+    assert(!dst.alive(es[50]));
+    Entity a = w1.create(), b = w2.create();
+    assert(a == b);
+    std::printf("  compact: OK\n");
 }
 
-void test_command_buffer_move_only() {
-    World w;
-    CommandBuffer cb;
-    cb.add(w.create_with(Position{0, 0}), std::make_unique<int>(42));
-    cb.create_with(std::make_unique<int>(99));
-    cb.flush(w);
-    assert(w.count<std::unique_ptr<int>>() == 2);
+// --- Phase 7.9: Trivially Relocatable Columns ---
+
+// Counts live instances; any double destroy or leak shows up as a nonzero balance.
+struct Tracked {
+    static inline int live = 0;
+    int value = 0;
+    Tracked* self = this; // self-reference: never relocatable bytewise
+    explicit Tracked(int v = 0) : value(v) { ++live; }
+    Tracked(Tracked&& o) noexcept : value(o.value) { ++live; }
+    Tracked(const Tracked& o) : value(o.value) { ++live; }
+    Tracked& operator=(Tracked&& o) noexcept {
+        value = o.value;
+        return *this;
+    }
+    Tracked& operator=(const Tracked& o) = default;
+    ~Tracked() {
+        assert(self == this);
+        --live;
+    }
+};
 
-    // Also test via deferred()
-    Entity e = w.create_with(Position{1, 1});
-    w.deferred().add(e, std::make_unique<int>(7));
-    w.flush_deferred();
-    assert(w.has<std::unique_ptr<int>>(e));
-    assert(*w.get<std::unique_ptr<int>>(e) == 7);
-    std::printf("  command buffer move-only: OK\n");
+// Owns heap memory but no self-references: opted in to bytewise relocation.
+struct OwnedBuffer {
+    std::unique_ptr<int> data;
+};
+template <>
+struct ecs::is_trivially_relocatable<OwnedBuffer> : std::true_type {};
+
+void test_relocatable_traits() {
+    static_assert(is_trivially_relocatable_v<Position>);
+    static_assert(!is_trivially_relocatable_v<std::string>);
+    static_assert(!is_trivially_relocatable_v<Tracked>);
+    static_assert(is_trivially_relocatable_v<OwnedBuffer>);
+    auto pos = make_column<Position>();
+    assert(pos.trivially_relocatable && pos.trivially_destructible);
+    auto owned = make_column<OwnedBuffer>();
+    assert(owned.trivially_relocatable && !owned.trivially_destructible);
+    auto str = make_column<std::string>();
+    assert(!str.trivially_relocatable && !str.trivially_destructible);
+    std::printf("  relocatable traits: OK\n");
 }
 
-void test_command_buffer_unflushed_cleanup() {
-    // Verify that unflushed commands with non-trivial types don't leak
+void test_relocation_lifetimes() {
+    {
+        World w;
+        std::vector<Entity> es;
+        for (int i = 0; i < 300; ++i) // grows the block several times
+            es.push_back(w.create_with(Tracked{i}, OwnedBuffer{std::make_unique<int>(i)},
+                                       Position{float(i), 0}));
+        assert(Tracked::live == 300);
+        for (int i = 0; i < 300; i += 2) { // migrate both ways, swap-removing each time
+            w.add(es[i], Health{i});
+            w.remove<Position>(es[i]);
+        }
+        for (int i = 0; i < 300; i += 3)
+            w.destroy(es[i]);
+        w.deferred().add(es[1], Tracked{-1});
+        w.deferred().remove<Health>(es[2]);
+        w.flush_deferred();
+        w.shrink_to_fit(1.0f);
+        const World& cw = w;
+        for (int i = 0; i < 300; ++i) {
+            if (i % 3 == 0)
+                continue;
+            assert(cw.get<Tracked>(es[i]).value == (i == 1 ? -1 : i));
+            assert(*cw.get<OwnedBuffer>(es[i]).data == i);
+            assert(cw.has<Position>(es[i]) == (i % 2 == 1));
+        }
+        assert(Tracked::live == 200);
+
+        // Prefab overrides are constructed in place
+        Prefab p = Prefab::create(Tracked{7});
+        Entity e = instantiate(w, p, Health{1});
+        assert(w.get<Tracked>(e).value == 7 && Tracked::live == 202);
+    }
+    assert(Tracked::live == 0);
+    std::printf("  relocation lifetimes: OK\n");
+}
+
+void test_command_buffer_growth_relocates() {
+    World w;
+    std::vector<Entity> es;
+    for (int i = 0; i < 500; ++i)
+        es.push_back(w.create_with(Position{}));
     {
+        // Short strings live in libstdc++'s in-object buffer; a bytewise move would leave
+        // them pointing into the old buffer
         CommandBuffer cb;
-        cb.create_with(std::string("a long string to avoid small string optimization entirely"));
-        cb.add(Entity{1, 0}, std::string("another long string to avoid SSO completely here"));
-        // cb goes out of scope without flush — destructor should clean up
+        for (int i = 0; i < 500; ++i) {
+            cb.add(es[i], std::to_string(i));
+            cb.create_with(Tracked{i}, std::string("s") + std::to_string(i));
+        }
+        cb.flush(w);
     }
-    std::printf("  command buffer unflushed cleanup: OK\n");
+    const World& cw = w;
+    for (int i = 0; i < 500; ++i)
+        assert(cw.get<std::string>(es[i]) == std::to_string(i));
+    assert((w.count<Tracked, std::string>() == 500) && Tracked::live == 500);
+    {
+        CommandBuffer cb; // destroyed unflushed after growing
+        for (int i = 0; i < 500; ++i)
+            cb.create_with(Tracked{i});
+        assert(Tracked::live == 1000);
+    }
+    assert(Tracked::live == 500);
+    w.destroy_all<Tracked>();
+    assert(Tracked::live == 0);
+    std::printf("  command buffer growth relocates: OK\n");
 }
 
-void test_serialize_unregistered_type_asserts() {
-    // Use a type that is NOT registered
-    struct Unregistered {
-        int val;
-    };
+// --- Phase 7.10: Tag Components ---
 
-    World w;
-    w.create_with(Unregistered{42});
+struct Marker {};
+struct alignas(64) AlignedMarker {};
 
-    auto old_handler = signal(SIGABRT, abort_handler);
-    bool caught = false;
+void test_tag_traits() {
+    static_assert(is_tag_component_v<Tag> && is_tag_component_v<Marker>);
+    static_assert(!is_tag_component_v<Position> && !is_tag_component_v<std::string>);
+    ComponentColumn col = make_column<Tag>();
+    assert(col.tag && col.elem_size == 0);
+    assert(!make_column<Position>().tag);
+
+    // The shared tag element is only max_align_t-aligned, so wider empty types get real rows
+    static_assert(!is_tag_component_v<AlignedMarker>);
+    World w;
+    for (int i = 0; i < 5; ++i)
+        w.create_with(Position{float(i), 0}, AlignedMarker{});
+    w.each<const AlignedMarker>([](Entity, const AlignedMarker& m) {
+        assert(reinterpret_cast<uintptr_t>(&m) % alignof(AlignedMarker) == 0);
+    });
+    std::printf("  tag traits: OK\n");
+}
+
+void test_tag_storage() {
+    {
+        // A world of tag-only entities never allocates row storage
+        CountingAllocator counting;
+        WorldConfig config;
+        config.allocator = &counting.alloc;
+        World w(config);
+        for (int i = 0; i < 1000; ++i)
+            w.create_with(Tag{}, Marker{});
+        assert((w.count<Tag, Marker>() == 1000) && counting.allocs == 0);
+    }
+    // Tags leave the row size alone
+    size_t bytes[2];
+    for (int with_tags = 0; with_tags < 2; ++with_tags) {
+        CountingAllocator counting;
+        WorldConfig config;
+        config.allocator = &counting.alloc;
+        World w(config);
+        for (int i = 0; i < 1000; ++i) {
+            if (with_tags)
+                w.create_with(Position{float(i), 0}, Tag{}, Marker{});
+            else
+                w.create_with(Position{float(i), 0});
+        }
+        bytes[with_tags] = counting.live_bytes;
+    }
+    assert(bytes[0] == bytes[1]);
+    std::printf("  tag storage: OK\n");
+}
+
+void test_tag_queries() {
+    World w;
+    std::vector<Entity> es;
+    for (int i = 0; i < 100; ++i)
+        es.push_back(w.create_with(Position{float(i), 0}, Tag{}));
+    uint32_t since = w.advance_tick();
+    w.add(w.create_with(Position{-1, 0}), Tag{});
+
+    // Every row sees the same shared instance
+    const Tag* shared = nullptr;
+    int n = 0;
+    w.each<Position, Tag>([&](Entity, Position&, Tag& t) {
+        assert(!shared || &t == shared);
+        shared = &t;
+        ++n;
+    });
+    assert(n == 101 && shared);
+    n = 0;
+    w.each<const Position>(World::Added<Tag>{since}, [&](Entity, const Position& p) {
+        assert(p.x == -1);
+        ++n;
+    });
+    assert(n == 1);
+    w.remove<Tag>(es[3]);
+    assert(!w.has<Tag>(es[3]) && w.has<Tag>(es[4]) && w.count<Tag>() == 100);
+    w.destroy_all<Tag>();
+    assert(w.count() == 1 && w.count<Position>() == 1);
+    std::printf("  tag queries: OK\n");
+}
+
+void test_tag_serialization() {
+    register_component<Position>("Position");
+    register_component<Tag>("Tag");
+    World w1;
+    std::vector<Entity> es;
+    for (int i = 0; i < 50; ++i)
+        es.push_back(w1.create_with(Position{float(i), 0}, Tag{}));
+    es.push_back(w1.create_with(Tag{}));
+
+    std::stringstream v1, snap, stream;
+    serialize(w1, v1);
+    serialize_snapshot(w1, snap);
+    serialize_stream(w1, stream);
+    std::string snap_bytes = snap.str();
+    World a, b, c;
+    deserialize(a, v1);
+    deserialize_snapshot(b, snap_bytes.data(), snap_bytes.size());
+    deserialize_stream(c, stream);
+    for (World* w : {&a, &b, &c}) {
+        const World& cw = *w;
+        assert((w->count<Position, Tag>() == 50) && w->count<Tag>() == 51);
+        for (int i = 0; i < 50; ++i)
+            assert(cw.has<Tag>(es[i]) && cw.get<Position>(es[i]).x == float(i));
+    }
+
+    // Deltas carry tag membership through the archetype, not through changed rows
+    uint32_t baseline = w1.advance_tick();
+    w1.remove<Tag>(es[0]);
+    w1.add(es[1], Marker{});
+    w1.get<Position>(es[2]).x = 100;
+    register_component<Marker>("Marker");
+    std::stringstream delta;
+    serialize_delta(w1, baseline, delta);
+    apply_delta(b, delta);
+    const World& cb = b;
+    assert(!cb.has<Tag>(es[0]) && cb.has<Position>(es[0]));
+    assert(cb.has<Marker>(es[1]) && cb.has<Tag>(es[1]) && cb.get<Position>(es[1]).x == 1);
+    assert(cb.get<Position>(es[2]).x == 100 && b.count<Tag>() == 50);
+    std::printf("  tag serialization: OK\n");
+}
+
+// --- Phase 7.11: Sparse Components ---
+
+struct Target {
+    Entity who;
+};
+struct Stunned {};
+struct Timer {
+    Tracked t;
+};
+template <>
+struct ecs::is_sparse_component<Target> : std::true_type {};
+template <>
+struct ecs::is_sparse_component<Stunned> : std::true_type {};
+template <>
+struct ecs::is_sparse_component<Timer> : std::true_type {};
+
+void test_sparse_add_remove() {
+    static_assert(is_sparse_component_v<Target> && is_sparse_component_v<const Target>);
+    static_assert(!is_sparse_component_v<Position>);
+    {
+        World w;
+        Entity e = w.create_with(Position{1, 2}, Velocity{3, 4});
+        size_t archetypes = w.archetype_count();
+        int added = 0, removed = 0;
+        w.on_add<Target>([&](World&, Entity, Target&) { ++added; });
+        w.on_remove<Target>([&](World&, Entity, Target& t) {
+            assert(t.who.index == 7);
+            ++removed;
+        });
+
+        // Toggling never migrates: no archetype is created and the row stays put
+        for (int i = 0; i < 3; ++i) {
+            w.add(e, Target{Entity{7, 0}});
+            w.add(e, Stunned{});
+            assert(w.has<Target>(e) && w.has<Stunned>(e) && w.get<Target>(e).who.index == 7);
+            w.remove<Target>(e);
+            w.remove<Stunned>(e);
+            assert(!w.has<Target>(e) && w.try_get<Target>(e) == nullptr);
+        }
+        assert(w.archetype_count() == archetypes && added == 3 && removed == 3);
+        assert(w.get<Position>(e).x == 1 && w.get<Velocity>(e).dy == 4);
+
+        // Overwrite keeps one value, without a second on_add
+        w.add(e, Target{Entity{7, 0}});
+        w.add(e, Target{Entity{7, 1}});
+        assert(added == 4 && w.get<Target>(e).who.generation == 1);
+        w.destroy(e);
+        assert(removed == 4 && !w.has<Target>(e));
+
+        Entity f = w.create_with(Target{Entity{7, 0}}, Position{0, 0});
+        assert(w.has<Target>(f) && w.count<Position>() == 1 && w.count<Target>() == 1);
+    }
+    {
+        // Non-relocatable values survive swap-removal and are destroyed exactly once
+        World w;
+        std::vector<Entity> es;
+        for (int i = 0; i < 600; ++i) {
+            es.push_back(w.create_with(Position{float(i), 0}));
+            w.add(es.back(), Timer{Tracked(i)});
+        }
+        for (int i = 0; i < 600; i += 2)
+            w.remove<Timer>(es[i]);
+        for (int i = 1; i < 600; i += 2)
+            assert(w.get<Timer>(es[i]).t.value == i);
+        assert(Tracked::live == 300 && w.destroy_all<Timer>() == 300);
+        assert(Tracked::live == 0 && w.count() == 300);
+        w.add(es[0], Timer{Tracked(1)});
+    }
+    assert(Tracked::live == 0);
+    std::printf("  sparse add/remove: OK\n");
+}
+
+void test_sparse_queries() {
+    World w;
+    std::vector<Entity> es;
+    for (int i = 0; i < 100; ++i)
+        es.push_back(i % 2 ? w.create_with(Position{float(i), 0}, Velocity{1, 0})
+                           : w.create_with(Position{float(i), 0}));
+    for (int i = 0; i < 100; i += 3)
+        w.add(es[i], Target{es[i]});
+    w.add(es[1], Stunned{});
+
+    int n = 0;
+    w.each<Position, Target>([&](Entity e, Position& p, Target& t) {
+        assert(t.who == e && int(p.x) % 3 == 0);
+        ++n;
+    });
+    assert(n == 34 && (w.count<Position, Target>()) == 34 && w.count<Target>() == 34);
+
+    // Archetype terms narrow the sparse driver
+    n = 0;
+    w.each_no_entity<const Velocity, const Target>([&](const Velocity&, const Target& t) {
+        assert(t.who.index % 2 == es[1].index % 2);
+        ++n;
+    });
+    assert(n == 17 && (w.count<Velocity, Target>()) == 17);
+
+    // Sparse excludes, with and without a sparse include
+    n = 0;
+    w.each<Position>(World::Exclude<Target>{}, [&](Entity, Position& p) {
+        assert(int(p.x) % 3 != 0);
+        ++n;
+    });
+    assert(n == 66);
+    n = 0;
+    w.each<Target>(World::Exclude<Velocity, Stunned>{}, [&](Entity, Target&) { ++n; });
+    assert(n == 17);
+    assert((w.count<Position, Stunned>()) == 1 && (w.count<Position, Timer>()) == 0);
+
+    w.get<Target>(es[3]).who = es[4];
+    const World& cw = w;
+    assert(cw.get<Target>(es[3]).who == es[4]);
+    std::printf("  sparse queries: OK\n");
+}
+
+void test_sparse_deferred_and_prefabs() {
+    World w;
+    Entity a = w.create_with(Position{1, 0});
+    Entity b = w.create_with(Position{2, 0});
+    w.deferred().add(a, Target{b});
+    w.deferred().add(b, Target{a});
+    w.deferred().add(b, Timer{Tracked(5)});
+    w.deferred().create_with(Position{3, 0}, Target{a});
+    w.flush_deferred();
+    assert(w.get<Target>(a).who == b && w.get<Target>(b).who == a);
+    assert(w.get<Timer>(b).t.value == 5 && (w.count<Position, Target>()) == 3);
+
+    CommandBuffer cmds;
+    cmds.remove<Target>(a);
+    cmds.remove<Target>(b);
+    cmds.add(a, Stunned{});
+    cmds.add(b, Stunned{});
+    cmds.destroy(b);
+    cmds.flush_batched(w);
+    assert(!w.has<Target>(a) && w.has<Stunned>(a) && !w.alive(b));
+    assert(w.count<Target>() == 1 && w.count<Stunned>() == 1 && Tracked::live == 0);
+
+    Prefab enemy = Prefab::create(Position{0, 0}, Target{a});
+    Entity x = instantiate(w, enemy);
+    Entity y = instantiate(w, enemy, Target{x}, Stunned{});
+    assert(w.get<Target>(x).who == a && w.get<Target>(y).who == x && w.has<Stunned>(y));
+    assert(w.has<Position>(y) && !w.has<Stunned>(x));
+    std::printf("  sparse deferred and prefabs: OK\n");
+}
+
+void test_sparse_serialize_assert() {
+    World w;
+    Entity e = w.create_with(Position{1, 2});
+    w.add(e, Target{e});
+
+    auto old_handler = signal(SIGABRT, abort_handler);
+    bool caught = false;
+    if (sigsetjmp(jump_buf, 1) == 0) {
+        std::stringstream ss;
+        serialize(w, ss);
+    } else {
+        caught = true;
+    }
+    signal(SIGABRT, old_handler);
+    assert(caught);
+
+    // Once the values are gone the world serializes again
+    w.remove<Target>(e);
+    std::stringstream ss;
+    serialize(w, ss);
+    std::printf("  sparse serialize assert: OK\n");
+}
+
+// --- Phase 7.12: Maintained Order ---
+
+// Checks that each archetype holding Depth is ordered by z and that records match rows.
+static bool depth_ordered(World& w) {
+    bool ok = true;
+    auto check = [&](Entity e, const Depth& d, float& prev) {
+        ok = ok && d.z >= prev && &w.get<Depth>(e) == &d;
+        prev = d.z;
+    };
+    float prev = -1e30f;
+    w.each<const Depth>(World::Exclude<Position>{}, [&](Entity e, const Depth& d) { check(e, d, prev); });
+    prev = -1e30f;
+    w.each<const Depth, const Position>(
+        [&](Entity e, const Depth& d, const Position&) { check(e, d, prev); });
+    return ok;
+}
+
+void test_order_by_incremental() {
+    for (StorageMode mode : {StorageMode::Block, StorageMode::Chunked}) {
+        World w(WorldConfig{mode, 1024});
+        std::vector<Entity> es;
+        uint32_t seed = 12345;
+        auto rnd = [&] {
+            seed = seed * 1664525u + 1013904223u;
+            return float(seed >> 8) / float(1u << 24);
+        };
+        for (int i = 0; i < 2000; ++i)
+            es.push_back(i % 4 ? w.create_with(Depth{rnd()}, Position{float(i), 0})
+                               : w.create_with(Depth{rnd()}));
+        w.order_by<Depth>([](const Depth& d) { return d.z; });
+        assert(depth_ordered(w) && w.refresh_order() == 0);
+
+        // One key change moves the rows between its old and new place, not the archetype
+        w.get<Depth>(es[1]).z = -1.0f;
+        size_t moved = w.refresh_order();
+        assert(depth_ordered(w) && moved > 0 && moved < 1500);
+
+        // Creation, destruction (swap-removal), migration and key writes
+        for (int i = 0; i < 50; ++i)
+            es.push_back(w.create_with(Depth{rnd()}, Position{0, 0}));
+        for (int i = 0; i < 2000; i += 37)
+            w.destroy(es[i]);
+        for (int i = 4; i < 400; i += 40)
+            w.add(es[i], Position{1, 1});
+        for (int i = 3; i < 2000; i += 101)
+            if (w.alive(es[i]))
+                w.get<Depth>(es[i]).z = rnd();
+        w.refresh_order();
+        assert(depth_ordered(w) && w.refresh_order() == 0);
+        for (Entity e : es)
+            assert(!w.alive(e) || w.get<Depth>(e).z >= -1.0f);
+
+        // sort<T> applies its permutation the same way
+        w.sort<Depth>([](const Depth& a, const Depth& b) { return a.z > b.z; });
+        w.refresh_order();
+        assert(depth_ordered(w));
+    }
+    std::printf("  order_by incremental: OK\n");
+}
+
+void test_order_by_skips_clean_archetypes() {
+    World w;
+    int calls = 0;
+    for (int i = 0; i < 100; ++i)
+        w.create_with(Depth{float(100 - i)});
+    w.order_by<Depth>([&](const Depth& d) {
+        ++calls;
+        return d.z;
+    });
+    assert(depth_ordered(w));
+
+    // No writes and no structural change since the last refresh's tick: keys are not read.
+    // The first refresh in a new tick still checks, as writes may have followed the last one.
+    w.advance_tick();
+    assert(w.refresh_order() == 0 && calls > 0);
+    w.advance_tick();
+    calls = 0;
+    assert(w.refresh_order() == 0 && calls == 0);
+    // Read-only iteration leaves the archetype clean; a write does not
+    w.each<const Depth>([](Entity, const Depth&) {});
+    assert(w.refresh_order() == 0 && calls == 0);
+    w.advance_tick();
+    w.each<Depth>([](Entity, Depth& d) { d.z = -d.z; });
+    assert(w.refresh_order() > 0 && calls > 0 && depth_ordered(w));
+
+    // Tuple keys; registering again replaces the key; clear_order stops maintenance
+    struct RenderKey {
+        int material;
+        float depth;
+    };
+    World m;
+    std::vector<Entity> keyed;
+    for (int i = 0; i < 64; ++i)
+        keyed.push_back(m.create_with(RenderKey{i % 3, float(i % 7)}));
+    m.order_by<RenderKey>([](const RenderKey& k) { return std::make_tuple(k.material, k.depth); });
+    const RenderKey* prev = nullptr;
+    m.each<const RenderKey>([&](Entity, const RenderKey& k) {
+        assert(!prev || prev->material < k.material ||
+               (prev->material == k.material && prev->depth <= k.depth));
+        prev = &k;
+    });
+    m.order_by<RenderKey>([](const RenderKey& k) { return -k.depth; });
+    prev = nullptr;
+    m.each<const RenderKey>([&](Entity, const RenderKey& k) {
+        assert(!prev || prev->depth >= k.depth);
+        prev = &k;
+    });
+    m.clear_order<RenderKey>();
+    m.get<RenderKey>(keyed[0]).depth = 1000;
+    assert(m.refresh_order() == 0);
+    std::printf("  order_by skips clean archetypes: OK\n");
+}
+
+void test_order_by_non_relocatable() {
+    {
+        World w;
+        std::vector<Entity> es;
+        for (int i = 0; i < 300; ++i)
+            es.push_back(w.create_with(Tracked((i * 7919) % 300), Position{float(i), 0}));
+        w.order_by<Tracked>([](const Tracked& t) { return t.value; });
+        int prev = -1;
+        w.each<const Tracked>([&](Entity, const Tracked& t) {
+            assert(t.value > prev && t.self == &t);
+            prev = t.value;
+        });
+        for (int i = 0; i < 300; i += 3)
+            w.destroy(es[i]);
+        w.refresh_order();
+        prev = -1;
+        w.each<const Tracked, const Position>([&](Entity e, const Tracked& t, const Position& p) {
+            assert(t.value > prev && (int(p.x) * 7919) % 300 == t.value);
+            assert(&w.get<Tracked>(e) == &t);
+            prev = t.value;
+        });
+        assert(Tracked::live == 200);
+    }
+    assert(Tracked::live == 0);
+    std::printf("  order_by non-relocatable: OK\n");
+}
+
+// --- Phase 7.13: Batched Observers ---
+
+void test_observer_batches() {
+    for (StorageMode mode : {StorageMode::Block, StorageMode::Chunked}) {
+        World w(WorldConfig{mode, 1024});
+        int calls = 0;
+        std::vector<Entity> seen;
+        w.on_add_batch<Position>([&](World& world, Span<const Entity> es, Position* values) {
+            ++calls;
+            for (size_t i = 0; i < es.size(); ++i) {
+                assert(&world.get<Position>(es[i]) == &values[i]);
+                seen.push_back(es[i]);
+            }
+        });
+
+        // One call per contiguous run: one for block storage, one per chunk otherwise
+        auto created = w.create_n(300, Position{1, 2});
+        assert(seen.size() == 300 && std::equal(seen.begin(), seen.end(), created.begin()));
+        assert(mode == StorageMode::Block ? calls == 1 : calls > 1);
+
+        // Single-entity operations deliver spans of one
+        calls = 0;
+        seen.clear();
+        Entity a = w.create_with(Position{0, 0}, Velocity{0, 0});
+        Entity b = w.create();
+        w.add(b, Position{5, 5});
+        assert(calls == 2 && seen.size() == 2 && seen[0] == a && seen[1] == b);
+
+        // flush_batched delivers one run per target archetype
+        std::vector<Entity> plain, moving;
+        for (int i = 0; i < 40; ++i) {
+            plain.push_back(w.create());
+            moving.push_back(w.create_with(Velocity{1, 1}));
+        }
+        calls = 0;
+        seen.clear();
+        CommandBuffer cmds;
+        for (int i = 0; i < 40; ++i) {
+            cmds.add(plain[i], Position{float(i), 0});
+            cmds.add(moving[i], Position{float(i), 1});
+        }
+        cmds.flush_batched(w);
+        assert(seen.size() == 80 && (mode == StorageMode::Block ? calls == 2 : calls >= 2));
+
+        // destroy_all hands over every row before any is destroyed
+        size_t removed = 0;
+        w.on_remove_batch<Position>([&](World& world, Span<const Entity> es, Position* values) {
+            for (size_t i = 0; i < es.size(); ++i)
+                assert(world.alive(es[i]) && &world.get<Position>(es[i]) == &values[i]);
+            removed += es.size();
+        });
+        size_t total = w.count<Position>();
+        assert(w.destroy_all<Position>() == total && removed == total);
+    }
+    std::printf("  observer batches: OK\n");
+}
+
+void test_observer_batch_structural_assert() {
+    World w;
+    w.on_add_batch<Position>([](World& world, Span<const Entity> es, Position*) {
+        world.destroy(es[0]);
+    });
+    auto old_handler = signal(SIGABRT, abort_handler);
+    bool caught = false;
+    if (sigsetjmp(jump_buf, 1) == 0) {
+        w.create_with(Position{0, 0});
+    } else {
+        caught = true;
+    }
+    signal(SIGABRT, old_handler);
+    assert(caught);
+
+    // The supported route: defer the change
+    World d;
+    d.on_add_batch<Position>([](World& world, Span<const Entity> es, Position*) {
+        for (Entity e : es)
+            world.deferred().add(e, Velocity{1, 1});
+    });
+    d.create_n(10, Position{0, 0});
+    d.flush_deferred();
+    assert((d.count<Position, Velocity>() == 10));
+    std::printf("  observer batch structural assert: OK\n");
+}
+
+void test_observer_queues() {
+    World w;
+    w.queue_on_add<Velocity>();
+    w.queue_on_remove<Velocity>();
+    int hook_calls = 0;
+    w.on_add<Velocity>([&](World&, Entity, Velocity&) { ++hook_calls; });
+
+    Entity a = w.create_with(Position{0, 0}, Velocity{1, 0});
+    Entity b = w.create_with(Position{0, 0});
+    w.add(b, Velocity{2, 0});
+    w.add(b, Velocity{3, 0}); // overwrite: no event
+    w.remove<Velocity>(a);
+    w.destroy(b);
+    assert(hook_calls == 2);
+
+    std::vector<Entity> added, removed;
+    size_t n = w.drain_added<Velocity>([&](World&, Span<const Entity> es) {
+        added.assign(es.begin(), es.end());
+    });
+    w.drain_removed<Velocity>([&](World&, Span<const Entity> es) {
+        removed.assign(es.begin(), es.end());
+    });
+    assert(n == 2 && added.size() == 2 && added[0] == a && added[1] == b);
+    assert(removed.size() == 2 && removed[0] == a && removed[1] == b);
+    assert(w.drain_added<Velocity>([](World&, Span<const Entity>) { assert(false); }) == 0);
+
+    // Events raised while draining go to the next drain
+    w.create_n(5, Velocity{0, 0});
+    n = w.drain_added<Velocity>([&](World& world, Span<const Entity> es) {
+        assert(es.size() == 5);
+        world.create_with(Velocity{9, 9});
+    });
+    assert(n == 5);
+    assert(w.drain_added<Velocity>([](World&, Span<const Entity> es) {
+        assert(es.size() == 1);
+    }) == 1);
+
+    // Unobserved types never touch the observer tables
+    w.create_with(Position{1, 1});
+    assert(w.drain_added<Position>([](World&, Span<const Entity>) { assert(false); }) == 0);
+    std::printf("  observer queues: OK\n");
+}
+
+// --- Phase 7.14: Value Indexes ---
+
+struct NetId {
+    uint64_t value;
+};
+struct Team {
+    int id;
+};
+struct IdProbeA {};
+struct IdProbeB {};
+
+void test_value_index_unique() {
+    World w;
+    Entity early = w.create_with(NetId{1}, Position{0, 0});
+    w.index_by<NetId>(&NetId::value); // built from existing entities
+    assert(w.find_by<NetId>(uint64_t{1}) == early);
+    assert(w.find_by<NetId>(uint64_t{99}) == INVALID_ENTITY);
+
+    // create, create_n, add, migration and prefabs keep it current
+    Entity a = w.create_with(NetId{2});
+    Entity d = w.create_n(1, NetId{100})[0]; // a unique index allows one entity per key
+    Entity b = w.create();
+    w.add(b, NetId{3});
+    w.add(b, Velocity{1, 1}); // migrates; the key stays
+    Entity c = instantiate(w, Prefab::create(Position{0, 0}), NetId{4});
+    assert(w.find_by<NetId>(uint64_t{2}) == a && w.find_by<NetId>(uint64_t{3}) == b);
+    assert(w.find_by<NetId>(uint64_t{4}) == c && w.find_by<NetId>(uint64_t{100}) == d);
+
+    // add<T> overwrite re-keys; remove and destroy drop the entry
+    w.add(a, NetId{20});
+    assert(w.find_by<NetId>(uint64_t{2}) == INVALID_ENTITY && w.find_by<NetId>(uint64_t{20}) == a);
+    w.remove<NetId>(b);
+    w.destroy(c);
+    assert(w.find_by<NetId>(uint64_t{3}) == INVALID_ENTITY);
+    assert(w.find_by<NetId>(uint64_t{4}) == INVALID_ENTITY);
+    Span<const Entity> one = w.find_all_by<NetId>(uint64_t{20});
+    assert(one.size() == 1 && one[0] == a && w.find_all_by<NetId>(uint64_t{3}).size() == 0);
+
+    // Deferred and batched flushes
+    CommandBuffer cmds;
+    cmds.add(b, NetId{30});
+    cmds.remove<NetId>(d);
+    cmds.flush_batched(w);
+    assert(w.find_by<NetId>(uint64_t{30}) == b && w.find_by<NetId>(uint64_t{100}) == INVALID_ENTITY);
+
+    // In-place writes need reindex
+    w.get<NetId>(a).value = 21;
+    w.reindex<NetId>();
+    assert(w.find_by<NetId>(uint64_t{20}) == INVALID_ENTITY && w.find_by<NetId>(uint64_t{21}) == a);
+
+    w.destroy_all<NetId>();
+    assert(w.find_by<NetId>(uint64_t{21}) == INVALID_ENTITY);
+    assert(w.find_by<NetId>(uint64_t{1}) == INVALID_ENTITY);
+    std::printf("  value index unique: OK\n");
+}
+
+void test_value_index_grouped() {
+    World w;
+    w.index_by<Team>(&Team::id, IndexKind::Grouped);
+    auto red_span = w.create_n(50, Team{1}, Position{0, 0});
+    std::vector<Entity> reds(red_span.begin(), red_span.end());
+    auto blues = w.create_n(20, Team{2});
+    assert(w.find_all_by<Team>(1).size() == 50 && w.find_all_by<Team>(2).size() == 20);
+    assert(w.get<Team>(w.find_by<Team>(2)).id == 2 && w.find_all_by<Team>(3).size() == 0);
+
+    for (int i = 0; i < 10; ++i)
+        w.add(reds[i], Team{2});
+    w.destroy(blues[0]);
+    Span<const Entity> team2 = w.find_all_by<Team>(2);
+    assert(team2.size() == 29 && w.find_all_by<Team>(1).size() == 40);
+    for (Entity e : team2)
+        assert(w.get<Team>(e).id == 2);
+
+    // An observer sees the index already updated for its event
+    bool indexed = false;
+    w.on_add<Team>([&](World& world, Entity e, Team& t) {
+        Span<const Entity> es = world.find_all_by<Team>(t.id);
+        indexed = std::find(es.begin(), es.end(), e) != es.end();
+    });
+    w.create_with(Team{5});
+    assert(indexed);
+
+    // Sparse components are indexed too
+    Entity boss = w.create();
+    w.index_by<Target>([](const Target& t) { return t.who.index; }, IndexKind::Grouped);
+    Entity x = w.create_with(Target{boss});
+    Entity y = w.create_with(Target{boss}, Position{0, 0});
+    assert(w.find_all_by<Target>(boss.index).size() == 2);
+    w.remove<Target>(x);
+    assert(w.find_all_by<Target>(boss.index).size() == 1 && w.find_by<Target>(boss.index) == y);
+    w.destroy(y);
+    assert(w.find_by<Target>(boss.index) == INVALID_ENTITY);
+    std::printf("  value index grouped: OK\n");
+}
+
+void test_value_index_loads() {
+    register_component<NetId>("NetId");
+    World src;
+    std::vector<Entity> es;
+    for (uint64_t i = 0; i < 100; ++i)
+        es.push_back(src.create_with(NetId{i * 7}));
+    std::stringstream v1, stream;
+    serialize(src, v1);
+    serialize_stream(src, stream);
+
+    World a, b;
+    a.index_by<NetId>(&NetId::value);
+    b.index_by<NetId>(&NetId::value);
+    deserialize(a, v1);
+    deserialize_stream(b, stream);
+    for (uint64_t i = 0; i < 100; ++i)
+        assert(a.find_by<NetId>(i * 7) == es[i] && b.find_by<NetId>(i * 7) == es[i]);
+    std::printf("  value index loads: OK\n");
+}
+
+void test_value_index_asserts() {
+    World w;
+    w.index_by<NetId>(&NetId::value);
+    w.create_with(NetId{1});
+    auto old_handler = signal(SIGABRT, abort_handler);
+    bool duplicate = false, key_type = false, missing = false;
+    if (sigsetjmp(jump_buf, 1) == 0)
+        w.create_with(NetId{1});
+    else
+        duplicate = true;
+    if (sigsetjmp(jump_buf, 1) == 0)
+        w.find_by<NetId>(1); // int, not uint64_t
+    else
+        key_type = true;
+    if (sigsetjmp(jump_buf, 1) == 0)
+        w.find_by<Position>(1.0f);
+    else
+        missing = true;
+    signal(SIGABRT, old_handler);
+    assert(duplicate && key_type && missing);
+
+    // Key types are told apart by a static tag, so they take no component ID
+    component_id<Team>();
+    ComponentTypeID before = component_id<IdProbeA>();
+    w.index_by<Team>([](const Team& t) { return char16_t(t.id); }, IndexKind::Grouped);
+    w.create_with(Team{4});
+    assert(w.find_by<Team>(char16_t(4)) != INVALID_ENTITY);
+    assert(component_id<IdProbeB>() == before + 1);
+    std::printf("  value index asserts: OK\n");
+}
+
+// --- Phase 7.15: Persistent Queries ---
+
+void test_query_handle_each() {
+    World w;
+    Query<Position, const Velocity> moving = w.query<Position, const Velocity>(World::Exclude<Tag>{});
+    Query<Position> empty;
+    assert(moving.valid() && !empty.valid() && moving.count() == 0);
+
+    // Archetypes created after the query are picked up
+    for (int i = 0; i < 10; ++i)
+        w.create_with(Position{0, 0}, Velocity{1, 2});
+    w.create_with(Position{0, 0}, Velocity{1, 2}, Health{3});
+    w.create_with(Position{0, 0}, Velocity{1, 2}, Tag{});
+    w.create_with(Position{0, 0});
+    assert(moving.count() == 11 && moving.archetype_count() == 2);
+
+    uint32_t since = w.advance_tick();
+    int visited = 0;
+    moving.each([&](Entity e, Position& p, const Velocity& v) {
+        p.x += v.dx;
+        assert(!w.has<Tag>(e));
+        ++visited;
+    });
+    moving.each_no_entity([](Position& p, const Velocity& v) { p.y += v.dy; });
+    assert(visited == 11);
+    // Same change stamping as World::each: Position written, Velocity read-only
+    int changed_pos = 0, changed_vel = 0;
+    w.each<const Position>(World::Changed<Position>{since},
+                           [&](Entity, const Position&) { ++changed_pos; });
+    w.each<const Velocity>(World::Changed<Velocity>{since},
+                           [&](Entity, const Velocity&) { ++changed_vel; });
+    assert(changed_pos == 11 && changed_vel == 0);
+    w.each<const Position, const Velocity>(World::Exclude<Tag>{},
+                                           [](Entity, const Position& p, const Velocity&) {
+                                               assert(p.x == 1 && p.y == 2);
+                                           });
+
+    // Equal queries share their state; deleted archetypes leave it, recreated ones rejoin
+    auto again = w.query<Position, const Velocity>(World::Exclude<Tag>{});
+    assert(again.archetype_count() == moving.archetype_count());
+    w.destroy_all<Health>();
+    w.compact();
+    assert(moving.archetype_count() == 1 && moving.count() == 10);
+    w.create_with(Position{0, 0}, Velocity{0, 0}, Health{1});
+    assert(moving.archetype_count() == 2 && again.count() == 11);
+    std::printf("  query handle each: OK\n");
+}
+
+void test_query_handle_chunks_and_par() {
+    World w(WorldConfig{StorageMode::Chunked, 1024});
+    auto q = w.query<Position, Velocity>();
+    auto es = w.create_n(1000, Position{1, 0}, Velocity{2, 0});
+    std::vector<Entity> created(es.begin(), es.end());
+
+    size_t runs = 0, rows = 0;
+    q.each_chunk([&](Span<const Entity> entities, Position* p, Velocity* v) {
+        for (size_t i = 0; i < entities.size(); ++i) {
+            assert(&w.get<Position>(entities[i]) == &p[i]);
+            p[i].x += v[i].dx;
+        }
+        ++runs;
+        rows += entities.size();
+    });
+    assert(rows == 1000 && runs > 1);
+
+    ThreadPool pool(4);
+    std::atomic<int> visited{0};
+    q.par_each(pool, [&](Entity, Position& p, Velocity&) {
+        p.y = p.x;
+        ++visited;
+    });
+    q.par_each_no_entity(pool, [&](Position&, Velocity&) { ++visited; });
+    assert(visited == 2000);
+    for (Entity e : created)
+        assert(w.get<Position>(e).y == 3);
+
+    // Structural changes inside a query loop assert, as for World::each
+    auto old_handler = signal(SIGABRT, abort_handler);
+    bool caught = false;
+    if (sigsetjmp(jump_buf, 1) == 0)
+        q.each([&](Entity, Position&, Velocity&) { w.create(); });
+    else
+        caught = true;
+    signal(SIGABRT, old_handler);
+    assert(caught);
+    std::printf("  query handle chunks and par: OK\n");
+}
+
+// --- Phase 7.16: Constant-Time Column Lookup ---
+
+// Builds `arch`'s columns the way the World does: sorted by ID, then indexed
+template <typename... Ts>
+static void build_columns(Archetype& arch) {
+    std::vector<std::pair<ComponentTypeID, ComponentColumn>> cols;
+    (cols.emplace_back(component_id<Ts>(), make_column<Ts>()), ...);
+    std::sort(cols.begin(), cols.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (auto& col : cols) {
+        arch.type_set.push_back(col.first);
+        arch.component_bits.set(col.first);
+        arch.columns.push_back(std::move(col));
+    }
+    arch.index_columns();
+}
+
+template <size_t... Ns>
+static Entity create_wide(World& w, std::index_sequence<Ns...>) {
+    return w.create_with(Wide<Ns>{int(Ns)}...);
+}
+
+template <size_t... Ns>
+static bool wide_values_intact(World& w, Entity e, std::index_sequence<Ns...>) {
+    const World& reader = w;
+    return ((Ns == 5 || reader.get<Wide<Ns>>(e).v == int(Ns)) && ...);
+}
+
+void test_column_slot_lookup() {
+    register_wide(std::make_index_sequence<300>{});
+
+    // IDs scattered over the inline words and the overflow words of the mask
+    Archetype arch;
+    build_columns<Wide<0>, Wide<5>, Wide<70>, Wide<130>, Wide<200>, Wide<255>, Wide<260>,
+                  Wide<299>, Position>(arch);
+    for (size_t i = 0; i < arch.columns.size(); ++i) {
+        ComponentTypeID cid = arch.columns[i].first;
+        assert(arch.column_slot(cid) == i && arch.find_column(cid) == &arch.columns[i].second);
+    }
+    for (ComponentTypeID absent : {component_id<Wide<1>>(), component_id<Wide<298>>(),
+                                   component_id<Velocity>(), ComponentTypeID(100000)}) {
+        assert(arch.column_slot(absent) == Archetype::NO_SLOT);
+        assert(arch.find_column(absent) == nullptr);
+    }
+    Archetype moved(std::move(arch)); // the table moves with the columns
+    ComponentTypeID high = component_id<Wide<260>>();
+    size_t slot = moved.column_slot(high);
+    assert(slot != Archetype::NO_SLOT && moved.columns[slot].first == high);
+    assert(moved.find_column(high) == &moved.columns[slot].second);
+
+    // Columns filled by hand without index_columns() assert instead of reporting no columns
+    Archetype unindexed;
+    unindexed.columns.emplace_back(component_id<Position>(), make_column<Position>());
+    auto old_handler = signal(SIGABRT, abort_handler);
+    bool caught = false;
+    if (sigsetjmp(jump_buf, 1) == 0)
+        unindexed.find_column(component_id<Position>());
+    else
+        caught = true;
+    signal(SIGABRT, old_handler);
+    assert(caught && Archetype().column_slot(component_id<Position>()) == Archetype::NO_SLOT);
+
+    // A 24-component entity through get, migrations and the count cache
+    World w;
+    assert(w.count() == 0 && w.count<Wide<3>>() == 0);
+    Entity e = create_wide(w, std::make_index_sequence<24>{});
+    assert(w.count() == 1 && (w.count<Wide<3>, Wide<17>>() == 1));
+    w.add(e, Wide<299>{299});
+    w.remove<Wide<5>>(e);
+    assert(wide_values_intact(w, e, std::make_index_sequence<24>{}));
+    assert(w.get<Wide<299>>(e).v == 299 && !w.has<Wide<5>>(e) && w.try_get<Wide<5>>(e) == nullptr);
+
+    // Archetypes created after a count was cached are counted, and so are empty entities
+    for (int i = 0; i < 3; ++i)
+        w.create_with(Position{float(i), 0}, Wide<3>{3});
+    Entity bare = w.create();
+    assert(w.count() == 5 && w.count<Wide<3>>() == 4 && (w.count<Wide<3>, Wide<17>>() == 1));
+    w.destroy(e);
+    w.destroy(bare);
+    w.compact();
+    assert(w.count() == 3 && w.count<Wide<3>>() == 3 && (w.count<Wide<3>, Wide<17>>() == 0));
+    w.create_with(Wide<17>{1}, Wide<3>{2});
+    assert(w.count() == 4 && (w.count<Wide<3>, Wide<17>>() == 1));
+
+    std::printf("  column slot lookup and cached counts: OK\n");
+}
+
+// --- Phase 7.17: Column Alignment and Split Components ---
+
+struct Mass {
+    float m;
+};
+template <>
+struct ecs::column_alignment<Mass> : std::integral_constant<size_t, 64> {};
+
+struct alignas(32) Packet {
+    float v[3];
+};
+
+struct Particle3 {
+    float x, y, z;
+};
+template <>
+struct ecs::split_fields<Particle3>
+    : ecs::fields<&Particle3::x, &Particle3::y, &Particle3::z> {};
+
+// A split type with mixed field types; `pad` is not listed, so it is not stored
+struct Body {
+    float mass;
+    int pad;
+    int32_t cell;
+};
+template <>
+struct ecs::split_fields<Body> : ecs::fields<&Body::mass, &Body::cell> {};
+
+static bool aligned_to(const void* p, size_t align) {
+    return reinterpret_cast<uintptr_t>(p) % align == 0;
+}
+
+void test_column_alignment() {
+    static_assert(column_alignment_v<Mass> == 64 && column_alignment_v<const Mass> == 64);
+    static_assert(column_alignment_v<Position> == 0);
+    static_assert(column_alignment_v<Lane<Particle3, 1>> == 64);
+    assert(make_column<Mass>().alignment == 64);
+    assert(make_column<Packet>().alignment == 32);
+    assert(make_column<Position>().alignment == alignof(Position));
+
+    for (StorageMode mode : {StorageMode::Block, StorageMode::Chunked}) {
+        World w(WorldConfig{mode, 1024});
+        // Odd-sized neighbours so unaligned offsets would show up; one entity at a time so
+        // block storage relocates several times
+        std::vector<Entity> es;
+        for (int i = 0; i < 1000; ++i) {
+            es.push_back(w.create_with(Health{i}, Mass{float(i)}, Packet{{float(i), 0, 0}}));
+            if (i % 3 == 0)
+                w.add(es.back(), Position{float(i), 1});
+        }
+        // Every run starts aligned: whole columns in block storage, each chunk when chunked
+        auto check_runs = [&](size_t expected_rows) {
+            size_t runs = 0, rows = 0;
+            w.query<const Mass, const Packet>().each_chunk(
+                [&](Span<const Entity> entities, const Mass* m, const Packet* p) {
+                    assert(aligned_to(m, 64) && aligned_to(p, 32));
+                    for (size_t i = 0; i < entities.size(); ++i) {
+                        assert(m[i].m == p[i].v[0]);
+                        assert(size_t(m[i].m) < es.size() && es[size_t(m[i].m)] == entities[i]);
+                    }
+                    ++runs;
+                    rows += entities.size();
+                });
+            assert(rows == expected_rows && (mode == StorageMode::Chunked || runs <= 4));
+            return runs;
+        };
+        size_t runs = check_runs(1000);
+        assert(mode == StorageMode::Block ? runs == 2 : runs > 2);
+
+        // Migrations and shrinking keep the layout
+        for (size_t i = 0; i < es.size(); i += 2)
+            w.remove<Health>(es[i]);
+        w.shrink_to_fit(1.0f);
+        check_runs(1000);
+        w.each<const Mass, const Health>([&](Entity, const Mass& m, const Health& h) {
+            assert(m.m == float(h.hp));
+        });
+    }
+    std::printf("  column alignment: OK\n");
+}
+
+void test_split_components() {
+    static_assert(is_split_component_v<Particle3> && is_split_component_v<const Particle3>);
+    static_assert(!is_split_component_v<Position> && lane_count<Position>() == 1);
+    static_assert(lane_count<Particle3>() == 3 && lane_count<Body>() == 2);
+    static_assert(std::is_same_v<Lane<Body, 1>::value_type, int32_t>);
+
+    World w;
+    int lane_adds = 0;
+    w.on_add<Lane<Particle3, 0>>([&](World&, Entity, Lane<Particle3, 0>&) { ++lane_adds; });
+
+    Entity e = w.create_with(Position{1, 2});
+    w.add(e, Particle3{1, 2, 3});
+    assert((w.has<Particle3>(e) && w.has<Lane<Particle3, 2>>(e) && lane_adds == 1));
+    assert((w.count<Lane<Particle3, 0>, Lane<Particle3, 1>, Lane<Particle3, 2>, Position>() == 1));
+    Particle3 p = w.load<Particle3>(e);
+    assert(p.x == 1 && p.y == 2 && p.z == 3 && w.load<Position>(e).y == 2);
+
+    // Overwrites stay in place and stamp every lane
+    uint32_t before = w.advance_tick();
+    size_t archetypes = w.archetype_count();
+    w.add(e, Particle3{4, 5, 6});
+    w.store(e, Particle3{7, 8, 9});
+    assert(w.archetype_count() == archetypes && lane_adds == 1);
+    int changed = 0;
+    w.each<const Lane<Particle3, 2>>(World::Changed<Lane<Particle3, 2>>{before},
+                                     [&](Entity, const Lane<Particle3, 2>& z) {
+                                         assert(z.value == 9);
+                                         ++changed;
+                                     });
+    assert(changed == 1);
+
+    // A missing lane is restored with the others in one migration
+    w.remove<Lane<Particle3, 1>>(e);
+    assert((!w.has<Particle3>(e) && w.has<Lane<Particle3, 0>>(e)));
+    w.add(e, Particle3{1, 1, 1});
+    p = w.load<Particle3>(e);
+    assert(w.has<Particle3>(e) && p.x == 1 && p.y == 1 && p.z == 1 && lane_adds == 1);
+
+    // Fields that are not listed are not stored
+    w.add(e, Body{2.5f, 77, -4});
+    Body b = w.load<Body>(e);
+    assert(b.mass == 2.5f && b.pad == 0 && b.cell == -4);
+
+    w.remove<Particle3>(e);
+    assert((!w.has<Particle3>(e) && !w.has<Lane<Particle3, 0>>(e)));
+    assert((!w.has<Lane<Particle3, 2>>(e)));
+    assert(w.has<Body>(e) && w.load<Position>(e).x == 1);
+    w.remove<Particle3>(e); // no lanes left: nothing to do
+    w.remove<Body>(e);
+    assert(!w.has<Body>(e) && w.has<Position>(e));
+    std::printf("  split components: OK\n");
+}
+
+void test_each_lanes() {
+    for (StorageMode mode : {StorageMode::Block, StorageMode::Chunked}) {
+        World w(WorldConfig{mode, 2048});
+        std::vector<Entity> es;
+        for (int i = 0; i < 1500; ++i) {
+            Entity e = w.create_with(Velocity{float(i), 1}, Health{i});
+            w.add(e, Particle3{float(i), 0, -float(i)});
+            es.push_back(e);
+        }
+        Entity other = w.create_with(Velocity{0, 0}); // no lanes: not visited
+        (void)other;
+
+        uint32_t before = w.advance_tick();
+        size_t rows = 0;
+        w.each_lanes<const Particle3>([&](Span<const Entity> entities, Lanes<const Particle3>) {
+            rows += entities.size();
+        });
+        assert(rows == 1500);
+        size_t stamped = 0;
+        w.each<const Lane<Particle3, 0>>(World::Changed<Lane<Particle3, 0>>{before},
+                                         [&](Entity, const Lane<Particle3, 0>&) { ++stamped; });
+        assert(stamped == 0); // read-only lanes are not marked
+
+        rows = 0;
+        w.each_lanes<Particle3, const Velocity, Health>(
+            [&](Span<const Entity> entities, Lanes<Particle3> p, const Velocity* v, Health* h) {
+                float* px = p.lane<0>();
+                float* py = p.lane<1>();
+                float* pz = p.lane<2>();
+                assert(aligned_to(px, 64) && aligned_to(py, 64) && aligned_to(pz, 64));
+                for (size_t i = 0; i < entities.size(); ++i) {
+                    assert(h[i].hp == int(v[i].dx));
+                    px[i] += v[i].dx;
+                    py[i] += v[i].dy;
+                    pz[i] = p.load(i).x + pz[i];
+                }
+                if (!entities.empty())
+                    p.store(0, Particle3{-1, -1, -1});
+                rows += entities.size();
+            });
+        assert(rows == 1500);
+        size_t reset = 0;
+        for (size_t i = 0; i < es.size(); ++i) {
+            Particle3 q = w.load<Particle3>(es[i]);
+            if (q.x == -1 && q.y == -1 && q.z == -1) {
+                ++reset;
+                continue;
+            }
+            assert(q.x == 2.0f * float(i) && q.y == 1 && q.z == float(i));
+        }
+        assert(mode == StorageMode::Block ? reset == 1 : reset > 1);
+        stamped = 0;
+        w.each<const Lane<Particle3, 2>>(World::Changed<Lane<Particle3, 2>>{before},
+                                         [&](Entity, const Lane<Particle3, 2>&) { ++stamped; });
+        assert(stamped == 1500); // mutable lanes mark every lane
+
+        // Structural changes inside the loop assert, as for each
+        auto old_handler = signal(SIGABRT, abort_handler);
+        bool caught = false;
+        if (sigsetjmp(jump_buf, 1) == 0)
+            w.each_lanes<Particle3>([&](Span<const Entity>, Lanes<Particle3>) { w.create(); });
+        else
+            caught = true;
+        signal(SIGABRT, old_handler);
+        assert(caught);
+    }
+    std::printf("  each_lanes: OK\n");
+}
+
+// --- Phase 8.1: Stable Type Registration ---
+
+void test_register_component_lookup() {
+    register_component<Position>("Position");
+    register_component<Velocity>("Velocity");
+
+    assert(component_id_by_name("Position") == component_id<Position>());
+    assert(component_id_by_name("Velocity") == component_id<Velocity>());
+    assert(component_name(component_id<Position>()) == "Position");
+    assert(component_name(component_id<Velocity>()) == "Velocity");
+    assert(component_registered(component_id<Position>()));
+    assert(component_registered(component_id<Velocity>()));
+    std::printf("  register component lookup: OK\n");
+}
+
+void test_register_component_idempotent() {
+    register_component<Position>("Position");
+    register_component<Position>("Position"); // same name, same type — no-op
+    assert(component_id_by_name("Position") == component_id<Position>());
+    std::printf("  register component idempotent: OK\n");
+}
+
+void test_register_component_conflict() {
+    auto old_handler = signal(SIGABRT, abort_handler);
+    bool caught = false;
+    if (sigsetjmp(jump_buf, 1) == 0) {
+        register_component<Health>("Position"); // different type, same name as Position
+    } else {
+        caught = true;
+    }
+    signal(SIGABRT, old_handler);
+    assert(caught);
+    std::printf("  register component conflict: OK\n");
+}
+
+// --- Phase 8.2: Serialization ---
+
+void test_serialize_round_trip() {
+    register_component<Position>("Position");
+    register_component<Velocity>("Velocity");
+    register_component<Health>("Health");
+
+    World w1;
+    Entity e1 = w1.create_with(Position{1.0f, 2.0f}, Velocity{3.0f, 4.0f});
+    Entity e2 = w1.create_with(Position{5.0f, 6.0f}, Health{100});
+    Entity e3 = w1.create_with(Health{50});
+
+    std::stringstream ss;
+    serialize(w1, ss);
+
+    World w2;
+    deserialize(w2, ss);
+
+    assert(w2.alive(e1));
+    assert(w2.alive(e2));
+    assert(w2.alive(e3));
+    assert(w2.get<Position>(e1).x == 1.0f && w2.get<Position>(e1).y == 2.0f);
+    assert(w2.get<Velocity>(e1).dx == 3.0f && w2.get<Velocity>(e1).dy == 4.0f);
+    assert(w2.get<Position>(e2).x == 5.0f && w2.get<Position>(e2).y == 6.0f);
+    assert(w2.get<Health>(e2).hp == 100);
+    assert(w2.get<Health>(e3).hp == 50);
+    assert(!w2.has<Velocity>(e2));
+    assert(!w2.has<Position>(e3));
+    assert(w2.count() == 3);
+    std::printf("  serialize round trip: OK\n");
+}
+
+void test_serialize_destroyed_entities() {
+    register_component<Position>("Position");
+
+    World w1;
+    Entity e1 = w1.create_with(Position{1.0f, 0.0f});
+    Entity e2 = w1.create_with(Position{2.0f, 0.0f});
+    Entity e3 = w1.create_with(Position{3.0f, 0.0f});
+    w1.destroy(e2); // free list should contain e2's index
+
+    std::stringstream ss;
+    serialize(w1, ss);
+
+    World w2;
+    deserialize(w2, ss);
+
+    assert(w2.alive(e1));
+    assert(!w2.alive(e2)); // destroyed
+    assert(w2.alive(e3));
+    assert(w2.get<Position>(e1).x == 1.0f);
+    assert(w2.get<Position>(e3).x == 3.0f);
+    assert(w2.count() == 2);
+
+    // New entity should reuse the free slot
+    Entity e4 = w2.create();
+    assert(e4.index == e2.index);
+    assert(e4.generation == e2.generation + 1);
+    std::printf("  serialize destroyed entities: OK\n");
+}
+
+void test_serialize_empty_world() {
+    World w1;
+
+    std::stringstream ss;
+    serialize(w1, ss);
+
+    World w2;
+    deserialize(w2, ss);
+
+    assert(w2.count() == 0);
+    std::printf("  serialize empty world: OK\n");
+}
+
+// Registers Parent, and Children with a custom (non-trivially-copyable) serializer.
+static void register_hierarchy_components() {
+    register_component<Parent>("Parent");
+    register_component<Children>(
+        "Children",
+        // Custom serialize for Children (non-trivially-copyable)
+        [](const void* elem, std::ostream& out) {
+            auto& children = *static_cast<const Children*>(elem);
+            uint32_t count = static_cast<uint32_t>(children.entities.size());
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            for (auto& e : children.entities) {
+                out.write(reinterpret_cast<const char*>(&e.index), sizeof(uint32_t));
+                out.write(reinterpret_cast<const char*>(&e.generation), sizeof(uint32_t));
+            }
+        },
+        [](void* elem, std::istream& in) {
+            auto& children = *static_cast<Children*>(elem);
+            uint32_t count;
+            in.read(reinterpret_cast<char*>(&count), sizeof(count));
+            children.entities.resize(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                in.read(reinterpret_cast<char*>(&children.entities[i].index), sizeof(uint32_t));
+                in.read(reinterpret_cast<char*>(&children.entities[i].generation),
+                        sizeof(uint32_t));
+            }
+        });
+}
+
+void test_serialize_with_hierarchy() {
+    register_hierarchy_components();
+
+    World w1;
+    Entity parent = w1.create_with(Position{10.0f, 0.0f});
+    Entity child = w1.create_with(Position{0.0f, 5.0f});
+    set_parent(w1, child, parent);
+
+    std::stringstream ss;
+    serialize(w1, ss);
+
+    World w2;
+    deserialize(w2, ss);
+
+    assert(w2.alive(parent));
+    assert(w2.alive(child));
+    assert(w2.has<Parent>(child));
+    assert(w2.get<Parent>(child).entity == parent);
+    assert(w2.has<Children>(parent));
+    assert(w2.get<Children>(parent).entities.size() == 1);
+    assert(w2.get<Children>(parent).entities[0] == child);
+    std::printf("  serialize with hierarchy: OK\n");
+}
+
+// --- Phase 8.3: Snapshot Format v2 ---
+
+void test_snapshot_round_trip() {
+    register_component<Position>("Position");
+    register_component<Velocity>("Velocity");
+    register_component<Health>("Health");
+    register_hierarchy_components();
+
+    World w1;
+    std::vector<Entity> es;
+    for (int i = 0; i < 700; ++i)
+        es.push_back(w1.create_with(Position{float(i), 1}, Velocity{2, float(i)}));
+    Entity h = w1.create_with(Health{77});
+    Entity doomed = w1.create_with(Health{1});
+    set_parent(w1, es[5], h);
+    set_parent(w1, es[6], h);
+    w1.destroy(doomed);
+
+    std::stringstream ss;
+    serialize_snapshot(w1, ss);
+    std::string bytes = ss.str();
+
+    // Header, table, and page-aligned blobs
+    SnapshotHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    assert(header.version == SNAPSHOT_VERSION && header.size == bytes.size());
+    assert(header.generations_offset % SNAPSHOT_ALIGN == 0 &&
+           header.free_list_offset % SNAPSHOT_ALIGN == 0);
+
+    auto check = [&](World& w) {
+        assert(w.count() == w1.count() && !w.alive(doomed));
+        for (int i = 0; i < 700; ++i)
+            assert(w.get<Position>(es[i]).x == float(i) && w.get<Velocity>(es[i]).dy == float(i));
+        assert(w.get<Health>(h).hp == 77);
+        assert(w.get<Parent>(es[6]).entity == h);
+        assert(w.get<Children>(h).entities.size() == 2);
+        assert(w.create().index == doomed.index); // free list restored
+    };
+
+    // From memory, into chunked storage
+    World w2(WorldConfig{StorageMode::Chunked, 256});
+    deserialize_snapshot(w2, bytes.data(), bytes.size());
+    check(w2);
+
+    // Through the stream entry point
+    World w3;
+    std::stringstream in(bytes);
+    deserialize(w3, in);
+    check(w3);
+
+    // Through a mapped file
+    const char* path = "ecs_test_snapshot.bin";
+    assert(save_snapshot(w1, path));
+    World w4;
+    assert(load_snapshot(w4, path));
+    check(w4);
+    std::remove(path);
+    World w5;
+    assert(!load_snapshot(w5, path));
+    std::printf("  snapshot round trip: OK\n");
+}
+
+// Renames every stored "Position" to an unregistered name of the same length
+static std::string rename_position(std::string bytes) {
+    for (size_t at = bytes.find("Position"); at != std::string::npos; at = bytes.find("Position"))
+        bytes[at] = 'Q';
+    return bytes;
+}
+
+// Overwrites the one stored entity run `{from[0], from[1]}` with `to`; false if none or several
+static bool patch_entity_pair(std::string& data, const Entity (&from)[2], const Entity (&to)[2]) {
+    std::string pattern(reinterpret_cast<const char*>(from), sizeof(from));
+    size_t at = data.find(pattern);
+    if (at == std::string::npos || data.find(pattern, at + 1) != std::string::npos)
+        return false;
+    std::memcpy(&data[at], to, sizeof(to));
+    return true;
+}
+
+void test_snapshot_malformed() {
+    register_component<Position>("Position");
+    register_component<Health>("Health");
+    register_hierarchy_components();
+
+    World w1;
+    std::vector<Entity> es;
+    for (int i = 0; i < 50; ++i)
+        es.push_back(w1.create_with(Position{float(i), 0}));
+    Entity h = w1.create_with(Health{7});
+    set_parent(w1, es[0], h);
+    w1.destroy(es[49]);
+    w1.destroy(es[48]);
+    std::stringstream ss;
+    serialize_snapshot(w1, ss);
+    const std::string bytes = ss.str();
+
+    // A failed load leaves the world empty and usable, even for a later good load
+    auto rejects = [](const std::string& data) {
+        World w;
+        bool loaded = deserialize_snapshot(w, data.data(), data.size());
+        assert(!loaded && w.count() == 0);
+        assert(w.create_with(Position{1, 1}) != INVALID_ENTITY);
+        return true;
+    };
+
+    // Truncated anywhere
+    for (size_t n = 0; n < bytes.size(); n += 61)
+        assert(rejects(bytes.substr(0, n)));
+    assert(rejects(bytes.substr(0, bytes.size() - 1)));
+
+    // Walks the table to the column entry named `name`
+    SnapshotHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    auto column_at = [&](const std::string& data, const char* name) {
+        size_t cursor = header.table_offset;
+        for (uint32_t a = 0; a < header.archetype_count; ++a) {
+            SnapshotArchetype entry;
+            std::memcpy(&entry, data.data() + cursor, sizeof(entry));
+            cursor += sizeof(entry);
+            for (uint32_t c = 0; c < entry.component_count; ++c) {
+                SnapshotColumn col;
+                std::memcpy(&col, data.data() + cursor, sizeof(col));
+                if (data.compare(cursor + sizeof(col), col.name_len, name) == 0)
+                    return cursor;
+                cursor += sizeof(col) + ((col.name_len + 7) & ~7u);
+            }
+        }
+        assert(false);
+        return size_t(0);
+    };
+    auto patch_column = [&](const char* name, auto&& edit) {
+        std::string data = bytes;
+        size_t at = column_at(data, name);
+        SnapshotColumn col;
+        std::memcpy(&col, data.data() + at, sizeof(col));
+        edit(col);
+        std::memcpy(&data[at], &col, sizeof(col));
+        return data;
+    };
+
+    assert(rejects(rename_position(bytes)));
+    assert(rejects(patch_column("Position", [](SnapshotColumn& c) { c.offset = ~0ull - 8; })));
+    assert(rejects(patch_column("Position", [](SnapshotColumn& c) { c.size -= 8; })));
+    assert(rejects(patch_column("Position", [](SnapshotColumn& c) { c.elem_size += 4; })));
+    assert(rejects(patch_column("Health", [](SnapshotColumn& c) { c.encoding = 9; })));
+    // A stream-encoded column that runs short is caught after decoding
+    assert(rejects(patch_column("Children", [](SnapshotColumn& c) { c.size -= 4; })));
+
+    // An entity or free-list index outside the entity table
+    std::string data = bytes;
+    SnapshotArchetype entry;
+    std::memcpy(&entry, data.data() + header.table_offset, sizeof(entry));
+    uint32_t bad = header.slot_count;
+    std::memcpy(&data[entry.entities_offset], &bad, sizeof(bad));
+    assert(rejects(data));
+    data = bytes;
+    std::memcpy(&data[header.free_list_offset], &bad, sizeof(bad));
+    assert(rejects(data));
+
+    // Entity lists and the free list must describe each slot once: no reserved index 0, no
+    // index listed twice (in one archetype or two), generations matching the table, and no
+    // free slot that is also live or freed twice
+    const Entity pair[2] = {es[1], es[2]};
+    const Entity edits[][2] = {
+        {Entity{0, 0}, es[2]}, {es[1], es[1]}, {es[1], h}, {Entity{es[1].index, 5}, es[2]}};
+    for (const auto& to : edits) {
+        data = bytes;
+        assert(patch_entity_pair(data, pair, to) && rejects(data));
+    }
+    uint32_t free_list[2];
+    std::memcpy(free_list, bytes.data() + header.free_list_offset, sizeof(free_list));
+    for (uint32_t first : {0u, es[1].index, free_list[1]}) {
+        data = bytes;
+        std::memcpy(&data[header.free_list_offset], &first, sizeof(first));
+        assert(rejects(data));
+    }
+
+    World w2;
+    assert(load_snapshot(w2, "ecs_test_missing.bin") == false);
+    assert(deserialize_snapshot(w2, bytes.data(), bytes.size()));
+    assert(w2.count() == w1.count() && w2.get<Parent>(es[0]).entity == h);
+    std::printf("  snapshot malformed input: OK\n");
+}
+
+// --- Phase 8.4: Delta Snapshots ---
+
+void test_delta_snapshot() {
+    register_component<Position>("Position");
+    register_component<Velocity>("Velocity");
+    register_component<Health>("Health");
+    register_hierarchy_components();
+
+    World w1;
+    std::vector<Entity> es;
+    for (int i = 0; i < 500; ++i)
+        es.push_back(w1.create_with(Position{float(i), 0}, Velocity{1, 1}));
+    Entity h = w1.create_with(Health{10});
+    set_parent(w1, es[0], h);
+
+    std::stringstream full;
+    serialize_snapshot(w1, full);
+    std::string full_bytes = full.str();
+    World w2;
+    deserialize_snapshot(w2, full_bytes.data(), full_bytes.size());
+    uint32_t baseline = w1.advance_tick();
+
+    // Edits, migrations, destroys, slot reuse and hierarchy changes
+    w1.get<Position>(es[3]).x = 42;
+    w1.add(es[10], Health{5});
+    w1.remove<Velocity>(es[11]);
+    w1.destroy(es[12]);
+    w1.destroy(es[13]);
+    Entity reused = w1.create_with(Health{99});
+    Entity fresh = w1.create_with(Position{-1, -1});
+    set_parent(w1, es[1], h);
+
+    std::stringstream d1;
+    serialize_delta(w1, baseline, d1);
+    baseline = w1.advance_tick();
+    assert(d1.str().size() * 10 < full_bytes.size());
+    apply_delta(w2, d1);
+
+    auto check = [&] {
+        const World& src = w1; // const reads do not stamp change ticks
+        const World& dst = w2;
+        assert(dst.count() == src.count());
+        for (Entity e : es) {
+            assert(dst.alive(e) == src.alive(e));
+            if (!src.alive(e))
+                continue;
+            assert(dst.has<Velocity>(e) == src.has<Velocity>(e));
+            assert(dst.has<Health>(e) == src.has<Health>(e));
+            assert(dst.get<Position>(e).x == src.get<Position>(e).x);
+            if (src.has<Velocity>(e))
+                assert(dst.get<Velocity>(e).dx == src.get<Velocity>(e).dx);
+        }
+    };
+    check();
+    assert(w2.alive(reused) && w2.get<Health>(reused).hp == 99);
+    assert(!w2.alive(Entity{reused.index, reused.generation - 1}));
+    assert(w2.get<Position>(fresh).x == -1 && w2.get<Health>(es[10]).hp == 5);
+    assert(w2.get<Children>(h).entities.size() == 2 && w2.get<Parent>(es[1]).entity == h);
+
+    // A whole-column write sends the column; an idle frame sends only the section headers
+    w1.each<Velocity>([](Entity, Velocity& v) { v.dx += 1; });
+    std::stringstream d2;
+    serialize_delta(w1, baseline, d2);
+    baseline = w1.advance_tick();
+    apply_delta(w2, d2);
+    check();
+
+    std::stringstream d3;
+    serialize_delta(w1, baseline, d3);
+    assert(d3.str().size() == 7 * sizeof(uint32_t));
+    apply_delta(w2, d3);
+    check();
+
+    // Both worlds hand out the same slots afterwards
+    Entity a = w1.create(), b = w2.create();
+    assert(a == b);
+    std::printf("  delta snapshot: OK\n");
+}
+
+// --- Phase 8.5: Streamed Serialization ---
+
+// Byte-level run-length codec: (run length, byte) pairs
+static size_t rle_bound(size_t n) { return n * 2; }
+static size_t rle_compress(const void* src, size_t n, void* dst, size_t cap) {
+    auto* in = static_cast<const uint8_t*>(src);
+    auto* out = static_cast<uint8_t*>(dst);
+    size_t o = 0;
+    for (size_t i = 0; i < n;) {
+        size_t run = 1;
+        while (i + run < n && run < 255 && in[i + run] == in[i])
+            ++run;
+        if (o + 2 > cap)
+            return 0;
+        out[o++] = static_cast<uint8_t>(run);
+        out[o++] = in[i];
+        i += run;
+    }
+    return o;
+}
+static bool rle_decompress(const void* src, size_t n, void* dst, size_t raw) {
+    auto* in = static_cast<const uint8_t*>(src);
+    auto* out = static_cast<uint8_t*>(dst);
+    size_t o = 0;
+    for (size_t i = 0; i + 1 < n; i += 2) {
+        if (o + in[i] > raw)
+            return false;
+        std::memset(out + o, in[i + 1], in[i]);
+        o += in[i];
+    }
+    return o == raw;
+}
+
+void test_stream_round_trip() {
+    register_component<Position>("Position");
+    register_component<Velocity>("Velocity");
+    register_component<Health>("Health");
+    register_hierarchy_components();
+
+    World w1;
+    std::vector<Entity> es;
+    for (int i = 0; i < 3000; ++i)
+        es.push_back(w1.create_with(Position{float(i % 7), 0}, Velocity{1, 1}));
+    Entity h = w1.create_with(Health{3});
+    Entity doomed = w1.create();
+    for (int i = 0; i < 4; ++i)
+        set_parent(w1, es[i], h);
+    w1.destroy(doomed);
+
+    auto check = [&](World& w) {
+        assert(w.count() == w1.count() && !w.alive(doomed));
+        for (int i = 0; i < 3000; ++i)
+            assert(w.get<Position>(es[i]).x == float(i % 7) && w.get<Velocity>(es[i]).dy == 1);
+        assert(w.get<Children>(h).entities.size() == 4 && w.get<Parent>(es[3]).entity == h);
+        assert(w.create().index == doomed.index);
+    };
+
+    // Small blocks split the big archetype; compressed and decoded on a pool
+    ThreadPool pool(4);
+    BlockCompressor rle{7, rle_bound, rle_compress, rle_decompress};
+    StreamOptions options;
+    options.block_bytes = 4096;
+    options.compressor = &rle;
+    options.pool = &pool;
+
+    StreamCapture capture = capture_stream(w1, options);
+    assert(capture.blocks.size() > 8);
+    w1.get<Position>(es[0]).x = 100; // later writes do not reach the capture
+
+    std::stringstream packed;
+    write_stream(capture, packed, options);
+    assert(packed.str().size() < capture.raw_bytes());
+    World w2(WorldConfig{StorageMode::Chunked, 1024});
+    deserialize_stream(w2, packed, options);
+    w1.get<Position>(es[0]).x = 0;
+    check(w2);
+
+    // Uncompressed, single-threaded
+    std::stringstream plain;
+    serialize_stream(w1, plain);
+    World w3;
+    deserialize_stream(w3, plain);
+    check(w3);
+    std::printf("  stream round trip: OK\n");
+}
+
+void test_stream_malformed() {
+    register_component<Position>("Position");
+    register_component<Health>("Health");
+    register_hierarchy_components();
+
+    World w1;
+    std::vector<Entity> es;
+    for (int i = 0; i < 50; ++i)
+        es.push_back(w1.create_with(Position{float(i), 0}));
+    Entity h = w1.create_with(Health{7});
+    set_parent(w1, es[0], h);
+    w1.destroy(es[49]);
+    w1.destroy(es[48]);
+    std::stringstream ss;
+    serialize_stream(w1, ss);
+    const std::string bytes = ss.str();
+
+    auto rejects = [](const std::string& data) {
+        World w;
+        std::stringstream in(data);
+        bool loaded = deserialize_stream(w, in);
+        assert(!loaded && w.count() == 0);
+        assert(w.create_with(Position{1, 1}) != INVALID_ENTITY);
+        return true;
+    };
+
+    for (size_t n = 0; n < bytes.size(); n += 7)
+        assert(rejects(bytes.substr(0, n)));
+    assert(rejects(rename_position(bytes)));
+
+    // Walks the frames to the first one of `kind`
+    auto frame_at = [&](const std::string& data, uint32_t kind) {
+        size_t cursor = 8;
+        for (;;) {
+            StreamFrame frame;
+            std::memcpy(&frame, data.data() + cursor, sizeof(frame));
+            if (frame.kind == kind)
+                return cursor;
+            cursor += sizeof(frame) + frame.stored_size;
+        }
+    };
+
+    // A huge payload length in a short stream fails without allocating it
+    std::string data = bytes;
+    StreamFrame frame;
+    size_t at = frame_at(data, StreamBlock);
+    std::memcpy(&frame, data.data() + at, sizeof(frame));
+    frame.stored_size = frame.raw_size = uint64_t(1) << 40;
+    std::memcpy(&data[at], &frame, sizeof(frame));
+    assert(rejects(data));
+
+    // A compressed frame without the compressor, and an unknown frame kind
+    data = bytes;
+    std::memcpy(&frame, data.data() + at, sizeof(frame));
+    frame.codec = 7;
+    std::memcpy(&data[at], &frame, sizeof(frame));
+    assert(rejects(data));
+    data = bytes;
+    frame.codec = 0;
+    frame.kind = 9;
+    std::memcpy(&data[at], &frame, sizeof(frame));
+    assert(rejects(data));
+
+    // An entity table that moves slots into the free list leaves entities outside it
+    data = bytes;
+    at = frame_at(data, StreamEntityTable) + sizeof(StreamFrame);
+    uint32_t counts[2];
+    std::memcpy(counts, data.data() + at, sizeof(counts));
+    counts[0] -= 8;
+    counts[1] += 8;
+    std::memcpy(&data[at], counts, sizeof(counts));
+    assert(rejects(data));
+
+    // The snapshot's slot checks, through edited captures: entity runs in the blocks, then
+    // the entity table's generations and free list
+    auto rejects_capture = [&](const StreamCapture& capture) {
+        std::stringstream out;
+        write_stream(capture, out);
+        return rejects(out.str());
+    };
+    const StreamCapture original = capture_stream(w1);
+    const Entity pair[2] = {es[1], es[2]};
+    const Entity edits[][2] = {
+        {Entity{0, 0}, es[2]}, {es[1], es[1]}, {es[1], h}, {Entity{es[1].index, 5}, es[2]}};
+    for (const auto& to : edits) {
+        StreamCapture capture = original;
+        size_t patched = 0;
+        for (std::string& block : capture.blocks)
+            patched += patch_entity_pair(block, pair, to);
+        assert(patched == 1 && rejects_capture(capture));
+    }
+    std::memcpy(counts, original.entity_table.data(), sizeof(counts));
+    size_t free_at = sizeof(counts) + size_t(counts[0]) * 4;
+    uint32_t free_list[2];
+    std::memcpy(free_list, original.entity_table.data() + free_at, sizeof(free_list));
+    for (uint32_t first : {0u, es[1].index, free_list[1]}) {
+        StreamCapture capture = original;
+        std::memcpy(&capture.entity_table[free_at], &first, sizeof(first));
+        assert(rejects_capture(capture));
+    }
+    StreamCapture stale = original;
+    uint32_t generation = 5;
+    std::memcpy(&stale.entity_table[sizeof(counts) + size_t(es[1].index) * 4], &generation, 4);
+    assert(rejects_capture(stale));
+
+    World w2;
+    std::stringstream in(bytes);
+    assert(deserialize_stream(w2, in));
+    assert(w2.count() == w1.count() && w2.get<Parent>(es[0]).entity == h);
+    std::printf("  stream malformed input: OK\n");
+}
+
+void test_command_buffer_move_only() {
+    World w;
+    CommandBuffer cb;
+    cb.add(w.create_with(Position{0, 0}), std::make_unique<int>(42));
+    cb.create_with(std::make_unique<int>(99));
+    cb.flush(w);
+    assert(w.count<std::unique_ptr<int>>() == 2);
+
+    // Also test via deferred()
+    Entity e = w.create_with(Position{1, 1});
+    w.deferred().add(e, std::make_unique<int>(7));
+    w.flush_deferred();
+    assert(w.has<std::unique_ptr<int>>(e));
+    assert(*w.get<std::unique_ptr<int>>(e) == 7);
+    std::printf("  command buffer move-only: OK\n");
+}
+
+void test_command_buffer_unflushed_cleanup() {
+    // Verify that unflushed commands with non-trivial types don't leak
+    {
+        CommandBuffer cb;
+        cb.create_with(std::string("a long string to avoid small string optimization entirely"));
+        cb.add(Entity{1, 0}, std::string("another long string to avoid SSO completely here"));
+        // cb goes out of scope without flush — destructor should clean up
+    }
+    std::printf("  command buffer unflushed cleanup: OK\n");
+}
+
+void test_serialize_unregistered_type_asserts() {
+    // Use a type that is NOT registered
+    struct Unregistered {
+        int val;
+    };
+
+    World w;
+    w.create_with(Unregistered{42});
+
+    auto old_handler = signal(SIGABRT, abort_handler);
+    bool caught = false;
     if (sigsetjmp(jump_buf, 1) == 0) {
         std::stringstream ss;
         serialize(w, ss);
@@ -1342,6 +3771,365 @@ void test_serialize_unregistered_type_asserts() {
     std::printf("  serialize unregistered type asserts: OK\n");
 }
 
+// --- Phase 8.6: In-Memory Checkpoints ---
+
+void test_checkpoint_round_trip() {
+    for (StorageMode mode : {StorageMode::Block, StorageMode::Chunked}) {
+        int live_before = Tracked::live;
+        {
+            World w(WorldConfig{mode, 1024});
+            auto movers = w.query<Position, const Velocity>();
+            std::vector<Entity> es;
+            for (int i = 0; i < 3000; ++i)
+                es.push_back(w.create_with(Position{float(i), 0}, Velocity{1, 0}));
+            for (int i = 0; i < 100; ++i)
+                es.push_back(w.create_with(Position{0, float(i)}, Tracked(i),
+                                           std::string("checkpointed string value #" +
+                                                       std::to_string(i))));
+            w.add(es[0], Target{es[1]});
+            w.add(es[2], Stunned{});
+            w.destroy(es[5]); // a free slot in the captured tables
+            w.advance_tick();
+
+            Checkpoint cp;
+            assert(cp.empty());
+            cp.capture(w);
+            assert(!cp.empty() && cp.change_tick() == w.change_tick());
+            assert(cp.entity_count() == w.count());
+            Entity first_new = w.create();
+            size_t archetypes = w.archetype_count();
+
+            // Diverge: writes, destroys, migrations, new archetypes, sparse changes
+            movers.each_no_entity([](Position& p, const Velocity& v) { p.x += v.dx; });
+            w.get<Tracked>(es[3000]).value = -1;
+            w.get<std::string>(es[3001]) = "changed";
+            for (int i = 10; i < 20; ++i)
+                w.destroy(es[i]);
+            w.add(es[20], Tag{});
+            w.remove<Velocity>(es[21]);
+            w.remove<Target>(es[0]);
+            w.add(es[1], Stunned{});
+            w.create_with(Health{1}, Marker{});
+            w.advance_tick();
+
+            cp.restore(w);
+            assert(w.change_tick() == cp.change_tick());
+            assert(w.count() == cp.entity_count());
+            assert(!w.alive(first_new) && !w.alive(es[5]) && w.alive(es[10]));
+            assert(w.archetype_count() >= archetypes); // new archetypes stay, empty
+            assert(movers.count() == 3000 - 1);        // es[5] was dead at capture
+            for (int i = 0; i < 3000; ++i) {
+                if (i == 5)
+                    continue;
+                assert(w.get<Position>(es[i]).x == float(i) && w.has<Velocity>(es[i]));
+                assert(!w.has<Tag>(es[i]));
+            }
+            for (int i = 0; i < 100; ++i) {
+                assert(w.get<Tracked>(es[3000 + i]).value == i);
+                assert(w.get<std::string>(es[3000 + i]) ==
+                       "checkpointed string value #" + std::to_string(i));
+            }
+            assert(w.get<Target>(es[0]).who == es[1]);
+            assert(w.has<Stunned>(es[2]) && !w.has<Stunned>(es[1]));
+            w.each<const Health>([](Entity, const Health&) { assert(false); });
+
+            // Entity allocation resumes exactly where it was, so re-simulation is deterministic
+            assert(w.create() == first_new);
+
+            // Restoring again after archetypes were deleted recreates them
+            cp.restore(w);
+            w.compact();
+            cp.restore(w);
+            assert(w.count() == cp.entity_count() && w.get<Position>(es[2999]).x == 2999.0f);
+            assert(w.get<Tracked>(es[3099]).value == 99);
+        }
+        assert(Tracked::live == live_before);
+    }
+
+    // Column copies come from the world's allocator and are reused by the next capture
+    CountingAllocator counting;
+    {
+        WorldConfig config;
+        config.allocator = &counting.alloc;
+        World w(config);
+        for (int i = 0; i < 100; ++i)
+            w.create_with(Position{float(i), 0}, Tracked(i));
+        size_t world_allocs = counting.allocs;
+        Checkpoint cp;
+        cp.capture(w);
+        assert(counting.allocs > world_allocs);
+        size_t captured = counting.allocs;
+        cp.capture(w);
+        assert(counting.allocs == captured);
+    }
+    assert(counting.frees == counting.allocs && counting.live_bytes == 0);
+    std::printf("  checkpoint round trip: OK\n");
+}
+
+// One deterministic simulation step for the rollback test
+static void checkpoint_step(World& w, int frame) {
+    w.each<Position, const Velocity>(
+        [](Entity, Position& p, const Velocity& v) { p.x += v.dx; });
+    w.each<Position>([&](Entity e, Position& p) {
+        if (int(p.x) % 7 == frame % 7)
+            w.deferred().destroy(e);
+    });
+    w.flush_deferred();
+    for (int i = 0; i < 5; ++i)
+        w.create_with(Position{float(frame * 10 + i), 0}, Velocity{float(i % 3), 0},
+                      NetId{uint64_t(frame * 10 + i)});
+    w.advance_tick();
+}
+
+void test_checkpoint_rollback() {
+    auto dump = [](World& w) {
+        std::vector<std::tuple<Entity, float, uint64_t>> rows;
+        w.each<const Position, const NetId>([&](Entity e, const Position& p, const NetId& id) {
+            rows.emplace_back(e, p.x, id.value);
+        });
+        std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+            return std::get<2>(a) < std::get<2>(b);
+        });
+        return rows;
+    };
+
+    World reference, w;
+    for (World* world : {&reference, &w}) {
+        world->index_by<NetId>(&NetId::value);
+        for (int frame = 0; frame < 20; ++frame)
+            checkpoint_step(*world, frame);
+    }
+
+    // Ring of 8 checkpoints; roll back 5 frames and re-simulate
+    std::vector<Checkpoint> ring(8);
+    for (int frame = 20; frame < 30; ++frame) {
+        ring[frame % 8].capture(w);
+        checkpoint_step(w, frame);
+    }
+    ring[25 % 8].restore(w);
+    for (int frame = 25; frame < 30; ++frame)
+        checkpoint_step(w, frame);
+    for (int frame = 20; frame < 30; ++frame)
+        checkpoint_step(reference, frame);
+    assert(dump(w) == dump(reference));
+    assert(w.change_tick() == reference.change_tick());
+
+    // The value index was rebuilt for the restored entities
+    Entity found = w.find_by<NetId>(uint64_t(292));
+    assert(found == reference.find_by<NetId>(uint64_t(292)));
+    assert(w.alive(found) && w.get<NetId>(found).value == 292);
+
+    // Asserts: restoring into another World, capturing a non-copyable component
+    auto old_handler = signal(SIGABRT, abort_handler);
+    bool caught = false;
+    if (sigsetjmp(jump_buf, 1) == 0)
+        ring[0].restore(reference);
+    else
+        caught = true;
+    assert(caught);
+    World owning;
+    owning.create_with(std::make_unique<int>(1));
+    caught = false;
+    if (sigsetjmp(jump_buf, 1) == 0)
+        ring[1].capture(owning);
+    else
+        caught = true;
+    signal(SIGABRT, old_handler);
+    assert(caught);
+    std::printf("  checkpoint rollback: OK\n");
+}
+
+// --- Phase 10: Parallel Iteration ---
+
+void test_system_access_graph() {
+    SystemRegistry systems;
+    auto noop = [](World&) {};
+    systems.add("movement", {access<Position>(ReadWrite), access<Velocity>(ReadOnly)}, noop);
+    systems.add("render", {access<Position>(ReadOnly)}, noop);
+    systems.add("health", {access<Health>(ReadWrite)}, noop);
+    systems.add("drag", {access<Velocity>(ReadWrite)}, noop);
+    systems.add("inspect", {access<Velocity>(ReadOnly), access<Health>(ReadOnly)}, noop);
+    systems.add("exclusive", noop);
+    systems.add("late_reader", {access<Health>(ReadOnly)}, noop);
+
+    assert(systems.conflicts(0, 1));  // movement writes Position, render reads it
+    assert(!systems.conflicts(0, 2)); // disjoint
+    assert(systems.conflicts(0, 3));  // movement reads Velocity, drag writes it
+    assert(!systems.conflicts(1, 3));
+    assert(!systems.conflicts(0, 4)); // both only read Velocity
+    assert(systems.conflicts(2, 4));  // health writes Health, inspect reads it
+    assert(systems.conflicts(3, 4));  // drag writes Velocity, inspect reads it
+    for (size_t i = 0; i < 5; ++i)
+        assert(systems.conflicts(i, 5)); // undeclared systems are exclusive
+    assert(systems.conflicts(5, 6));
+
+    // [movement, health] [render, drag] [inspect] [exclusive] [late_reader]
+    auto& stages = systems.stages();
+    assert(stages.size() == 5);
+    assert((stages[0] == std::vector<size_t>{0, 2}));
+    assert((stages[1] == std::vector<size_t>{1, 3}));
+    assert((stages[2] == std::vector<size_t>{4}));
+    assert((stages[3] == std::vector<size_t>{5}));
+    assert((stages[4] == std::vector<size_t>{6}));
+    std::printf("  system access graph: OK\n");
+}
+
+void test_thread_pool_parallel_for() {
+    ThreadPool pool(4);
+    assert(pool.size() == 4);
+
+    std::vector<int> hits(1000, 0);
+    pool.parallel_for(hits.size(), [&](size_t i) { hits[i] += 1; });
+    for (int h : hits)
+        assert(h == 1);
+
+    // Nested calls run inline instead of deadlocking
+    std::atomic<int> total{0};
+    pool.parallel_for(8, [&](size_t) { pool.parallel_for(8, [&](size_t) { ++total; }); });
+    assert(total == 64);
+
+    ThreadPool inline_pool(1);
+    int serial = 0;
+    inline_pool.parallel_for(10, [&](size_t) { ++serial; });
+    assert(serial == 10);
+    std::printf("  thread pool parallel_for: OK\n");
+}
+
+void test_run_all_parallel() {
+    World w;
+    for (int i = 0; i < 1000; ++i)
+        w.create_with(Position{0, 0}, Velocity{1, 2}, Health{i});
+
+    SystemRegistry systems;
+    systems.add("movement", {access<Position>(ReadWrite), access<Velocity>(ReadOnly)},
+                [](World& world) {
+                    world.each<Position, Velocity>([](Entity, Position& p, Velocity& v) {
+                        p.x += v.dx;
+                        p.y += v.dy;
+                    });
+                });
+    systems.add("regen", {access<Health>(ReadWrite)}, [](World& world) {
+        world.each<Health>([](Entity, Health& h) { h.hp += 1; });
+    });
+    // Conflicts with regen, so it runs after the first barrier and sees its results.
+    systems.add("cull", {access<Health>(ReadWrite)}, [](World& world) {
+        world.each<Health>([&](Entity e, Health& h) {
+            if (h.hp > 500)
+                world.deferred().destroy(e);
+        });
+    });
+    assert(systems.stages().size() == 2);
+
+    ThreadPool pool(4);
+    systems.run_all_parallel(w, pool);
+
+    assert(w.count() == 500); // hp 1..500 survive; cull's commands flushed at the barrier
+    w.each<Position, Health>([](Entity, Position& p, Health& h) {
+        assert(p.x == 1.0f && p.y == 2.0f);
+        assert(h.hp >= 1 && h.hp <= 500);
+    });
+    std::printf("  run_all_parallel: OK\n");
+}
+
+void test_par_each() {
+    World w;
+    // Two archetypes, both large enough to span many chunk-sized ranges.
+    for (int i = 0; i < 20000; ++i)
+        w.create_with(Position{0, 0}, Velocity{1, 0});
+    for (int i = 0; i < 5000; ++i)
+        w.create_with(Position{0, 0}, Velocity{1, 0}, Tag{});
+
+    ThreadPool pool(4);
+    std::atomic<int> visited{0};
+    w.par_each<Position, Velocity>(pool, [&](Entity e, Position& p, Velocity& v) {
+        assert(w.alive(e));
+        p.x += v.dx;
+        ++visited;
+    });
+    assert(visited == 25000);
+    w.each<Position>([](Entity, Position& p) { assert(p.x == 1.0f); }); // each row exactly once
+
+    w.par_each_no_entity<Position>(pool, [](Position& p) { p.y = 2.0f; });
+    w.each<Position>([](Entity, Position& p) { assert(p.y == 2.0f); });
+
+    std::atomic<int> untagged{0};
+    w.par_each<Position>(pool, World::Exclude<Tag>{}, [&](Entity, Position&) { ++untagged; });
+    assert(untagged == 20000);
+
+    // Nested parallel iteration from inside a pool job runs inline
+    std::atomic<int> nested{0};
+    pool.parallel_for(2, [&](size_t) {
+        w.par_each_no_entity<Velocity>(pool, World::Exclude<Tag>{}, [&](Velocity&) { ++nested; });
+    });
+    assert(nested == 40000);
+    std::printf("  par_each: OK\n");
+}
+
+// Records the same commands for every entity, whichever thread visits it
+static void record_par_commands(World& w, Entity e, const Position& p) {
+    int i = static_cast<int>(p.x);
+    if (i % 3 == 0)
+        w.deferred().destroy(e);
+    else
+        w.deferred().add(e, Health{i});
+    if (i % 5 == 0)
+        w.deferred().create_with(Position{float(i), 1},
+                                 std::string("spawned by a long enough string " + std::to_string(i)));
+}
+
+void test_par_deferred_commands() {
+    World seq, par;
+    for (World* w : {&seq, &par}) {
+        for (int i = 0; i < 20000; ++i)
+            w->create_with(Position{float(i), 0});
+        w->deferred().create_with(Position{-1, 0}); // recorded before the loop, applied first
+    }
+    seq.each<const Position>([&](Entity e, const Position& p) { record_par_commands(seq, e, p); });
+    ThreadPool pool(4);
+    par.par_each<const Position>(pool,
+                                 [&](Entity e, const Position& p) { record_par_commands(par, e, p); });
+    seq.flush_deferred();
+    par.flush_deferred();
+
+    // Same commands in the same order: identical entities, rows and values
+    auto dump = [](World& w) {
+        std::vector<std::tuple<Entity, float, int, std::string>> rows;
+        w.each<const Position>([&](Entity e, const Position& p) {
+            rows.emplace_back(e, p.x, w.has<Health>(e) ? w.get<Health>(e).hp : -1,
+                              w.has<std::string>(e) ? w.get<std::string>(e) : "");
+        });
+        return rows;
+    };
+    auto rows = dump(par);
+    assert(rows == dump(seq));
+    assert(par.count() == 20000 - 6667 + 4000 + 1);
+
+    // Nested par_for merges into the enclosing job's buffer, in index order
+    World w;
+    w.par_for(pool, 4, [&](size_t i) {
+        w.par_for(pool, 3, [&](size_t j) { w.deferred().create_with(Health{int(i * 3 + j)}); });
+    });
+    w.flush_deferred();
+    int expected = 0;
+    w.each<const Health>([&](Entity, const Health& h) { assert(h.hp == expected++); });
+    assert(expected == 12);
+
+    // Systems sharing a stage merge in registration order
+    World sys_world;
+    SystemRegistry systems;
+    for (int s = 0; s < 3; ++s)
+        systems.add("spawn", {access<Velocity>(ReadOnly)}, [s](World& world) {
+            for (int i = 0; i < 100; ++i)
+                world.deferred().create_with(Health{s});
+        });
+    assert(systems.stages().size() == 1);
+    systems.run_all_parallel(sys_world, pool);
+    int row = 0;
+    sys_world.each<const Health>([&](Entity, const Health& h) { assert(h.hp == row++ / 100); });
+    assert(row == 300);
+    std::printf("  par deferred commands: OK\n");
+}
+
 // --- Phase 11: Prefabs ---
 
 void test_prefab_instantiate_defaults() {
@@ -1458,6 +4246,478 @@ void test_prefab_destructor_cleanup() {
     std::printf("  prefab destructor cleanup: OK\n");
 }
 
+void test_prefab_instantiate_n() {
+    for (StorageMode mode : {StorageMode::Block, StorageMode::Chunked}) {
+        World w(WorldConfig{mode, 1024});
+        int before = Tracked::live;
+        {
+            Prefab p = Prefab::create(Position{1, 2}, Health{7}, Tracked{5},
+                                      std::string("a long string to avoid small string optimization"));
+            w.create_with(Position{0, 0}, Health{0}); // rows before the batch stay intact
+            auto es = instantiate_n(w, p, 300);
+            assert(es.size() == 300 && w.count<Tracked>() == 300);
+            size_t archetypes = w.archetype_count();
+            std::vector<Entity> first(es.begin(), es.end());
+            instantiate_n(w, p, 10);
+            instantiate(w, p);
+            assert(w.archetype_count() == archetypes && w.count<Tracked>() == 311);
+            for (Entity e : first) {
+                assert(w.get<Position>(e).x == 1 && w.get<Position>(e).y == 2);
+                assert(w.get<Health>(e).hp == 7 && w.get<Tracked>(e).value == 5);
+                assert(w.get<std::string>(e) == "a long string to avoid small string optimization");
+            }
+            w.get<std::string>(first[0]) = "changed";
+            assert(w.get<std::string>(first[1]) != "changed");
+            assert(instantiate_n(w, p, 0).size() == 0);
+        }
+        assert(Tracked::live == before + 311);
+        w.destroy_all<Tracked>();
+        assert(Tracked::live == before);
+
+        // Prefabs resolve by type set: removed archetypes come back, and throwaway prefabs
+        // leave nothing behind in the world
+        Prefab q = Prefab::create(Velocity{1, 1});
+        instantiate_n(w, q, 5);
+        w.destroy_all<Velocity>();
+        w.remove_empty_archetypes();
+        Prefab copy = q;
+        Prefab moved = std::move(copy);
+        assert(copy.types().empty() && moved.types() == q.types());
+        assert(w.count<Velocity>() == 0);
+        instantiate_n(w, q, 3);
+        size_t archetypes = w.archetype_count();
+        for (int i = 0; i < 100; ++i)
+            instantiate(w, Prefab::create(Velocity{1, 1}));
+        instantiate_n(w, moved, 2);
+        assert(w.archetype_count() == archetypes && w.count<Velocity>() == 105);
+    }
+    std::printf("  prefab instantiate_n: OK\n");
+}
+
+void test_prefab_instantiate_n_overrides() {
+    World w;
+    Prefab enemy = Prefab::create(Position{0, 0}, Health{100}, Target{});
+    int batches = 0, hp_adds = 0, targets = 0;
+    w.on_add_batch<Position>([&](World&, Span<const Entity> es, Position*) {
+        ++batches;
+        assert(es.size() == 64);
+    });
+    w.on_add<Health>([&](World&, Entity, Health& h) { hp_adds += h.hp == 100; });
+    w.on_add<Target>([&](World&, Entity, Target&) { ++targets; });
+
+    // Overrides replace a default and add a component the prefab lacks
+    auto es = instantiate_n<Position, Velocity>(w, enemy, 64, [](size_t i) {
+        return std::make_tuple(Position{float(i), 0}, Velocity{0, float(i)});
+    });
+    assert(batches == 1 && hp_adds == 64 && targets == 64);
+    std::vector<Entity> spawned(es.begin(), es.end());
+    for (size_t i = 0; i < spawned.size(); ++i) {
+        Entity e = spawned[i];
+        assert(w.get<Position>(e).x == float(i) && w.get<Velocity>(e).dy == float(i));
+        assert(w.get<Health>(e).hp == 100 && w.has<Target>(e));
+    }
+    assert((w.count<Position, Velocity, Health, Target>() == 64));
+    std::printf("  prefab instantiate_n overrides: OK\n");
+}
+
+// --- Phase 12: Bulk Operations ---
+
+void test_create_n_broadcast() {
+    World w;
+    auto es = w.create_n(1000, Position{1, 2}, Velocity{3, 4});
+    assert(es.size() == 1000);
+    assert(w.count() == 1000);
+    assert((w.count<Position, Velocity>() == 1000));
+    for (size_t i = 0; i < es.size(); ++i) {
+        assert(w.alive(es[i]));
+        assert(w.get<Position>(es[i]).x == 1.0f && w.get<Velocity>(es[i]).dy == 4.0f);
+    }
+    // Fresh indices are contiguous
+    for (size_t i = 1; i < es.size(); ++i)
+        assert(es[i].index == es[0].index + i);
+
+    // Recycled slots are used before fresh ones
+    std::vector<Entity> victims(es.begin(), es.begin() + 10);
+    for (Entity e : victims)
+        w.destroy(e);
+    auto more = w.create_n(20, Position{5, 5});
+    int recycled = 0;
+    for (Entity e : more) {
+        for (Entity v : victims)
+            if (e.index == v.index) {
+                assert(e.generation == v.generation + 1);
+                ++recycled;
+            }
+    }
+    assert(recycled == 10);
+    assert(w.count() == 1010);
+    assert(w.create_n(0, Position{}).empty());
+    std::printf("  create_n broadcast: OK\n");
+}
+
+void test_create_n_generate_and_from() {
+    World w(WorldConfig{StorageMode::Chunked, 256}); // spans many chunks
+    auto gen = w.create_n_generate<Position, Health>(
+        500, [](size_t i) { return std::make_tuple(Position{float(i), 0}, Health{int(i) * 2}); });
+    for (size_t i = 0; i < gen.size(); ++i) {
+        assert(w.get<Position>(gen[i]).x == float(i));
+        assert(w.get<Health>(gen[i]).hp == int(i) * 2);
+    }
+
+    std::vector<Position> positions;
+    std::vector<std::string> names;
+    for (int i = 0; i < 300; ++i) {
+        positions.push_back(Position{float(i), float(-i)});
+        names.push_back("entity number " + std::to_string(i) + " with a heap-allocated name");
+    }
+    auto from = w.create_n_from<Position, std::string>(positions, names);
+    assert(from.size() == 300);
+    for (size_t i = 0; i < from.size(); ++i) {
+        assert(w.get<Position>(from[i]).y == -float(i));
+        assert(w.get<std::string>(from[i]) == names[i]);
+    }
+    std::printf("  create_n generate and from: OK\n");
+}
+
+void test_create_n_hooks() {
+    World w;
+    int added = 0;
+    w.on_add<Health>([&](World& world, Entity e, Health& h) {
+        assert(world.get<Health>(e).hp == h.hp);
+        ++added;
+        if (h.hp == 7) // structural change from inside a batch hook
+            world.add(e, Tag{});
+    });
+    auto es = w.create_n(50, Health{7}, Position{0, 0});
+    assert(added == 50);
+    assert(w.count<Tag>() == 50);
+    w.each<Health, Position, Tag>([](Entity, Health& h, Position&, Tag&) { assert(h.hp == 7); });
+    // Every row migrated away, yet the span still lists the batch
+    assert(es.size() == 50);
+    for (Entity e : es)
+        assert(w.alive(e) && w.has<Tag>(e));
+
+    // Hooks that destroy entities and spawn nested batches leave the outer span intact
+    World v;
+    Entity victim = v.create_with(Velocity{0, 0});
+    v.on_add<Position>([&](World& world, Entity, Position& p) {
+        if (p.x != 1)
+            return;
+        world.destroy(victim);
+        world.create_n(3, Position{2, 2});
+    });
+    auto outer = v.create_n(4, Position{1, 1});
+    assert(outer.size() == 4 && !v.alive(victim) && v.count<Position>() == 16);
+    for (Entity e : outer)
+        assert(v.alive(e) && v.get<Position>(e).x == 1);
+    std::printf("  create_n hooks: OK\n");
+}
+
+void test_flush_batched_matches_flush() {
+    // Same command stream into two identical worlds: FIFO flush vs batched flush.
+    World wa, wb;
+    std::vector<Entity> ea, eb;
+    for (int i = 0; i < 3000; ++i) {
+        ea.push_back(i % 3 ? wa.create_with(Position{float(i), 0})
+                           : wa.create_with(Position{float(i), 0}, Velocity{1, 1}));
+        eb.push_back(i % 3 ? wb.create_with(Position{float(i), 0})
+                           : wb.create_with(Position{float(i), 0}, Velocity{1, 1}));
+    }
+    auto record = [](CommandBuffer& cb, const std::vector<Entity>& es) {
+        for (size_t i = 0; i < es.size(); i += 2)
+            cb.add(es[i], Health{int(i)});
+        cb.remove<Velocity>(es[0]);
+        cb.add(es[0], Health{-1}); // new run; overwrites the earlier add
+        for (size_t i = 0; i < es.size(); i += 4)
+            cb.remove<Health>(es[i]);
+        cb.add(es[4], Health{44}); // re-add after removal
+        cb.destroy(es[5]);
+        cb.add(es[5], Health{55}); // dead by now: payload dropped
+        for (int i = 0; i < 100; ++i)
+            cb.create_with(Position{-1, float(i)}, Tag{});
+    };
+    CommandBuffer ca, cbuf;
+    record(ca, ea);
+    record(cbuf, eb);
+    ca.flush(wa);
+    cbuf.flush_batched(wb);
+    assert(cbuf.empty());
+
+    assert(wa.count() == wb.count());
+    assert(wa.count<Health>() == wb.count<Health>());
+    assert(wa.count<Velocity>() == wb.count<Velocity>());
+    assert(wb.count<Tag>() == 100);
+    for (size_t i = 0; i < ea.size(); ++i) {
+        assert(wa.alive(ea[i]) == wb.alive(eb[i]));
+        if (!wa.alive(ea[i]))
+            continue;
+        assert(wa.get<Position>(ea[i]).x == wb.get<Position>(eb[i]).x);
+        assert(wa.has<Velocity>(ea[i]) == wb.has<Velocity>(eb[i]));
+        assert(wa.has<Health>(ea[i]) == wb.has<Health>(eb[i]));
+        if (wa.has<Health>(ea[i]))
+            assert(wa.get<Health>(ea[i]).hp == wb.get<Health>(eb[i]).hp);
+    }
+    assert(!wb.has<Health>(eb[0]) && wb.get<Health>(eb[4]).hp == 44);
+    std::printf("  flush_batched matches flush: OK\n");
+}
+
+void test_flush_batched_hooks_and_cleanup() {
+    World w;
+    int added = 0, removed = 0;
+    w.on_add<std::string>([&](World&, Entity, std::string& s) {
+        assert(s.size() > 20);
+        ++added;
+    });
+    w.on_remove<std::string>([&](World& world, Entity e, std::string& s) {
+        assert(world.has<std::string>(e) && s.size() > 20); // data still alive
+        ++removed;
+    });
+    auto es = w.create_n(200, Position{0, 0});
+    std::vector<Entity> ents(es.begin(), es.end());
+    Entity dead = ents.back();
+    w.destroy(dead);
+
+    CommandBuffer cb;
+    for (Entity e : ents)
+        cb.add(e, std::string("a string long enough to live on the heap"));
+    cb.flush_batched(w);
+    assert(added == 199);
+    assert(w.count<std::string>() == 199);
+
+    for (Entity e : ents)
+        cb.remove<std::string>(e);
+    cb.flush_batched(w);
+    assert(removed == 199);
+    assert(w.count<std::string>() == 0);
+    assert(w.count<Position>() == 199);
+    std::printf("  flush_batched hooks and cleanup: OK\n");
+}
+
+// --- Phase 13: Change Detection ---
+
+struct Tag13 {};
+
+template <typename... Ts, typename Filter>
+int count_filtered(World& w, Filter filter) {
+    int n = 0;
+    w.each<const Ts...>(filter, [&](Entity, const Ts&...) { ++n; });
+    return n;
+}
+
+void test_change_ticks_filters() {
+    World w;
+    Entity a = w.create_with(Position{1, 0}, Velocity{0, 0});
+    Entity b = w.create_with(Position{2, 0}, Velocity{0, 0});
+    Entity c = w.create_with(Position{3, 0});
+    assert(count_filtered<Position>(w, World::Added<Position>{0}) == 3);
+
+    uint32_t since = w.advance_tick();
+    assert(w.change_tick() == since + 1);
+    assert(count_filtered<Position>(w, World::Changed<Position>{since}) == 0);
+
+    // Single-entity writes are row-precise; const access and reads do not count
+    w.get<Position>(b).x = 20;
+    const World& cw = w;
+    assert(cw.get<Position>(a).x == 1);
+    w.each<const Position>([](Entity, const Position&) {});
+    assert(count_filtered<Position>(w, World::Changed<Position>{since}) == 1);
+    assert(count_filtered<Position>(w, World::Added<Position>{since}) == 0);
+    assert(count_filtered<Velocity>(w, World::Changed<Velocity>{since}) == 0);
+
+    // Migration keeps ticks; a newly added component is both added and changed
+    w.add(c, Velocity{1, 1});
+    w.add(a, Tag13{});
+    assert(count_filtered<Position>(w, World::Changed<Position>{since}) == 1);
+    assert(count_filtered<Velocity>(w, World::Added<Velocity>{since}) == 1);
+    assert(count_filtered<Velocity>(w, World::Changed<Velocity>{since}) == 1);
+    // Overwriting add marks changed, not added; any-of semantics over several filter types
+    w.add(a, Position{10, 0});
+    assert(count_filtered<Position>(w, World::Added<Position>{since}) == 0);
+    assert((count_filtered<Position>(w, World::Changed<Position, Velocity>{since}) == 3));
+
+    // Swap-remove and sort carry ticks with their rows
+    since = w.advance_tick();
+    w.get<Position>(c).x = 30;
+    w.destroy(a);
+    w.sort<Position>([](const Position& l, const Position& r) { return l.x > r.x; });
+    std::vector<Entity> changed;
+    w.each<const Position>(World::Changed<Position>{since},
+                           [&](Entity e, const Position&) { changed.push_back(e); });
+    assert(changed.size() == 1 && changed[0] == c);
+
+    // Mutable iteration marks every visited row; the filtered form marks only what it visits
+    since = w.advance_tick();
+    w.each<Position>([](Entity, Position&) {});
+    assert(count_filtered<Position>(w, World::Changed<Position>{since}) == 2);
+    since = w.advance_tick();
+    w.get<Velocity>(b);
+    int visited = 0;
+    w.each<Position>(World::Changed<Velocity>{since}, [&](Entity e, Position&) {
+        assert(e == b);
+        ++visited;
+    });
+    assert(visited == 1);
+    assert(count_filtered<Position>(w, World::Changed<Position>{since}) == 1);
+
+    std::printf("  change ticks filters: OK\n");
+}
+
+void test_change_ticks_bulk_and_chunked() {
+    WorldConfig cfg;
+    cfg.storage = StorageMode::Chunked;
+    cfg.chunk_bytes = 256; // many chunks, partial tick blocks
+    World w(cfg);
+    auto created = w.create_n(500, Position{0, 0}, Velocity{1, 0});
+    std::vector<Entity> ents(created.begin(), created.end());
+    uint32_t since = w.advance_tick();
+
+    // Parallel mutable iteration marks every row (on the calling thread)
+    ThreadPool pool(4);
+    w.par_each_no_entity<Position, const Velocity>(pool, [](Position& p, const Velocity& v) {
+        p.x += v.dx;
+    });
+    assert(count_filtered<Position>(w, World::Changed<Position>{since}) == 500);
+    assert(count_filtered<Velocity>(w, World::Changed<Velocity>{since}) == 0);
+
+    // Batched removal compacts rows and keeps per-row ticks aligned
+    since = w.advance_tick();
+    for (size_t i = 0; i < ents.size(); i += 7)
+        w.get<Velocity>(ents[i]).dy = 1;
+    CommandBuffer cmds;
+    for (size_t i = 0; i < ents.size(); i += 2)
+        cmds.remove<Position>(ents[i]);
+    cmds.flush_batched(w);
+    int hits = 0;
+    w.each<const Velocity>(World::Changed<Velocity>{since}, [&](Entity e, const Velocity& v) {
+        assert(v.dy == 1);
+        assert((e.index - ents[0].index) % 7 == 0);
+        ++hits;
+    });
+    assert(hits == (500 + 6) / 7);
+    assert(count_filtered<Velocity>(w, World::Added<Velocity>{since}) == 0);
+
+    // Two ReadOnly systems in one stage read through non-const access: the stamps they race
+    // on are atomic, and the reads still report as changes (SPEC §4.2)
+    since = w.advance_tick();
+    SystemRegistry systems;
+    for (const char* name : {"reader a", "reader b"})
+        systems.add(name, {access<Velocity>(ReadOnly)}, [&](World& world) {
+            for (Entity e : ents)
+                (void)world.get<Velocity>(e).dx;
+        });
+    assert(systems.stages().size() == 1);
+    systems.run_all_parallel(w, pool);
+    assert(count_filtered<Velocity>(w, World::Changed<Velocity>{since}) == 500);
+
+    std::printf("  change ticks bulk and chunked: OK\n");
+}
+
+// --- Phase 0.5: Profiling Instrumentation ---
+
+void test_profile_stats() {
+    World w;
+    std::vector<Entity> ents;
+    for (int i = 0; i < 3000; ++i)
+        ents.push_back(w.create_with(Position{float(i), 0}));
+    SystemRegistry systems;
+    systems.add("move", [](World& world) {
+        world.each<Position>([](Entity, Position& p) { p.y += 1; });
+    });
+    systems.add("tag \"slow\"", [&](World& world) {
+        for (size_t i = 0; i < 10; ++i)
+            world.deferred().add(ents[i], Health{1});
+    });
+    ChromeTraceWriter trace;
+    TraceSink sink = trace.sink();
+    w.set_trace_sink(&sink);
+
+#if defined(ECS_PROFILE)
+    // Block storage grew once past the first allocation, relocating whole Position rows
+    WorldStats s = w.stats();
+    assert(s.storage_allocations == 2);
+    assert(s.bytes_moved > 0 && s.bytes_moved % sizeof(Position) == 0);
+    w.reset_stats();
+    assert(w.stats().storage_allocations == 0);
+
+    systems.run_all(w);
+    s = w.stats();
+    assert(s.entities_visited == 3000);
+    assert(s.query_cache_misses == 1 && s.query_cache_hits == 0);
+    assert(s.commands_flushed == 10 && s.entities_migrated == 10);
+    assert(s.query_cache_updates == 1); // {Position, Health} joins the cached Position query
+
+    systems.run_all(w);
+    s = w.stats();
+    assert(s.entities_visited == 6000 && s.query_cache_hits == 1);
+    assert(s.commands_flushed == 20 && s.entities_migrated == 10); // second adds overwrite
+
+    // Per query: the Position key saw both frames; a Query handle over it shares the entry
+    auto position_stats = [&] {
+        for (const QueryStats& q : w.query_stats())
+            if (q.include == std::vector<uint32_t>{component_id<Position>()} && q.exclude.empty())
+                return q;
+        assert(false);
+        return QueryStats{};
+    };
+    QueryStats qs = position_stats();
+    assert(qs.entities_visited == 6000 && qs.query_cache_misses == 1 && qs.query_cache_hits == 1);
+    assert(qs.query_cache_updates == 1);
+    auto handle = w.query<const Position>();
+    w.each<Health>([](Entity, Health&) {});
+    handle.each([](Entity, const Position&) {});
+    qs = position_stats();
+    assert(qs.entities_visited == 9000 && qs.query_cache_misses == 2);
+    assert(w.query_stats().size() == 2); // Position, Health
+
+    for (size_t i = 0; i < systems.size(); ++i) {
+        const SystemStats& st = systems.stats(i);
+        assert(st.calls == 2);
+        assert(st.total_ns >= st.max_ns && st.max_ns >= st.last_ns);
+    }
+
+    // Two events per system and per deferred flush, balanced and escaped
+    assert(trace.size() == 16);
+    std::ostringstream json;
+    trace.write(json);
+    std::string out = json.str();
+    assert(out.rfind("{\"traceEvents\": [", 0) == 0);
+    assert(out.find("\"name\": \"move\"") != std::string::npos);
+    assert(out.find("\"name\": \"tag \\\"slow\\\"\"") != std::string::npos);
+    auto occurrences = [&](const char* needle) {
+        size_t n = 0;
+        for (size_t pos = out.find(needle); pos != std::string::npos; pos = out.find(needle, pos + 1))
+            ++n;
+        return n;
+    };
+    assert(occurrences("\"ph\": \"B\"") == 8 && occurrences("\"ph\": \"E\"") == 8);
+
+    // Parallel stages time and trace on the worker threads
+    ThreadPool pool(2);
+    trace.clear();
+    systems.run_all_parallel(w, pool);
+    assert(systems.stats(0).calls == 3 && systems.stats(1).calls == 3);
+    assert(trace.size() == 8);
+
+    w.set_trace_sink(nullptr);
+    systems.run_all(w);
+    assert(trace.size() == 8);
+    w.reset_stats();
+    systems.reset_stats();
+    assert(w.stats().entities_visited == 0 && systems.stats(0).calls == 0);
+    assert(position_stats().entities_visited == 0);
+#else
+    // Compiled out: nothing is counted, timed or traced
+    systems.run_all(w);
+    WorldStats s = w.stats();
+    assert(s.entities_visited == 0 && s.storage_allocations == 0 && s.commands_flushed == 0);
+    assert(systems.stats(0).calls == 0);
+    assert(w.trace_sink() == nullptr && trace.size() == 0);
+    assert(w.query_stats().empty());
+#endif
+    assert(w.has<Health>(ents[0]));
+    std::printf("  profile stats: OK\n");
+}
+
 int main() {
     std::printf("Running ECS tests...\n");
     test_create_destroy();
@@ -1482,6 +4742,8 @@ int main() {
     test_destroy_all_basic();
     test_destroy_all_empty();
     test_destroy_all_hooks();
+    std::printf("  -- Phase 0.5 --\n");
+    test_profile_stats();
     std::printf("  -- Phase 1.1 --\n");
     test_exclude_filter();
     test_exclude_no_entity();
@@ -1492,6 +4754,7 @@ int main() {
     test_single_assert_multi();
     std::printf("  -- Phase 1.3 --\n");
     test_query_cache_invalidation();
+    test_query_cache_incremental();
     std::printf("  -- Phase 2.1 --\n");
     test_command_buffer_basic();
     test_command_buffer_empty_flush();
@@ -1526,6 +4789,10 @@ int main() {
     test_destroy_recursive_leaf();
     test_set_parent_creates_children();
     test_hierarchy_propagation_with_set_parent();
+    test_incremental_propagation();
+    test_transform_batch_kernels();
+    test_spatial_grid_queries();
+    test_spatial_grid_incremental();
     std::printf("  -- Phase 6 --\n");
     test_sort_basic_order();
     test_sort_multi_column();
@@ -1536,6 +4803,55 @@ int main() {
     test_sort_assert_during_iteration();
     std::printf("  -- Phase 7.1 --\n");
     test_bitset_many_archetypes();
+    test_component_mask_beyond_256();
+    std::printf("  -- Phase 7.3 --\n");
+    test_chunked_storage_pointer_stability();
+    test_chunked_storage_iteration_and_removal();
+    test_chunked_storage_serialize();
+    std::printf("  -- Phase 7.7 --\n");
+    test_block_pool_size_classes();
+    test_world_allocator();
+    test_command_buffer_arena();
+    std::printf("  -- Phase 7.8 --\n");
+    test_shrink_to_fit();
+    test_remove_empty_archetypes();
+    test_compact();
+    std::printf("  -- Phase 7.9 --\n");
+    test_relocatable_traits();
+    test_relocation_lifetimes();
+    test_command_buffer_growth_relocates();
+    std::printf("  -- Phase 7.10 --\n");
+    test_tag_traits();
+    test_tag_storage();
+    test_tag_queries();
+    test_tag_serialization();
+    std::printf("  -- Phase 7.11 --\n");
+    test_sparse_add_remove();
+    test_sparse_queries();
+    test_sparse_deferred_and_prefabs();
+    test_sparse_serialize_assert();
+    std::printf("  -- Phase 7.12 --\n");
+    test_order_by_incremental();
+    test_order_by_skips_clean_archetypes();
+    test_order_by_non_relocatable();
+    std::printf("  -- Phase 7.13 --\n");
+    test_observer_batches();
+    test_observer_batch_structural_assert();
+    test_observer_queues();
+    std::printf("  -- Phase 7.14 --\n");
+    test_value_index_unique();
+    test_value_index_grouped();
+    test_value_index_loads();
+    test_value_index_asserts();
+    std::printf("  -- Phase 7.15 --\n");
+    test_query_handle_each();
+    test_query_handle_chunks_and_par();
+    std::printf("  -- Phase 7.16 --\n");
+    test_column_slot_lookup();
+    std::printf("  -- Phase 7.17 --\n");
+    test_column_alignment();
+    test_split_components();
+    test_each_lanes();
     std::printf("  -- Phase 8.1 --\n");
     test_register_component_lookup();
     test_register_component_idempotent();
@@ -1546,6 +4862,23 @@ int main() {
     test_serialize_empty_world();
     test_serialize_with_hierarchy();
     test_serialize_unregistered_type_asserts();
+    std::printf("  -- Phase 8.3 --\n");
+    test_snapshot_round_trip();
+    test_snapshot_malformed();
+    std::printf("  -- Phase 8.4 --\n");
+    test_delta_snapshot();
+    std::printf("  -- Phase 8.5 --\n");
+    test_stream_round_trip();
+    test_stream_malformed();
+    std::printf("  -- Phase 8.6 --\n");
+    test_checkpoint_round_trip();
+    test_checkpoint_rollback();
+    std::printf("  -- Phase 10 --\n");
+    test_system_access_graph();
+    test_thread_pool_parallel_for();
+    test_run_all_parallel();
+    test_par_each();
+    test_par_deferred_commands();
     std::printf("  -- Phase 11 --\n");
     test_prefab_instantiate_defaults();
     test_prefab_instantiate_override();
@@ -1555,6 +4888,17 @@ int main() {
     test_prefab_override_extra_component();
     test_prefab_on_add_fires();
     test_prefab_destructor_cleanup();
+    test_prefab_instantiate_n();
+    test_prefab_instantiate_n_overrides();
+    std::printf("  -- Phase 12 --\n");
+    test_create_n_broadcast();
+    test_create_n_generate_and_from();
+    test_create_n_hooks();
+    test_flush_batched_matches_flush();
+    test_flush_batched_hooks_and_cleanup();
+    std::printf("  -- Phase 13 --\n");
+    test_change_ticks_filters();
+    test_change_ticks_bulk_and_chunked();
     std::printf("All tests passed!\n");
     return 0;
 }